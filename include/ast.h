@@ -1,6 +1,9 @@
 #ifndef AST_H
 #define AST_H
 
+#include "lexer.h"
+#include <stddef.h>
+
 // Enumeration for AST node types.
 typedef enum
 {
@@ -32,20 +35,42 @@ typedef enum
   AST_FIELD_ACCESS   // Field access (struct.field).
 } ASTNodeType;
 
+// Number of node types; follows the last one.
+#define AST_NODE_TYPE_COUNT (AST_FIELD_ACCESS + 1)
+
 // Forward declaration.
 typedef struct ASTNode ASTNode;
 
+// A function body whose parsing was deferred. The producer (the parser)
+// embeds this at the start of its own record, which holds the token range,
+// and parse builds the body on first use.
+typedef struct LazyBody LazyBody;
+struct LazyBody
+{
+  ASTNode *(*parse)(LazyBody *body); // Returns the block, or NULL on a syntax error
+};
+
+// Node flags.
+#define AST_NODE_IN_ARENA 0x1 // Allocated from an ASTArena (free_ast skips it)
+#define AST_NODE_SHARED 0x2   // Canonical node owned by an ExprTable (free_ast skips it)
+
 // Definition for an AST node.
 struct ASTNode
 {
   ASTNodeType type;
+  unsigned flags;
+  // Canonical type computed by semantic analysis ("unknown" for statements),
+  // NULL until the node has been checked. Always NULL for a shared node,
+  // whose occurrences may have different types.
+  const struct Type *value_type;
   union
   {
     // Variable declaration: let [const] id [: type] = initializer;
     struct
     {
       int is_const;
-      char *identifier;
+      const char *identifier; // Interned text of atom
+      Atom atom;
       char *type_annotation; // Initially stored as a string.
       ASTNode *initializer;  // Expression node.
     } var_decl;
@@ -83,7 +108,8 @@ struct ASTNode
     // For loop: for (id in {start : end}) { ... }
     struct
     {
-      char *iterator;
+      const char *iterator; // Interned text of iterator_atom
+      Atom iterator_atom;
       ASTNode *start_expr;
       ASTNode *end_expr;
       ASTNode *block;
@@ -92,12 +118,14 @@ struct ASTNode
     // Function definition: fn name(parameters) [: return_type] { body }
     struct
     {
-      char *name;
+      const char *name; // Interned text of atom
+      Atom atom;
       ASTNode **parameters; // Array of parameter nodes.
       int param_count;
       char *return_type;
-      ASTNode *body;   // Block node.
-      int is_comptime; // Flag for compile-time functions.
+      ASTNode *body;        // Block node (NULL until lazy_body is parsed).
+      LazyBody *lazy_body;  // Deferred body, or NULL. Use func_def_body().
+      int is_comptime;      // Flag for compile-time functions.
     } func_def;
 
     // Expression statement: expression;
@@ -131,19 +159,22 @@ struct ASTNode
     // Literal: numbers, strings, etc.
     struct
     {
-      char *value;
+      char *value;         // Source text
+      LiteralValue parsed; // Pre-parsed value (LITERAL_NONE if the text is not recognized)
     } literal;
 
     // Identifier: variable and function names.
     struct
     {
-      char *name;
+      const char *name; // Interned text of atom
+      Atom atom;
     } identifier;
 
     // Function call: id(argument1, argument2, ...)
     struct
     {
-      char *name;
+      const char *name; // Interned text of atom
+      Atom atom;
       ASTNode **arguments;
       int arg_count;
     } func_call;
@@ -207,7 +238,8 @@ struct ASTNode
     // Struct definition.
     struct
     {
-      char *name;
+      const char *name; // Interned text of atom
+      Atom atom;
       char **field_names;
       char **field_types;
       int field_count;
@@ -217,28 +249,32 @@ struct ASTNode
     struct
     {
       ASTNode *struct_expr;
-      char *field_name;
+      const char *field_name; // Interned text of field_atom
+      Atom field_atom;
     } field_access;
   } data;
 };
 
 // Function prototypes for creating AST nodes.
-ASTNode *create_var_decl(int is_const, char *identifier, char *type_annotation, ASTNode *initializer);
+ASTNode *create_var_decl(int is_const, const char *identifier, char *type_annotation, ASTNode *initializer);
 ASTNode *create_print_stmt(ASTNode *expr);
 ASTNode *create_prompt_stmt(ASTNode *expr);
 ASTNode *create_if_stmt(ASTNode *condition, ASTNode *if_block,
                         ASTNode **elif_conds, ASTNode **elif_blocks, int elif_count,
                         ASTNode *else_block);
 ASTNode *create_while_stmt(ASTNode *condition, ASTNode *block);
-ASTNode *create_for_stmt(char *iterator, ASTNode *start_expr, ASTNode *end_expr, ASTNode *block);
-ASTNode *create_func_def(char *name, ASTNode **parameters, int param_count, char *return_type, ASTNode *body, int is_comptime);
+ASTNode *create_for_stmt(const char *iterator, ASTNode *start_expr, ASTNode *end_expr, ASTNode *block);
+ASTNode *create_func_def(const char *name, ASTNode **parameters, int param_count, char *return_type, ASTNode *body, int is_comptime);
 ASTNode *create_expr_stmt(ASTNode *expr);
 ASTNode *create_block(ASTNode **statements, int stmt_count);
 ASTNode *create_binary_expr(char *op, ASTNode *left, ASTNode *right);
 ASTNode *create_unary_expr(char *op, ASTNode *operand);
 ASTNode *create_literal(const char *value);
-ASTNode *create_identifier(char *name);
-ASTNode *create_func_call(char *name, ASTNode **arguments, int arg_count);
+ASTNode *create_identifier(const char *name);
+ASTNode *create_identifier_atom(Atom name);
+ASTNode *create_token_literal(const char *text, size_t length, const LiteralValue *value);
+ASTNode *create_literal_value(const char *text, size_t length, const LiteralValue *value);
+ASTNode *create_func_call(const char *name, ASTNode **arguments, int arg_count);
 ASTNode *create_assign_expr(ASTNode *left, ASTNode *right);
 ASTNode *create_return_stmt(ASTNode *expr);
 ASTNode *create_array_literal(ASTNode **elements, int element_count);
@@ -249,10 +285,66 @@ ASTNode *create_switch_stmt(ASTNode *expr, ASTNode **cases, int case_count, ASTN
 ASTNode *create_case_stmt(ASTNode *expr, ASTNode *statement);
 ASTNode *create_fstring(ASTNode **parts, int part_count);
 ASTNode *create_string_interp(ASTNode *expr);
-ASTNode *create_struct_def(char *name, char **field_names, char **field_types, int field_count);
-ASTNode *create_field_access(ASTNode *struct_expr, char *field_name);
+ASTNode *create_struct_def(const char *name, char **field_names, char **field_types, int field_count);
+ASTNode *create_field_access(ASTNode *struct_expr, const char *field_name);
+
+// Body of a function definition, parsing it first if it was deferred. Not
+// thread-safe for a node whose body is still pending. NULL if the deferred
+// body had a syntax error (reported when it was parsed); every function
+// definition has a body otherwise.
+ASTNode *func_def_body(ASTNode *func);
 
-// Free an AST node (recursively).
+// Free an AST node and its subtree.
 void free_ast(ASTNode *node);
 
+// Free a single heap node and the strings and arrays it owns, but not its
+// children.
+void free_ast_node(ASTNode *node);
+
+// Iterative traversal. ast_walk visits a tree depth-first using an explicit,
+// heap-allocated stack, so the depth of a tree (long generated operator
+// chains) is limited by memory rather than by the native stack. pre runs
+// before a node's children and post after them; either may be NULL. Children
+// are visited in source order and NULL children are skipped.
+typedef enum
+{
+  AST_WALK_CONTINUE, // Keep going
+  AST_WALK_SKIP,     // From pre: skip the node's children (post still runs)
+  AST_WALK_STOP      // End the walk without running any further callbacks
+} ASTWalkAction;
+
+typedef struct
+{
+  ASTWalkAction (*pre)(ASTNode *node, ASTNode *parent, void *context);
+  ASTWalkAction (*post)(ASTNode *node, ASTNode *parent, void *context);
+  void *context;
+} ASTVisitor;
+
+// Returns 1 if the walk finished, 0 if a callback stopped it.
+int ast_walk(ASTNode *root, const ASTVisitor *visitor);
+
+// The children ast_walk visits. A deferred function body is not a child until
+// func_def_body() has parsed it, which pre may do.
+int ast_child_count(const ASTNode *node);
+ASTNode *ast_child(const ASTNode *node, int index);
+
+// Address of a child pointer, for passes that replace children.
+ASTNode **ast_child_slot(ASTNode *node, int index);
+
+// Bump allocator for AST nodes. While an arena is current on a thread, every
+// create_* call on that thread allocates the node, its strings and its child
+// arrays from the arena (heap arrays passed in are moved into it), and
+// free_ast ignores those nodes. destroy_ast_arena releases the whole tree at
+// once. A tree should be built entirely inside or entirely outside an arena.
+typedef struct ASTArena ASTArena;
+
+ASTArena *create_ast_arena(void);
+void destroy_ast_arena(ASTArena *arena);
+ASTArena *ast_arena_set_current(ASTArena *arena); // Returns the previous one
+ASTArena *ast_arena_current(void);
+void *ast_arena_alloc(ASTArena *arena, size_t size);
+char *ast_arena_strndup(ASTArena *arena, const char *s, size_t length);
+size_t ast_arena_memory(const ASTArena *arena);
+size_t ast_arena_node_count(const ASTArena *arena);
+
 #endif // AST_H
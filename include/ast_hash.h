@@ -0,0 +1,52 @@
+#ifndef AST_HASH_H
+#define AST_HASH_H
+
+#include "ast.h"
+#include <stdint.h>
+
+// Structural hashing and hash-consing of pure expressions. Literals,
+// identifiers, unary and binary operators, array indexing and field access
+// are pure; a subtree is pure if all of its nodes are. Two pure subtrees are
+// structurally equal if they have the same shape, operators, literal values
+// and identifier atoms.
+//
+// hash_cons_ast replaces every pure subtree of a tree by the canonical node
+// for its structure, so structurally equal expressions become the same
+// pointer and duplicates can be found by comparing pointers. Canonical nodes
+// are flagged AST_NODE_SHARED and owned by the ExprTable: free_ast skips
+// them, and they stay valid until the table is destroyed.
+typedef struct ExprTable ExprTable;
+
+ExprTable *create_expr_table(void);
+
+// Free the canonical nodes. Trees consed into the table must not be used
+// afterwards (free them first).
+void destroy_expr_table(ExprTable *table);
+
+// Structural hash and equality of a subtree, computed without recursion.
+// Nodes of any kind are accepted, but only the kinds, shapes and the payloads
+// of pure nodes are compared (not, say, the names of declarations).
+uint64_t ast_structural_hash(const ASTNode *node);
+int ast_structurally_equal(const ASTNode *a, const ASTNode *b);
+
+// Whether a node kind is pure.
+int ast_is_pure_kind(ASTNodeType type);
+
+// Hash-cons the pure subtrees of root and return the new root, which is the
+// canonical node if root itself is pure. Heap duplicates are freed; arena
+// duplicates are left to their arena. Function bodies that were not parsed yet
+// are left alone.
+ASTNode *hash_cons_ast(ExprTable *table, ASTNode *root);
+
+// The canonical node structurally equal to a pure subtree, or NULL if none was
+// consed yet.
+ASTNode *expr_table_find(const ExprTable *table, const ASTNode *node);
+
+// Times a canonical node has been the result of consing a subtree.
+uint32_t expr_table_uses(const ExprTable *table, const ASTNode *canonical);
+
+// Distinct pure subtrees in the table and pure subtrees consed in total.
+size_t expr_table_count(const ExprTable *table);
+size_t expr_table_occurrences(const ExprTable *table);
+
+#endif // AST_HASH_H
@@ -59,4 +59,7 @@ ComptimeValue *evaluate_comptime_unary_op(const char *op, ComptimeValue *operand
 // Convert a literal to a comptime value.
 ComptimeValue *literal_to_comptime_value(const char *literal_value, Type *type);
 
+// Convert an already parsed literal value to a comptime value
+ComptimeValue *literal_value_to_comptime_value(const LiteralValue *literal, Type *type);
+
 #endif // COMPTIME_H
@@ -0,0 +1,151 @@
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "ast.h"
+#include <stdint.h>
+
+// Compact, index-based form of the AST. All nodes of a FlatAST live in one
+// contiguous array and refer to each other by 32-bit index; variable-length
+// lists (block statements, call arguments, elif chains, struct fields...) are
+// runs in a shared extra array of uint32_t. Index 0 is a reserved null node,
+// so FLAT_NONE marks an absent child. Every field is an index, an offset or a
+// name, so the arrays can be written out and mapped back in place (zast.h).
+// Name fields ("atom" below) are read through flat_atom().
+//
+// Node layout by tag (a, b, c are the three operand words; "extra[x..]" is a
+// run starting at extra index x):
+//   AST_VAR_DECL      a = name atom, b = initializer, c = type atom; flags = is_const
+//   AST_PRINT_STMT,
+//   AST_PROMPT_STMT,
+//   AST_EXPR_STMT,
+//   AST_RETURN_STMT,
+//   AST_STRING_INTERP a = expression
+//   AST_IF_STMT       a = condition, b = if block,
+//                     c -> extra[c..] = else block, elif count, (cond, block)*
+//   AST_WHILE_STMT    a = condition, b = block
+//   AST_FOR_STMT      a = iterator atom, b = block, c -> extra[c..] = start, end
+//   AST_FUNC_DEF      a = name atom, b = body,
+//                     c -> extra[c..] = return type atom, param count, params*;
+//                     flags = is_comptime
+//   AST_BLOCK,
+//   AST_ARRAY_LITERAL,
+//   AST_FSTRING       a -> extra[a..] = children, b = child count
+//   AST_BINARY_EXPR   op = operator subkind, a = left, b = right
+//   AST_UNARY_EXPR    op = operator subkind, a = operand
+//   AST_LITERAL       a = literal index
+//   AST_IDENTIFIER    a = atom
+//   AST_FUNC_CALL     a = name atom, b -> extra[b..] = arguments, c = argument count
+//   AST_ASSIGN_EXPR   a = target, b = value
+//   AST_ARRAY_INDEX   a = array, b = index
+//   AST_SWITCH_STMT   a = expression, b -> extra[b..] = finally block, case count, cases*
+//   AST_CASE_STMT     a = expression, b = statement
+//   AST_STRUCT_DEF    a = name atom, b -> extra[b..] = (field atom, type atom)*, c = field count
+//   AST_FIELD_ACCESS  a = struct expression, b = field atom
+//   AST_BREAK_STMT,
+//   AST_CONTINUE_STMT no operands
+typedef uint32_t FlatIndex;
+
+#define FLAT_NONE 0
+
+typedef struct
+{
+  uint8_t tag;    // ASTNodeType
+  uint8_t op;     // TokenSubkind of binary and unary operators
+  uint16_t flags; // is_const / is_comptime
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+} FlatNode;
+
+typedef struct
+{
+  uint32_t text;      // Offset of the NUL-terminated source text in strings
+  uint32_t length;
+  uint32_t contents;  // Offset of the unescaped contents of string literals
+  uint32_t reserved;
+  LiteralValue value; // Pre-parsed value with value.as.string.text NULL; see flat_literal_value
+} FlatLiteral;
+
+typedef struct
+{
+  FlatNode *nodes;
+  uint32_t node_count;
+  uint32_t node_capacity;
+  uint32_t *extra;
+  uint32_t extra_count;
+  uint32_t extra_capacity;
+  FlatLiteral *literals;
+  uint32_t literal_count;
+  uint32_t literal_capacity;
+  char *strings; // Literal text
+  uint32_t string_size;
+  uint32_t string_capacity;
+  const Atom *atom_map; // Stored name -> atom, or NULL when names are atoms
+  const struct Type **types; // Parallel to nodes: value_type of the source node, or NULL
+                             // when not checked (never stored by zast)
+} FlatAST;
+
+FlatAST *create_flat_ast(void);
+void destroy_flat_ast(FlatAST *ast);
+
+// Append a pointer tree to the flat AST and return the index of its root.
+// Children are stored before their parents, so a forward scan of the node
+// array visits every subtree bottom-up. The tree is not modified, except that
+// deferred function bodies are parsed. Each node keeps its value_type.
+FlatIndex flat_ast_add_tree(FlatAST *ast, const ASTNode *root);
+
+// Rebuild a heap-allocated pointer tree (free with free_ast) from the subtree
+// at index, for consumers that have not moved to the flat form yet. Node
+// types are restored along with it.
+ASTNode *flat_ast_to_tree(const FlatAST *ast, FlatIndex index);
+
+// Append a block node listing already added statements (e.g. the top-level
+// declarations of a file).
+FlatIndex flat_ast_add_block(FlatAST *ast, const FlatIndex *items, uint32_t count);
+
+// Bytes held by the node, extra and literal arrays and the literal text.
+size_t flat_ast_memory(const FlatAST *ast);
+
+static inline const FlatNode *flat_node(const FlatAST *ast, FlatIndex index)
+{
+  return &ast->nodes[index];
+}
+
+// Pointer to the run of extra data starting at index.
+static inline const uint32_t *flat_extra(const FlatAST *ast, uint32_t index)
+{
+  return &ast->extra[index];
+}
+
+// Type semantic analysis gave the node, or NULL if it was not checked.
+static inline const struct Type *flat_type(const FlatAST *ast, FlatIndex index)
+{
+  return ast->types ? ast->types[index] : NULL;
+}
+
+static inline const FlatLiteral *flat_literal(const FlatAST *ast, FlatIndex index)
+{
+  return &ast->literals[ast->nodes[index].a];
+}
+
+static inline const char *flat_literal_text(const FlatAST *ast, const FlatLiteral *literal)
+{
+  return ast->strings + literal->text;
+}
+
+// Literal value with its string contents (if any) resolved.
+static inline LiteralValue flat_literal_value(const FlatAST *ast, const FlatLiteral *literal)
+{
+  LiteralValue value = literal->value;
+  if (value.kind == LITERAL_STRING)
+    value.as.string.text = ast->strings + literal->contents;
+  return value;
+}
+
+// Atom of a name field.
+static inline Atom flat_atom(const FlatAST *ast, uint32_t name)
+{
+  return ast->atom_map ? ast->atom_map[name] : name;
+}
+
+#endif // FLAT_AST_H
@@ -0,0 +1,38 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  // An atom names one interned string. Equal strings always get the same atom,
+  // so names compare as integers and each one is stored once per process.
+  // ATOM_NONE stands for the empty string.
+  typedef uint32_t Atom;
+
+#define ATOM_NONE 0
+
+  // Intern text[0, length), which need not be NUL-terminated. Thread-safe.
+  Atom intern_string(const char *text, size_t length);
+  Atom intern_cstring(const char *text);
+
+  // Atom of text if it has already been interned, otherwise ATOM_NONE.
+  Atom intern_find(const char *text, size_t length);
+
+  // NUL-terminated text of an atom, valid for the life of the process.
+  const char *atom_text(Atom atom);
+  size_t atom_length(Atom atom);
+
+  // Number of interned strings and the bytes used to store them.
+  size_t intern_count(void);
+  size_t intern_memory(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INTERN_H
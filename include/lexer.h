@@ -1,6 +1,10 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include "intern.h"
+
 // Define different token types.
 typedef enum
 {
@@ -23,13 +27,112 @@ typedef enum
   TOKEN_EOF         // End of file.
 } TokenType;
 
+// Keyword and operator subkinds, classified once by the lexer so later stages
+// compare integers instead of token text. Keyword subkinds follow the order of
+// the lexer's keyword table.
+typedef enum
+{
+  TOKEN_SUB_NONE, // Identifiers, literals and punctuation.
+  // Keywords.
+  KW_LET,
+  KW_CONST,
+  KW_PRINT,
+  KW_PROMPT,
+  KW_IF,
+  KW_ELSE,
+  KW_ELIF,
+  KW_CASE,
+  KW_SWITCH,
+  KW_FINALLY,
+  KW_TRUE,
+  KW_FALSE,
+  KW_FN,
+  KW_RETURN,
+  KW_BREAK,
+  KW_CONTINUE,
+  KW_WHILE,
+  KW_FOR,
+  KW_AND,
+  KW_OR,
+  KW_NOT,
+  KW_XOR,
+  KW_IN,
+  KW_STRUCT,
+  KW_COMPTIME,
+  KW_I32, // Primitive types.
+  KW_I64,
+  KW_F32,
+  KW_F64,
+  KW_BOOL,
+  KW_CHAR,
+  KW_STRING,
+  KW_VOID,
+  // Operators.
+  OP_PLUS,    // +
+  OP_MINUS,   // -
+  OP_STAR,    // *
+  OP_SLASH,   // /
+  OP_PERCENT, // %
+  OP_ASSIGN,  // =
+  OP_LT,      // <
+  OP_GT,      // >
+  OP_AMP,     // &
+  OP_PIPE,    // |
+  OP_EQ,      // ==
+  OP_NE,      // !=
+  OP_LE,      // <=
+  OP_GE,      // >=
+  OP_POWER    // **
+} TokenSubkind;
+
+// Number of subkinds; follows the last one.
+#define TOKEN_SUBKIND_COUNT (OP_POWER + 1)
+
+// Kind of a pre-parsed literal value.
+typedef enum
+{
+  LITERAL_NONE,   // Not a literal (or not recognized).
+  LITERAL_INT,    // Integer literal.
+  LITERAL_FLOAT,  // Floating-point literal.
+  LITERAL_BOOL,   // true / false.
+  LITERAL_STRING  // String literal.
+} LiteralKind;
+
+#define LITERAL_KIND_COUNT (LITERAL_STRING + 1)
+
+// Literal value parsed once by the lexer.
+typedef struct
+{
+  LiteralKind kind;
+  int overflow; // Value did not fit in int64/double (it is saturated)
+  union
+  {
+    int64_t integer;
+    double real;
+    int boolean;
+    struct
+    {
+      const char *text; // Unescaped contents, NUL-terminated (NULL in tokens, whose text is the raw contents)
+      size_t length;    // Length of the unescaped contents
+      int has_escapes;  // The raw contents contain escape sequences
+    } string;
+  } as;
+} LiteralValue;
+
 // Token structure.
 typedef struct
 {
   TokenType type;
-  char *value;
-  int line;   // Line number where token appears (1-based)
-  int column; // Column number where token starts (1-based)
+  TokenSubkind subkind; // Keyword or operator kind (TOKEN_SUB_NONE otherwise)
+  char *value;          // NUL-terminated copy of the text (NULL for span tokens); shared
+                        // interned text, not owned, when atom is set
+  size_t offset;        // Byte offset of the token text in the source buffer
+  int length;           // Length of the token text in bytes
+  int line;             // Line number where token appears (1-based)
+  int column;           // Column number where token starts (1-based)
+  int in_fstring;       // Part of an f-string literal (not a lexeme start)
+  LiteralValue literal; // Pre-parsed value of integer, float, bool and string tokens
+  Atom atom;            // Interned text of identifiers (ATOM_NONE otherwise)
 } Token;
 
 // Token Array structure.
@@ -38,8 +141,49 @@ typedef struct
   Token *tokens;
   int count;
   int capacity;
+  const char *source; // Buffer span tokens point into (NULL when every token owns its value)
 } TokenArray;
 
+// Read-only view of a source file. The file is memory-mapped when possible so
+// tokens can refer to it in place.
+typedef struct
+{
+  const char *data;
+  size_t length;
+  int is_mapped;
+} SourceBuffer;
+
+// Maximum lookahead of a streaming Lexer.
+#define LEXER_LOOKAHEAD 8
+
+// Maximum nesting of f-strings and their interpolations.
+#define LEXER_MAX_MODES 32
+
+// Mode stack entry for an f-string body. An open interpolation is recorded
+// as its count of unclosed '{' instead (0 when the next '}' closes it).
+#define LEXER_MODE_FSTRING (-1)
+
+// Pull-based lexer. Tokens are produced on demand into a fixed ring buffer,
+// so token memory does not grow with the size of the input. The only other
+// buffer holds the token just scanned until it fits in the ring.
+typedef struct Lexer
+{
+  const char *source;   // Buffer span tokens point into
+  size_t length;        // Length of source
+  size_t pos;           // Scan position
+  int line;             // Line at the scan position (1-based)
+  int column;           // Column at the scan position (1-based)
+  int copy_values;      // Tokens own a copy of their text
+  int finished;         // The EOF token has been produced
+  int modes[LEXER_MAX_MODES]; // Open f-string bodies and interpolations
+  int mode_depth;       // Number of entries in modes (0 outside f-strings)
+  Token ring[LEXER_LOOKAHEAD];
+  int ring_head;        // Index of the next token in ring
+  int ring_count;       // Number of buffered tokens
+  TokenArray pending;   // Tokens of the last lexeme not yet moved into ring
+  int pending_next;     // Next token to move out of pending
+} Lexer;
+
 // Function prototypes.
 TokenArray create_token_array();
 void add_token(TokenArray *array, TokenType type, const char *value, int line, int column);
@@ -47,4 +191,62 @@ void free_token_array(TokenArray *array);
 TokenArray tokenize(const char *code);
 void print_tokens(const TokenArray *array);
 
+// Zero-copy lexing: tokens are (offset, length) spans into the given buffer,
+// which must outlive the returned array. No per-token allocation is made.
+TokenArray tokenize_source(const char *code, size_t length);
+
+// Streaming lexer over source[0, length). Tokens are spans into source,
+// which must outlive the lexer.
+Lexer *create_lexer(const char *source, size_t length);
+void destroy_lexer(Lexer *lexer);
+Token lexer_next_token(Lexer *lexer);
+Token lexer_peek_token(Lexer *lexer, int k);
+const char *lexer_token_text(const Lexer *lexer, const Token *token);
+
+// A text edit: removed_length bytes at offset replaced by inserted.
+typedef struct
+{
+  size_t offset;
+  size_t removed_length;
+  const char *inserted;
+  size_t inserted_length;
+} SourceEdit;
+
+// Apply an edit, returning a new heap-allocated NUL-terminated buffer.
+char *apply_source_edit(const char *source, size_t length, const SourceEdit *edit, size_t *new_length);
+
+// Incremental re-lexing: given the tokens of the source before edit and the
+// edited source, re-scan only around the edit and reuse the remaining tokens.
+// The result is identical to tokenizing source from scratch.
+TokenArray retokenize(const TokenArray *old, const char *source, size_t length,
+                      const SourceEdit *edit, int *relexed_count);
+
+// Zero-copy lexing split into newline-aligned chunks lexed on up to
+// thread_count threads. The result is identical to tokenize_source.
+TokenArray tokenize_parallel(const char *code, size_t length, int thread_count);
+
+// Map a file into memory (falls back to reading it). Returns 0 on success.
+int source_buffer_open(SourceBuffer *buffer, const char *path);
+void source_buffer_close(SourceBuffer *buffer);
+
+// Keyword/operator classification (TOKEN_SUB_NONE if the text is neither).
+TokenSubkind classify_keyword(const char *text, size_t length);
+TokenSubkind classify_operator(const char *text, size_t length, size_t *op_length);
+// Canonical spelling of a keyword or operator subkind.
+const char *token_subkind_text(TokenSubkind subkind);
+
+// Literal parsing. parse_token_literal parses the text of a token of the
+// given type; parse_literal_text classifies literal source text such as
+// 42, 1.5e3, true or "quoted" (kind LITERAL_NONE if it is none of them).
+LiteralValue parse_token_literal(TokenType type, TokenSubkind subkind, const char *text, size_t length);
+LiteralValue parse_literal_text(const char *text, size_t length);
+
+// Unescape string contents into a new NUL-terminated buffer.
+char *unescape_string(const char *text, size_t length, size_t *out_length);
+
+// Token text access that works for both owned and span tokens.
+const char *token_text(const TokenArray *array, const Token *token);
+int token_text_equals(const TokenArray *array, const Token *token, const char *text);
+char *token_text_dup(const TokenArray *array, const Token *token);
+
 #endif // LEXER_H
@@ -0,0 +1,39 @@
+#ifndef LEXER_SCAN_H
+#define LEXER_SCAN_H
+
+#include <stddef.h>
+
+// Character-class scanning kernels used by the lexer's hot loops. Each kernel
+// starts at code[i] and returns the index of the first byte (at most length)
+// that does not belong to the run. Vector kernels are selected at load time
+// from what the CPU supports; results are identical at every level.
+
+// Instruction set used by the scanning kernels.
+typedef enum
+{
+  SCAN_SCALAR, // Portable table-driven loop.
+  SCAN_SSE2,   // 16 bytes per step using range compares.
+  SCAN_AVX2    // 32 bytes per step using nibble lookup tables.
+} ScanLevel;
+
+// Currently selected kernel level.
+ScanLevel lexer_scan_level(void);
+
+// Select a kernel level (clamped to what the CPU supports). Returns the level
+// actually in use. Mainly useful for testing and benchmarking.
+ScanLevel lexer_scan_set_level(ScanLevel level);
+
+// End of a whitespace run (space, \t, \n, \v, \f, \r).
+size_t scan_whitespace(const char *code, size_t i, size_t length);
+
+// End of an identifier run ([A-Za-z0-9_]).
+size_t scan_identifier(const char *code, size_t i, size_t length);
+
+// End of a decimal digit run.
+size_t scan_digits(const char *code, size_t i, size_t length);
+
+// End of the plain part of a string body: stops at '"', '\\', '\n', NUL and,
+// for f-strings, '{'.
+size_t scan_string_body(const char *code, size_t i, size_t length, int is_fstring);
+
+#endif // LEXER_SCAN_H
@@ -3,18 +3,43 @@
 
 #include "ast.h"
 #include "lexer.h"
+#include "token_stream.h"
+
+// A syntax error recorded by a parser.
+typedef struct
+{
+    int token_index; // Position of the offending token
+    int line;
+    char *message;   // Formatted report, without a trailing newline
+} ParseError;
 
 // Parser structure to maintain state
 typedef struct Parser
 {
-    TokenArray tokens; // Token stream from lexer
-    int current;       // Current token position
-    int had_error;     // Error flag
+    TokenArray tokens;    // Token stream from lexer (empty in streaming mode)
+    int current;          // Current token position
+    int had_error;        // Error flag
+    Lexer *lexer;         // Token source in streaming mode, otherwise NULL
+    Token previous_token; // Last consumed token in streaming mode
+    TokenStream *stream;  // Compact token source, otherwise NULL
+    int lazy_bodies;      // Skip function bodies, parsing them on first use
+    ParseError *errors;   // Errors reported by this parser, in order
+    int error_count;
+    int error_capacity;
+    int print_errors;     // Also print each error to stderr when reported (default)
 } Parser;
 
 // Create a new parser instance
 Parser *create_parser(TokenArray tokens);
 
+// Create a parser that pulls tokens from a streaming lexer instead of a
+// pre-built array. The lexer is owned by the caller.
+Parser *create_stream_parser(Lexer *lexer);
+
+// Create a parser over a compact token stream (owned by the caller). Token
+// locations are looked up only when an error is reported.
+Parser *create_token_stream_parser(TokenStream *stream);
+
 // Free parser resources
 void destroy_parser(Parser *parser);
 
@@ -24,6 +49,9 @@ ASTNode *parse_var_declaration(Parser *parser);
 
 // Parse a function declaration
 // [comptime] fn identifier(params) [:type] { body }
+// With lazy_bodies set (ignored in streaming mode), the body is only
+// brace-matched and its token range recorded; func_def_body() parses it on
+// demand. The token array or stream must then outlive the AST.
 ASTNode *parse_function_declaration(Parser *parser);
 
 // Parse a single expression
@@ -32,6 +60,31 @@ ASTNode *parse_expression(Parser *parser);
 // Parse a block of statements
 ASTNode *parse_block(Parser *parser);
 
+// Parse a struct declaration
+// struct identifier { field: type, ... }
+ASTNode *parse_struct_declaration(Parser *parser);
+
+// Parse one top-level declaration: let, [comptime] fn or struct.
+ASTNode *parse_declaration(Parser *parser);
+
+// Result of parsing a whole token array as top-level declarations.
+typedef struct
+{
+    ASTNode **decls;    // Declarations that parsed, in source order
+    int decl_count;
+    ParseError *errors; // Errors from all workers, in source order
+    int error_count;
+    ASTArena **arenas;  // Arenas holding the declarations (one per worker)
+    int arena_count;
+} ParsedProgram;
+
+// Find top-level declaration boundaries by tracking brace depth, then parse
+// the declarations on up to thread_count threads, each with its own Parser
+// and AST arena. Errors are collected per worker, not printed. Lazy bodies
+// are not used, so the tokens may be freed once this returns.
+ParsedProgram parse_program_parallel(const TokenArray *tokens, int thread_count);
+void free_parsed_program(ParsedProgram *program);
+
 // Error reporting
 void parser_error(Parser *parser, const char *message);
 
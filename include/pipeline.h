@@ -0,0 +1,73 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "flat_ast.h"
+#include "parser.h"
+#include "semantic.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Bounded single-producer/single-consumer queue of pointers. The producer
+// only writes tail and the consumer only writes head, so neither side takes
+// a lock; a full push or an empty pop spins briefly and then yields. NULL is
+// not a valid item.
+typedef struct
+{
+  void **items;
+  size_t mask;                           // Capacity - 1 (capacity is a power of two)
+  _Alignas(64) atomic_size_t head;       // Next slot to pop
+  _Alignas(64) atomic_size_t tail;       // Next slot to push
+} SpscQueue;
+
+// Capacity is rounded up to a power of two (at least 2).
+void spsc_queue_init(SpscQueue *queue, size_t capacity);
+void spsc_queue_destroy(SpscQueue *queue);
+
+// Blocking push and pop.
+void spsc_queue_push(SpscQueue *queue, void *item);
+void *spsc_queue_pop(SpscQueue *queue);
+
+// Non-blocking variants: return 0 / NULL if the queue is full / empty.
+int spsc_queue_try_push(SpscQueue *queue, void *item);
+void *spsc_queue_try_pop(SpscQueue *queue);
+
+// Pipelined frontend. Lexing, parsing, semantic checking and lowering run on
+// their own threads, connected by SPSC queues, and each top-level declaration
+// moves to the next stage as soon as it is finished:
+//
+//   lexer:    streams tokens and cuts them into one token array per
+//             declaration (split like parse_program_parallel)
+//   parser:   parses each declaration into the result's arena
+//   semantic: checks declarations in order against one global scope
+//   lowering: appends each declaration to a FlatAST
+//
+// Errors are collected, not printed. Once a declaration fails to parse,
+// later declarations are still parsed (so every error is reported) but no
+// longer checked or lowered. Likewise, once a declaration fails its semantic
+// check, later ones are still checked but no longer lowered.
+typedef struct
+{
+  int queue_capacity; // Per queue, in declarations (0 for the default)
+  int check;          // Run semantic checks
+  int lower;          // Build the FlatAST
+} FrontendOptions;
+
+typedef struct
+{
+  ASTNode **decls;    // Parsed declarations, in source order
+  int decl_count;
+  ParseError *errors; // Parse errors in source order; token_index is file-wide
+  int error_count;
+  SemanticDiagnostics semantic_errors; // In order; decl indexes decls
+  ASTArena *arena;    // Holds the declarations
+  FlatAST *flat;      // Lowered declarations, or NULL without options->lower
+  FlatIndex root;     // Block of all lowered declarations
+  int token_count;    // Tokens lexed, including EOF
+} FrontendResult;
+
+// Run the frontend over source[0, length), which must stay valid until this
+// returns. options may be NULL (check and lower everything).
+FrontendResult run_frontend_pipeline(const char *source, size_t length, const FrontendOptions *options);
+void free_frontend_result(FrontendResult *result);
+
+#endif // PIPELINE_H
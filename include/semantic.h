@@ -4,6 +4,70 @@
 #include "ast.h"
 #include "symbol_table.h"
 
+// A semantic error, attributed to the top-level declaration it was found in.
+typedef struct
+{
+  int decl;      // Index of the declaration (0 for semantic_check)
+  char *message; // Formatted like the errors semantic_visit prints
+} SemanticDiagnostic;
+
+typedef struct
+{
+  SemanticDiagnostic *items;
+  int count;
+  int capacity;
+} SemanticDiagnostics;
+
+// State of semantic analysis passed through a whole pass instead of living in
+// globals, so several passes, or the workers of one, can run at once. Errors
+// are recorded rather than reported: the check of a declaration stops at its
+// first error and analysis goes on with the next one.
+typedef struct
+{
+  SymbolTable *globals;            // Global scope, owned by the caller
+  SemanticDiagnostics diagnostics; // In declaration order
+} SemanticContext;
+
+void semantic_context_init(SemanticContext *context, SymbolTable *globals);
+void semantic_context_destroy(SemanticContext *context); // Frees the diagnostics only
+
+// Check one tree in the global scope. Returns the number of errors added.
+int semantic_check(SemanticContext *context, ASTNode *node);
+
+// Check the top-level declarations of a program. Function bodies are checked
+// on up to thread_count threads against a read-only snapshot of the global
+// scope; each body sees the globals declared before it, as in a sequential
+// pass. Diagnostics are collected per thread and merged in declaration order,
+// so they do not depend on thread_count. Returns the number of errors added.
+int semantic_check_program(SemanticContext *context, ASTNode **decls, int count, int thread_count);
+
+// Incremental checking. A SemanticProgram keeps the result of checking each
+// top-level declaration together with the names it looked up: the functions
+// it calls, the variables and constants it reads, the struct types it uses,
+// and its own name. An update checks a new list of declarations and walks only
+// those that are new or whose dependencies now resolve to a different global
+// (a changed type, function signature or struct fields, or one declared, removed
+// or moved past it); the others keep their cached results. Declarations are
+// matched to the last update by node, so a checked tree must not be changed in
+// place: an edited declaration is passed as a new node, and the old one is
+// freed only after the update that drops it.
+typedef struct SemanticProgram SemanticProgram;
+
+SemanticProgram *create_semantic_program(void);
+void destroy_semantic_program(SemanticProgram *program);
+
+// Check decls against the results of the last update, with function bodies
+// split over up to thread_count threads as in semantic_check_program.
+// Returns the number of errors in the whole program; they are the ones
+// semantic_check_program would report for decls.
+int semantic_program_update(SemanticProgram *program, ASTNode **decls, int count, int thread_count);
+
+// Diagnostics of the last update in declaration order, valid until the next.
+const SemanticDiagnostics *semantic_program_diagnostics(const SemanticProgram *program);
+
+// Number of declarations the last update walked; the rest were reused.
+int semantic_program_rechecked(const SemanticProgram *program);
+
 // Perform semantic analysis on the AST. This function creates a global symbol
 // table, traverses the AST to perform semantic checks (such as variable declaration
 // checks and type consistency), and then cleans up the symbol table.
@@ -11,6 +75,8 @@ void semantic_analysis(ASTNode *root);
 
 // Recursively visit the AST nodes using the provided symbol table (for the current scope).
 // This function performs semantic checks and populates the symbol table as needed.
+// Each node's type is computed once, bottom-up, and stored in its value_type.
+// The first error is printed and ends the process through test_exit.
 void semantic_visit(ASTNode *node, SymbolTable *table);
 
 #endif // SEMANTIC_H
@@ -1,6 +1,7 @@
 #ifndef STATIC_TYPES_H
 #define STATIC_TYPES_H
 
+#include "lexer.h"
 #include <stdbool.h>
 
 // Basic type enumeration.
@@ -15,6 +16,7 @@ typedef enum
     TYPE_STRING,
     TYPE_VOID,
     TYPE_STRUCT, // For struct types.
+    TYPE_ARRAY,  // Array of an element type (written "T[]").
     TYPE_UNKNOWN,
     TYPE_ERROR
 } BasicTypeKind;
@@ -35,35 +37,59 @@ typedef struct StructType
 } StructType;
 
 // Type structure (can be extended for more complex types later).
+//
+// Types are canonical: the type context hash-conses every type by its kind,
+// const and comptime flags and identity (struct name, array element type), so
+// there is exactly one Type object per distinct type, and two types are equal
+// exactly when their pointers are. Canonical types are immutable, shared
+// between threads and live for the whole process; never modify or free one.
 typedef struct Type
 {
     BasicTypeKind kind;
     bool is_const;    // Whether the type is immutable (const).
     bool is_comptime; // Whether the value must be known at compile time.
+    const char *name; // Canonical spelling, e.g. "comptime i32" or "struct Point" (interned)
     union
     {
-        StructType *struct_info; // Only used if kind == TYPE_STRUCT.
+        StructType *struct_info;    // Only used if kind == TYPE_STRUCT.
+        const struct Type *element; // Only used if kind == TYPE_ARRAY.
     } info;
 } Type;
 
 // Function prototypes:
 
-// Create a new type instance.
+// Canonical type of a non-struct, non-array kind with the given flags.
+Type *type_get(BasicTypeKind kind, bool is_const, bool is_comptime);
+
+// The canonical type identical to type except for its flags.
+Type *type_with_flags(const Type *type, bool is_const, bool is_comptime);
+
+// Canonical array type with the given element type.
+Type *type_array_of(const Type *element);
+
+// Canonical struct type with the given name (fields are set by
+// create_struct_type).
+Type *type_struct_named(const char *name);
+
+// Canonical plain type of a kind (no flags).
 Type *create_type(BasicTypeKind kind);
 
-// Create a const type instance.
+// Canonical const type of a kind.
 Type *create_const_type(BasicTypeKind kind);
 
-// Create a comptime type instance.
+// Canonical comptime type of a kind.
 Type *create_comptime_type(BasicTypeKind kind);
 
-// Convert a type string to a Type instance.
+// Convert a type string ("i32", "struct Point", "f64[]", ...) to its canonical
+// type. "unknown" and NULL give the unknown type; any other unrecognized name
+// gives an opaque TYPE_UNKNOWN type of that name, equal only to itself.
 Type *type_from_string(const char *type_str);
 
-// Convert a Type to its string representation.
+// Convert a Type to its string representation (the canonical name).
 const char *type_to_string(const Type *type);
 
-// Check if two types are exactly the same (including const and comptime flags).
+// Check if two types are exactly the same (including const and comptime
+// flags): pointer equality of canonical types.
 bool types_are_equal(const Type *t1, const Type *t2);
 
 // Check if a value of the source type can be safely used where the target type is expected.
@@ -78,14 +104,14 @@ Type *get_unary_op_type(const char *op, const Type *operand);
 // Check if a type can be used in a condition (if, while, etc.).
 bool type_is_condition_compatible(const Type *type);
 
-// Free a type instance.
+// Types are canonical and never freed; kept for existing callers.
 void free_type(Type *type);
 
 // Get the default value string for a type.
 const char *get_type_default_value(const Type *type);
 
-// Check if a literal string value is compatible with a type.
-bool is_literal_compatible_with_type(const char *literal_value, const Type *type);
+// Check if a literal the lexer already parsed is compatible with a type.
+bool is_literal_compatible_with_type(const LiteralValue *literal, const Type *type);
 
 // Get the type of a literal value.
 Type *get_literal_type(const char *literal_value);
@@ -99,16 +125,25 @@ const char *get_type_conversion_fn(const Type *from, const Type *to);
 // Check if a type is numeric (integer or floating point).
 bool is_numeric_type(const Type *type);
 
+// Check if a type is one of the primitive types (i32, i64, f32, f64, bool,
+// char, string, void).
+bool is_primitive_type(const Type *type);
+
 // Check if a type is an integer type.
 bool is_integer_type(const Type *type);
 
 // Check if a type is a floating point type.
 bool is_float_type(const Type *type);
 
-// Check if a value would fit in the target numeric type.
-bool value_fits_in_type(const char *value, const Type *type);
+// Type of a literal the lexer already parsed (NULL for LITERAL_NONE).
+Type *get_literal_value_type(const LiteralValue *literal);
+
+// Check if an already parsed literal value fits in the target type.
+bool literal_value_fits_in_type(const LiteralValue *literal, const Type *type);
 
-// Create a new struct type.
+// Canonical struct type with the given name. The first call for a name
+// takes ownership of the fields; later calls free theirs and return the type
+// defined first.
 Type *create_struct_type(const char *name, StructField *fields, int field_count);
 
 // Look up a field in a struct type.
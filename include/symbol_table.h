@@ -2,31 +2,74 @@
 #define SYMBOL_TABLE_H
 
 #include "ast.h"
+#include "static_types.h"
+#include <stdint.h>
 
 // Symbol structure
 typedef struct Symbol
 {
-    char *name;
-    char *type;
-    ASTNode *node; // For function definitions and other declarations.
+    const char *name; // Interned text of atom
+    Atom atom;
+    const Type *type;        // Canonical, owned by the type context.
+    ASTNode *node;           // For function definitions and other declarations.
+    struct Symbol *shadowed; // Binding of the same name in an enclosing scope.
+    int depth;               // Scope depth it was declared at (0 is the outermost).
+    int index;               // Position among the table's symbols when declared.
+    uint32_t slot;           // Index of its name in the table's slots.
 } Symbol;
 
-// Symbol table structure
+// Name slot: the innermost binding of an interned name, or NULL while the
+// name is not in scope.
+typedef struct
+{
+    Atom atom;
+    Symbol *symbol;
+} SymbolSlot;
+
+// Symbol table structure. A table is a stack of scopes over one
+// open-addressing hash table keyed by atom, which always maps a name to its
+// innermost binding; a binding that shadows another keeps a link to it.
+// push_scope and pop_scope are O(1) per symbol declared, and popped symbols
+// and arrays are reused, so lookups and redeclaration checks do not depend on
+// scope sizes or depth.
 typedef struct SymbolTable
 {
-    Symbol **symbols;
+    SymbolSlot *slots;
+    uint32_t slot_count; // Power of two
+    uint32_t slot_used;
+    Symbol **symbols;    // Symbols in scope, in declaration order
     int count;
     int capacity;
-    struct SymbolTable *parent; // For nested scopes.
+    int *scope_starts;   // Index in symbols where each open scope starts
+    int depth;           // Number of scopes pushed on top of the outermost one
+    int scope_capacity;
+    Symbol *free_symbols;       // Popped symbols, linked through shadowed
+    struct SymbolBlock *blocks; // Symbol storage
+    struct SymbolTable *parent; // Searched when a name is not bound here.
+    int parent_limit;           // Only parent symbols with a lower index are
+                                // visible from here; -1 (the default) for all.
 } SymbolTable;
 
-// Create and destroy symbol tables.
+// Create and destroy symbol tables. Lookups only read a table, so several
+// threads may share a parent that none of them modifies.
 SymbolTable *create_symbol_table(SymbolTable *parent);
 void destroy_symbol_table(SymbolTable *table);
 
-// Symbol management.
+// Open a nested scope, or close the innermost one and unbind its symbols
+// (the outermost scope cannot be popped).
+void push_scope(SymbolTable *table);
+void pop_scope(SymbolTable *table);
+
+// Symbol management. Type names are resolved with type_from_string.
 void add_symbol(SymbolTable *table, const char *name, const char *type);
 void add_symbol_with_node(SymbolTable *table, const char *name, const char *type, ASTNode *node);
 Symbol *lookup_symbol(SymbolTable *table, const char *name);
 
+// Symbol management by interned name: lookups compare atoms only.
+void add_symbol_atom(SymbolTable *table, Atom name, const Type *type, ASTNode *node);
+Symbol *lookup_symbol_atom(SymbolTable *table, Atom name);
+
+// Binding of a name in the innermost scope only, for redeclaration checks.
+Symbol *lookup_symbol_local(SymbolTable *table, Atom name);
+
 #endif // SYMBOL_TABLE_H
@@ -0,0 +1,44 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include "lexer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Compact struct-of-arrays token stream: one array per field, about 10 bytes
+// per token instead of a full Token. Token text is always a span into source,
+// and line/column are not stored at all; they are computed on demand from a
+// line-start table that is built on the first position query.
+typedef struct
+{
+  uint8_t *kinds;         // TokenType of each token
+  uint8_t *subkinds;      // TokenSubkind of each token
+  uint32_t *offsets;      // Byte offset of each token's text in source
+  uint32_t *lengths;      // Length of each token's text in bytes
+  int count;
+  int capacity;
+  const char *source;     // Buffer the tokens point into
+  size_t source_length;
+  uint32_t *line_starts;  // Offset of the first byte of each line (lazy)
+  int line_count;         // Number of entries in line_starts (0 until built)
+} TokenStream;
+
+// Tokenize source[0, length) into a compact stream. The source must outlive
+// the stream and be smaller than 4 GiB.
+TokenStream tokenize_stream(const char *source, size_t length);
+void free_token_stream(TokenStream *stream);
+
+// Expand token index into a Token span (value NULL, line and column 0).
+Token token_stream_get(const TokenStream *stream, int index);
+
+// Line and column (1-based) of a token's first character; for string
+// literals, of the opening quote.
+void token_stream_position(TokenStream *stream, int index, int *line, int *column);
+
+// Line and column (1-based) of a byte offset in the source.
+void token_stream_offset_position(TokenStream *stream, size_t offset, int *line, int *column);
+
+// Bytes of token storage held by the stream (excluding the line table).
+size_t token_stream_memory(const TokenStream *stream);
+
+#endif // TOKEN_STREAM_H
@@ -0,0 +1,46 @@
+#ifndef ZAST_H
+#define ZAST_H
+
+#include "flat_ast.h"
+#include <stdint.h>
+
+// Binary AST cache (.zast). A cache file holds one FlatAST exactly as it is
+// laid out in memory, plus a table of the names it uses, and is keyed by a
+// hash of the source it was parsed from. Opening a cache maps the file and
+// uses the node, extra, literal and string arrays in place; only the name
+// table is interned, to build the FlatAST's atom_map. Files are specific to
+// the format version, byte order, struct layout and enum sizes that wrote
+// them, and any mismatch makes them a cache miss, as does any index or offset
+// in the sections that points out of bounds.
+#define ZAST_VERSION 2
+
+typedef struct ZastFile ZastFile;
+
+// Hash identifying a version of a source file.
+uint64_t zast_hash_source(const char *source, size_t length);
+
+// Write ast, rooted at root, to path (through a temporary file and rename).
+// Returns 0 on success.
+int zast_write(const char *path, const FlatAST *ast, FlatIndex root, uint64_t source_hash, uint64_t source_length);
+
+// Map a cache file. Returns NULL if it is missing, unreadable, from another
+// format version or layout, was written for a different source, or is
+// malformed. The sections are checked in one pass over the nodes.
+ZastFile *zast_open(const char *path, uint64_t source_hash, uint64_t source_length);
+void zast_close(ZastFile *file);
+
+// The cached AST (read-only; do not destroy it) and its root.
+const FlatAST *zast_ast(const ZastFile *file);
+FlatIndex zast_root(const ZastFile *file);
+
+// Whether the AST came from the cache rather than from parsing the source.
+int zast_from_cache(const ZastFile *file);
+
+// Frontend entry point: the AST of a source file, whose root is a block of
+// its top-level declarations. If cache_path holds a cache for the current
+// contents the file is neither lexed nor parsed. Otherwise it is lexed and
+// parsed on up to thread_count threads, and the cache is rewritten. Returns
+// NULL if the file cannot be read or has syntax errors (which are printed).
+ZastFile *zast_load_source(const char *source_path, const char *cache_path, int thread_count);
+
+#endif // ZAST_H
@@ -40,7 +40,7 @@ namespace zir
             // Add both operands' names if they are ZIRInstructionImpl results
             if (auto leftInst = std::dynamic_pointer_cast<ZIRInstructionImpl>(left))
             {
-                if (!leftInst->getResult().empty())
+                if (leftInst->hasResult())
                 {
                     vars.insert(leftInst->getResult());
                 }
@@ -53,7 +53,7 @@ namespace zir
 
             if (auto rightInst = std::dynamic_pointer_cast<ZIRInstructionImpl>(right))
             {
-                if (!rightInst->getResult().empty())
+                if (rightInst->hasResult())
                 {
                     vars.insert(rightInst->getResult());
                 }
@@ -23,8 +23,8 @@ namespace zir
     {
     public:
         // Constructor takes a name for the block and optional parent function
-        explicit ZIRBasicBlockImpl(std::string name)
-            : name(std::move(name)), id(next_id++), parent_function(nullptr) {}
+        explicit ZIRBasicBlockImpl(const std::string &name)
+            : name(intern_string(name.data(), name.size())), id(next_id++), parent_function(nullptr) {}
 
         // Destructor
         ~ZIRBasicBlockImpl() = default;
@@ -49,9 +49,10 @@ namespace zir
             parent_function = parent;
         }
 
-        // Get/set name
-        const std::string &getName() const { return name; }
-        void setName(std::string new_name) { name = std::move(new_name); }
+        // Get/set name (names are interned)
+        const char *getName() const { return atom_text(name); }
+        Atom getNameAtom() const { return name; }
+        void setName(const std::string &new_name) { name = intern_string(new_name.data(), new_name.size()); }
 
         // Get unique ID
         uint64_t getId() const { return id; }
@@ -238,7 +239,7 @@ namespace zir
         }
 
     private:
-        std::string name;
+        Atom name;
         uint64_t id;
         static std::atomic<uint64_t> next_id;
         void *parent_function; // Store as void* to avoid circular dependency
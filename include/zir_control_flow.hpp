@@ -71,7 +71,7 @@ namespace zir
 
         std::string toString() const override
         {
-            return "jump " + target->getName();
+            return std::string("jump ") + target->getName();
         }
 
     private:
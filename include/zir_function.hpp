@@ -15,8 +15,8 @@ namespace zir
     {
     public:
         // Constructor and destructor
-        explicit ZIRFunctionImpl(std::string name)
-            : name(std::move(name)), id(next_id++) {}
+        explicit ZIRFunctionImpl(const std::string &name)
+            : name(intern_string(name.data(), name.size())), id(next_id++) {}
 
         ~ZIRFunctionImpl() = default;
 
@@ -28,9 +28,10 @@ namespace zir
         ZIRFunctionImpl(ZIRFunctionImpl &&) = default;
         ZIRFunctionImpl &operator=(ZIRFunctionImpl &&) = default;
 
-        // Name management
-        const std::string &getName() const { return name; }
-        void setName(std::string new_name) { name = std::move(new_name); }
+        // Name management (names are interned)
+        const char *getName() const { return atom_text(name); }
+        Atom getNameAtom() const { return name; }
+        void setName(const std::string &new_name) { name = intern_string(new_name.data(), new_name.size()); }
 
         // ID accessor
         uint64_t getId() const { return id; }
@@ -52,7 +53,7 @@ namespace zir
         bool hasGlobalRedundantComputations() const;
 
     private:
-        std::string name;
+        Atom name;
         uint64_t id;
         std::vector<std::shared_ptr<ZIRBasicBlockImpl>> blocks;
         static std::atomic<uint64_t> next_id;
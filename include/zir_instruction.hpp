@@ -7,6 +7,7 @@
 #include <unordered_set>
 #include "zir_type.hpp"
 #include "zir_value.hpp"
+#include "intern.h"
 
 namespace zir
 {
@@ -30,30 +31,36 @@ namespace zir
     class ZIRInstructionImpl
     {
     public:
-        // Constructors
+        // Constructors. Names, results and labels are interned, so each one is
+        // stored once and compared as an atom.
         explicit ZIRInstructionImpl(const std::string &name)
-            : opcode(ZIROpcode::NOP), name(name), result(""), target_label("") {}
+            : opcode(ZIROpcode::NOP), name(internName(name)), result(ATOM_NONE), target_label(ATOM_NONE) {}
 
         explicit ZIRInstructionImpl(ZIROpcode opcode, const std::string &result = "")
-            : opcode(opcode), name(result), result(result), target_label("") {}
+            : opcode(opcode), name(internName(result)), result(name), target_label(ATOM_NONE) {}
 
         virtual ~ZIRInstructionImpl() = default;
 
         // Basic accessors
         ZIROpcode getOpcode() const { return opcode; }
-        const std::string &getName() const { return name; }
-        void setName(const std::string &new_name) { name = new_name; }
-        const std::string &getResult() const { return result; }
-        void setResult(const std::string &new_result) { result = new_result; }
+        const char *getName() const { return atom_text(name); }
+        Atom getNameAtom() const { return name; }
+        void setName(const std::string &new_name) { name = internName(new_name); }
+        const char *getResult() const { return atom_text(result); }
+        Atom getResultAtom() const { return result; }
+        bool hasResult() const { return result != ATOM_NONE; }
+        void setResult(const std::string &new_result) { result = internName(new_result); }
 
         // Pure virtual methods that all instructions must implement
         virtual std::string toString() const = 0;
         virtual ZIRType::Kind getResultType() const = 0;
 
         // Label handling
-        const std::string &getTargetLabel() const { return target_label; }
-        void setTargetLabel(const std::string &label) { target_label = label; }
-        bool referencesLabel(const std::string &label) const
+        const char *getTargetLabel() const { return atom_text(target_label); }
+        Atom getTargetLabelAtom() const { return target_label; }
+        void setTargetLabel(const std::string &label) { target_label = internName(label); }
+        void setTargetLabel(Atom label) { target_label = label; }
+        bool referencesLabel(Atom label) const
         {
             return target_label == label;
         }
@@ -70,9 +77,9 @@ namespace zir
         std::unordered_set<std::string> getDefinedVariables() const
         {
             std::unordered_set<std::string> vars;
-            if (!result.empty())
+            if (hasResult())
             {
-                vars.insert(result);
+                vars.insert(getResult());
             }
             return vars;
         }
@@ -94,10 +101,12 @@ namespace zir
         ZIRInstructionImpl &operator=(ZIRInstructionImpl &&) = default;
 
     private:
+        static Atom internName(const std::string &text) { return intern_string(text.data(), text.size()); }
+
         ZIROpcode opcode;
-        std::string name;   // For backward compatibility
-        std::string result; // For new code
-        std::string target_label;
+        Atom name;   // For backward compatibility
+        Atom result; // For new code
+        Atom target_label;
     };
 
 } // namespace zir
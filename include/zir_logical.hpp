@@ -56,7 +56,7 @@ namespace zir
         // Default string representation for unary operations
         std::string toString() const override
         {
-            return getName() + " " + operand->toString();
+            return std::string(getName()) + " " + operand->toString();
         }
 
     protected:
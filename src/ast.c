@@ -26,15 +26,201 @@ static char *xstrdup(const char *s)
   return ptr;
 }
 
+static char *xstrndup(const char *s, size_t length)
+{
+  char *ptr = strndup(s, length);
+  if (!ptr)
+  {
+    fprintf(stderr, "Memory allocation failed in strndup\n");
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+//----------------------------------------------------------
+// AST arena
+//----------------------------------------------------------
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGN 16
+
+typedef struct ArenaBlock
+{
+  struct ArenaBlock *next;
+  size_t size; // Usable bytes in data
+  size_t used;
+  _Alignas(ARENA_ALIGN) char data[];
+} ArenaBlock;
+
+struct ASTArena
+{
+  ArenaBlock *blocks; // Current block first
+  size_t memory;      // Bytes reserved from the system
+  size_t node_count;
+};
+
+// Arena the create_* functions allocate from on this thread (NULL: the heap).
+static __thread ASTArena *current_arena;
+
+ASTArena *create_ast_arena(void)
+{
+  ASTArena *arena = (ASTArena *)xmalloc(sizeof(ASTArena));
+  arena->blocks = NULL;
+  arena->memory = 0;
+  arena->node_count = 0;
+  return arena;
+}
+
+// Free every node, string and array allocated from the arena at once.
+void destroy_ast_arena(ASTArena *arena)
+{
+  if (!arena)
+    return;
+  if (current_arena == arena)
+    current_arena = NULL;
+  ArenaBlock *block = arena->blocks;
+  while (block)
+  {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(arena);
+}
+
+ASTArena *ast_arena_set_current(ASTArena *arena)
+{
+  ASTArena *previous = current_arena;
+  current_arena = arena;
+  return previous;
+}
+
+ASTArena *ast_arena_current(void)
+{
+  return current_arena;
+}
+
+// Bump-allocate size bytes. Requests larger than a quarter block get a block
+// of their own behind the current one, so the current block keeps filling.
+void *ast_arena_alloc(ASTArena *arena, size_t size)
+{
+  size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+  ArenaBlock *block = arena->blocks;
+  if (block && block->used + size <= block->size)
+  {
+    void *ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+  }
+
+  size_t block_size = size > ARENA_BLOCK_SIZE / 4 ? size : ARENA_BLOCK_SIZE;
+  ArenaBlock *fresh = (ArenaBlock *)xmalloc(sizeof(ArenaBlock) + block_size);
+  fresh->size = block_size;
+  fresh->used = size;
+  arena->memory += sizeof(ArenaBlock) + block_size;
+  if (block && block_size != ARENA_BLOCK_SIZE)
+  {
+    fresh->next = block->next;
+    block->next = fresh;
+  }
+  else
+  {
+    fresh->next = block;
+    arena->blocks = fresh;
+  }
+  return fresh->data;
+}
+
+char *ast_arena_strndup(ASTArena *arena, const char *s, size_t length)
+{
+  char *copy = (char *)ast_arena_alloc(arena, length + 1);
+  memcpy(copy, s, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+size_t ast_arena_memory(const ASTArena *arena)
+{
+  return arena->memory;
+}
+
+size_t ast_arena_node_count(const ASTArena *arena)
+{
+  return arena->node_count;
+}
+
+// Node storage: from the current arena if there is one, else the heap.
+static ASTNode *new_node(ASTNodeType type)
+{
+  ASTNode *node;
+  if (current_arena)
+  {
+    node = (ASTNode *)ast_arena_alloc(current_arena, sizeof(ASTNode));
+    node->flags = AST_NODE_IN_ARENA;
+    current_arena->node_count++;
+  }
+  else
+  {
+    node = (ASTNode *)xmalloc(sizeof(ASTNode));
+    node->flags = 0;
+  }
+  node->type = type;
+  node->value_type = NULL;
+  return node;
+}
+
+static char *node_strdup(const char *s)
+{
+  return current_arena ? ast_arena_strndup(current_arena, s, strlen(s)) : xstrdup(s);
+}
+
+static char *node_strndup(const char *s, size_t length)
+{
+  return current_arena ? ast_arena_strndup(current_arena, s, length) : xstrndup(s, length);
+}
+
+static void *node_alloc(size_t size)
+{
+  return current_arena ? ast_arena_alloc(current_arena, size) : xmalloc(size);
+}
+
+// Take ownership of a heap array of child pointers. In arena mode it is moved
+// into the arena so the tree holds no heap memory.
+static void *adopt_array(void *array, size_t size)
+{
+  if (!current_arena || !array)
+    return array;
+  void *copy = ast_arena_alloc(current_arena, size);
+  memcpy(copy, array, size);
+  free(array);
+  return copy;
+}
+
+// Move a heap string produced by the literal parser into the arena.
+static const char *adopt_string(const char *text, size_t length)
+{
+  if (!current_arena || !text)
+    return text;
+  char *copy = ast_arena_strndup(current_arena, text, length);
+  free((char *)text);
+  return copy;
+}
+
+static void adopt_literal_text(LiteralValue *value)
+{
+  if (value->kind == LITERAL_STRING)
+    value->as.string.text = adopt_string(value->as.string.text, value->as.string.length);
+}
+
 // Create a variable declaration node.
-ASTNode *create_var_decl(int is_const, char *identifier, char *type_annotation,
+ASTNode *create_var_decl(int is_const, const char *identifier, char *type_annotation,
                          ASTNode *initializer)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_VAR_DECL;
+  ASTNode *node = new_node(AST_VAR_DECL);
   node->data.var_decl.is_const = is_const;
-  node->data.var_decl.identifier = xstrdup(identifier);
-  node->data.var_decl.type_annotation = type_annotation ? xstrdup(type_annotation) : NULL;
+  node->data.var_decl.atom = intern_cstring(identifier);
+  node->data.var_decl.identifier = atom_text(node->data.var_decl.atom);
+  node->data.var_decl.type_annotation = type_annotation ? node_strdup(type_annotation) : NULL;
   node->data.var_decl.initializer = initializer;
   return node;
 }
@@ -42,8 +228,7 @@ ASTNode *create_var_decl(int is_const, char *identifier, char *type_annotation,
 // Create a print statement node.
 ASTNode *create_print_stmt(ASTNode *expr)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_PRINT_STMT;
+  ASTNode *node = new_node(AST_PRINT_STMT);
   node->data.print_stmt.expr = expr;
   return node;
 }
@@ -51,8 +236,7 @@ ASTNode *create_print_stmt(ASTNode *expr)
 // Create a prompt statement node.
 ASTNode *create_prompt_stmt(ASTNode *expr)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_PROMPT_STMT;
+  ASTNode *node = new_node(AST_PROMPT_STMT);
   node->data.prompt_stmt.expr = expr;
   return node;
 }
@@ -62,12 +246,11 @@ ASTNode *create_if_stmt(ASTNode *condition, ASTNode *if_block,
                         ASTNode **elif_conds, ASTNode **elif_blocks, int elif_count,
                         ASTNode *else_block)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_IF_STMT;
+  ASTNode *node = new_node(AST_IF_STMT);
   node->data.if_stmt.condition = condition;
   node->data.if_stmt.if_block = if_block;
-  node->data.if_stmt.elif_conds = elif_conds;
-  node->data.if_stmt.elif_blocks = elif_blocks;
+  node->data.if_stmt.elif_conds = adopt_array(elif_conds, elif_count * sizeof(ASTNode *));
+  node->data.if_stmt.elif_blocks = adopt_array(elif_blocks, elif_count * sizeof(ASTNode *));
   node->data.if_stmt.elif_count = elif_count;
   node->data.if_stmt.else_block = else_block;
   return node;
@@ -76,20 +259,19 @@ ASTNode *create_if_stmt(ASTNode *condition, ASTNode *if_block,
 // Create a while loop node.
 ASTNode *create_while_stmt(ASTNode *condition, ASTNode *block)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_WHILE_STMT;
+  ASTNode *node = new_node(AST_WHILE_STMT);
   node->data.while_stmt.condition = condition;
   node->data.while_stmt.block = block;
   return node;
 }
 
 // Create a for loop node (range-based).
-ASTNode *create_for_stmt(char *iterator, ASTNode *start_expr, ASTNode *end_expr,
+ASTNode *create_for_stmt(const char *iterator, ASTNode *start_expr, ASTNode *end_expr,
                          ASTNode *block)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_FOR_STMT;
-  node->data.for_stmt.iterator = xstrdup(iterator);
+  ASTNode *node = new_node(AST_FOR_STMT);
+  node->data.for_stmt.iterator_atom = intern_cstring(iterator);
+  node->data.for_stmt.iterator = atom_text(node->data.for_stmt.iterator_atom);
   node->data.for_stmt.start_expr = start_expr;
   node->data.for_stmt.end_expr = end_expr;
   node->data.for_stmt.block = block;
@@ -97,25 +279,40 @@ ASTNode *create_for_stmt(char *iterator, ASTNode *start_expr, ASTNode *end_expr,
 }
 
 // Create a function definition node.
-ASTNode *create_func_def(char *name, ASTNode **parameters, int param_count,
+ASTNode *create_func_def(const char *name, ASTNode **parameters, int param_count,
                          char *return_type, ASTNode *body, int is_comptime)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_FUNC_DEF;
-  node->data.func_def.name = xstrdup(name);
-  node->data.func_def.parameters = parameters;
+  ASTNode *node = new_node(AST_FUNC_DEF);
+  node->data.func_def.atom = intern_cstring(name);
+  node->data.func_def.name = atom_text(node->data.func_def.atom);
+  node->data.func_def.parameters = adopt_array(parameters, param_count * sizeof(ASTNode *));
   node->data.func_def.param_count = param_count;
-  node->data.func_def.return_type = return_type ? xstrdup(return_type) : NULL;
+  node->data.func_def.return_type = return_type ? node_strdup(return_type) : NULL;
   node->data.func_def.body = body;
+  node->data.func_def.lazy_body = NULL;
   node->data.func_def.is_comptime = is_comptime;
   return node;
 }
 
+// Parse a deferred body on first use. The lazy record is released whether or
+// not parsing succeeds; records of arena nodes live in the arena.
+ASTNode *func_def_body(ASTNode *func)
+{
+  LazyBody *lazy = func->data.func_def.lazy_body;
+  if (lazy)
+  {
+    func->data.func_def.lazy_body = NULL;
+    func->data.func_def.body = lazy->parse(lazy);
+    if (!(func->flags & AST_NODE_IN_ARENA))
+      free(lazy);
+  }
+  return func->data.func_def.body;
+}
+
 // Create an expression statement node.
 ASTNode *create_expr_stmt(ASTNode *expr)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_EXPR_STMT;
+  ASTNode *node = new_node(AST_EXPR_STMT);
   node->data.expr_stmt.expr = expr;
   return node;
 }
@@ -123,9 +320,8 @@ ASTNode *create_expr_stmt(ASTNode *expr)
 // Create a block node, which represents a series of statements.
 ASTNode *create_block(ASTNode **statements, int stmt_count)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_BLOCK;
-  node->data.block.statements = statements;
+  ASTNode *node = new_node(AST_BLOCK);
+  node->data.block.statements = adopt_array(statements, stmt_count * sizeof(ASTNode *));
   node->data.block.stmt_count = stmt_count;
   return node;
 }
@@ -133,9 +329,8 @@ ASTNode *create_block(ASTNode **statements, int stmt_count)
 // Create a binary expression node.
 ASTNode *create_binary_expr(char *op, ASTNode *left, ASTNode *right)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_BINARY_EXPR;
-  node->data.binary_expr.op = xstrdup(op);
+  ASTNode *node = new_node(AST_BINARY_EXPR);
+  node->data.binary_expr.op = node_strdup(op);
   node->data.binary_expr.left = left;
   node->data.binary_expr.right = right;
   return node;
@@ -144,38 +339,72 @@ ASTNode *create_binary_expr(char *op, ASTNode *left, ASTNode *right)
 // Create a unary expression node.
 ASTNode *create_unary_expr(char *op, ASTNode *operand)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_UNARY_EXPR;
-  node->data.unary_expr.op = xstrdup(op);
+  ASTNode *node = new_node(AST_UNARY_EXPR);
+  node->data.unary_expr.op = node_strdup(op);
   node->data.unary_expr.operand = operand;
   return node;
 }
 
-// Create a literal node.
+// Create a literal node. The value is parsed once here.
 ASTNode *create_literal(const char *value)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_LITERAL;
-  node->data.literal.value = xstrdup(value);
+  ASTNode *node = new_node(AST_LITERAL);
+  node->data.literal.value = node_strdup(value);
+  node->data.literal.parsed = parse_literal_text(value, strlen(value));
+  adopt_literal_text(&node->data.literal.parsed);
+  return node;
+}
+
+// Create a literal node from a literal token's text and the value the lexer
+// already parsed. String tokens hold the raw contents (without quotes).
+ASTNode *create_token_literal(const char *text, size_t length, const LiteralValue *value)
+{
+  ASTNode *node = new_node(AST_LITERAL);
+  node->data.literal.value = node_strndup(text, length);
+  node->data.literal.parsed = *value;
+  if (value->kind == LITERAL_STRING)
+  {
+    node->data.literal.parsed.as.string.text =
+        value->as.string.has_escapes ? adopt_string(unescape_string(text, length, NULL), value->as.string.length)
+                                     : node_strndup(text, length);
+  }
+  return node;
+}
+
+// Create a literal node from source text and an already parsed value whose
+// string contents (if any) are copied.
+ASTNode *create_literal_value(const char *text, size_t length, const LiteralValue *value)
+{
+  ASTNode *node = new_node(AST_LITERAL);
+  node->data.literal.value = node_strndup(text, length);
+  node->data.literal.parsed = *value;
+  if (value->kind == LITERAL_STRING)
+    node->data.literal.parsed.as.string.text = node_strndup(value->as.string.text, value->as.string.length);
   return node;
 }
 
 // Create an identifier node.
-ASTNode *create_identifier(char *name)
+ASTNode *create_identifier(const char *name)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_IDENTIFIER;
-  node->data.identifier.name = xstrdup(name);
+  return create_identifier_atom(intern_cstring(name));
+}
+
+// Create an identifier node for an already interned name.
+ASTNode *create_identifier_atom(Atom name)
+{
+  ASTNode *node = new_node(AST_IDENTIFIER);
+  node->data.identifier.atom = name;
+  node->data.identifier.name = atom_text(name);
   return node;
 }
 
 // Create a function call node.
-ASTNode *create_func_call(char *name, ASTNode **arguments, int arg_count)
+ASTNode *create_func_call(const char *name, ASTNode **arguments, int arg_count)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_FUNC_CALL;
-  node->data.func_call.name = xstrdup(name);
-  node->data.func_call.arguments = arguments;
+  ASTNode *node = new_node(AST_FUNC_CALL);
+  node->data.func_call.atom = intern_cstring(name);
+  node->data.func_call.name = atom_text(node->data.func_call.atom);
+  node->data.func_call.arguments = adopt_array(arguments, arg_count * sizeof(ASTNode *));
   node->data.func_call.arg_count = arg_count;
   return node;
 }
@@ -183,8 +412,7 @@ ASTNode *create_func_call(char *name, ASTNode **arguments, int arg_count)
 // Create an assignment expression node.
 ASTNode *create_assign_expr(ASTNode *left, ASTNode *right)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_ASSIGN_EXPR;
+  ASTNode *node = new_node(AST_ASSIGN_EXPR);
   node->data.assign_expr.left = left;
   node->data.assign_expr.right = right;
   return node;
@@ -193,8 +421,7 @@ ASTNode *create_assign_expr(ASTNode *left, ASTNode *right)
 // Create a return statement node.
 ASTNode *create_return_stmt(ASTNode *expr)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_RETURN_STMT;
+  ASTNode *node = new_node(AST_RETURN_STMT);
   node->data.return_stmt.expr = expr;
   return node;
 }
@@ -202,9 +429,8 @@ ASTNode *create_return_stmt(ASTNode *expr)
 // Create an array literal node.
 ASTNode *create_array_literal(ASTNode **elements, int element_count)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_ARRAY_LITERAL;
-  node->data.array_literal.elements = elements;
+  ASTNode *node = new_node(AST_ARRAY_LITERAL);
+  node->data.array_literal.elements = adopt_array(elements, element_count * sizeof(ASTNode *));
   node->data.array_literal.element_count = element_count;
   return node;
 }
@@ -212,8 +438,7 @@ ASTNode *create_array_literal(ASTNode **elements, int element_count)
 // Create an array indexing node.
 ASTNode *create_array_index(ASTNode *array, ASTNode *index)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_ARRAY_INDEX;
+  ASTNode *node = new_node(AST_ARRAY_INDEX);
   node->data.array_index.array = array;
   node->data.array_index.index = index;
   return node;
@@ -222,26 +447,23 @@ ASTNode *create_array_index(ASTNode *array, ASTNode *index)
 // Create a break statement node.
 ASTNode *create_break_stmt(void)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_BREAK_STMT;
+  ASTNode *node = new_node(AST_BREAK_STMT);
   return node;
 }
 
 // Create a continue statement node.
 ASTNode *create_continue_stmt(void)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_CONTINUE_STMT;
+  ASTNode *node = new_node(AST_CONTINUE_STMT);
   return node;
 }
 
 // Create a switch statement node.
 ASTNode *create_switch_stmt(ASTNode *expr, ASTNode **cases, int case_count, ASTNode *finally_block)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_SWITCH_STMT;
+  ASTNode *node = new_node(AST_SWITCH_STMT);
   node->data.switch_stmt.expr = expr;
-  node->data.switch_stmt.cases = cases;
+  node->data.switch_stmt.cases = adopt_array(cases, case_count * sizeof(ASTNode *));
   node->data.switch_stmt.case_count = case_count;
   node->data.switch_stmt.finally_block = finally_block;
   return node;
@@ -250,8 +472,7 @@ ASTNode *create_switch_stmt(ASTNode *expr, ASTNode **cases, int case_count, ASTN
 // Create a case statement node.
 ASTNode *create_case_stmt(ASTNode *expr, ASTNode *statement)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_CASE_STMT;
+  ASTNode *node = new_node(AST_CASE_STMT);
   node->data.case_stmt.expr = expr;
   node->data.case_stmt.statement = statement;
   return node;
@@ -260,9 +481,8 @@ ASTNode *create_case_stmt(ASTNode *expr, ASTNode *statement)
 // Create an f-string node.
 ASTNode *create_fstring(ASTNode **parts, int part_count)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_FSTRING;
-  node->data.fstring.parts = parts;
+  ASTNode *node = new_node(AST_FSTRING);
+  node->data.fstring.parts = adopt_array(parts, part_count * sizeof(ASTNode *));
   node->data.fstring.part_count = part_count;
   return node;
 }
@@ -270,165 +490,294 @@ ASTNode *create_fstring(ASTNode **parts, int part_count)
 // Create a string interpolation node.
 ASTNode *create_string_interp(ASTNode *expr)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_STRING_INTERP;
+  ASTNode *node = new_node(AST_STRING_INTERP);
   node->data.string_interp.expr = expr;
   return node;
 }
 
 // Create a struct definition node.
-ASTNode *create_struct_def(char *name, char **field_names, char **field_types, int field_count)
+ASTNode *create_struct_def(const char *name, char **field_names, char **field_types, int field_count)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_STRUCT_DEF;
-  node->data.struct_def.name = xstrdup(name);
+  ASTNode *node = new_node(AST_STRUCT_DEF);
+  node->data.struct_def.atom = intern_cstring(name);
+  node->data.struct_def.name = atom_text(node->data.struct_def.atom);
 
   // Allocate and copy field names and types.
-  node->data.struct_def.field_names = (char **)xmalloc(field_count * sizeof(char *));
-  node->data.struct_def.field_types = (char **)xmalloc(field_count * sizeof(char *));
+  node->data.struct_def.field_names = (char **)node_alloc(field_count * sizeof(char *));
+  node->data.struct_def.field_types = (char **)node_alloc(field_count * sizeof(char *));
   node->data.struct_def.field_count = field_count;
 
   for (int i = 0; i < field_count; i++)
   {
-    node->data.struct_def.field_names[i] = xstrdup(field_names[i]);
-    node->data.struct_def.field_types[i] = xstrdup(field_types[i]);
+    node->data.struct_def.field_names[i] = node_strdup(field_names[i]);
+    node->data.struct_def.field_types[i] = node_strdup(field_types[i]);
   }
   return node;
 }
 
 // Create a field access node.
-ASTNode *create_field_access(ASTNode *struct_expr, char *field_name)
+ASTNode *create_field_access(ASTNode *struct_expr, const char *field_name)
 {
-  ASTNode *node = (ASTNode *)xmalloc(sizeof(ASTNode));
-  node->type = AST_FIELD_ACCESS;
+  ASTNode *node = new_node(AST_FIELD_ACCESS);
   node->data.field_access.struct_expr = struct_expr;
-  node->data.field_access.field_name = xstrdup(field_name);
+  node->data.field_access.field_atom = intern_cstring(field_name);
+  node->data.field_access.field_name = atom_text(node->data.field_access.field_atom);
   return node;
 }
 
-// Recursively free an AST node and all its children.
-void free_ast(ASTNode *node)
+//----------------------------------------------------------
+// Traversal
+//----------------------------------------------------------
+
+int ast_child_count(const ASTNode *node)
 {
-  if (!node)
-    return;
   switch (node->type)
   {
   case AST_VAR_DECL:
-    free(node->data.var_decl.identifier);
-    if (node->data.var_decl.type_annotation)
-      free(node->data.var_decl.type_annotation);
-    if (node->data.var_decl.initializer)
-      free_ast(node->data.var_decl.initializer);
-    break;
   case AST_PRINT_STMT:
-    free_ast(node->data.print_stmt.expr);
-    break;
   case AST_PROMPT_STMT:
-    free_ast(node->data.prompt_stmt.expr);
-    break;
+  case AST_EXPR_STMT:
+  case AST_RETURN_STMT:
+  case AST_UNARY_EXPR:
+  case AST_STRING_INTERP:
+  case AST_FIELD_ACCESS:
+    return 1;
+  case AST_WHILE_STMT:
+  case AST_BINARY_EXPR:
+  case AST_ASSIGN_EXPR:
+  case AST_ARRAY_INDEX:
+  case AST_CASE_STMT:
+    return 2;
   case AST_IF_STMT:
-    free_ast(node->data.if_stmt.condition);
-    free_ast(node->data.if_stmt.if_block);
-    if (node->data.if_stmt.elif_count > 0)
+    return 3 + 2 * node->data.if_stmt.elif_count;
+  case AST_FOR_STMT:
+    return 3;
+  case AST_FUNC_DEF:
+    return node->data.func_def.param_count + 1;
+  case AST_BLOCK:
+    return node->data.block.stmt_count;
+  case AST_FUNC_CALL:
+    return node->data.func_call.arg_count;
+  case AST_ARRAY_LITERAL:
+    return node->data.array_literal.element_count;
+  case AST_SWITCH_STMT:
+    return node->data.switch_stmt.case_count + 2;
+  case AST_FSTRING:
+    return node->data.fstring.part_count;
+  default:
+    return 0;
+  }
+}
+
+ASTNode **ast_child_slot(ASTNode *node, int index)
+{
+  switch (node->type)
+  {
+  case AST_VAR_DECL:
+    return &node->data.var_decl.initializer;
+  case AST_PRINT_STMT:
+    return &node->data.print_stmt.expr;
+  case AST_PROMPT_STMT:
+    return &node->data.prompt_stmt.expr;
+  case AST_EXPR_STMT:
+    return &node->data.expr_stmt.expr;
+  case AST_RETURN_STMT:
+    return &node->data.return_stmt.expr;
+  case AST_UNARY_EXPR:
+    return &node->data.unary_expr.operand;
+  case AST_STRING_INTERP:
+    return &node->data.string_interp.expr;
+  case AST_FIELD_ACCESS:
+    return &node->data.field_access.struct_expr;
+  case AST_WHILE_STMT:
+    return index == 0 ? &node->data.while_stmt.condition : &node->data.while_stmt.block;
+  case AST_BINARY_EXPR:
+    return index == 0 ? &node->data.binary_expr.left : &node->data.binary_expr.right;
+  case AST_ASSIGN_EXPR:
+    return index == 0 ? &node->data.assign_expr.left : &node->data.assign_expr.right;
+  case AST_ARRAY_INDEX:
+    return index == 0 ? &node->data.array_index.array : &node->data.array_index.index;
+  case AST_CASE_STMT:
+    return index == 0 ? &node->data.case_stmt.expr : &node->data.case_stmt.statement;
+  case AST_IF_STMT:
+    // condition, if block, (elif condition, elif block)*, else block
+    if (index == 0)
+      return &node->data.if_stmt.condition;
+    if (index == 1)
+      return &node->data.if_stmt.if_block;
+    index -= 2;
+    if (index < 2 * node->data.if_stmt.elif_count)
+      return index % 2 == 0 ? &node->data.if_stmt.elif_conds[index / 2] : &node->data.if_stmt.elif_blocks[index / 2];
+    return &node->data.if_stmt.else_block;
+  case AST_FOR_STMT:
+    if (index == 0)
+      return &node->data.for_stmt.start_expr;
+    return index == 1 ? &node->data.for_stmt.end_expr : &node->data.for_stmt.block;
+  case AST_FUNC_DEF:
+    if (index < node->data.func_def.param_count)
+      return &node->data.func_def.parameters[index];
+    return &node->data.func_def.body;
+  case AST_BLOCK:
+    return &node->data.block.statements[index];
+  case AST_FUNC_CALL:
+    return &node->data.func_call.arguments[index];
+  case AST_ARRAY_LITERAL:
+    return &node->data.array_literal.elements[index];
+  case AST_SWITCH_STMT:
+    // expression, cases*, finally block
+    if (index == 0)
+      return &node->data.switch_stmt.expr;
+    if (index <= node->data.switch_stmt.case_count)
+      return &node->data.switch_stmt.cases[index - 1];
+    return &node->data.switch_stmt.finally_block;
+  case AST_FSTRING:
+    return &node->data.fstring.parts[index];
+  default:
+    return NULL;
+  }
+}
+
+ASTNode *ast_child(const ASTNode *node, int index)
+{
+  ASTNode **slot = ast_child_slot((ASTNode *)node, index);
+  return slot ? *slot : NULL;
+}
+
+typedef struct
+{
+  ASTNode *node;
+  ASTNode *parent;
+  int next;  // Next child to visit, -1 before pre has run
+  int count; // Children to visit
+} ASTWalkFrame;
+
+// Frames kept on the native stack before the walk moves to the heap
+#define AST_WALK_INLINE_FRAMES 32
+
+int ast_walk(ASTNode *root, const ASTVisitor *visitor)
+{
+  if (!root)
+    return 1;
+
+  ASTWalkFrame inline_frames[AST_WALK_INLINE_FRAMES];
+  ASTWalkFrame *stack = inline_frames;
+  size_t capacity = AST_WALK_INLINE_FRAMES;
+  size_t depth = 1;
+  int finished = 1;
+  stack[0] = (ASTWalkFrame){root, NULL, -1, 0};
+
+  while (depth > 0)
+  {
+    ASTWalkFrame *frame = &stack[depth - 1];
+    if (frame->next < 0)
     {
-      for (int i = 0; i < node->data.if_stmt.elif_count; i++)
+      ASTWalkAction action = visitor->pre ? visitor->pre(frame->node, frame->parent, visitor->context) : AST_WALK_CONTINUE;
+      if (action == AST_WALK_STOP)
       {
-        free_ast(node->data.if_stmt.elif_conds[i]);
-        free_ast(node->data.if_stmt.elif_blocks[i]);
+        finished = 0;
+        break;
       }
-      free(node->data.if_stmt.elif_conds);
-      free(node->data.if_stmt.elif_blocks);
+      frame->next = 0;
+      frame->count = action == AST_WALK_SKIP ? 0 : ast_child_count(frame->node);
     }
-    if (node->data.if_stmt.else_block)
-      free_ast(node->data.if_stmt.else_block);
-    break;
-  case AST_WHILE_STMT:
-    free_ast(node->data.while_stmt.condition);
-    free_ast(node->data.while_stmt.block);
+
+    if (frame->next < frame->count)
+    {
+      ASTNode *child = ast_child(frame->node, frame->next++);
+      if (!child)
+        continue;
+      if (depth == capacity)
+      {
+        capacity *= 2;
+        if (stack == inline_frames)
+        {
+          stack = xmalloc(capacity * sizeof(ASTWalkFrame));
+          memcpy(stack, inline_frames, sizeof(inline_frames));
+        }
+        else
+        {
+          stack = realloc(stack, capacity * sizeof(ASTWalkFrame));
+          if (!stack)
+          {
+            fprintf(stderr, "Memory allocation failed for AST walk\n");
+            exit(EXIT_FAILURE);
+          }
+        }
+        frame = &stack[depth - 1];
+      }
+      stack[depth++] = (ASTWalkFrame){child, frame->node, -1, 0};
+      continue;
+    }
+
+    if (visitor->post && visitor->post(frame->node, frame->parent, visitor->context) == AST_WALK_STOP)
+    {
+      finished = 0;
+      break;
+    }
+    depth--;
+  }
+
+  if (stack != inline_frames)
+    free(stack);
+  return finished;
+}
+
+//----------------------------------------------------------
+// Freeing
+//----------------------------------------------------------
+
+static ASTWalkAction free_ast_enter(ASTNode *node, ASTNode *parent, void *context)
+{
+  (void)parent;
+  (void)context;
+  // Arena nodes and everything below them are released with their arena, and
+  // shared nodes with the table that owns them
+  return node->flags & (AST_NODE_IN_ARENA | AST_NODE_SHARED) ? AST_WALK_SKIP : AST_WALK_CONTINUE;
+}
+
+void free_ast_node(ASTNode *node)
+{
+  switch (node->type)
+  {
+  case AST_VAR_DECL:
+    free(node->data.var_decl.type_annotation);
     break;
-  case AST_FOR_STMT:
-    free(node->data.for_stmt.iterator);
-    free_ast(node->data.for_stmt.start_expr);
-    free_ast(node->data.for_stmt.end_expr);
-    free_ast(node->data.for_stmt.block);
+  case AST_IF_STMT:
+    free(node->data.if_stmt.elif_conds);
+    free(node->data.if_stmt.elif_blocks);
     break;
   case AST_FUNC_DEF:
-    free(node->data.func_def.name);
-    for (int i = 0; i < node->data.func_def.param_count; i++)
-      free_ast(node->data.func_def.parameters[i]);
     free(node->data.func_def.parameters);
-    if (node->data.func_def.return_type)
-      free(node->data.func_def.return_type);
-    free_ast(node->data.func_def.body);
-    break;
-  case AST_EXPR_STMT:
-    free_ast(node->data.expr_stmt.expr);
+    free(node->data.func_def.return_type);
+    free(node->data.func_def.lazy_body);
     break;
   case AST_BLOCK:
-    for (int i = 0; i < node->data.block.stmt_count; i++)
-      free_ast(node->data.block.statements[i]);
     free(node->data.block.statements);
     break;
   case AST_BINARY_EXPR:
     free(node->data.binary_expr.op);
-    free_ast(node->data.binary_expr.left);
-    free_ast(node->data.binary_expr.right);
     break;
   case AST_UNARY_EXPR:
     free(node->data.unary_expr.op);
-    free_ast(node->data.unary_expr.operand);
     break;
   case AST_LITERAL:
     free(node->data.literal.value);
-    break;
-  case AST_IDENTIFIER:
-    free(node->data.identifier.name);
+    if (node->data.literal.parsed.kind == LITERAL_STRING)
+      free((char *)node->data.literal.parsed.as.string.text);
     break;
   case AST_FUNC_CALL:
-    free(node->data.func_call.name);
-    for (int i = 0; i < node->data.func_call.arg_count; i++)
-      free_ast(node->data.func_call.arguments[i]);
     free(node->data.func_call.arguments);
     break;
-  case AST_ASSIGN_EXPR:
-    free_ast(node->data.assign_expr.left);
-    free_ast(node->data.assign_expr.right);
-    break;
-  case AST_RETURN_STMT:
-    if (node->data.return_stmt.expr)
-      free_ast(node->data.return_stmt.expr);
-    break;
   case AST_ARRAY_LITERAL:
-    for (int i = 0; i < node->data.array_literal.element_count; i++)
-      free_ast(node->data.array_literal.elements[i]);
     free(node->data.array_literal.elements);
     break;
-  case AST_ARRAY_INDEX:
-    free_ast(node->data.array_index.array);
-    free_ast(node->data.array_index.index);
-    break;
   case AST_SWITCH_STMT:
-    free_ast(node->data.switch_stmt.expr);
-    for (int i = 0; i < node->data.switch_stmt.case_count; i++)
-      free_ast(node->data.switch_stmt.cases[i]);
     free(node->data.switch_stmt.cases);
-    if (node->data.switch_stmt.finally_block)
-      free_ast(node->data.switch_stmt.finally_block);
-    break;
-  case AST_CASE_STMT:
-    free_ast(node->data.case_stmt.expr);
-    free_ast(node->data.case_stmt.statement);
     break;
   case AST_FSTRING:
-    for (int i = 0; i < node->data.fstring.part_count; i++)
-      free_ast(node->data.fstring.parts[i]);
     free(node->data.fstring.parts);
     break;
-  case AST_STRING_INTERP:
-    free_ast(node->data.string_interp.expr);
-    break;
   case AST_STRUCT_DEF:
-    free(node->data.struct_def.name);
     for (int i = 0; i < node->data.struct_def.field_count; i++)
     {
       free(node->data.struct_def.field_names[i]);
@@ -437,12 +786,27 @@ void free_ast(ASTNode *node)
     free(node->data.struct_def.field_names);
     free(node->data.struct_def.field_types);
     break;
-  case AST_FIELD_ACCESS:
-    free_ast(node->data.field_access.struct_expr);
-    free(node->data.field_access.field_name);
-    break;
   default:
     break;
   }
   free(node);
 }
+
+// Children are already gone when a node is left.
+static ASTWalkAction free_ast_leave(ASTNode *node, ASTNode *parent, void *context)
+{
+  (void)parent;
+  (void)context;
+  if (!(node->flags & (AST_NODE_IN_ARENA | AST_NODE_SHARED)))
+    free_ast_node(node);
+  return AST_WALK_CONTINUE;
+}
+
+// Free an AST node and all its children, walking the tree without recursion.
+// Arena nodes and shared nodes are skipped along with their subtrees; they are
+// released with their arena or ExprTable.
+void free_ast(ASTNode *node)
+{
+  ASTVisitor visitor = {free_ast_enter, free_ast_leave, NULL};
+  ast_walk(node, &visitor);
+}
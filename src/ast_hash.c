@@ -0,0 +1,504 @@
+#include "../include/ast_hash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+  uint64_t hash;
+  ASTNode *node;
+  uint32_t uses;
+} ExprEntry;
+
+struct ExprTable
+{
+  ExprEntry *entries;
+  uint32_t count;
+  uint32_t capacity;
+  // Open addressing over entries (index + 1, 0 when empty), by structural
+  // hash and by canonical node address.
+  uint32_t *by_hash;
+  uint32_t *by_node;
+  uint32_t slot_count;
+  size_t occurrences;
+};
+
+static void *xrealloc(void *ptr, size_t size)
+{
+  ptr = realloc(ptr, size);
+  if (!ptr)
+  {
+    fprintf(stderr, "Memory allocation failed for %zu bytes\n", size);
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+//----------------------------------------------------------
+// Hashing
+//----------------------------------------------------------
+
+static uint64_t mix(uint64_t hash, uint64_t value)
+{
+  hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+static uint64_t finish(uint64_t hash)
+{
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+static uint64_t hash_bytes(const char *bytes, size_t length)
+{
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < length; i++)
+  {
+    hash ^= (unsigned char)bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+int ast_is_pure_kind(ASTNodeType type)
+{
+  switch (type)
+  {
+  case AST_LITERAL:
+  case AST_IDENTIFIER:
+  case AST_BINARY_EXPR:
+  case AST_UNARY_EXPR:
+  case AST_ARRAY_INDEX:
+  case AST_FIELD_ACCESS:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+// Hash of what a node holds besides its children.
+static uint64_t payload_hash(const ASTNode *node)
+{
+  uint64_t hash = (uint64_t)node->type;
+  switch (node->type)
+  {
+  case AST_LITERAL:
+  {
+    const LiteralValue *value = &node->data.literal.parsed;
+    hash = mix(hash, value->kind);
+    switch (value->kind)
+    {
+    case LITERAL_INT:
+      return mix(hash, (uint64_t)value->as.integer);
+    case LITERAL_FLOAT:
+    {
+      uint64_t bits;
+      memcpy(&bits, &value->as.real, sizeof(bits));
+      return mix(hash, bits);
+    }
+    case LITERAL_BOOL:
+      return mix(hash, (uint64_t)value->as.boolean);
+    case LITERAL_STRING:
+      return mix(hash, hash_bytes(value->as.string.text, value->as.string.length));
+    default:
+      return mix(hash, hash_bytes(node->data.literal.value, strlen(node->data.literal.value)));
+    }
+  }
+  case AST_IDENTIFIER:
+    return mix(hash, node->data.identifier.atom);
+  case AST_BINARY_EXPR:
+    return mix(hash, hash_bytes(node->data.binary_expr.op, strlen(node->data.binary_expr.op)));
+  case AST_UNARY_EXPR:
+    return mix(hash, hash_bytes(node->data.unary_expr.op, strlen(node->data.unary_expr.op)));
+  case AST_FIELD_ACCESS:
+    return mix(hash, node->data.field_access.field_atom);
+  default:
+    return hash;
+  }
+}
+
+static int payload_equal(const ASTNode *a, const ASTNode *b)
+{
+  if (a->type != b->type)
+    return 0;
+  switch (a->type)
+  {
+  case AST_LITERAL:
+  {
+    const LiteralValue *x = &a->data.literal.parsed;
+    const LiteralValue *y = &b->data.literal.parsed;
+    if (x->kind != y->kind)
+      return 0;
+    switch (x->kind)
+    {
+    case LITERAL_INT:
+      return x->as.integer == y->as.integer;
+    case LITERAL_FLOAT:
+      return memcmp(&x->as.real, &y->as.real, sizeof(x->as.real)) == 0;
+    case LITERAL_BOOL:
+      return x->as.boolean == y->as.boolean;
+    case LITERAL_STRING:
+      return x->as.string.length == y->as.string.length &&
+             memcmp(x->as.string.text, y->as.string.text, x->as.string.length) == 0;
+    default:
+      return strcmp(a->data.literal.value, b->data.literal.value) == 0;
+    }
+  }
+  case AST_IDENTIFIER:
+    return a->data.identifier.atom == b->data.identifier.atom;
+  case AST_BINARY_EXPR:
+    return strcmp(a->data.binary_expr.op, b->data.binary_expr.op) == 0;
+  case AST_UNARY_EXPR:
+    return strcmp(a->data.unary_expr.op, b->data.unary_expr.op) == 0;
+  case AST_FIELD_ACCESS:
+    return a->data.field_access.field_atom == b->data.field_access.field_atom;
+  default:
+    return 1;
+  }
+}
+
+// Combine a node's payload with the hashes of its children, in order.
+static uint64_t node_hash(const ASTNode *node, const uint64_t *child_hashes, int count)
+{
+  uint64_t hash = payload_hash(node);
+  for (int i = 0; i < count; i++)
+    hash = mix(hash, child_hashes[i]);
+  return finish(mix(hash, (uint64_t)count));
+}
+
+static int present_child_count(const ASTNode *node)
+{
+  int count = 0;
+  for (int i = 0; i < ast_child_count(node); i++)
+    count += ast_child(node, i) != NULL;
+  return count;
+}
+
+typedef struct
+{
+  uint64_t *hashes;
+  size_t count;
+  size_t capacity;
+} HashWalk;
+
+static ASTWalkAction hash_leave(ASTNode *node, ASTNode *parent, void *context)
+{
+  (void)parent;
+  HashWalk *walk = context;
+  int count = present_child_count(node);
+  walk->count -= count;
+  uint64_t hash = node_hash(node, &walk->hashes[walk->count], count);
+  if (walk->count == walk->capacity)
+  {
+    walk->capacity = walk->capacity ? walk->capacity * 2 : 64;
+    walk->hashes = xrealloc(walk->hashes, walk->capacity * sizeof(uint64_t));
+  }
+  walk->hashes[walk->count++] = hash;
+  return AST_WALK_CONTINUE;
+}
+
+uint64_t ast_structural_hash(const ASTNode *node)
+{
+  if (!node)
+    return 0;
+  HashWalk walk = {NULL, 0, 0};
+  ASTVisitor visitor = {NULL, hash_leave, &walk};
+  ast_walk((ASTNode *)node, &visitor);
+  uint64_t hash = walk.hashes[0];
+  free(walk.hashes);
+  return hash;
+}
+
+int ast_structurally_equal(const ASTNode *a, const ASTNode *b)
+{
+  // Pairs still to compare
+  const ASTNode **pairs = NULL;
+  size_t count = 0, capacity = 0;
+  int equal = 1;
+  const ASTNode *x = a, *y = b;
+  for (;;)
+  {
+    if (x != y)
+    {
+      int children = x && y ? ast_child_count(x) : 0;
+      if (!x || !y || !payload_equal(x, y) || children != ast_child_count(y))
+      {
+        equal = 0;
+        break;
+      }
+      if (count + 2 * (size_t)children > capacity)
+      {
+        capacity = (count + 2 * (size_t)children) * 2 + 16;
+        pairs = xrealloc(pairs, capacity * sizeof(const ASTNode *));
+      }
+      for (int i = 0; i < children; i++)
+      {
+        pairs[count++] = ast_child(x, i);
+        pairs[count++] = ast_child(y, i);
+      }
+    }
+    if (count == 0)
+      break;
+    y = pairs[--count];
+    x = pairs[--count];
+  }
+  free(pairs);
+  return equal;
+}
+
+//----------------------------------------------------------
+// Table
+//----------------------------------------------------------
+
+ExprTable *create_expr_table(void)
+{
+  ExprTable *table = calloc(1, sizeof(ExprTable));
+  if (!table)
+  {
+    fprintf(stderr, "Memory allocation failed for expression table\n");
+    exit(EXIT_FAILURE);
+  }
+  return table;
+}
+
+void destroy_expr_table(ExprTable *table)
+{
+  if (!table)
+    return;
+  for (uint32_t i = 0; i < table->count; i++)
+  {
+    ASTNode *node = table->entries[i].node;
+    if (!(node->flags & AST_NODE_IN_ARENA))
+      free_ast_node(node);
+  }
+  free(table->entries);
+  free(table->by_hash);
+  free(table->by_node);
+  free(table);
+}
+
+static uint32_t pointer_slot(const ASTNode *node, uint32_t mask)
+{
+  return (uint32_t)(finish((uint64_t)(uintptr_t)node) & mask);
+}
+
+static void insert_slots(ExprTable *table, uint32_t index)
+{
+  uint32_t mask = table->slot_count - 1;
+  uint32_t i = (uint32_t)(table->entries[index].hash & mask);
+  while (table->by_hash[i])
+    i = (i + 1) & mask;
+  table->by_hash[i] = index + 1;
+  i = pointer_slot(table->entries[index].node, mask);
+  while (table->by_node[i])
+    i = (i + 1) & mask;
+  table->by_node[i] = index + 1;
+}
+
+static void add_entry(ExprTable *table, uint64_t hash, ASTNode *node)
+{
+  if (table->count == table->capacity)
+  {
+    table->capacity = table->capacity ? table->capacity * 2 : 64;
+    table->entries = xrealloc(table->entries, table->capacity * sizeof(ExprEntry));
+  }
+  if ((table->count + 1) * 2 > table->slot_count)
+  {
+    table->slot_count = table->slot_count ? table->slot_count * 2 : 128;
+    free(table->by_hash);
+    free(table->by_node);
+    table->by_hash = calloc(table->slot_count, sizeof(uint32_t));
+    table->by_node = calloc(table->slot_count, sizeof(uint32_t));
+    if (!table->by_hash || !table->by_node)
+    {
+      fprintf(stderr, "Memory allocation failed for expression table\n");
+      exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < table->count; i++)
+      insert_slots(table, i);
+  }
+  node->flags |= AST_NODE_SHARED;
+  node->value_type = NULL; // See ASTNode::value_type
+  table->entries[table->count] = (ExprEntry){hash, node, 1};
+  insert_slots(table, table->count++);
+}
+
+static ExprEntry *entry_of(const ExprTable *table, const ASTNode *node)
+{
+  if (!table->slot_count)
+    return NULL;
+  uint32_t mask = table->slot_count - 1;
+  for (uint32_t i = pointer_slot(node, mask); table->by_node[i]; i = (i + 1) & mask)
+  {
+    ExprEntry *entry = &table->entries[table->by_node[i] - 1];
+    if (entry->node == node)
+      return entry;
+  }
+  return NULL;
+}
+
+// Canonical entry with the given hash whose node has the payload of node and
+// exactly its (canonical) children.
+static ExprEntry *find_shallow(const ExprTable *table, uint64_t hash, const ASTNode *node)
+{
+  if (!table->slot_count)
+    return NULL;
+  uint32_t mask = table->slot_count - 1;
+  for (uint32_t i = (uint32_t)(hash & mask); table->by_hash[i]; i = (i + 1) & mask)
+  {
+    ExprEntry *entry = &table->entries[table->by_hash[i] - 1];
+    if (entry->hash != hash || !payload_equal(entry->node, node))
+      continue;
+    int count = ast_child_count(node);
+    int same = count == ast_child_count(entry->node);
+    for (int c = 0; same && c < count; c++)
+      same = ast_child(node, c) == ast_child(entry->node, c);
+    if (same)
+      return entry;
+  }
+  return NULL;
+}
+
+ASTNode *expr_table_find(const ExprTable *table, const ASTNode *node)
+{
+  if (!node || !table->slot_count)
+    return NULL;
+  ExprEntry *known = entry_of(table, node);
+  if (known)
+    return known->node;
+  uint64_t hash = ast_structural_hash(node);
+  uint32_t mask = table->slot_count - 1;
+  for (uint32_t i = (uint32_t)(hash & mask); table->by_hash[i]; i = (i + 1) & mask)
+  {
+    ExprEntry *entry = &table->entries[table->by_hash[i] - 1];
+    if (entry->hash == hash && ast_structurally_equal(entry->node, node))
+      return entry->node;
+  }
+  return NULL;
+}
+
+uint32_t expr_table_uses(const ExprTable *table, const ASTNode *canonical)
+{
+  ExprEntry *entry = entry_of(table, canonical);
+  return entry ? entry->uses : 0;
+}
+
+size_t expr_table_count(const ExprTable *table)
+{
+  return table->count;
+}
+
+size_t expr_table_occurrences(const ExprTable *table)
+{
+  return table->occurrences;
+}
+
+//----------------------------------------------------------
+// Hash-consing
+//----------------------------------------------------------
+
+// Result of a visited subtree: its hash and replacement, if it is pure.
+typedef struct
+{
+  uint64_t hash;
+  ASTNode *node;
+  int pure;
+} ConsResult;
+
+typedef struct
+{
+  ExprTable *table;
+  ConsResult *results;
+  size_t count;
+  size_t capacity;
+} ConsWalk;
+
+static ASTWalkAction cons_enter(ASTNode *node, ASTNode *parent, void *context)
+{
+  (void)parent;
+  (void)context;
+  // Below a canonical node everything is canonical already
+  return node->flags & AST_NODE_SHARED ? AST_WALK_SKIP : AST_WALK_CONTINUE;
+}
+
+static ASTWalkAction cons_leave(ASTNode *node, ASTNode *parent, void *context)
+{
+  (void)parent;
+  ConsWalk *walk = context;
+  ExprTable *table = walk->table;
+  ConsResult result = {0, node, 0};
+
+  if (node->flags & AST_NODE_SHARED)
+  {
+    ExprEntry *entry = entry_of(table, node);
+    if (entry)
+    {
+      entry->uses++;
+      table->occurrences++;
+      result = (ConsResult){entry->hash, node, 1};
+    }
+  }
+  else
+  {
+    // Point the node at the canonical versions of its children
+    int count = present_child_count(node);
+    ConsResult *children = &walk->results[walk->count - count];
+    uint64_t hashes[2];
+    int pure = ast_is_pure_kind(node->type);
+    for (int i = 0, c = 0; i < ast_child_count(node); i++)
+    {
+      ASTNode **slot = ast_child_slot(node, i);
+      if (!*slot)
+        continue;
+      *slot = children[c].node;
+      pure = pure && children[c].pure;
+      if (c < 2)
+        hashes[c] = children[c].hash;
+      c++;
+    }
+    walk->count -= count;
+
+    // Pure kinds have at most two children
+    if (pure)
+    {
+      uint64_t hash = node_hash(node, hashes, count);
+      ExprEntry *entry = find_shallow(table, hash, node);
+      table->occurrences++;
+      if (entry)
+      {
+        entry->uses++;
+        if (!(node->flags & AST_NODE_IN_ARENA))
+          free_ast_node(node);
+        result = (ConsResult){hash, entry->node, 1};
+      }
+      else
+      {
+        add_entry(table, hash, node);
+        result = (ConsResult){hash, node, 1};
+      }
+    }
+  }
+
+  if (walk->count == walk->capacity)
+  {
+    walk->capacity = walk->capacity ? walk->capacity * 2 : 64;
+    walk->results = xrealloc(walk->results, walk->capacity * sizeof(ConsResult));
+  }
+  walk->results[walk->count++] = result;
+  return AST_WALK_CONTINUE;
+}
+
+ASTNode *hash_cons_ast(ExprTable *table, ASTNode *root)
+{
+  if (!root)
+    return NULL;
+  ConsWalk walk = {table, NULL, 0, 0};
+  ASTVisitor visitor = {cons_enter, cons_leave, &walk};
+  ast_walk(root, &visitor);
+  ASTNode *result = walk.results[0].node;
+  free(walk.results);
+  return result;
+}
@@ -121,38 +121,42 @@ char *comptime_value_to_string(ComptimeValue *value)
 //-----------------------------------------------------------
 // Check if an expression can be evaluated at compile time
 //-----------------------------------------------------------
-bool is_comptime_expr(ASTNode *expr)
+static ASTWalkAction comptime_check_enter(ASTNode *expr, ASTNode *parent, void *context)
 {
-    if (!expr)
-        return false;
-
+    (void)parent;
+    (void)context;
     switch (expr->type)
     {
     case AST_LITERAL:
-        return true;
-
-    case AST_IDENTIFIER:
-        // Only const variables can be comptime.
-        // TODO: Look up in symbol table and check if const.
-        return false;
+        return AST_WALK_CONTINUE;
 
     case AST_BINARY_EXPR:
-        return is_comptime_expr(expr->data.binary_expr.left) &&
-               is_comptime_expr(expr->data.binary_expr.right);
+        if (!expr->data.binary_expr.left || !expr->data.binary_expr.right)
+            return AST_WALK_STOP;
+        return AST_WALK_CONTINUE;
 
     case AST_UNARY_EXPR:
-        return is_comptime_expr(expr->data.unary_expr.operand);
+        return expr->data.unary_expr.operand ? AST_WALK_CONTINUE : AST_WALK_STOP;
 
+    case AST_IDENTIFIER:
+        // Only const variables can be comptime.
+        // TODO: Look up in symbol table and check if const.
     case AST_FUNC_CALL:
         // Only comptime functions can be evaluated at compile time.
         // TODO: Look up function and check if comptime.
-        return false;
-
     default:
-        return false;
+        return AST_WALK_STOP;
     }
 }
 
+bool is_comptime_expr(ASTNode *expr)
+{
+    if (!expr)
+        return false;
+    ASTVisitor visitor = {comptime_check_enter, NULL, NULL};
+    return ast_walk(expr, &visitor);
+}
+
 //-----------------------------------------------------------
 // Convert a literal to a comptime value
 //-----------------------------------------------------------
@@ -205,6 +209,78 @@ ComptimeValue *literal_to_comptime_value(const char *literal_value, Type *type)
     return value;
 }
 
+//-----------------------------------------------------------
+// Convert an already parsed literal value to a comptime value
+//-----------------------------------------------------------
+ComptimeValue *literal_value_to_comptime_value(const LiteralValue *literal, Type *type)
+{
+    ComptimeValue *value = create_comptime_value(type);
+    if (!value)
+        return NULL;
+
+    switch (literal->kind)
+    {
+    case LITERAL_INT:
+        value->value.i_val = literal->as.integer;
+        break;
+    case LITERAL_FLOAT:
+        value->value.f_val = literal->as.real;
+        break;
+    case LITERAL_BOOL:
+        value->value.b_val = literal->as.boolean;
+        break;
+    case LITERAL_STRING:
+        value->value.s_val = strndup(literal->as.string.text, literal->as.string.length);
+        break;
+    default:
+        fprintf(stderr, "Unsupported literal type for comptime evaluation\n");
+        free_comptime_value(value);
+        return NULL;
+    }
+    return value;
+}
+
+//-----------------------------------------------------------
+// Build a literal node holding a comptime value. The parsed value is set
+// directly so it does not round-trip through text.
+//-----------------------------------------------------------
+static ASTNode *comptime_value_to_literal(ComptimeValue *value)
+{
+    char *str_value = comptime_value_to_string(value);
+    ASTNode *literal = create_literal(str_value);
+    free(str_value);
+
+    LiteralValue *parsed = &literal->data.literal.parsed;
+    if (parsed->kind == LITERAL_STRING)
+        free((char *)parsed->as.string.text);
+    memset(parsed, 0, sizeof(LiteralValue));
+    switch (value->type->kind)
+    {
+    case TYPE_I32:
+    case TYPE_I64:
+        parsed->kind = LITERAL_INT;
+        parsed->as.integer = value->value.i_val;
+        break;
+    case TYPE_F32:
+    case TYPE_F64:
+        parsed->kind = LITERAL_FLOAT;
+        parsed->as.real = value->value.f_val;
+        break;
+    case TYPE_BOOL:
+        parsed->kind = LITERAL_BOOL;
+        parsed->as.boolean = value->value.b_val;
+        break;
+    case TYPE_STRING:
+        parsed->kind = LITERAL_STRING;
+        parsed->as.string.text = strdup(value->value.s_val ? value->value.s_val : "");
+        parsed->as.string.length = strlen(parsed->as.string.text);
+        break;
+    default:
+        break;
+    }
+    return literal;
+}
+
 //-----------------------------------------------------------
 // Evaluate a binary operation at compile time
 //-----------------------------------------------------------
@@ -486,7 +562,7 @@ static ComptimeValue *evaluate_comptime_function_body(ASTNode *func_def, ASTNode
     }
     current_recursion_depth++;
 
-    ASTNode *body = func_def->data.func_def.body;
+    ASTNode *body = func_def_body(func_def);
     if (!body || body->type != AST_BLOCK)
     {
         printf("DEBUG: Invalid function body\n");
@@ -494,18 +570,17 @@ static ComptimeValue *evaluate_comptime_function_body(ASTNode *func_def, ASTNode
         return NULL;
     }
 
-    // Create a new scope for the function
-    SymbolTable *function_scope = create_symbol_table(symbols);
-
     // Check argument count
     if (arg_count != func_def->data.func_def.param_count)
     {
         printf("DEBUG: Argument count mismatch\n");
-        destroy_symbol_table(function_scope);
         current_recursion_depth--;
         return NULL;
     }
 
+    // Open a new scope for the function
+    push_scope(symbols);
+
     // Add each parameter to the function's scope
     for (int i = 0; i < arg_count; i++)
     {
@@ -513,7 +588,7 @@ static ComptimeValue *evaluate_comptime_function_body(ASTNode *func_def, ASTNode
         if (param->type != AST_VAR_DECL)
         {
             printf("DEBUG: Invalid parameter node type\n");
-            destroy_symbol_table(function_scope);
+            pop_scope(symbols);
             current_recursion_depth--;
             return NULL;
         }
@@ -522,183 +597,259 @@ static ComptimeValue *evaluate_comptime_function_body(ASTNode *func_def, ASTNode
         ASTNode *param_decl = create_var_decl(1, param->data.var_decl.identifier,
                                               param->data.var_decl.type_annotation,
                                               args[i]);
-        add_symbol_with_node(function_scope, param->data.var_decl.identifier,
-                             param->data.var_decl.type_annotation, param_decl);
+        add_symbol_atom(symbols, param->data.var_decl.atom,
+                        type_from_string(param->data.var_decl.type_annotation), param_decl);
     }
 
     // Evaluate the function body
-    ComptimeValue *result = evaluate_comptime_block(body, function_scope);
+    ComptimeValue *result = evaluate_comptime_block(body, symbols);
 
     // Cleanup
-    destroy_symbol_table(function_scope);
+    pop_scope(symbols);
     current_recursion_depth--;
     return result;
 }
 
 //-----------------------------------------------------------
 // Evaluate an expression at compile time with a symbol table.
+// The expression is walked iteratively: leaves push their values and
+// operators replace their operands' values with the result, like a stack
+// machine. Any value that cannot be computed stops the walk.
 //-----------------------------------------------------------
-ComptimeValue *evaluate_comptime_expr_with_symbols(ASTNode *expr, SymbolTable *symbols)
+typedef struct
 {
-    if (!expr)
+    SymbolTable *symbols;
+    ComptimeValue **values;
+    size_t count;
+    size_t capacity;
+} ComptimeWalk;
+
+static void push_value(ComptimeWalk *walk, ComptimeValue *value)
+{
+    if (walk->count == walk->capacity)
     {
-        printf("DEBUG: evaluate_comptime_expr_with_symbols called with NULL expr\n");
-        return NULL;
+        walk->capacity = walk->capacity ? walk->capacity * 2 : 16;
+        ComptimeValue **values = realloc(walk->values, walk->capacity * sizeof(ComptimeValue *));
+        if (!values)
+        {
+            fprintf(stderr, "Failed to allocate comptime value stack\n");
+            exit(EXIT_FAILURE);
+        }
+        walk->values = values;
     }
+    walk->values[walk->count++] = value;
+}
 
-    printf("DEBUG: Evaluating expression of type %d with symbols\n", expr->type);
-
-    switch (expr->type)
+static ComptimeValue *evaluate_literal(ASTNode *expr)
+{
+    printf("DEBUG: Converting literal '%s' to comptime value\n", expr->data.literal.value);
+    const LiteralValue *parsed = &expr->data.literal.parsed;
+    if (parsed->kind != LITERAL_NONE)
     {
-    case AST_LITERAL:
+        // Reuse the type semantic analysis gave the literal; all literals are comptime.
+        Type *type = expr->value_type ? type_with_flags(expr->value_type, false, true)
+                                      : get_literal_value_type(parsed);
+        return literal_value_to_comptime_value(parsed, type);
+    }
+    Type *type = get_literal_type(expr->data.literal.value);
+    if (!type)
     {
-        printf("DEBUG: Converting literal '%s' to comptime value\n", expr->data.literal.value);
-        Type *type = get_literal_type(expr->data.literal.value);
-        if (!type)
-        {
-            printf("DEBUG: Failed to get type for literal\n");
-            return NULL;
-        }
-        printf("DEBUG: Got type %s for literal\n", type_to_string(type));
-        return literal_to_comptime_value(expr->data.literal.value, type);
+        printf("DEBUG: Failed to get type for literal\n");
+        return NULL;
     }
+    printf("DEBUG: Got type %s for literal\n", type_to_string(type));
+    return literal_to_comptime_value(expr->data.literal.value, type);
+}
 
-    case AST_IDENTIFIER:
+static ComptimeValue *evaluate_identifier(ASTNode *expr, SymbolTable *symbols)
+{
+    printf("DEBUG: Looking up identifier '%s' in symbol table\n", expr->data.identifier.name);
+    Symbol *sym = lookup_symbol_atom(symbols, expr->data.identifier.atom);
+    if (!sym)
     {
-        printf("DEBUG: Looking up identifier '%s' in symbol table\n", expr->data.identifier.name);
-        Symbol *sym = lookup_symbol(symbols, expr->data.identifier.name);
-        if (!sym)
-        {
-            printf("DEBUG: Symbol '%s' not found\n", expr->data.identifier.name);
-            return NULL;
-        }
+        printf("DEBUG: Symbol '%s' not found\n", expr->data.identifier.name);
+        return NULL;
+    }
 
-        // Check if it's a const variable.
-        if (sym->node && sym->node->type == AST_VAR_DECL && sym->node->data.var_decl.is_const)
-        {
-            printf("DEBUG: Found const variable '%s', evaluating initializer\n", expr->data.identifier.name);
-            return evaluate_comptime_expr_with_symbols(sym->node->data.var_decl.initializer, symbols);
-        }
+    // Check if it's a const variable.
+    if (sym->node && sym->node->type == AST_VAR_DECL && sym->node->data.var_decl.is_const)
+    {
+        printf("DEBUG: Found const variable '%s', evaluating initializer\n", expr->data.identifier.name);
+        return evaluate_comptime_expr_with_symbols(sym->node->data.var_decl.initializer, symbols);
+    }
 
-        printf("DEBUG: Symbol '%s' is not a const variable\n", expr->data.identifier.name);
+    printf("DEBUG: Symbol '%s' is not a const variable\n", expr->data.identifier.name);
+    return NULL;
+}
+
+// Call a comptime function with the values of its arguments.
+static ComptimeValue *evaluate_call(ASTNode *expr, ComptimeValue **arg_values, SymbolTable *symbols)
+{
+    Symbol *sym = lookup_symbol_atom(symbols, expr->data.func_call.atom);
+    int arg_count = expr->data.func_call.arg_count;
+    ASTNode **evaluated_args = malloc(arg_count * sizeof(ASTNode *));
+    if (!evaluated_args)
+    {
+        printf("DEBUG: Failed to allocate memory for evaluated arguments\n");
         return NULL;
     }
 
-    case AST_BINARY_EXPR:
+    // Convert the argument values to literals
+    for (int i = 0; i < arg_count; i++)
+        evaluated_args[i] = comptime_value_to_literal(arg_values[i]);
+
+    // Evaluate the function body
+    ComptimeValue *result = evaluate_comptime_function_body(sym->node, evaluated_args, arg_count, symbols);
+
+    // Clean up the evaluated arguments
+    for (int i = 0; i < arg_count; i++)
+        free_ast(evaluated_args[i]);
+    free(evaluated_args);
+    return result;
+}
+
+static ASTWalkAction comptime_enter(ASTNode *expr, ASTNode *parent, void *context)
+{
+    (void)parent;
+    ComptimeWalk *walk = context;
+    printf("DEBUG: Evaluating expression of type %d with symbols\n", expr->type);
+
+    switch (expr->type)
+    {
+    case AST_LITERAL:
+    case AST_IDENTIFIER:
     {
+        ComptimeValue *value = expr->type == AST_LITERAL ? evaluate_literal(expr)
+                                                         : evaluate_identifier(expr, walk->symbols);
+        if (!value)
+            return AST_WALK_STOP;
+        push_value(walk, value);
+        return AST_WALK_CONTINUE;
+    }
+
+    case AST_BINARY_EXPR:
         printf("DEBUG: Evaluating binary expression with operator '%s'\n", expr->data.binary_expr.op);
-        ComptimeValue *left = evaluate_comptime_expr_with_symbols(expr->data.binary_expr.left, symbols);
-        if (!left)
+        if (!expr->data.binary_expr.left || !expr->data.binary_expr.right)
         {
-            printf("DEBUG: Failed to evaluate left operand\n");
-            return NULL;
+            printf("DEBUG: Binary expression is missing an operand\n");
+            return AST_WALK_STOP;
         }
-        ComptimeValue *right = evaluate_comptime_expr_with_symbols(expr->data.binary_expr.right, symbols);
-        if (!right)
-        {
-            printf("DEBUG: Failed to evaluate right operand\n");
-            free_comptime_value(left);
-            return NULL;
-        }
-        ComptimeValue *result = evaluate_comptime_binary_op(expr->data.binary_expr.op, left, right);
-        free_comptime_value(left);
-        free_comptime_value(right);
-        return result;
-    }
+        return AST_WALK_CONTINUE;
 
     case AST_UNARY_EXPR:
-    {
         printf("DEBUG: Evaluating unary expression with operator '%s'\n", expr->data.unary_expr.op);
-        ComptimeValue *operand = evaluate_comptime_expr_with_symbols(expr->data.unary_expr.operand, symbols);
-        if (!operand)
+        if (!expr->data.unary_expr.operand)
         {
-            printf("DEBUG: Failed to evaluate unary operand\n");
-            return NULL;
+            printf("DEBUG: Unary expression is missing its operand\n");
+            return AST_WALK_STOP;
         }
-        ComptimeValue *result = evaluate_comptime_unary_op(expr->data.unary_expr.op, operand);
-        free_comptime_value(operand);
-        return result;
-    }
+        return AST_WALK_CONTINUE;
 
     case AST_FUNC_CALL:
     {
         printf("DEBUG: Evaluating function call to '%s'\n", expr->data.func_call.name);
 
         // Look up the function.
-        Symbol *sym = lookup_symbol(symbols, expr->data.func_call.name);
+        Symbol *sym = lookup_symbol_atom(walk->symbols, expr->data.func_call.atom);
         if (!sym || !sym->node || sym->node->type != AST_FUNC_DEF)
         {
             printf("DEBUG: Function '%s' not found\n", expr->data.func_call.name);
-            return NULL;
+            return AST_WALK_STOP;
         }
 
         // Check if it's a comptime function.
         if (!sym->node->data.func_def.is_comptime)
         {
             printf("DEBUG: Function '%s' is not marked as comptime\n", expr->data.func_call.name);
-            return NULL;
-        }
-
-        // Evaluate each argument
-        ASTNode **evaluated_args = malloc(expr->data.func_call.arg_count * sizeof(ASTNode *));
-        if (!evaluated_args)
-        {
-            printf("DEBUG: Failed to allocate memory for evaluated arguments\n");
-            return NULL;
+            return AST_WALK_STOP;
         }
 
-        // Initialize to NULL so we can clean up properly on error
         for (int i = 0; i < expr->data.func_call.arg_count; i++)
         {
-            evaluated_args[i] = NULL;
-        }
-
-        // Evaluate each argument
-        for (int i = 0; i < expr->data.func_call.arg_count; i++)
-        {
-            ComptimeValue *arg_value = evaluate_comptime_expr_with_symbols(expr->data.func_call.arguments[i], symbols);
-            if (!arg_value)
+            if (!expr->data.func_call.arguments[i])
             {
                 printf("DEBUG: Failed to evaluate argument %d\n", i);
-                // Clean up any arguments we've already evaluated
-                for (int j = 0; j < i; j++)
-                {
-                    if (evaluated_args[j])
-                    {
-                        free_ast(evaluated_args[j]);
-                    }
-                }
-                free(evaluated_args);
-                return NULL;
+                return AST_WALK_STOP;
             }
-
-            // Convert the argument value to a literal
-            char *str_value = comptime_value_to_string(arg_value);
-            evaluated_args[i] = create_literal(str_value);
-            free(str_value);
-            free_comptime_value(arg_value);
         }
+        return AST_WALK_CONTINUE;
+    }
 
-        // Evaluate the function body
-        ComptimeValue *result = evaluate_comptime_function_body(sym->node, evaluated_args, expr->data.func_call.arg_count, symbols);
+    default:
+        printf("DEBUG: Cannot evaluate expression type %d at compile time\n", expr->type);
+        return AST_WALK_STOP;
+    }
+}
 
-        // Clean up the evaluated arguments
-        for (int i = 0; i < expr->data.func_call.arg_count; i++)
-        {
-            if (evaluated_args[i])
-            {
-                free_ast(evaluated_args[i]);
-            }
-        }
-        free(evaluated_args);
+static ASTWalkAction comptime_leave(ASTNode *expr, ASTNode *parent, void *context)
+{
+    (void)parent;
+    ComptimeWalk *walk = context;
+    ComptimeValue *result;
 
-        return result;
+    switch (expr->type)
+    {
+    case AST_BINARY_EXPR:
+    {
+        ComptimeValue *left = walk->values[walk->count - 2];
+        ComptimeValue *right = walk->values[walk->count - 1];
+        result = evaluate_comptime_binary_op(expr->data.binary_expr.op, left, right);
+        free_comptime_value(left);
+        free_comptime_value(right);
+        walk->count -= 2;
+        break;
+    }
+
+    case AST_UNARY_EXPR:
+    {
+        ComptimeValue *operand = walk->values[--walk->count];
+        result = evaluate_comptime_unary_op(expr->data.unary_expr.op, operand);
+        free_comptime_value(operand);
+        break;
+    }
+
+    case AST_FUNC_CALL:
+    {
+        int arg_count = expr->data.func_call.arg_count;
+        ComptimeValue **arg_values = &walk->values[walk->count - arg_count];
+        result = evaluate_call(expr, arg_values, walk->symbols);
+        for (int i = 0; i < arg_count; i++)
+            free_comptime_value(arg_values[i]);
+        walk->count -= arg_count;
+        break;
     }
 
     default:
-        printf("DEBUG: Cannot evaluate expression type %d at compile time\n", expr->type);
+        // Leaves pushed their value when entered.
+        return AST_WALK_CONTINUE;
+    }
+
+    if (!result)
+        return AST_WALK_STOP;
+    push_value(walk, result);
+    return AST_WALK_CONTINUE;
+}
+
+ComptimeValue *evaluate_comptime_expr_with_symbols(ASTNode *expr, SymbolTable *symbols)
+{
+    if (!expr)
+    {
+        printf("DEBUG: evaluate_comptime_expr_with_symbols called with NULL expr\n");
         return NULL;
     }
+
+    ComptimeWalk walk = {symbols, NULL, 0, 0};
+    ASTVisitor visitor = {comptime_enter, comptime_leave, &walk};
+    ComptimeValue *result = NULL;
+    if (ast_walk(expr, &visitor) && walk.count == 1)
+        result = walk.values[0];
+    else
+    {
+        for (size_t i = 0; i < walk.count; i++)
+            free_comptime_value(walk.values[i]);
+    }
+    free(walk.values);
+    return result;
 }
 
 //-----------------------------------------------------------
@@ -0,0 +1,589 @@
+#include "../include/flat_ast.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_NODES 256
+#define INITIAL_EXTRA 256
+#define INITIAL_LITERALS 64
+#define INITIAL_STRINGS 1024
+#define SMALL_LIST 16
+
+static void *xrealloc(void *ptr, size_t size)
+{
+  ptr = realloc(ptr, size);
+  if (!ptr)
+  {
+    fprintf(stderr, "Memory allocation failed for %zu bytes\n", size);
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+FlatAST *create_flat_ast(void)
+{
+  FlatAST *ast = (FlatAST *)xrealloc(NULL, sizeof(FlatAST));
+  ast->node_capacity = INITIAL_NODES;
+  ast->nodes = (FlatNode *)xrealloc(NULL, ast->node_capacity * sizeof(FlatNode));
+  memset(&ast->nodes[FLAT_NONE], 0, sizeof(FlatNode)); // Reserved null node
+  ast->types = (const struct Type **)xrealloc(NULL, ast->node_capacity * sizeof(*ast->types));
+  ast->types[FLAT_NONE] = NULL;
+  ast->node_count = 1;
+  ast->extra_capacity = INITIAL_EXTRA;
+  ast->extra = (uint32_t *)xrealloc(NULL, ast->extra_capacity * sizeof(uint32_t));
+  ast->extra_count = 0;
+  ast->literal_capacity = INITIAL_LITERALS;
+  ast->literals = (FlatLiteral *)xrealloc(NULL, ast->literal_capacity * sizeof(FlatLiteral));
+  ast->literal_count = 0;
+  ast->string_capacity = INITIAL_STRINGS;
+  ast->strings = (char *)xrealloc(NULL, ast->string_capacity);
+  ast->string_size = 0;
+  ast->atom_map = NULL;
+  return ast;
+}
+
+void destroy_flat_ast(FlatAST *ast)
+{
+  if (!ast)
+    return;
+  free(ast->nodes);
+  free(ast->types);
+  free(ast->extra);
+  free(ast->literals);
+  free(ast->strings);
+  free(ast);
+}
+
+size_t flat_ast_memory(const FlatAST *ast)
+{
+  return ast->node_capacity * (sizeof(FlatNode) + sizeof(*ast->types)) + ast->extra_capacity * sizeof(uint32_t) +
+         ast->literal_capacity * sizeof(FlatLiteral) + ast->string_capacity;
+}
+
+//----------------------------------------------------------
+// Building
+//----------------------------------------------------------
+
+static FlatIndex push_node(FlatAST *ast, ASTNodeType tag, uint32_t a, uint32_t b, uint32_t c)
+{
+  if (ast->node_count == ast->node_capacity)
+  {
+    ast->node_capacity *= 2;
+    ast->nodes = (FlatNode *)xrealloc(ast->nodes, ast->node_capacity * sizeof(FlatNode));
+    ast->types = (const struct Type **)xrealloc(ast->types, ast->node_capacity * sizeof(*ast->types));
+  }
+  ast->types[ast->node_count] = NULL;
+  FlatNode *node = &ast->nodes[ast->node_count];
+  node->tag = (uint8_t)tag;
+  node->op = TOKEN_SUB_NONE;
+  node->flags = 0;
+  node->a = a;
+  node->b = b;
+  node->c = c;
+  return ast->node_count++;
+}
+
+// Reserve count words of extra data and return the index of the first.
+static uint32_t reserve_extra(FlatAST *ast, uint32_t count)
+{
+  if (ast->extra_count + count > ast->extra_capacity)
+  {
+    while (ast->extra_count + count > ast->extra_capacity)
+      ast->extra_capacity *= 2;
+    ast->extra = (uint32_t *)xrealloc(ast->extra, ast->extra_capacity * sizeof(uint32_t));
+  }
+  uint32_t start = ast->extra_count;
+  ast->extra_count += count;
+  return start;
+}
+
+// Copy text into the string pool, NUL-terminated, and return its offset.
+static uint32_t push_string(FlatAST *ast, const char *text, size_t length)
+{
+  if (ast->string_size + length + 1 > ast->string_capacity)
+  {
+    while (ast->string_size + length + 1 > ast->string_capacity)
+      ast->string_capacity *= 2;
+    ast->strings = (char *)xrealloc(ast->strings, ast->string_capacity);
+  }
+  uint32_t offset = ast->string_size;
+  memcpy(ast->strings + offset, text, length);
+  ast->strings[offset + length] = '\0';
+  ast->string_size += (uint32_t)length + 1;
+  return offset;
+}
+
+static uint32_t push_literal(FlatAST *ast, const char *text, const LiteralValue *value)
+{
+  if (ast->literal_count == ast->literal_capacity)
+  {
+    ast->literal_capacity *= 2;
+    ast->literals = (FlatLiteral *)xrealloc(ast->literals, ast->literal_capacity * sizeof(FlatLiteral));
+  }
+  size_t length = strlen(text);
+  uint32_t text_offset = push_string(ast, text, length);
+  uint32_t contents = value->kind == LITERAL_STRING ? push_string(ast, value->as.string.text, value->as.string.length) : 0;
+  FlatLiteral *literal = &ast->literals[ast->literal_count];
+  literal->text = text_offset;
+  literal->length = (uint32_t)length;
+  literal->contents = contents;
+  literal->reserved = 0;
+  literal->value = *value;
+  if (value->kind == LITERAL_STRING)
+    literal->value.as.string.text = NULL;
+  return ast->literal_count++;
+}
+
+// Subkind of an operator as spelled in the pointer tree.
+static TokenSubkind operator_subkind(const char *op)
+{
+  size_t length = strlen(op);
+  TokenSubkind subkind = classify_keyword(op, length);
+  if (subkind != TOKEN_SUB_NONE)
+    return subkind;
+  size_t op_length = 0;
+  subkind = classify_operator(op, length, &op_length);
+  return op_length == length ? subkind : TOKEN_SUB_NONE;
+}
+
+static Atom text_atom(const char *text)
+{
+  return text ? intern_cstring(text) : ATOM_NONE;
+}
+
+// Append a run of child indices to extra, preceded by the given header words.
+// Returns the start of the run.
+static uint32_t add_list(FlatAST *ast, const FlatIndex *items, int count, const uint32_t *header, int header_count)
+{
+  uint32_t start = reserve_extra(ast, header_count + count);
+  for (int i = 0; i < header_count; i++)
+    ast->extra[start + i] = header[i];
+  if (count > 0)
+    memcpy(&ast->extra[start + header_count], items, count * sizeof(FlatIndex));
+  return start;
+}
+
+// Append one node whose children are already converted: children[i] is the
+// index of ast_child(node, i), FLAT_NONE where that child is NULL.
+static FlatIndex convert_node(FlatAST *ast, const ASTNode *node, const FlatIndex *children)
+{
+  FlatIndex index;
+  switch (node->type)
+  {
+  case AST_VAR_DECL:
+    index = push_node(ast, AST_VAR_DECL, node->data.var_decl.atom, children[0],
+                      text_atom(node->data.var_decl.type_annotation));
+    ast->nodes[index].flags = (uint16_t)node->data.var_decl.is_const;
+    return index;
+  case AST_PRINT_STMT:
+  case AST_PROMPT_STMT:
+  case AST_EXPR_STMT:
+  case AST_RETURN_STMT:
+  case AST_STRING_INTERP:
+    return push_node(ast, node->type, children[0], 0, 0);
+  case AST_IF_STMT:
+  {
+    // Children: condition, if block, (elif condition, elif block)*, else block
+    int elif_count = node->data.if_stmt.elif_count;
+    uint32_t header[2] = {children[2 + 2 * elif_count], (uint32_t)elif_count};
+    uint32_t extra = add_list(ast, &children[2], 2 * elif_count, header, 2);
+    return push_node(ast, AST_IF_STMT, children[0], children[1], extra);
+  }
+  case AST_WHILE_STMT:
+    return push_node(ast, AST_WHILE_STMT, children[0], children[1], 0);
+  case AST_FOR_STMT:
+  {
+    uint32_t extra = add_list(ast, children, 2, NULL, 0);
+    return push_node(ast, AST_FOR_STMT, node->data.for_stmt.iterator_atom, children[2], extra);
+  }
+  case AST_FUNC_DEF:
+  {
+    int count = node->data.func_def.param_count;
+    uint32_t header[2] = {text_atom(node->data.func_def.return_type), (uint32_t)count};
+    uint32_t extra = add_list(ast, children, count, header, 2);
+    index = push_node(ast, AST_FUNC_DEF, node->data.func_def.atom, children[count], extra);
+    ast->nodes[index].flags = (uint16_t)node->data.func_def.is_comptime;
+    return index;
+  }
+  case AST_BLOCK:
+  case AST_ARRAY_LITERAL:
+  case AST_FSTRING:
+  {
+    int count = ast_child_count(node);
+    uint32_t extra = add_list(ast, children, count, NULL, 0);
+    return push_node(ast, node->type, extra, (uint32_t)count, 0);
+  }
+  case AST_BINARY_EXPR:
+    index = push_node(ast, AST_BINARY_EXPR, children[0], children[1], 0);
+    ast->nodes[index].op = (uint8_t)operator_subkind(node->data.binary_expr.op);
+    return index;
+  case AST_UNARY_EXPR:
+    index = push_node(ast, AST_UNARY_EXPR, children[0], 0, 0);
+    ast->nodes[index].op = (uint8_t)operator_subkind(node->data.unary_expr.op);
+    return index;
+  case AST_LITERAL:
+    return push_node(ast, AST_LITERAL, push_literal(ast, node->data.literal.value, &node->data.literal.parsed), 0, 0);
+  case AST_IDENTIFIER:
+    return push_node(ast, AST_IDENTIFIER, node->data.identifier.atom, 0, 0);
+  case AST_FUNC_CALL:
+  {
+    int count = node->data.func_call.arg_count;
+    uint32_t extra = add_list(ast, children, count, NULL, 0);
+    return push_node(ast, AST_FUNC_CALL, node->data.func_call.atom, extra, (uint32_t)count);
+  }
+  case AST_ASSIGN_EXPR:
+  case AST_ARRAY_INDEX:
+  case AST_CASE_STMT:
+    return push_node(ast, node->type, children[0], children[1], 0);
+  case AST_SWITCH_STMT:
+  {
+    // Children: expression, cases*, finally block
+    int count = node->data.switch_stmt.case_count;
+    uint32_t header[2] = {children[1 + count], (uint32_t)count};
+    uint32_t extra = add_list(ast, &children[1], count, header, 2);
+    return push_node(ast, AST_SWITCH_STMT, children[0], extra, 0);
+  }
+  case AST_STRUCT_DEF:
+  {
+    int count = node->data.struct_def.field_count;
+    uint32_t extra = reserve_extra(ast, 2 * count);
+    for (int i = 0; i < count; i++)
+    {
+      ast->extra[extra + 2 * i] = text_atom(node->data.struct_def.field_names[i]);
+      ast->extra[extra + 2 * i + 1] = text_atom(node->data.struct_def.field_types[i]);
+    }
+    return push_node(ast, AST_STRUCT_DEF, node->data.struct_def.atom, extra, (uint32_t)count);
+  }
+  case AST_FIELD_ACCESS:
+    return push_node(ast, AST_FIELD_ACCESS, children[0], node->data.field_access.field_atom, 0);
+  case AST_BREAK_STMT:
+  case AST_CONTINUE_STMT:
+    return push_node(ast, node->type, 0, 0, 0);
+  }
+  return FLAT_NONE;
+}
+
+// Conversion state: the indices of converted subtrees whose parent has not
+// been left yet, in visiting order.
+typedef struct
+{
+  FlatAST *ast;
+  FlatIndex *indices;
+  size_t count;
+  size_t capacity;
+} FlatBuilder;
+
+static ASTWalkAction add_enter(ASTNode *node, ASTNode *parent, void *context)
+{
+  (void)parent;
+  (void)context;
+  // A deferred body becomes a child once it is parsed.
+  if (node->type == AST_FUNC_DEF)
+    func_def_body(node);
+  return AST_WALK_CONTINUE;
+}
+
+// The indices of the node's non-NULL children are on top of the stack; replace
+// them by the index of the node, which keeps the type semantic analysis gave it.
+static ASTWalkAction add_leave(ASTNode *node, ASTNode *parent, void *context)
+{
+  (void)parent;
+  FlatBuilder *builder = context;
+  int count = ast_child_count(node);
+  FlatIndex small[SMALL_LIST];
+  FlatIndex *children = count <= SMALL_LIST ? small : (FlatIndex *)xrealloc(NULL, count * sizeof(FlatIndex));
+  size_t present = 0;
+  for (int i = 0; i < count; i++)
+    present += ast_child(node, i) != NULL;
+  size_t next = builder->count - present;
+  for (int i = 0; i < count; i++)
+    children[i] = ast_child(node, i) ? builder->indices[next++] : FLAT_NONE;
+  builder->count -= present;
+
+  FlatIndex index = convert_node(builder->ast, node, children);
+  if (children != small)
+    free(children);
+  if (index != FLAT_NONE)
+    builder->ast->types[index] = node->value_type;
+  if (builder->count == builder->capacity)
+  {
+    builder->capacity = builder->capacity ? builder->capacity * 2 : 64;
+    builder->indices = (FlatIndex *)xrealloc(builder->indices, builder->capacity * sizeof(FlatIndex));
+  }
+  builder->indices[builder->count++] = index;
+  return AST_WALK_CONTINUE;
+}
+
+// Converted with ast_walk, so deep trees do not use the native stack.
+FlatIndex flat_ast_add_tree(FlatAST *ast, const ASTNode *root)
+{
+  FlatBuilder builder = {ast, NULL, 0, 0};
+  ASTVisitor visitor = {add_enter, add_leave, &builder};
+  ast_walk((ASTNode *)root, &visitor);
+  FlatIndex index = builder.count ? builder.indices[0] : FLAT_NONE;
+  free(builder.indices);
+  return index;
+}
+
+FlatIndex flat_ast_add_block(FlatAST *ast, const FlatIndex *items, uint32_t count)
+{
+  uint32_t extra = reserve_extra(ast, count);
+  memcpy(&ast->extra[extra], items, count * sizeof(FlatIndex));
+  return push_node(ast, AST_BLOCK, extra, count, 0);
+}
+
+//----------------------------------------------------------
+// Conversion back to pointer trees
+//----------------------------------------------------------
+
+// Children of a flat node, in the order ast_child lists them for the
+// pointer node it stands for.
+static uint32_t flat_child_count(const FlatAST *ast, const FlatNode *node)
+{
+  switch ((ASTNodeType)node->tag)
+  {
+  case AST_VAR_DECL:
+  case AST_PRINT_STMT:
+  case AST_PROMPT_STMT:
+  case AST_EXPR_STMT:
+  case AST_RETURN_STMT:
+  case AST_UNARY_EXPR:
+  case AST_STRING_INTERP:
+  case AST_FIELD_ACCESS:
+    return 1;
+  case AST_WHILE_STMT:
+  case AST_BINARY_EXPR:
+  case AST_ASSIGN_EXPR:
+  case AST_ARRAY_INDEX:
+  case AST_CASE_STMT:
+    return 2;
+  case AST_IF_STMT:
+    return 3 + 2 * ast->extra[node->c + 1];
+  case AST_FOR_STMT:
+    return 3;
+  case AST_FUNC_DEF:
+    return ast->extra[node->c + 1] + 1;
+  case AST_BLOCK:
+  case AST_ARRAY_LITERAL:
+  case AST_FSTRING:
+    return node->b;
+  case AST_FUNC_CALL:
+    return node->c;
+  case AST_SWITCH_STMT:
+    return ast->extra[node->b + 1] + 2;
+  default:
+    return 0;
+  }
+}
+
+static FlatIndex flat_child(const FlatAST *ast, const FlatNode *node, uint32_t i)
+{
+  switch ((ASTNodeType)node->tag)
+  {
+  case AST_VAR_DECL:
+    return node->b;
+  case AST_IF_STMT:
+    if (i < 2)
+      return i == 0 ? node->a : node->b;
+    return i - 2 < 2 * ast->extra[node->c + 1] ? ast->extra[node->c + i] : ast->extra[node->c];
+  case AST_FOR_STMT:
+    return i < 2 ? ast->extra[node->c + i] : node->b;
+  case AST_FUNC_DEF:
+    return i < ast->extra[node->c + 1] ? ast->extra[node->c + 2 + i] : node->b;
+  case AST_BLOCK:
+  case AST_ARRAY_LITERAL:
+  case AST_FSTRING:
+    return ast->extra[node->a + i];
+  case AST_FUNC_CALL:
+    return ast->extra[node->b + i];
+  case AST_SWITCH_STMT:
+    if (i == 0)
+      return node->a;
+    return i <= ast->extra[node->b + 1] ? ast->extra[node->b + 1 + i] : ast->extra[node->b];
+  default:
+    // One or two operands in a and b.
+    return i == 0 ? node->a : node->b;
+  }
+}
+
+// Heap copy of a list of rebuilt children, NULL if it is empty.
+static ASTNode **copy_trees(ASTNode **items, uint32_t count, int stride)
+{
+  if (count == 0)
+    return NULL;
+  ASTNode **copy = (ASTNode **)xrealloc(NULL, count * sizeof(ASTNode *));
+  for (uint32_t i = 0; i < count; i++)
+    copy[i] = items[i * stride];
+  return copy;
+}
+
+static const char *name_text(const FlatAST *ast, uint32_t name)
+{
+  return atom_text(flat_atom(ast, name));
+}
+
+static char *name_or_null(const FlatAST *ast, uint32_t name)
+{
+  Atom atom = flat_atom(ast, name);
+  return atom == ATOM_NONE ? NULL : (char *)atom_text(atom);
+}
+
+// Create the pointer node for a flat node from its rebuilt children, given in
+// flat_child order.
+static ASTNode *build_node(const FlatAST *ast, const FlatNode *node, ASTNode **children)
+{
+  switch ((ASTNodeType)node->tag)
+  {
+  case AST_VAR_DECL:
+    return create_var_decl(node->flags, name_text(ast, node->a), name_or_null(ast, node->c), children[0]);
+  case AST_PRINT_STMT:
+    return create_print_stmt(children[0]);
+  case AST_PROMPT_STMT:
+    return create_prompt_stmt(children[0]);
+  case AST_EXPR_STMT:
+    return create_expr_stmt(children[0]);
+  case AST_RETURN_STMT:
+    return create_return_stmt(children[0]);
+  case AST_STRING_INTERP:
+    return create_string_interp(children[0]);
+  case AST_IF_STMT:
+  {
+    uint32_t elif_count = ast->extra[node->c + 1];
+    return create_if_stmt(children[0], children[1], copy_trees(&children[2], elif_count, 2),
+                          copy_trees(&children[3], elif_count, 2), (int)elif_count, children[2 + 2 * elif_count]);
+  }
+  case AST_WHILE_STMT:
+    return create_while_stmt(children[0], children[1]);
+  case AST_FOR_STMT:
+    return create_for_stmt(name_text(ast, node->a), children[0], children[1], children[2]);
+  case AST_FUNC_DEF:
+  {
+    uint32_t param_count = ast->extra[node->c + 1];
+    return create_func_def(name_text(ast, node->a), copy_trees(children, param_count, 1), (int)param_count,
+                           name_or_null(ast, ast->extra[node->c]), children[param_count], node->flags);
+  }
+  case AST_BLOCK:
+    return create_block(copy_trees(children, node->b, 1), (int)node->b);
+  case AST_ARRAY_LITERAL:
+    return create_array_literal(copy_trees(children, node->b, 1), (int)node->b);
+  case AST_FSTRING:
+    return create_fstring(copy_trees(children, node->b, 1), (int)node->b);
+  case AST_BINARY_EXPR:
+    return create_binary_expr((char *)token_subkind_text(node->op), children[0], children[1]);
+  case AST_UNARY_EXPR:
+    return create_unary_expr((char *)token_subkind_text(node->op), children[0]);
+  case AST_LITERAL:
+  {
+    const FlatLiteral *literal = &ast->literals[node->a];
+    LiteralValue value = flat_literal_value(ast, literal);
+    return create_literal_value(flat_literal_text(ast, literal), literal->length, &value);
+  }
+  case AST_IDENTIFIER:
+    return create_identifier_atom(flat_atom(ast, node->a));
+  case AST_FUNC_CALL:
+    return create_func_call(name_text(ast, node->a), copy_trees(children, node->c, 1), (int)node->c);
+  case AST_ASSIGN_EXPR:
+    return create_assign_expr(children[0], children[1]);
+  case AST_ARRAY_INDEX:
+    return create_array_index(children[0], children[1]);
+  case AST_SWITCH_STMT:
+  {
+    uint32_t case_count = ast->extra[node->b + 1];
+    return create_switch_stmt(children[0], copy_trees(&children[1], case_count, 1), (int)case_count,
+                              children[1 + case_count]);
+  }
+  case AST_CASE_STMT:
+    return create_case_stmt(children[0], children[1]);
+  case AST_STRUCT_DEF:
+  {
+    char *small_names[SMALL_LIST], *small_types[SMALL_LIST];
+    char **names = node->c <= SMALL_LIST ? small_names : (char **)xrealloc(NULL, node->c * sizeof(char *));
+    char **types = node->c <= SMALL_LIST ? small_types : (char **)xrealloc(NULL, node->c * sizeof(char *));
+    for (uint32_t i = 0; i < node->c; i++)
+    {
+      names[i] = (char *)name_text(ast, ast->extra[node->b + 2 * i]);
+      types[i] = (char *)name_text(ast, ast->extra[node->b + 2 * i + 1]);
+    }
+    ASTNode *result = create_struct_def(name_text(ast, node->a), names, types, (int)node->c);
+    if (names != small_names)
+    {
+      free(names);
+      free(types);
+    }
+    return result;
+  }
+  case AST_FIELD_ACCESS:
+    return create_field_access(children[0], name_text(ast, node->b));
+  case AST_BREAK_STMT:
+    return create_break_stmt();
+  case AST_CONTINUE_STMT:
+    return create_continue_stmt();
+  }
+  return NULL;
+}
+
+// A flat node being rebuilt: its children are rebuilt one at a time onto the
+// tree stack, from base up.
+typedef struct
+{
+  FlatIndex index;
+  uint32_t next;
+  uint32_t count;
+  size_t base;
+} BuildFrame;
+
+static void *grow(void *array, size_t *capacity, size_t element_size)
+{
+  *capacity = *capacity ? *capacity * 2 : 64;
+  return xrealloc(array, *capacity * element_size);
+}
+
+// Rebuilt with explicit work stacks, so deep trees do not use the native stack.
+ASTNode *flat_ast_to_tree(const FlatAST *ast, FlatIndex index)
+{
+  if (index == FLAT_NONE)
+    return NULL;
+
+  BuildFrame *frames = NULL;
+  size_t frame_count = 0, frame_capacity = 0;
+  ASTNode **trees = NULL;
+  size_t tree_count = 0, tree_capacity = 0;
+  frames = grow(frames, &frame_capacity, sizeof(BuildFrame));
+  trees = grow(trees, &tree_capacity, sizeof(ASTNode *));
+  frames[frame_count++] = (BuildFrame){index, 0, flat_child_count(ast, &ast->nodes[index]), 0};
+
+  while (frame_count > 0)
+  {
+    BuildFrame *frame = &frames[frame_count - 1];
+    const FlatNode *node = &ast->nodes[frame->index];
+    if (frame->next < frame->count)
+    {
+      FlatIndex child = flat_child(ast, node, frame->next++);
+      if (child == FLAT_NONE)
+      {
+        if (tree_count == tree_capacity)
+          trees = grow(trees, &tree_capacity, sizeof(ASTNode *));
+        trees[tree_count++] = NULL;
+        continue;
+      }
+      if (frame_count == frame_capacity)
+        frames = grow(frames, &frame_capacity, sizeof(BuildFrame));
+      frames[frame_count++] = (BuildFrame){child, 0, flat_child_count(ast, &ast->nodes[child]), tree_count};
+      continue;
+    }
+
+    ASTNode *tree = build_node(ast, node, &trees[frame->base]);
+    if (tree)
+      tree->value_type = flat_type(ast, frame->index);
+    tree_count = frame->base;
+    if (tree_count == tree_capacity)
+      trees = grow(trees, &tree_capacity, sizeof(ASTNode *));
+    trees[tree_count++] = tree;
+    frame_count--;
+  }
+
+  ASTNode *root = trees[0];
+  free(trees);
+  free(frames);
+  return root;
+}
@@ -0,0 +1,242 @@
+#include "../include/intern.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The interner is split into shards selected by hash, each with its own lock,
+// so threads lexing different chunks rarely contend. An atom encodes its shard
+// in the low bits and its index within the shard above them. Entries live in
+// fixed pages that never move, so atom_text needs no lock.
+#define SHARD_BITS 4
+#define SHARD_COUNT (1 << SHARD_BITS)
+#define PAGE_BITS 10
+#define PAGE_SIZE (1 << PAGE_BITS)
+#define MAX_PAGES 4096
+#define TEXT_BLOCK_SIZE (64 * 1024)
+#define INITIAL_SLOTS 1024
+#define RECENT_SIZE 1024
+
+typedef struct
+{
+  const char *text;
+  uint32_t length;
+  uint32_t hash;
+} AtomEntry;
+
+typedef struct
+{
+  pthread_mutex_t lock;
+  AtomEntry *pages[MAX_PAGES];
+  uint32_t count;      // Entries in this shard
+  uint32_t *slots;     // Open-addressing table of entry index + 1 (0 is empty)
+  uint32_t slot_count; // Power of two
+  char *block;         // Current text block
+  size_t block_used;
+  size_t memory;       // Bytes of text and entries
+} InternShard;
+
+static InternShard shards[SHARD_COUNT] = {[0 ... SHARD_COUNT - 1] = {.lock = PTHREAD_MUTEX_INITIALIZER}};
+
+// Per-thread cache of recently interned atoms by hash. Source code repeats the
+// same names constantly, so most lookups are answered here without locking.
+static __thread Atom recent[RECENT_SIZE];
+
+static void *xmalloc(size_t size)
+{
+  void *ptr = malloc(size);
+  if (!ptr)
+  {
+    fprintf(stderr, "Memory allocation failed for %zu bytes\n", size);
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+// FNV-1a.
+static uint32_t hash_text(const char *text, size_t length)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++)
+  {
+    hash ^= (unsigned char)text[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static AtomEntry *shard_entry(InternShard *shard, uint32_t index)
+{
+  return &shard->pages[index >> PAGE_BITS][index & (PAGE_SIZE - 1)];
+}
+
+// Slot holding text, or the empty slot where it belongs. Caller holds the lock.
+static uint32_t *find_slot(InternShard *shard, const char *text, size_t length, uint32_t hash)
+{
+  uint32_t mask = shard->slot_count - 1;
+  uint32_t i = (hash >> SHARD_BITS) & mask;
+  for (;;)
+  {
+    uint32_t *slot = &shard->slots[i];
+    if (*slot == 0)
+      return slot;
+    AtomEntry *entry = shard_entry(shard, *slot - 1);
+    if (entry->hash == hash && entry->length == length && memcmp(entry->text, text, length) == 0)
+      return slot;
+    i = (i + 1) & mask;
+  }
+}
+
+static void grow_slots(InternShard *shard)
+{
+  uint32_t old_count = shard->slot_count;
+  uint32_t *old_slots = shard->slots;
+  shard->slot_count = old_count ? old_count * 2 : INITIAL_SLOTS;
+  shard->slots = xmalloc(shard->slot_count * sizeof(uint32_t));
+  memset(shard->slots, 0, shard->slot_count * sizeof(uint32_t));
+  uint32_t mask = shard->slot_count - 1;
+  for (uint32_t k = 0; k < old_count; k++)
+  {
+    if (old_slots[k] == 0)
+      continue;
+    uint32_t i = (shard_entry(shard, old_slots[k] - 1)->hash >> SHARD_BITS) & mask;
+    while (shard->slots[i] != 0)
+      i = (i + 1) & mask;
+    shard->slots[i] = old_slots[k];
+  }
+  free(old_slots);
+}
+
+// Copy text into the shard's text blocks, NUL-terminated.
+static const char *store_text(InternShard *shard, const char *text, size_t length)
+{
+  char *copy;
+  if (length + 1 > TEXT_BLOCK_SIZE / 4)
+  {
+    copy = xmalloc(length + 1); // Long strings get their own allocation.
+  }
+  else
+  {
+    if (!shard->block || shard->block_used + length + 1 > TEXT_BLOCK_SIZE)
+    {
+      shard->block = xmalloc(TEXT_BLOCK_SIZE);
+      shard->block_used = 0;
+    }
+    copy = shard->block + shard->block_used;
+    shard->block_used += length + 1;
+  }
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+  shard->memory += length + 1;
+  return copy;
+}
+
+static Atom make_atom(uint32_t shard, uint32_t index)
+{
+  return ((index + 1) << SHARD_BITS) | shard;
+}
+
+Atom intern_string(const char *text, size_t length)
+{
+  if (length == 0)
+    return ATOM_NONE;
+  uint32_t hash = hash_text(text, length);
+  Atom *cached = &recent[(hash >> SHARD_BITS) & (RECENT_SIZE - 1)];
+  if (*cached != ATOM_NONE && atom_length(*cached) == length && memcmp(atom_text(*cached), text, length) == 0)
+    return *cached;
+  uint32_t shard_index = hash & (SHARD_COUNT - 1);
+  InternShard *shard = &shards[shard_index];
+
+  pthread_mutex_lock(&shard->lock);
+  // Keep the table at most half full.
+  if ((shard->count + 1) * 2 > shard->slot_count)
+    grow_slots(shard);
+  uint32_t *slot = find_slot(shard, text, length, hash);
+  if (*slot == 0)
+  {
+    uint32_t index = shard->count;
+    if (index >> PAGE_BITS >= MAX_PAGES)
+    {
+      fprintf(stderr, "Too many interned strings\n");
+      exit(EXIT_FAILURE);
+    }
+    if ((index & (PAGE_SIZE - 1)) == 0)
+    {
+      shard->pages[index >> PAGE_BITS] = xmalloc(PAGE_SIZE * sizeof(AtomEntry));
+      shard->memory += PAGE_SIZE * sizeof(AtomEntry);
+    }
+    AtomEntry *entry = shard_entry(shard, index);
+    entry->text = store_text(shard, text, length);
+    entry->length = (uint32_t)length;
+    entry->hash = hash;
+    shard->count++;
+    *slot = index + 1;
+  }
+  Atom atom = make_atom(shard_index, *slot - 1);
+  pthread_mutex_unlock(&shard->lock);
+  *cached = atom;
+  return atom;
+}
+
+Atom intern_cstring(const char *text)
+{
+  return text ? intern_string(text, strlen(text)) : ATOM_NONE;
+}
+
+Atom intern_find(const char *text, size_t length)
+{
+  if (length == 0)
+    return ATOM_NONE;
+  uint32_t hash = hash_text(text, length);
+  uint32_t shard_index = hash & (SHARD_COUNT - 1);
+  InternShard *shard = &shards[shard_index];
+
+  Atom atom = ATOM_NONE;
+  pthread_mutex_lock(&shard->lock);
+  if (shard->slot_count)
+  {
+    uint32_t *slot = find_slot(shard, text, length, hash);
+    if (*slot != 0)
+      atom = make_atom(shard_index, *slot - 1);
+  }
+  pthread_mutex_unlock(&shard->lock);
+  return atom;
+}
+
+const char *atom_text(Atom atom)
+{
+  if (atom == ATOM_NONE)
+    return "";
+  return shard_entry(&shards[atom & (SHARD_COUNT - 1)], (atom >> SHARD_BITS) - 1)->text;
+}
+
+size_t atom_length(Atom atom)
+{
+  if (atom == ATOM_NONE)
+    return 0;
+  return shard_entry(&shards[atom & (SHARD_COUNT - 1)], (atom >> SHARD_BITS) - 1)->length;
+}
+
+size_t intern_count(void)
+{
+  size_t count = 0;
+  for (int k = 0; k < SHARD_COUNT; k++)
+  {
+    pthread_mutex_lock(&shards[k].lock);
+    count += shards[k].count;
+    pthread_mutex_unlock(&shards[k].lock);
+  }
+  return count;
+}
+
+size_t intern_memory(void)
+{
+  size_t memory = 0;
+  for (int k = 0; k < SHARD_COUNT; k++)
+  {
+    pthread_mutex_lock(&shards[k].lock);
+    memory += shards[k].memory + shards[k].slot_count * sizeof(uint32_t);
+    pthread_mutex_unlock(&shards[k].lock);
+  }
+  return memory;
+}
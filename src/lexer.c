@@ -1,10 +1,22 @@
 #include "../include/lexer.h"
+#include "../include/lexer_scan.h"
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-// Defining ZackLang keywords:
+// Inputs at least this large are lexed on multiple threads by tokenize().
+#define PARALLEL_LEX_THRESHOLD (1 << 20)
+// Upper bound on lexer threads (and so on chunks).
+#define MAX_LEX_THREADS 64
+
+// Defining ZackLang keywords (in TokenSubkind order starting at KW_LET):
 const char *KEYWORDS[] = {
     "let", "const", "print", "prompt", "if",
     "else", "elif", "case", "switch", "finally",
@@ -14,18 +26,10 @@ const char *KEYWORDS[] = {
     // Primitive types:
     "i32", "i64", "f32", "f64", "bool",
     "char", "string", "void"};
-#define NUM_KEYWORDS (sizeof(KEYWORDS) / sizeof(KEYWORDS[0]))
-
-// Defining multi-character operators:
-const char *MULTI_CHAR_OPERATORS[] = {"==", "!=", "<=", ">=", "//", "**"};
-#define NUM_OPERATORS (sizeof(MULTI_CHAR_OPERATORS) / sizeof(MULTI_CHAR_OPERATORS[0]))
 
-// Defining single-character operators & symbols:
-const char SINGLE_CHAR_OPERATORS[] = {'+', '-', '*', '/', '%', '=',
-                                      '<', '>', '&', '|', ';', ':',
-                                      '(', ')', '{', '}', '[', ']',
-                                      ','};
-#define NUM_SINGLE_OPERATORS (sizeof(SINGLE_CHAR_OPERATORS) / sizeof(SINGLE_CHAR_OPERATORS[0]))
+// Canonical operator spellings, in TokenSubkind order starting at OP_PLUS:
+static const char *const OPERATORS[] = {"+", "-", "*", "/", "%", "=", "<", ">",
+                                        "&", "|", "==", "!=", "<=", ">=", "**"};
 
 // Error-reporting helper (prints to stderr)
 static void report_error(int line, int col, const char *message)
@@ -33,46 +37,194 @@ static void report_error(int line, int col, const char *message)
   fprintf(stderr, "Lexer Error (line %d, col %d): %s\n", line, col, message);
 }
 
-// Check if a string is a keyword (including primitive types)
-int is_keyword(const char *str)
+// Compare the remainder of a keyword candidate once length and first
+// character have already selected it.
+static TokenSubkind keyword_if(const char *text, const char *keyword, size_t length, TokenSubkind subkind)
+{
+  return memcmp(text + 1, keyword + 1, length - 1) == 0 ? subkind : TOKEN_SUB_NONE;
+}
+
+// Classify a (not necessarily NUL-terminated) span as a keyword. Dispatching
+// on length and first character leaves at most three candidates, each checked
+// with one memcmp.
+TokenSubkind classify_keyword(const char *text, size_t length)
 {
-  printf("DEBUG: Checking if '%s' is a keyword\n", str);
-  for (size_t i = 0; i < NUM_KEYWORDS; i++)
+  switch (length)
   {
-    if (strcmp(str, KEYWORDS[i]) == 0)
+  case 2:
+    switch (text[0])
     {
-      printf("DEBUG: Found keyword match: %s\n", str);
-      return 1; // It's a keyword
+    case 'i':
+      return text[1] == 'f' ? KW_IF : text[1] == 'n' ? KW_IN : TOKEN_SUB_NONE;
+    case 'f':
+      return text[1] == 'n' ? KW_FN : TOKEN_SUB_NONE;
+    case 'o':
+      return text[1] == 'r' ? KW_OR : TOKEN_SUB_NONE;
     }
+    break;
+  case 3:
+    switch (text[0])
+    {
+    case 'l':
+      return keyword_if(text, "let", 3, KW_LET);
+    case 'a':
+      return keyword_if(text, "and", 3, KW_AND);
+    case 'n':
+      return keyword_if(text, "not", 3, KW_NOT);
+    case 'x':
+      return keyword_if(text, "xor", 3, KW_XOR);
+    case 'i':
+      if (text[1] == '3')
+        return text[2] == '2' ? KW_I32 : TOKEN_SUB_NONE;
+      return keyword_if(text, "i64", 3, KW_I64);
+    case 'f':
+      if (text[1] == 'o')
+        return text[2] == 'r' ? KW_FOR : TOKEN_SUB_NONE;
+      if (text[1] == '3')
+        return text[2] == '2' ? KW_F32 : TOKEN_SUB_NONE;
+      return keyword_if(text, "f64", 3, KW_F64);
+    }
+    break;
+  case 4:
+    switch (text[0])
+    {
+    case 'e':
+      if (text[1] == 'l' && text[2] == 's')
+        return text[3] == 'e' ? KW_ELSE : TOKEN_SUB_NONE;
+      return keyword_if(text, "elif", 4, KW_ELIF);
+    case 'c':
+      if (text[1] == 'a')
+        return keyword_if(text, "case", 4, KW_CASE);
+      return keyword_if(text, "char", 4, KW_CHAR);
+    case 't':
+      return keyword_if(text, "true", 4, KW_TRUE);
+    case 'b':
+      return keyword_if(text, "bool", 4, KW_BOOL);
+    case 'v':
+      return keyword_if(text, "void", 4, KW_VOID);
+    }
+    break;
+  case 5:
+    switch (text[0])
+    {
+    case 'c':
+      return keyword_if(text, "const", 5, KW_CONST);
+    case 'p':
+      return keyword_if(text, "print", 5, KW_PRINT);
+    case 'f':
+      return keyword_if(text, "false", 5, KW_FALSE);
+    case 'b':
+      return keyword_if(text, "break", 5, KW_BREAK);
+    case 'w':
+      return keyword_if(text, "while", 5, KW_WHILE);
+    }
+    break;
+  case 6:
+    switch (text[0])
+    {
+    case 'p':
+      return keyword_if(text, "prompt", 6, KW_PROMPT);
+    case 'r':
+      return keyword_if(text, "return", 6, KW_RETURN);
+    case 's':
+      if (text[1] == 'w')
+        return keyword_if(text, "switch", 6, KW_SWITCH);
+      if (text[3] == 'i')
+        return keyword_if(text, "string", 6, KW_STRING);
+      return keyword_if(text, "struct", 6, KW_STRUCT);
+    }
+    break;
+  case 7:
+    return text[0] == 'f' ? keyword_if(text, "finally", 7, KW_FINALLY) : TOKEN_SUB_NONE;
+  case 8:
+    if (text[0] == 'c' && text[1] == 'o' && text[2] == 'n')
+      return keyword_if(text, "continue", 8, KW_CONTINUE);
+    return text[0] == 'c' ? keyword_if(text, "comptime", 8, KW_COMPTIME) : TOKEN_SUB_NONE;
   }
-  printf("DEBUG: Not a keyword: %s\n", str);
-  return 0; // Not a keyword
+  return TOKEN_SUB_NONE;
 }
 
-// Check if a string is a multi-character operator
-int is_multi_char_operator(const char *str)
+// Check if a string is a keyword (including primitive types)
+int is_keyword(const char *str)
 {
-  for (size_t i = 0; i < NUM_OPERATORS; i++)
+  return classify_keyword(str, strlen(str)) != TOKEN_SUB_NONE;
+}
+
+// Classify the operator at the start of text (up to length bytes), preferring
+// the two-character form. Stores the operator's length in op_length.
+TokenSubkind classify_operator(const char *text, size_t length, size_t *op_length)
+{
+  if (length == 0)
+    return TOKEN_SUB_NONE;
+  char next = length > 1 ? text[1] : '\0';
+  *op_length = 2;
+  switch (text[0])
   {
-    if (strcmp(str, MULTI_CHAR_OPERATORS[i]) == 0)
-    {
-      return 1; // It's a multi-character operator
-    }
+  case '=':
+    if (next == '=')
+      return OP_EQ;
+    *op_length = 1;
+    return OP_ASSIGN;
+  case '!':
+    return next == '=' ? OP_NE : TOKEN_SUB_NONE;
+  case '<':
+    if (next == '=')
+      return OP_LE;
+    *op_length = 1;
+    return OP_LT;
+  case '>':
+    if (next == '=')
+      return OP_GE;
+    *op_length = 1;
+    return OP_GT;
+  case '*':
+    if (next == '*')
+      return OP_POWER;
+    *op_length = 1;
+    return OP_STAR;
+  }
+  *op_length = 1;
+  switch (text[0])
+  {
+  case '+':
+    return OP_PLUS;
+  case '-':
+    return OP_MINUS;
+  case '/':
+    return OP_SLASH;
+  case '%':
+    return OP_PERCENT;
+  case '&':
+    return OP_AMP;
+  case '|':
+    return OP_PIPE;
   }
-  return 0; // Not found
+  return TOKEN_SUB_NONE;
+}
+
+// Canonical spelling of a keyword or operator subkind.
+const char *token_subkind_text(TokenSubkind subkind)
+{
+  if (subkind >= KW_LET && subkind <= KW_VOID)
+    return KEYWORDS[subkind - KW_LET];
+  if (subkind >= OP_PLUS && subkind <= OP_POWER)
+    return OPERATORS[subkind - OP_PLUS];
+  return "";
 }
 
-// Check if a character is a single-character operator or symbol
-int is_single_char_operator(char c)
+// Subkind of a token built from text (for tokens added through add_token).
+static TokenSubkind classify_token_text(TokenType type, const char *value)
 {
-  for (size_t i = 0; i < NUM_SINGLE_OPERATORS; i++)
+  size_t length = strlen(value);
+  size_t op_length;
+  if (type == TOKEN_KEYWORD)
+    return classify_keyword(value, length);
+  if (type == TOKEN_OPERATOR)
   {
-    if (SINGLE_CHAR_OPERATORS[i] == c)
-    {
-      return 1; // It's a single-character operator/symbol
-    }
+    TokenSubkind subkind = classify_operator(value, length, &op_length);
+    return op_length == length ? subkind : TOKEN_SUB_NONE;
   }
-  return 0; // Not found
+  return TOKEN_SUB_NONE;
 }
 
 // Initialize tokenArray
@@ -88,11 +240,12 @@ TokenArray create_token_array()
   }
   array.count = 0;
   array.capacity = INITIAL_CAPACITY;
+  array.source = NULL;
   return array;
 }
 
-// Add a token to the tokenArray
-void add_token(TokenArray *array, TokenType type, const char *value, int line, int column)
+// Reserve a slot at the end of the tokenArray.
+static Token *push_token(TokenArray *array)
 {
   if (array->count >= array->capacity)
   {
@@ -104,11 +257,57 @@ void add_token(TokenArray *array, TokenType type, const char *value, int line, i
       exit(1);
     }
   }
-  array->tokens[array->count].type = type;
-  array->tokens[array->count].value = strdup(value);
-  array->tokens[array->count].line = line;
-  array->tokens[array->count].column = column;
-  array->count++;
+  Token *token = &array->tokens[array->count++];
+  memset(token, 0, sizeof(Token));
+  return token;
+}
+
+// Add a token to the tokenArray
+void add_token(TokenArray *array, TokenType type, const char *value, int line, int column)
+{
+  Token *token = push_token(array);
+  token->type = type;
+  token->subkind = classify_token_text(type, value);
+  if (type == TOKEN_IDENTIFIER)
+  {
+    token->atom = intern_cstring(value);
+    token->value = (char *)atom_text(token->atom);
+  }
+  else
+  {
+    token->value = strdup(value);
+  }
+  token->literal = parse_token_literal(type, token->subkind, value, strlen(value));
+  token->offset = 0;
+  token->length = (int)strlen(value);
+  token->line = line;
+  token->column = column;
+}
+
+// Add a token covering code[offset, offset + length). In span mode (no source
+// copy requested) the token only records the span.
+static Token *add_span_token(TokenArray *array, int copy_values, TokenType type, TokenSubkind subkind,
+                             const char *code, size_t offset, size_t length, int line, int column)
+{
+  Token *token = push_token(array);
+  token->literal = parse_token_literal(type, subkind, &code[offset], length);
+  token->type = type;
+  token->subkind = subkind;
+  if (type == TOKEN_IDENTIFIER)
+  {
+    // Identifiers share their interned text instead of owning a copy.
+    token->atom = intern_string(&code[offset], length);
+    token->value = copy_values ? (char *)atom_text(token->atom) : NULL;
+  }
+  else
+  {
+    token->value = copy_values ? strndup(&code[offset], length) : NULL;
+  }
+  token->offset = offset;
+  token->length = (int)length;
+  token->line = line;
+  token->column = column;
+  return token;
 }
 
 // Free the memory allocated for the tokenArray
@@ -116,161 +315,321 @@ void free_token_array(TokenArray *array)
 {
   for (int i = 0; i < array->count; i++)
   {
-    free(array->tokens[i].value);
+    if (array->tokens[i].atom == ATOM_NONE)
+      free(array->tokens[i].value);
   }
   free(array->tokens);
 }
 
-// Forward declaration for recursive tokenization in f-string interpolation.
-TokenArray tokenize(const char *code);
+// Bounds-checked character access: the source is not required to be NUL-terminated.
+#define CH(k) ((size_t)(k) < length ? code[(k)] : '\0')
 
-// Tokenize the input string with robust line/column tracking.
-TokenArray tokenize(const char *code)
+// End of the number starting at code[i] (integer, float or scientific notation).
+static size_t scan_number(const char *code, size_t i, size_t length, int *is_float)
 {
-  TokenArray array = create_token_array();
-  size_t i = 0;
-  int line = 1;
-  int col = 1;
-  int start_col = 1; // Track starting column of current token
+  size_t start = i;
+  int has_dot = 0;
+  int has_e = 0;
+  for (;;)
+  {
+    i = scan_digits(code, i, length);
+    if (!((CH(i) == '.' && !has_dot) ||
+          ((CH(i) == 'e' || CH(i) == 'E') && !has_e) ||
+          ((CH(i) == '+' || CH(i) == '-') && i > start && (code[i - 1] == 'e' || code[i - 1] == 'E'))))
+      break;
 
-  while (code[i] != '\0')
+    if (code[i] == '.')
+    {
+      has_dot = 1;
+    }
+    if (code[i] == 'e' || code[i] == 'E')
+    {
+      has_e = 1;
+      has_dot = 1; // Force float type for scientific notation.
+    }
+    i++;
+  }
+  *is_float = has_dot;
+  return i;
+}
+
+//----------------------------------------------------------
+// Literal values
+//----------------------------------------------------------
+
+static char escaped_char(char c)
+{
+  switch (c)
   {
-    // Skip whitespace and update position.
-    while (isspace(code[i]))
+  case 'n':
+    return '\n';
+  case 't':
+    return '\t';
+  case 'r':
+    return '\r';
+  case '0':
+    return '\0';
+  default:
+    return c; // \\, \", \{ and unknown escapes stand for the character itself.
+  }
+}
+
+// Unescape into out (which may be NULL to only measure). Returns the length.
+static size_t unescape_into(const char *text, size_t length, char *out)
+{
+  size_t n = 0;
+  for (size_t i = 0; i < length; i++)
+  {
+    char c = text[i];
+    if (c == '\\' && i + 1 < length)
+      c = escaped_char(text[++i]);
+    if (out)
+      out[n] = c;
+    n++;
+  }
+  return n;
+}
+
+char *unescape_string(const char *text, size_t length, size_t *out_length)
+{
+  char *result = malloc(length + 1);
+  if (!result)
+  {
+    fprintf(stderr, "Memory allocation failed for string literal\n");
+    exit(1);
+  }
+  size_t n = unescape_into(text, length, result);
+  result[n] = '\0';
+  if (out_length)
+    *out_length = n;
+  return result;
+}
+
+// Decimal digits to int64, saturating (and flagging) on overflow. A leading
+// '-' may use the full negative range.
+static void parse_integer(const char *text, size_t length, int negative, LiteralValue *literal)
+{
+  uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+  uint64_t value = 0;
+  for (size_t i = 0; i < length; i++)
+  {
+    uint64_t digit = (uint64_t)(text[i] - '0');
+    if (value > (limit - digit) / 10)
     {
-      if (code[i] == '\n')
-      {
-        line++;
-        col = 1;
-      }
+      value = limit;
+      literal->overflow = 1;
+      break;
+    }
+    value = value * 10 + digit;
+  }
+  literal->kind = LITERAL_INT;
+  literal->as.integer = negative ? (int64_t)(0 - value) : (int64_t)value;
+}
+
+static void parse_float(const char *text, size_t length, int negative, LiteralValue *literal)
+{
+  char small[64];
+  char *copy = length < sizeof(small) ? small : malloc(length + 1);
+  if (!copy)
+  {
+    fprintf(stderr, "Memory allocation failed for float literal\n");
+    exit(1);
+  }
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+  errno = 0;
+  double value = strtod(copy, NULL);
+  literal->overflow = errno == ERANGE && (value > 1.0 || value < -1.0);
+  if (copy != small)
+    free(copy);
+  literal->kind = LITERAL_FLOAT;
+  literal->as.real = negative ? -value : value;
+}
+
+LiteralValue parse_token_literal(TokenType type, TokenSubkind subkind, const char *text, size_t length)
+{
+  LiteralValue literal;
+  memset(&literal, 0, sizeof(literal));
+  switch (type)
+  {
+  case TOKEN_INTEGER:
+    parse_integer(text, length, 0, &literal);
+    break;
+  case TOKEN_FLOAT:
+    parse_float(text, length, 0, &literal);
+    break;
+  case TOKEN_KEYWORD:
+    if (subkind == KW_TRUE || subkind == KW_FALSE)
+    {
+      literal.kind = LITERAL_BOOL;
+      literal.as.boolean = subkind == KW_TRUE;
+    }
+    break;
+  case TOKEN_STRING:
+    literal.kind = LITERAL_STRING;
+    literal.as.string.has_escapes = memchr(text, '\\', length) != NULL;
+    literal.as.string.length = literal.as.string.has_escapes ? unescape_into(text, length, NULL) : length;
+    break;
+  default:
+    break;
+  }
+  return literal;
+}
+
+// For strings the unescaped contents are a new heap copy owned by the caller.
+LiteralValue parse_literal_text(const char *text, size_t length)
+{
+  LiteralValue literal;
+  memset(&literal, 0, sizeof(literal));
+
+  if (length >= 2 && text[0] == '"' && text[length - 1] == '"')
+  {
+    literal.kind = LITERAL_STRING;
+    literal.as.string.has_escapes = memchr(text + 1, '\\', length - 2) != NULL;
+    literal.as.string.text = unescape_string(text + 1, length - 2, &literal.as.string.length);
+    return literal;
+  }
+
+  TokenSubkind keyword = classify_keyword(text, length);
+  if (keyword == KW_TRUE || keyword == KW_FALSE)
+    return parse_token_literal(TOKEN_KEYWORD, keyword, text, length);
+
+  int negative = length > 0 && text[0] == '-';
+  const char *digits = text + negative;
+  size_t digits_length = length - negative;
+  if (digits_length > 0 &&
+      (isdigit((unsigned char)digits[0]) || (digits[0] == '.' && digits_length > 1 && isdigit((unsigned char)digits[1]))))
+  {
+    int is_float;
+    if (scan_number(digits, 0, digits_length, &is_float) == digits_length)
+    {
+      if (is_float)
+        parse_float(digits, digits_length, negative, &literal);
       else
-      {
-        col++;
-      }
-      i++;
+        parse_integer(digits, digits_length, negative, &literal);
     }
-    if (code[i] == '\0')
-      break;
+  }
+  return literal;
+}
 
-    start_col = col; // Remember where this token starts
+// Push an f-string mode, reporting an error if nesting is too deep.
+static int push_mode(Lexer *lexer, int mode, int line, int col)
+{
+  if (lexer->mode_depth == LEXER_MAX_MODES)
+  {
+    report_error(line, col, "F-strings nested too deeply");
+    return 0;
+  }
+  lexer->modes[lexer->mode_depth++] = mode;
+  return 1;
+}
+
+// Lex the next token of lexer->source into out, with robust line/column
+// tracking. F-strings are lexed in place through the lexer's mode stack: each
+// body part is an FSTRING token and interpolations are lexed as ordinary code
+// until their closing '}'. When copy_values is set each token owns a
+// NUL-terminated copy of its text; otherwise tokens are spans into the
+// source. Returns 0 once the EOF token has been appended.
+static int scan_next(Lexer *lexer, TokenArray *out)
+{
+  const char *code = lexer->source;
+  size_t length = lexer->length;
+  int copy_values = lexer->copy_values;
+  size_t i = lexer->pos;
+  int line = lexer->line;
+  int col = lexer->column;
+  int start_col = col; // Track starting column of current token
+  int emitted = out->count;
+  TokenArray array = *out;
 
-    // f-string literal: check for f" prefix.
-    if (code[i] == 'f' && code[i + 1] == '"')
+  // Comments and f-string delimiters produce no token, so keep going until
+  // something is emitted.
+  while (i < length && array.count == emitted)
+  {
+    // Inside an f-string body: emit the text up to the next interpolation or
+    // the closing quote, then open or close on the next step.
+    if (lexer->mode_depth > 0 && lexer->modes[lexer->mode_depth - 1] == LEXER_MODE_FSTRING)
     {
-      i += 2; // Skip f"
-      col += 2;
-      start_col = col; // Start column is after f"
       size_t start = i;
-      while (code[i] != '"' && code[i] != '\0')
+      int start_line = line;
+      start_col = col;
+      while (CH(i) != '"' && CH(i) != '{' && CH(i) != '\0')
       {
-        if (code[i] == '\n')
+        // Skip the plain run up to the next character that needs attention.
+        size_t plain_end = scan_string_body(code, i, length, 1);
+        if (plain_end != i)
         {
-          line++;
-          col = 1;
+          col += plain_end - i;
+          i = plain_end;
+          continue;
         }
-        else
+
+        if (code[i] == '\\' && CH(i + 1) != '\0')
         {
+          i++;
           col++;
         }
-
-        if (code[i] == '{')
+        if (code[i] == '\n')
         {
-          // Add the string part before the interpolation if it exists.
-          if (i > start)
-          {
-            char *str_part = strndup(&code[start], i - start);
-            add_token(&array, TOKEN_FSTRING, str_part, line, start_col);
-            free(str_part);
-          }
-
-          size_t orig_pos = i; // Remember the original position in the source
-          i++;                 // Skip '{'
-          size_t expr_start = i;
-          int brace_count = 1;
-
-          // Find matching '}'.
-          while (code[i] != '\0' && brace_count > 0)
-          {
-            if (code[i] == '\n')
-            {
-              line++;
-              col = 1;
-            }
-            else
-            {
-              col++;
-            }
-            if (code[i] == '{')
-              brace_count++;
-            if (code[i] == '}')
-              brace_count--;
-            i++;
-          }
-
-          if (brace_count > 0)
-          {
-            report_error(line, col, "Unterminated interpolation in f-string");
-            break;
-          }
-
-          // Back up one position so that we extract the expression correctly.
-          i--;
-          size_t expr_len = i - expr_start;
-          char *expr = strndup(&code[expr_start], expr_len);
-
-          // Tokenize the expression.
-          TokenArray expr_tokens = tokenize(expr);
-          // Add all tokens except the EOF token.
-          // Calculate base column: start_col (after f") + length of string before { - 1
-          int base_col = start_col + (orig_pos - start) - 1; // -1 to align with the opening '{'
-          for (int j = 0; j < expr_tokens.count - 1; j++)
-          {
-            // Calculate the original column position for each token
-            int token_col = base_col + (j * 2); // Each token is separated by a space
-            // If we're on a new line, adjust the column position
-            if (line > 1)
-            {
-              token_col = 8; // Reset to the start of the line plus indentation
-            }
-            add_token(&array, expr_tokens.tokens[j].type, expr_tokens.tokens[j].value, line, token_col);
-          }
-          free_token_array(&expr_tokens);
-          free(expr);
-
-          i++; // Move past the closing '}'
-          start = i;
-          start_col = col; // Update start_col for next string part
-          continue;
+          line++;
+          col = 1;
         }
-
-        // Handle escape sequences.
-        if (code[i] == '\\' && code[i + 1] != '\0')
+        else
         {
-          i++;
           col++;
         }
         i++;
       }
 
-      // Add any remaining string part.
       if (i > start)
       {
-        char *str_part = strndup(&code[start], i - start);
-        add_token(&array, TOKEN_FSTRING, str_part, line, start_col);
-        free(str_part);
+        add_span_token(&array, copy_values, TOKEN_FSTRING, TOKEN_SUB_NONE, code, start, i - start, start_line,
+                       start_col);
+        continue;
       }
-
+      if (CH(i) == '\0')
+        break; // Reported as unterminated below.
       if (code[i] == '"')
       {
-        i++;
-        // Calculate column position after the f-string
-        // It should be: start_col + length of string + length of interpolation + 1 (for closing quote)
-        col = start_col + (i - start) - 2; // -2 to account for f" prefix
+        lexer->mode_depth--;
       }
-      else
+      else if (!push_mode(lexer, 0, line, col))
       {
-        report_error(line, col, "Unterminated f-string");
+        i = length;
+        break;
       }
+      i++;
+      col++;
+      continue;
+    }
+
+    // Skip whitespace and update position.
+    size_t space_end = scan_whitespace(code, i, length);
+    const char *newline;
+    while ((newline = memchr(&code[i], '\n', space_end - i)) != NULL)
+    {
+      line++;
+      col = 1;
+      i = (size_t)(newline - code) + 1;
+    }
+    col += space_end - i;
+    i = space_end;
+    if (CH(i) == '\0')
+      break;
+
+    start_col = col; // Remember where this token starts
+
+    // f-string literal: check for f" prefix. Its body is scanned in
+    // LEXER_MODE_FSTRING on the following steps.
+    if (code[i] == 'f' && CH(i + 1) == '"')
+    {
+      if (!push_mode(lexer, LEXER_MODE_FSTRING, line, col))
+      {
+        i = length;
+        break;
+      }
+      i += 2; // Skip f"
+      col += 2;
       continue;
     }
 
@@ -280,9 +639,17 @@ TokenArray tokenize(const char *code)
       i++;
       col++; // Skip the opening quote.
       size_t start = i;
-      while (code[i] != '"' && code[i] != '\0')
+      while (CH(i) != '"' && CH(i) != '\0')
       {
-        if (code[i] == '\\' && code[i + 1] != '\0')
+        size_t plain_end = scan_string_body(code, i, length, 0);
+        if (plain_end != i)
+        {
+          col += plain_end - i;
+          i = plain_end;
+          continue;
+        }
+
+        if (code[i] == '\\' && CH(i + 1) != '\0')
         {
           i++;
           col++;
@@ -298,166 +665,767 @@ TokenArray tokenize(const char *code)
         }
         i++;
       }
-      if (code[i] == '\0')
+      if (CH(i) == '\0')
       {
         report_error(line, col, "Unterminated string literal");
         break;
       }
-      char *string_val = strndup(&code[start], i - start);
-      add_token(&array, TOKEN_STRING, string_val, line, start_col);
-      free(string_val);
+      add_span_token(&array, copy_values, TOKEN_STRING, TOKEN_SUB_NONE, code, start, i - start, line, start_col);
       i++;
       col++; // Skip the closing quote.
       continue;
     }
 
     // Identifiers & Keywords (start with a letter or underscore).
-    if (isalpha(code[i]) || code[i] == '_')
+    if (isalpha((unsigned char)code[i]) || code[i] == '_')
     {
       size_t start = i;
-      while (isalnum(code[i]) || code[i] == '_')
-      {
-        i++;
-        col++;
-      }
-      char *value = strndup(&code[start], i - start);
-      TokenType type = is_keyword(value) ? TOKEN_KEYWORD : TOKEN_IDENTIFIER;
-      add_token(&array, type, value, line, start_col);
-      free(value);
+      i = scan_identifier(code, i, length);
+      col += i - start;
+      TokenSubkind keyword = classify_keyword(&code[start], i - start);
+      TokenType type = keyword != TOKEN_SUB_NONE ? TOKEN_KEYWORD : TOKEN_IDENTIFIER;
+      add_span_token(&array, copy_values, type, keyword, code, start, i - start, line, start_col);
       continue;
     }
 
     // Numbers (Integers, Floats, and scientific notation).
-    if (isdigit(code[i]) || (code[i] == '.' && isdigit(code[i + 1])))
+    if (isdigit((unsigned char)code[i]) || (code[i] == '.' && isdigit((unsigned char)CH(i + 1))))
     {
       size_t start = i;
-      int has_dot = 0;
-      int has_e = 0;
-      while (isdigit(code[i]) ||
-             (code[i] == '.' && !has_dot) ||
-             ((code[i] == 'e' || code[i] == 'E') && !has_e) ||
-             ((code[i] == '+' || code[i] == '-') && i > start && (code[i - 1] == 'e' || code[i - 1] == 'E')))
+      int is_float;
+      i = scan_number(code, i, length, &is_float);
+      col += i - start;
+      Token *number = add_span_token(&array, copy_values, is_float ? TOKEN_FLOAT : TOKEN_INTEGER, TOKEN_SUB_NONE,
+                                     code, start, i - start, line, start_col);
+      if (number->literal.overflow)
+        report_error(line, start_col, is_float ? "Float literal out of range" : "Integer literal out of range");
+      continue;
+    }
+
+    // Comments run to the end of the line.
+    if (code[i] == '/' && CH(i + 1) == '/')
+    {
+      // Skip until end of line or end of file
+      const char *line_end = memchr(&code[i], '\n', length - i);
+      size_t comment_end = line_end ? (size_t)(line_end - code) : length;
+      comment_end = i + strnlen(&code[i], comment_end - i);
+      col += comment_end - i;
+      i = comment_end;
+      // If we found a newline, process it
+      if (CH(i) == '\n')
       {
-        if (code[i] == '.')
-        {
-          has_dot = 1;
-        }
-        if (code[i] == 'e' || code[i] == 'E')
-        {
-          has_e = 1;
-          has_dot = 1; // Force float type for scientific notation.
-        }
+        line++;
+        col = 1;
         i++;
-        col++;
       }
-      char *num = strndup(&code[start], i - start);
-      add_token(&array, has_dot ? TOKEN_FLOAT : TOKEN_INTEGER, num, line, start_col);
-      free(num);
       continue;
     }
 
-    // Multi-Character Operators.
-    int matched = 0;
-    for (size_t op = 0; op < NUM_OPERATORS; op++)
+    // Operators (two-character forms take precedence).
+    size_t op_length;
+    TokenSubkind op = classify_operator(&code[i], length - i, &op_length);
+    if (op != TOKEN_SUB_NONE)
     {
-      size_t opLen = strlen(MULTI_CHAR_OPERATORS[op]);
-      if (strncmp(&code[i], MULTI_CHAR_OPERATORS[op], opLen) == 0)
-      {
-        // Check for comment
-        if (strcmp(MULTI_CHAR_OPERATORS[op], "//") == 0)
-        {
-          // Skip until end of line or end of file
-          while (code[i] != '\0' && code[i] != '\n')
-          {
-            i++;
-            col++;
-          }
-          // If we found a newline, process it
-          if (code[i] == '\n')
-          {
-            line++;
-            col = 1;
-            i++;
-          }
-          matched = 1;
-          break;
-        }
+      add_span_token(&array, copy_values, TOKEN_OPERATOR, op, code, i, op_length, line, start_col);
+      i += op_length;
+      col += op_length;
+      continue;
+    }
 
-        add_token(&array, TOKEN_OPERATOR, MULTI_CHAR_OPERATORS[op], line, start_col);
-        // Update column (and line if any newline appears in the operator).
-        for (size_t k = 0; k < opLen; k++)
-        {
-          if (code[i + k] == '\n')
-          {
-            line++;
-            col = 1;
-          }
-          else
-          {
-            col++;
-          }
-        }
-        i += opLen;
-        matched = 1;
-        break;
+    // Braces inside an interpolation are counted; the '}' that closes it
+    // returns to the enclosing f-string body.
+    if (lexer->mode_depth > 0 && (code[i] == '{' || code[i] == '}'))
+    {
+      int *braces = &lexer->modes[lexer->mode_depth - 1];
+      if (code[i] == '}' && *braces == 0)
+      {
+        lexer->mode_depth--;
+        i++;
+        col++;
+        continue;
       }
+      *braces += code[i] == '{' ? 1 : -1;
     }
-    if (matched)
-      continue;
 
-    // Single-Character Operators and Symbols.
+    // Punctuation.
     char current = code[i];
+    TokenType single_type;
     switch (current)
     {
     case '(':
-      add_token(&array, TOKEN_LPAREN, "(", line, col);
+      single_type = TOKEN_LPAREN;
       break;
     case ')':
-      add_token(&array, TOKEN_RPAREN, ")", line, col);
+      single_type = TOKEN_RPAREN;
       break;
     case '{':
-      add_token(&array, TOKEN_LBRACE, "{", line, col);
+      single_type = TOKEN_LBRACE;
       break;
     case '}':
-      add_token(&array, TOKEN_RBRACE, "}", line, col);
+      single_type = TOKEN_RBRACE;
       break;
     case '[':
-      add_token(&array, TOKEN_LBRACKET, "[", line, col);
+      single_type = TOKEN_LBRACKET;
       break;
     case ']':
-      add_token(&array, TOKEN_RBRACKET, "]", line, col);
+      single_type = TOKEN_RBRACKET;
       break;
     case ';':
-      add_token(&array, TOKEN_SEMICOLON, ";", line, col);
+      single_type = TOKEN_SEMICOLON;
       break;
     case ':':
-      add_token(&array, TOKEN_COLON, ":", line, col);
+      single_type = TOKEN_COLON;
       break;
     case ',':
-      add_token(&array, TOKEN_COMMA, ",", line, col);
+      single_type = TOKEN_COMMA;
       break;
     default:
-      if (is_single_char_operator(current))
+      single_type = TOKEN_EOF;
+      break;
+    }
+    if (single_type != TOKEN_EOF)
+    {
+      add_span_token(&array, copy_values, single_type, TOKEN_SUB_NONE, code, i, 1, line, col);
+    }
+    else
+    {
+      char err_msg[64];
+      snprintf(err_msg, sizeof(err_msg), "Unexpected character '%c'", current);
+      report_error(line, col, err_msg);
+    }
+    i++;
+    col++;
+  }
+
+  int more = array.count != emitted;
+  // Tokens inside an f-string are not lexeme starts, so re-lexing can never
+  // restart from them.
+  if (more && lexer->mode_depth > 0)
+    array.tokens[emitted].in_fstring = 1;
+  if (!more)
+  {
+    if (lexer->mode_depth > 0)
+    {
+      int in_body = lexer->modes[lexer->mode_depth - 1] == LEXER_MODE_FSTRING;
+      report_error(line, col, in_body ? "Unterminated f-string" : "Unterminated interpolation in f-string");
+      lexer->mode_depth = 0;
+    }
+    // Append end-of-file token.
+    if (copy_values)
+    {
+      add_token(&array, TOKEN_EOF, "EOF", line, col);
+      array.tokens[array.count - 1].offset = length;
+    }
+    else
+    {
+      add_span_token(&array, copy_values, TOKEN_EOF, TOKEN_SUB_NONE, code, length, 0, line, col);
+    }
+  }
+
+  *out = array;
+  lexer->pos = i;
+  lexer->line = line;
+  lexer->column = col;
+  return more;
+}
+
+// Scanner state positioned at the start of code[0, length).
+static Lexer scanner_at(const char *code, size_t length, int copy_values)
+{
+  Lexer lexer;
+  memset(&lexer, 0, sizeof(lexer));
+  lexer.source = code;
+  lexer.length = length;
+  lexer.line = 1;
+  lexer.column = 1;
+  lexer.copy_values = copy_values;
+  return lexer;
+}
+
+// Tokenize all of code[0, length).
+static TokenArray tokenize_range(const char *code, size_t length, int copy_values)
+{
+  TokenArray array = create_token_array();
+  array.source = copy_values ? NULL : code;
+  Lexer scanner = scanner_at(code, length, copy_values);
+  while (scan_next(&scanner, &array))
+    ;
+  return array;
+}
+
+//----------------------------------------------------------
+// Parallel chunked lexing
+//----------------------------------------------------------
+
+// Where a chunk starts: just after a newline that is outside every literal
+// and comment, with the line the lexer is on there.
+typedef struct
+{
+  size_t pos;
+  int line;
+} ChunkStart;
+
+// Whether code[target] begins a lexeme when lexing resumes at the lexeme start
+// `from`. Only identifiers, numbers, operators and whitespace lie in between.
+static int starts_lexeme(const char *code, size_t from, size_t target, size_t length)
+{
+  size_t i = from;
+  while (i < target)
+  {
+    int is_float;
+    if (isalpha((unsigned char)code[i]) || code[i] == '_')
+      i = scan_identifier(code, i, length);
+    else if (isdigit((unsigned char)code[i]) || (code[i] == '.' && isdigit((unsigned char)CH(i + 1))))
+      i = scan_number(code, i, length, &is_float);
+    else
+      i++; // Whitespace and operator characters (no two-character operator ends in 'f').
+  }
+  return i == target;
+}
+
+// Skip a string body starting after the opening quote, exactly as the lexer
+// does, counting newlines. Returns the position after the closing quote, or
+// length if the string is unterminated (which ends lexing).
+static size_t skip_string(const char *code, size_t i, size_t length, int *line)
+{
+  while (CH(i) != '"' && CH(i) != '\0')
+  {
+    if (code[i] == '\\' && CH(i + 1) != '\0')
+      i++;
+    if (code[i] == '\n')
+      (*line)++;
+    i++;
+  }
+  return CH(i) == '"' ? i + 1 : length;
+}
+
+// Skip f-string text, as the lexer does, counting newlines. Returns the
+// position of the '{' or closing quote that ends it, or of the end of input.
+static size_t skip_fstring_body(const char *code, size_t i, size_t length, int *line)
+{
+  while (CH(i) != '"' && CH(i) != '{' && CH(i) != '\0')
+  {
+    if (code[i] == '\\' && CH(i + 1) != '\0')
+      i++;
+    if (code[i] == '\n')
+      (*line)++;
+    i++;
+  }
+  return i;
+}
+
+// Pre-pass: find up to max_chunks chunk starts, each at the first top-level
+// newline past an even split of the input. Only literal and comment state is
+// tracked, so this is much cheaper than lexing. Returns the number of chunks.
+static int plan_chunks(const char *code, size_t length, int max_chunks, ChunkStart *starts)
+{
+  int count = 1;
+  starts[0].pos = 0;
+  starts[0].line = 1;
+  size_t target = length / max_chunks;
+  size_t i = 0;
+  size_t lexeme_start = 0; // A position known to begin a lexeme
+  int line = 1;
+  int modes[LEXER_MAX_MODES]; // F-string mode stack, as in Lexer
+  int depth = 0;
+
+  while (i < length && count < max_chunks)
+  {
+    char c = code[i];
+    if (depth > 0 && modes[depth - 1] == LEXER_MODE_FSTRING)
+    {
+      i = skip_fstring_body(code, i, length, &line);
+      if (CH(i) == '"')
+        depth--;
+      else if (CH(i) == '{' && depth < LEXER_MAX_MODES)
+        modes[depth++] = 0;
+      else
+        return CH(i) == '\0' ? count : 1; // Too deep: the lexer stops here.
+      lexeme_start = ++i;
+    }
+    else if (c == '\n')
+    {
+      line++;
+      lexeme_start = ++i;
+      if (depth == 0 && i >= target && i < length)
       {
-        char op_single[2] = {current, '\0'};
-        add_token(&array, TOKEN_OPERATOR, op_single, line, col);
+        starts[count].pos = i;
+        starts[count].line = line;
+        count++;
+        target = length / max_chunks * count;
+      }
+    }
+    else if (c == '"')
+    {
+      if (i > lexeme_start && code[i - 1] == 'f' && starts_lexeme(code, lexeme_start, i - 1, length))
+      {
+        if (depth == LEXER_MAX_MODES)
+          return 1;
+        modes[depth++] = LEXER_MODE_FSTRING;
+        i++;
       }
       else
       {
-        char err_msg[64];
-        snprintf(err_msg, sizeof(err_msg), "Unexpected character '%c'", current);
-        report_error(line, col, err_msg);
+        i = skip_string(code, i + 1, length, &line);
       }
+      lexeme_start = i;
+    }
+    else if (depth > 0 && (c == '{' || c == '}'))
+    {
+      if (c == '}' && modes[depth - 1] == 0)
+        depth--;
+      else
+        modes[depth - 1] += c == '{' ? 1 : -1;
+      lexeme_start = ++i;
+    }
+    else if (c == '/' && CH(i + 1) == '/')
+    {
+      const char *line_end = memchr(&code[i], '\n', length - i);
+      i = line_end ? (size_t)(line_end - code) : length;
+      lexeme_start = i;
+    }
+    else if (c == '\0')
+    {
+      break; // The lexer stops at a NUL byte.
+    }
+    else
+    {
+      i++;
+    }
+  }
+  return count;
+}
+
+typedef struct
+{
+  const char *code;
+  size_t start;
+  size_t end;
+  int line;
+  int copy_values;
+  TokenArray tokens;
+} LexChunk;
+
+static void *lex_chunk(void *arg)
+{
+  LexChunk *chunk = arg;
+  Lexer scanner = scanner_at(chunk->code, chunk->end, chunk->copy_values);
+  scanner.pos = chunk->start;
+  scanner.line = chunk->line;
+  chunk->tokens = create_token_array();
+  while (scan_next(&scanner, &chunk->tokens))
+    ;
+  return NULL;
+}
+
+// Lex code[0, length) on up to thread_count threads and stitch the per-chunk
+// token arrays together. The result is identical to tokenize_range.
+static TokenArray tokenize_chunked(const char *code, size_t length, int copy_values, int thread_count)
+{
+  if (thread_count > MAX_LEX_THREADS)
+    thread_count = MAX_LEX_THREADS;
+  ChunkStart starts[MAX_LEX_THREADS];
+  int chunk_count = thread_count > 1 ? plan_chunks(code, length, thread_count, starts) : 1;
+  if (chunk_count == 1)
+    return tokenize_range(code, length, copy_values);
+
+  LexChunk chunks[MAX_LEX_THREADS];
+  pthread_t threads[MAX_LEX_THREADS];
+  for (int k = 0; k < chunk_count; k++)
+  {
+    chunks[k].code = code;
+    chunks[k].start = starts[k].pos;
+    chunks[k].end = k + 1 < chunk_count ? starts[k + 1].pos : length;
+    chunks[k].line = starts[k].line;
+    chunks[k].copy_values = copy_values;
+    // The first chunk runs on the calling thread.
+    if (k > 0 && pthread_create(&threads[k], NULL, lex_chunk, &chunks[k]) != 0)
+    {
+      fprintf(stderr, "Failed to start lexer thread\n");
+      exit(1);
+    }
+  }
+  lex_chunk(&chunks[0]);
+  for (int k = 1; k < chunk_count; k++)
+    pthread_join(threads[k], NULL);
+
+  // Stitch: every chunk but the last ends with an EOF token to drop.
+  int total = 0;
+  for (int k = 0; k < chunk_count; k++)
+    total += chunks[k].tokens.count - (k + 1 < chunk_count);
+  TokenArray array = chunks[0].tokens;
+  if (total > array.capacity)
+  {
+    array.capacity = total;
+    array.tokens = realloc(array.tokens, array.capacity * sizeof(Token));
+    if (!array.tokens)
+    {
+      fprintf(stderr, "Memory allocation failed for expanding TokenArray\n");
+      exit(1);
+    }
+  }
+  array.count--;
+  free(array.tokens[array.count].value);
+  for (int k = 1; k < chunk_count; k++)
+  {
+    int count = chunks[k].tokens.count;
+    if (k + 1 < chunk_count)
+      free(chunks[k].tokens.tokens[--count].value);
+    memcpy(&array.tokens[array.count], chunks[k].tokens.tokens, count * sizeof(Token));
+    array.count += count;
+    free(chunks[k].tokens.tokens);
+  }
+  array.source = copy_values ? NULL : code;
+  return array;
+}
+
+#undef CH
+
+// Tokenize the input string with robust line/column tracking.
+TokenArray tokenize(const char *code)
+{
+  size_t length = strlen(code);
+  if (length >= PARALLEL_LEX_THRESHOLD)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return tokenize_chunked(code, length, 1, cpus > 1 ? (int)cpus : 1);
+  }
+  return tokenize_range(code, length, 1);
+}
+
+// Tokenize without copying: every token is a span into code.
+TokenArray tokenize_source(const char *code, size_t length)
+{
+  return tokenize_range(code, length, 0);
+}
+
+// Zero-copy tokenize on up to thread_count threads.
+TokenArray tokenize_parallel(const char *code, size_t length, int thread_count)
+{
+  return tokenize_chunked(code, length, 0, thread_count);
+}
+
+// Apply an edit to source, returning the new heap-allocated, NUL-terminated
+// buffer and its length.
+char *apply_source_edit(const char *source, size_t length, const SourceEdit *edit, size_t *new_length)
+{
+  size_t offset = edit->offset < length ? edit->offset : length;
+  size_t removed = edit->removed_length < length - offset ? edit->removed_length : length - offset;
+  size_t total = length - removed + edit->inserted_length;
+  char *buffer = malloc(total + 1);
+  if (!buffer)
+  {
+    fprintf(stderr, "Memory allocation failed for edited source\n");
+    exit(1);
+  }
+  memcpy(buffer, source, offset);
+  memcpy(buffer + offset, edit->inserted, edit->inserted_length);
+  memcpy(buffer + offset + edit->inserted_length, source + offset + removed, length - offset - removed);
+  buffer[total] = '\0';
+  *new_length = total;
+  return buffer;
+}
+
+// Whether the scanner can restart at this token: string tokens record the line
+// their literal ends on and f-string tokens belong to an enclosing literal.
+static int is_restart_token(const Token *token)
+{
+  return token->type != TOKEN_STRING && token->type != TOKEN_EOF && !token->in_fstring;
+}
+
+// Index of the first token at or after offset.
+static int first_token_at(const TokenArray *array, size_t offset)
+{
+  int lo = 0;
+  int hi = array->count;
+  while (lo < hi)
+  {
+    int mid = lo + (hi - lo) / 2;
+    if (array->tokens[mid].offset < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static Token *copy_token(TokenArray *array, const Token *token, int copy_values)
+{
+  Token *copy = push_token(array);
+  *copy = *token;
+  if (token->atom == ATOM_NONE)
+    copy->value = copy_values && token->value ? strdup(token->value) : NULL;
+  else
+    copy->value = copy_values ? (char *)atom_text(token->atom) : NULL;
+  return copy;
+}
+
+// Re-lex source (old's source with edit applied) reusing old's tokens. Scanning
+// restarts at the last lexeme that ends before the edit and stops as soon as a
+// new token lines up with an old one past the edit; the rest of the old tokens
+// are copied with their offsets and lines shifted. Columns are only shifted on
+// the line the streams sync on. The result owns copies of token text if old
+// did, otherwise it holds spans into source. If relexed_count is non-NULL it
+// receives the number of tokens actually scanned.
+TokenArray retokenize(const TokenArray *old, const char *source, size_t length,
+                      const SourceEdit *edit, int *relexed_count)
+{
+  int copy_values = old->source == NULL;
+  size_t edit_end = edit->offset + edit->inserted_length;
+  ptrdiff_t delta = (ptrdiff_t)edit->inserted_length - (ptrdiff_t)edit->removed_length;
+  if (edit_end > length || old->count == 0)
+  {
+    TokenArray array = tokenize_range(source, length, copy_values);
+    if (relexed_count)
+      *relexed_count = array.count;
+    return array;
+  }
+
+  TokenArray array = create_token_array();
+  array.source = copy_values ? NULL : source;
+  Lexer scanner = scanner_at(source, length, copy_values);
+
+  // A lexeme's extent depends on the character after it, so the restart token
+  // must end strictly before the edit.
+  int restart = first_token_at(old, edit->offset) - 1;
+  while (restart >= 0 && !(is_restart_token(&old->tokens[restart]) &&
+                           old->tokens[restart].offset + old->tokens[restart].length < edit->offset))
+    restart--;
+  if (restart >= 0)
+  {
+    for (int k = 0; k < restart; k++)
+      copy_token(&array, &old->tokens[k], copy_values);
+    scanner.pos = old->tokens[restart].offset;
+    scanner.line = old->tokens[restart].line;
+    scanner.column = old->tokens[restart].column;
+  }
+
+  int relexed = 0;
+  int next_old = first_token_at(old, edit->offset + edit->removed_length);
+  for (;;)
+  {
+    int first = array.count;
+    int more = scan_next(&scanner, &array);
+    relexed += array.count - first;
+    if (!more)
       break;
+
+    // Sync only at a lexeme start past the edit that matches an old token.
+    Token *token = &array.tokens[first];
+    if (!is_restart_token(token) || token->offset < edit_end)
+      continue;
+    size_t old_offset = (size_t)((ptrdiff_t)token->offset - delta);
+    while (next_old < old->count && old->tokens[next_old].offset < old_offset)
+      next_old++;
+    if (next_old == old->count)
+      continue;
+    const Token *match = &old->tokens[next_old];
+    if (match->offset != old_offset || match->type != token->type ||
+        match->subkind != token->subkind || match->length != token->length || !is_restart_token(match))
+      continue;
+
+    const char *newline = memchr(&source[token->offset], '\n', length - token->offset);
+    size_t line_end = newline ? (size_t)(newline - source) : length;
+    int line_delta = token->line - match->line;
+    int column_delta = token->column - match->column;
+    if (token->atom == ATOM_NONE)
+      free(token->value);
+    array.count = first;
+    relexed--;
+    for (int k = next_old; k < old->count; k++)
+    {
+      Token *copy = copy_token(&array, &old->tokens[k], copy_values);
+      copy->offset = (size_t)((ptrdiff_t)copy->offset + delta);
+      copy->line += line_delta;
+      size_t start = copy->type == TOKEN_STRING ? copy->offset - 1 : copy->offset;
+      if (start <= line_end)
+        copy->column += column_delta;
     }
-    i++;
-    col++;
+    break;
   }
 
-  add_token(&array, TOKEN_EOF, "EOF", line, col); // Append end-of-file token.
+  if (relexed_count)
+    *relexed_count = relexed;
   return array;
 }
 
+// Create a streaming lexer over source[0, length). Tokens are spans into
+// source, which must outlive the lexer.
+Lexer *create_lexer(const char *source, size_t length)
+{
+  Lexer *lexer = malloc(sizeof(Lexer));
+  if (!lexer)
+  {
+    fprintf(stderr, "Memory allocation failed for lexer\n");
+    exit(1);
+  }
+  *lexer = scanner_at(source, length, 0);
+  lexer->pending = create_token_array();
+  lexer->pending.source = source;
+  return lexer;
+}
+
+void destroy_lexer(Lexer *lexer)
+{
+  if (!lexer)
+    return;
+  free_token_array(&lexer->pending);
+  free(lexer);
+}
+
+// Top up the ring buffer, lexing further only when the pending tokens of the
+// last lexeme have all been moved in. Stops after the EOF token.
+static void lexer_fill(Lexer *lexer)
+{
+  while (lexer->ring_count < LEXER_LOOKAHEAD)
+  {
+    if (lexer->pending_next == lexer->pending.count)
+    {
+      if (lexer->finished)
+        return;
+      lexer->pending.count = 0;
+      lexer->pending_next = 0;
+      lexer->finished = !scan_next(lexer, &lexer->pending);
+    }
+    int slot = (lexer->ring_head + lexer->ring_count) % LEXER_LOOKAHEAD;
+    lexer->ring[slot] = lexer->pending.tokens[lexer->pending_next++];
+    lexer->ring_count++;
+  }
+}
+
+// Look k tokens ahead (0 is the next token) without consuming anything.
+// Looking past the end yields the EOF token.
+Token lexer_peek_token(Lexer *lexer, int k)
+{
+  if (k < 0 || k >= LEXER_LOOKAHEAD)
+  {
+    fprintf(stderr, "Lexer lookahead %d out of range (max %d)\n", k, LEXER_LOOKAHEAD - 1);
+    exit(1);
+  }
+  lexer_fill(lexer);
+  if (k >= lexer->ring_count)
+    k = lexer->ring_count - 1;
+  return lexer->ring[(lexer->ring_head + k) % LEXER_LOOKAHEAD];
+}
+
+// Consume and return the next token. The EOF token is never consumed, so
+// calling this at the end keeps returning it.
+Token lexer_next_token(Lexer *lexer)
+{
+  Token token = lexer_peek_token(lexer, 0);
+  if (token.type != TOKEN_EOF)
+  {
+    lexer->ring_head = (lexer->ring_head + 1) % LEXER_LOOKAHEAD;
+    lexer->ring_count--;
+  }
+  return token;
+}
+
+// Text of a token produced by a streaming lexer.
+const char *lexer_token_text(const Lexer *lexer, const Token *token)
+{
+  return token->value ? token->value : lexer->source + token->offset;
+}
+
+// Map a file read-only into memory. Empty files and files that cannot be
+// mapped (pipes, special files) are read into a heap buffer instead.
+int source_buffer_open(SourceBuffer *buffer, const char *path)
+{
+  buffer->data = NULL;
+  buffer->length = 0;
+  buffer->is_mapped = 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+  {
+    fprintf(stderr, "Failed to open source file '%s'\n", path);
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+  {
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED)
+    {
+      buffer->data = data;
+      buffer->length = (size_t)st.st_size;
+      buffer->is_mapped = 1;
+      close(fd);
+      return 0;
+    }
+  }
+
+  // Fallback: read the whole file.
+  size_t capacity = 4096;
+  char *data = malloc(capacity);
+  if (!data)
+  {
+    fprintf(stderr, "Memory allocation failed for source buffer\n");
+    exit(1);
+  }
+  ssize_t n;
+  while ((n = read(fd, data + buffer->length, capacity - buffer->length)) > 0)
+  {
+    buffer->length += (size_t)n;
+    if (buffer->length == capacity)
+    {
+      capacity *= 2;
+      data = realloc(data, capacity);
+      if (!data)
+      {
+        fprintf(stderr, "Memory allocation failed for source buffer\n");
+        exit(1);
+      }
+    }
+  }
+  close(fd);
+  if (n < 0)
+  {
+    fprintf(stderr, "Failed to read source file '%s'\n", path);
+    free(data);
+    buffer->length = 0;
+    return -1;
+  }
+  buffer->data = data;
+  return 0;
+}
+
+// Release a source buffer opened with source_buffer_open.
+void source_buffer_close(SourceBuffer *buffer)
+{
+  if (!buffer->data)
+    return;
+  if (buffer->is_mapped)
+    munmap((void *)buffer->data, buffer->length);
+  else
+    free((void *)buffer->data);
+  buffer->data = NULL;
+  buffer->length = 0;
+  buffer->is_mapped = 0;
+}
+
+// Start of a token's text. Span tokens are not NUL-terminated; use token->length.
+const char *token_text(const TokenArray *array, const Token *token)
+{
+  if (token->value)
+    return token->value;
+  return array->source ? array->source + token->offset : "";
+}
+
+// Compare a token's text against a NUL-terminated string.
+int token_text_equals(const TokenArray *array, const Token *token, const char *text)
+{
+  size_t len = strlen(text);
+  return (size_t)token->length == len && memcmp(token_text(array, token), text, len) == 0;
+}
+
+// Copy a token's text into a new NUL-terminated string.
+char *token_text_dup(const TokenArray *array, const Token *token)
+{
+  return strndup(token_text(array, token), (size_t)token->length);
+}
+
 // Helper: Convert TokenType to a human-readable string.
 const char *token_type_to_string(TokenType type)
 {
@@ -513,11 +1481,12 @@ void print_tokens(const TokenArray *array)
 
   for (int i = 0; i < array->count; i++)
   {
-    printf("Token[%d] at line %d, col %d: Type = %s, Value = \"%s\"\n",
+    printf("Token[%d] at line %d, col %d: Type = %s, Value = \"%.*s\"\n",
            i,
            array->tokens[i].line,
            array->tokens[i].column,
            type_names[array->tokens[i].type],
-           array->tokens[i].value);
+           array->tokens[i].length,
+           token_text(array, &array->tokens[i]));
   }
 }
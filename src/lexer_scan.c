@@ -0,0 +1,323 @@
+#include "../include/lexer_scan.h"
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LEXER_SCAN_X86 1
+#endif
+
+// Character classes for the scalar kernels.
+#define CC_SPACE 0x01          // Whitespace.
+#define CC_IDENT 0x02          // Identifier continuation character.
+#define CC_DIGIT 0x04          // Decimal digit.
+#define CC_STRING_STOP 0x08    // Ends the plain part of a string body.
+#define CC_FSTRING_STOP 0x10   // Additionally ends the plain part of an f-string body.
+
+#define S CC_SPACE
+#define I CC_IDENT
+#define D (CC_DIGIT | CC_IDENT)
+#define Q CC_STRING_STOP
+#define F CC_FSTRING_STOP
+static const unsigned char CHAR_CLASS[256] = {
+    // 0x00 - 0x0F
+    Q, 0, 0, 0, 0, 0, 0, 0, 0, S, S | Q, S, S, S, 0, 0,
+    // 0x10 - 0x1F
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    // 0x20 - 0x2F:  ! " # $ % & ' ( ) * + , - . /
+    S, 0, Q, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    // 0x30 - 0x3F: 0-9 : ; < = > ?
+    D, D, D, D, D, D, D, D, D, D, 0, 0, 0, 0, 0, 0,
+    // 0x40 - 0x4F: @ A-O
+    0, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,
+    // 0x50 - 0x5F: P-Z [ \ ] ^ _
+    I, I, I, I, I, I, I, I, I, I, I, 0, Q, 0, 0, I,
+    // 0x60 - 0x6F: ` a-o
+    0, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,
+    // 0x70 - 0x7F: p-z { | } ~ DEL
+    I, I, I, I, I, I, I, I, I, I, I, F, 0, 0, 0, 0,
+    // 0x80 - 0xFF: no class.
+};
+#undef S
+#undef I
+#undef D
+#undef Q
+#undef F
+
+//----------------------------------------------------------
+// Scalar kernels
+//----------------------------------------------------------
+static size_t scan_class_scalar(const char *code, size_t i, size_t length, unsigned char cls)
+{
+  while (i < length && (CHAR_CLASS[(unsigned char)code[i]] & cls))
+    i++;
+  return i;
+}
+
+static size_t scan_until_scalar(const char *code, size_t i, size_t length, unsigned char stop)
+{
+  while (i < length && !(CHAR_CLASS[(unsigned char)code[i]] & stop))
+    i++;
+  return i;
+}
+
+static size_t scan_whitespace_scalar(const char *code, size_t i, size_t length)
+{
+  return scan_class_scalar(code, i, length, CC_SPACE);
+}
+
+static size_t scan_identifier_scalar(const char *code, size_t i, size_t length)
+{
+  return scan_class_scalar(code, i, length, CC_IDENT);
+}
+
+static size_t scan_digits_scalar(const char *code, size_t i, size_t length)
+{
+  return scan_class_scalar(code, i, length, CC_DIGIT);
+}
+
+static size_t scan_string_body_scalar(const char *code, size_t i, size_t length, int is_fstring)
+{
+  return scan_until_scalar(code, i, length, CC_STRING_STOP | (is_fstring ? CC_FSTRING_STOP : 0));
+}
+
+#ifdef LEXER_SCAN_X86
+//----------------------------------------------------------
+// SSE2 kernels: 16 bytes per step, classes built from range compares.
+// An unsigned "x - lo <= n" test is min_epu8(x - lo, n) == x - lo.
+//----------------------------------------------------------
+__attribute__((target("sse2"))) static inline __m128i in_range_sse2(__m128i v, char lo, char span)
+{
+  __m128i d = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(span)), d);
+}
+
+__attribute__((target("sse2"))) static size_t scan_whitespace_sse2(const char *code, size_t i, size_t length)
+{
+  while (i + 16 <= length)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(code + i));
+    __m128i hit = _mm_or_si128(in_range_sse2(v, '\t', '\r' - '\t'),
+                               _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+    unsigned miss = ~(unsigned)_mm_movemask_epi8(hit) & 0xFFFF;
+    if (miss)
+      return i + __builtin_ctz(miss);
+    i += 16;
+  }
+  return scan_whitespace_scalar(code, i, length);
+}
+
+__attribute__((target("sse2"))) static size_t scan_identifier_sse2(const char *code, size_t i, size_t length)
+{
+  while (i + 16 <= length)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(code + i));
+    __m128i alpha = in_range_sse2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z' - 'a');
+    __m128i hit = _mm_or_si128(_mm_or_si128(alpha, in_range_sse2(v, '0', 9)),
+                               _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    unsigned miss = ~(unsigned)_mm_movemask_epi8(hit) & 0xFFFF;
+    if (miss)
+      return i + __builtin_ctz(miss);
+    i += 16;
+  }
+  return scan_identifier_scalar(code, i, length);
+}
+
+__attribute__((target("sse2"))) static size_t scan_digits_sse2(const char *code, size_t i, size_t length)
+{
+  while (i + 16 <= length)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(code + i));
+    unsigned miss = ~(unsigned)_mm_movemask_epi8(in_range_sse2(v, '0', 9)) & 0xFFFF;
+    if (miss)
+      return i + __builtin_ctz(miss);
+    i += 16;
+  }
+  return scan_digits_scalar(code, i, length);
+}
+
+__attribute__((target("sse2"))) static size_t scan_string_body_sse2(const char *code, size_t i, size_t length, int is_fstring)
+{
+  const __m128i brace = _mm_set1_epi8(is_fstring ? '{' : '"');
+  while (i + 16 <= length)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i *)(code + i));
+    __m128i stop = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                             _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                                             _mm_cmpeq_epi8(v, _mm_setzero_si128())));
+    stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, brace));
+    unsigned hit = (unsigned)_mm_movemask_epi8(stop);
+    if (hit)
+      return i + __builtin_ctz(hit);
+    i += 16;
+  }
+  return scan_string_body_scalar(code, i, length, is_fstring);
+}
+
+//----------------------------------------------------------
+// AVX2 kernels: 32 bytes per step. Whitespace, identifier and digit classes
+// come from two 16-entry nibble tables: a byte is in a class when
+// LO[byte & 0xF] & HI[byte >> 4] has one of the class bits set. Each bit is
+// one rectangle of (high nibble, low nibble) pairs:
+//   0x01 \t..\r   0x02 ' '   0x04 0-9   0x08 A-O a-o   0x10 P-Z p-z   0x20 _
+//----------------------------------------------------------
+#define NIBBLE_SPACE 0x03
+#define NIBBLE_DIGIT 0x04
+#define NIBBLE_IDENT 0x3C
+
+__attribute__((target("avx2"))) static inline __m256i nibble_class_avx2(__m256i v)
+{
+  const __m256i lo_table = _mm256_setr_epi8(
+      0x16, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1D, 0x19, 0x09, 0x09, 0x09, 0x08, 0x28,
+      0x16, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1D, 0x19, 0x09, 0x09, 0x09, 0x08, 0x28);
+  const __m256i hi_table = _mm256_setr_epi8(
+      0x01, 0x00, 0x02, 0x04, 0x08, 0x30, 0x08, 0x10, 0, 0, 0, 0, 0, 0, 0, 0,
+      0x01, 0x00, 0x02, 0x04, 0x08, 0x30, 0x08, 0x10, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+  __m256i lo = _mm256_and_si256(v, low_nibble);
+  __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibble);
+  return _mm256_and_si256(_mm256_shuffle_epi8(lo_table, lo), _mm256_shuffle_epi8(hi_table, hi));
+}
+
+__attribute__((target("avx2"))) static size_t scan_nibble_class_avx2(const char *code, size_t i, size_t length, char cls)
+{
+  const __m256i mask = _mm256_set1_epi8(cls);
+  while (i + 32 <= length)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(code + i));
+    __m256i outside = _mm256_cmpeq_epi8(_mm256_and_si256(nibble_class_avx2(v), mask),
+                                        _mm256_setzero_si256());
+    unsigned miss = (unsigned)_mm256_movemask_epi8(outside);
+    if (miss)
+      return i + __builtin_ctz(miss);
+    i += 32;
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) static size_t scan_whitespace_avx2(const char *code, size_t i, size_t length)
+{
+  return scan_whitespace_scalar(code, scan_nibble_class_avx2(code, i, length, NIBBLE_SPACE), length);
+}
+
+__attribute__((target("avx2"))) static size_t scan_identifier_avx2(const char *code, size_t i, size_t length)
+{
+  return scan_identifier_scalar(code, scan_nibble_class_avx2(code, i, length, NIBBLE_IDENT), length);
+}
+
+__attribute__((target("avx2"))) static size_t scan_digits_avx2(const char *code, size_t i, size_t length)
+{
+  return scan_digits_scalar(code, scan_nibble_class_avx2(code, i, length, NIBBLE_DIGIT), length);
+}
+
+__attribute__((target("avx2"))) static size_t scan_string_body_avx2(const char *code, size_t i, size_t length, int is_fstring)
+{
+  const __m256i brace = _mm256_set1_epi8(is_fstring ? '{' : '"');
+  while (i + 32 <= length)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(code + i));
+    __m256i stop = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                                   _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+                                   _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                                                   _mm256_cmpeq_epi8(v, _mm256_setzero_si256())));
+    stop = _mm256_or_si256(stop, _mm256_cmpeq_epi8(v, brace));
+    unsigned hit = (unsigned)_mm256_movemask_epi8(stop);
+    if (hit)
+      return i + __builtin_ctz(hit);
+    i += 32;
+  }
+  return scan_string_body_scalar(code, i, length, is_fstring);
+}
+#endif // LEXER_SCAN_X86
+
+//----------------------------------------------------------
+// Runtime dispatch
+//----------------------------------------------------------
+typedef struct
+{
+  size_t (*whitespace)(const char *, size_t, size_t);
+  size_t (*identifier)(const char *, size_t, size_t);
+  size_t (*digits)(const char *, size_t, size_t);
+  size_t (*string_body)(const char *, size_t, size_t, int);
+} ScanKernels;
+
+static const ScanKernels SCALAR_KERNELS = {scan_whitespace_scalar, scan_identifier_scalar,
+                                           scan_digits_scalar, scan_string_body_scalar};
+#ifdef LEXER_SCAN_X86
+static const ScanKernels SSE2_KERNELS = {scan_whitespace_sse2, scan_identifier_sse2,
+                                         scan_digits_sse2, scan_string_body_sse2};
+static const ScanKernels AVX2_KERNELS = {scan_whitespace_avx2, scan_identifier_avx2,
+                                         scan_digits_avx2, scan_string_body_avx2};
+#endif
+
+static const ScanKernels *active_kernels = &SCALAR_KERNELS;
+static ScanLevel active_level = SCAN_SCALAR;
+
+// Best level the CPU supports.
+static ScanLevel supported_level(void)
+{
+#ifdef LEXER_SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return SCAN_AVX2;
+  if (__builtin_cpu_supports("sse2"))
+    return SCAN_SSE2;
+#endif
+  return SCAN_SCALAR;
+}
+
+ScanLevel lexer_scan_set_level(ScanLevel level)
+{
+  ScanLevel best = supported_level();
+  if (level > best)
+    level = best;
+  switch (level)
+  {
+#ifdef LEXER_SCAN_X86
+  case SCAN_AVX2:
+    active_kernels = &AVX2_KERNELS;
+    break;
+  case SCAN_SSE2:
+    active_kernels = &SSE2_KERNELS;
+    break;
+#endif
+  default:
+    level = SCAN_SCALAR;
+    active_kernels = &SCALAR_KERNELS;
+    break;
+  }
+  active_level = level;
+  return level;
+}
+
+ScanLevel lexer_scan_level(void)
+{
+  return active_level;
+}
+
+// Pick the best kernels once at load time so the lexer (and lexer threads)
+// never race on initialization.
+__attribute__((constructor)) static void lexer_scan_init(void)
+{
+  lexer_scan_set_level(SCAN_AVX2);
+}
+
+size_t scan_whitespace(const char *code, size_t i, size_t length)
+{
+  return active_kernels->whitespace(code, i, length);
+}
+
+size_t scan_identifier(const char *code, size_t i, size_t length)
+{
+  return active_kernels->identifier(code, i, length);
+}
+
+size_t scan_digits(const char *code, size_t i, size_t length)
+{
+  return active_kernels->digits(code, i, length);
+}
+
+size_t scan_string_body(const char *code, size_t i, size_t length, int is_fstring)
+{
+  return active_kernels->string_body(code, i, length, is_fstring);
+}
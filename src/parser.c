@@ -1,4 +1,5 @@
 #include "../include/parser.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,28 +17,54 @@ static Token advance(Parser *parser);
 static int check(Parser *parser, TokenType type);
 static int match(Parser *parser, TokenType type);
 static void consume(Parser *parser, TokenType type, const char *message);
-static ASTNode *parse_term(Parser *parser);
-static ASTNode *parse_factor(Parser *parser);
-static ASTNode *parse_unary(Parser *parser);
-static ASTNode *parse_primary(Parser *parser);
 
 // Helper functions for token handling
 static Token peek(Parser *parser)
 {
-    Token t = parser->tokens.tokens[parser->current];
-    printf("DEBUG: peek() at position %d: type=%d value='%s'\n",
-           parser->current, t.type, t.value);
+    Token t = parser->lexer    ? lexer_peek_token(parser->lexer, 0)
+              : parser->stream ? token_stream_get(parser->stream, parser->current)
+                               : parser->tokens.tokens[parser->current];
+    printf("DEBUG: peek() at position %d: type=%d value='%.*s'\n",
+           parser->current, t.type, t.length, token_text(&parser->tokens, &t));
     return t;
 }
 
 static Token previous(Parser *parser)
 {
-    Token t = parser->tokens.tokens[parser->current - 1];
-    printf("DEBUG: previous() at position %d: type=%d value='%s'\n",
-           parser->current - 1, t.type, t.value);
+    Token t = parser->lexer    ? parser->previous_token
+              : parser->stream ? token_stream_get(parser->stream, parser->current - 1)
+                               : parser->tokens.tokens[parser->current - 1];
+    printf("DEBUG: previous() at position %d: type=%d value='%.*s'\n",
+           parser->current - 1, t.type, t.length, token_text(&parser->tokens, &t));
     return t;
 }
 
+// Literal node from a token, using the value the lexer parsed. Compact
+// streams do not store values, so those are parsed here.
+static ASTNode *literal_node(Parser *parser, Token token)
+{
+    const char *text = token_text(&parser->tokens, &token);
+    if (parser->stream)
+        token.literal = parse_token_literal(token.type, token.subkind, text, (size_t)token.length);
+    return create_token_literal(text, (size_t)token.length, &token.literal);
+}
+
+// Token text helper. Tokens may be spans into the source buffer, so their
+// text is only copied when a node needs to own it.
+static char *token_copy(Parser *parser, Token token)
+{
+    return token_text_dup(&parser->tokens, &token);
+}
+
+// Interned name of an identifier token. Compact token streams do not carry
+// atoms, so their identifiers are interned here.
+static Atom token_atom(Parser *parser, Token token)
+{
+    if (token.atom != ATOM_NONE)
+        return token.atom;
+    return intern_string(token_text(&parser->tokens, &token), token.length);
+}
+
 static int is_at_end(Parser *parser)
 {
     return peek(parser).type == TOKEN_EOF;
@@ -48,6 +75,8 @@ static Token advance(Parser *parser)
     printf("DEBUG: advance() from position %d\n", parser->current);
     if (!is_at_end(parser))
     {
+        if (parser->lexer)
+            parser->previous_token = lexer_next_token(parser->lexer);
         parser->current++;
     }
     return previous(parser);
@@ -62,13 +91,31 @@ static int check(Parser *parser, TokenType type)
 
 static int match(Parser *parser, TokenType type)
 {
-    printf("DEBUG: match() checking for type %d, current token type=%d value='%s'\n",
-           type, peek(parser).type, peek(parser).value);
+    printf("DEBUG: match() checking for type %d, current token type=%d\n",
+           type, peek(parser).type);
     if (check(parser, type))
     {
         advance(parser);
-        printf("DEBUG: match() found match, advanced to type=%d value='%s'\n",
-               peek(parser).type, peek(parser).value);
+        printf("DEBUG: match() found match, advanced to type=%d\n",
+               peek(parser).type);
+        return 1;
+    }
+    return 0;
+}
+
+// Keyword/operator checks compare the subkind the lexer already classified.
+static int check_subkind(Parser *parser, TokenSubkind subkind)
+{
+    if (is_at_end(parser))
+        return 0;
+    return peek(parser).subkind == subkind;
+}
+
+static int match_subkind(Parser *parser, TokenSubkind subkind)
+{
+    if (check_subkind(parser, subkind))
+    {
+        advance(parser);
         return 1;
     }
     return 0;
@@ -92,6 +139,54 @@ Parser *create_parser(TokenArray tokens)
     parser->tokens = tokens;
     parser->current = 0;
     parser->had_error = 0;
+    parser->lexer = NULL;
+    memset(&parser->previous_token, 0, sizeof(Token));
+    parser->stream = NULL;
+    parser->lazy_bodies = 0;
+    parser->errors = NULL;
+    parser->error_count = 0;
+    parser->error_capacity = 0;
+    parser->print_errors = 1;
+    return parser;
+}
+
+// Create a parser over a streaming lexer. The token array stays empty; it only
+// records the source buffer so span tokens resolve their text.
+Parser *create_stream_parser(Lexer *lexer)
+{
+    Parser *parser = malloc(sizeof(Parser));
+    parser->tokens = create_token_array();
+    parser->tokens.source = lexer->source;
+    parser->current = 0;
+    parser->had_error = 0;
+    parser->lexer = lexer;
+    memset(&parser->previous_token, 0, sizeof(Token));
+    parser->stream = NULL;
+    parser->lazy_bodies = 0;
+    parser->errors = NULL;
+    parser->error_count = 0;
+    parser->error_capacity = 0;
+    parser->print_errors = 1;
+    return parser;
+}
+
+// Create a parser over a compact token stream. As in streaming mode, the token
+// array only records the source buffer.
+Parser *create_token_stream_parser(TokenStream *stream)
+{
+    Parser *parser = malloc(sizeof(Parser));
+    parser->tokens = create_token_array();
+    parser->tokens.source = stream->source;
+    parser->current = 0;
+    parser->had_error = 0;
+    parser->lexer = NULL;
+    memset(&parser->previous_token, 0, sizeof(Token));
+    parser->stream = stream;
+    parser->lazy_bodies = 0;
+    parser->errors = NULL;
+    parser->error_count = 0;
+    parser->error_capacity = 0;
+    parser->print_errors = 1;
     return parser;
 }
 
@@ -99,6 +194,12 @@ Parser *create_parser(TokenArray tokens)
 void destroy_parser(Parser *parser)
 {
     // Note: We don't free tokens here as they're owned by the caller
+    // (in streaming mode the array is the parser's own empty placeholder).
+    if (parser->lexer || parser->stream)
+        free_token_array(&parser->tokens);
+    for (int i = 0; i < parser->error_count; i++)
+        free(parser->errors[i].message);
+    free(parser->errors);
     free(parser);
 }
 
@@ -106,62 +207,101 @@ void destroy_parser(Parser *parser)
 void parser_error(Parser *parser, const char *message)
 {
     Token token = peek(parser);
-    fprintf(stderr, "[line %d] Error at '%s': %s\n",
-            token.line, token.value, message);
+    if (parser->stream)
+    {
+        // Compact tokens carry no location; look it up now.
+        int column;
+        token_stream_position(parser->stream, parser->current, &token.line, &column);
+    }
+    char report[512];
+    if (token.type == TOKEN_EOF)
+        snprintf(report, sizeof(report), "[line %d] Error at 'EOF': %s", token.line, message);
+    else
+        snprintf(report, sizeof(report), "[line %d] Error at '%.*s': %s",
+                 token.line, token.length, token_text(&parser->tokens, &token), message);
+    if (parser->print_errors)
+        fprintf(stderr, "%s\n", report);
     parser->had_error = 1;
+
+    // Keep the error so callers (and parallel parsing) can report it later.
+    if (parser->error_count == parser->error_capacity)
+    {
+        parser->error_capacity = parser->error_capacity ? parser->error_capacity * 2 : 4;
+        parser->errors = realloc(parser->errors, parser->error_capacity * sizeof(ParseError));
+    }
+    ParseError *error = &parser->errors[parser->error_count++];
+    error->token_index = parser->current;
+    error->line = token.line;
+    error->message = strdup(report);
+}
+
+// Binding powers for the Pratt expression parser, indexed by token subkind.
+// An infix operator binds its left operand with `left` and parses its right
+// operand with `right`: left < right makes it left-associative, left > right
+// right-associative. A zero entry means the token is not an infix operator.
+typedef struct
+{
+    unsigned char left;
+    unsigned char right;
+} BindingPower;
+
+static const BindingPower INFIX_BP[OP_POWER + 1] = {
+    [OP_ASSIGN] = {2, 1},
+    [KW_OR] = {3, 4},
+    [KW_AND] = {5, 6},
+    [OP_EQ] = {7, 8},
+    [OP_NE] = {7, 8},
+    [OP_LT] = {9, 10},
+    [OP_GT] = {9, 10},
+    [OP_LE] = {9, 10},
+    [OP_GE] = {9, 10},
+    [OP_PLUS] = {11, 12},
+    [OP_MINUS] = {11, 12},
+    [OP_STAR] = {13, 14},
+    [OP_SLASH] = {13, 14},
+    [OP_PERCENT] = {13, 14},
+    [OP_POWER] = {16, 15},
+};
+
+// Prefix operators bind tighter than any infix operator, so -a ** b is (-a) ** b.
+#define PREFIX_BP 17
+
+static int is_prefix_operator(TokenSubkind subkind)
+{
+    return subkind == OP_MINUS || subkind == OP_PLUS || subkind == KW_NOT;
 }
 
-// Forward declarations for recursive descent
-static ASTNode *parse_primary(Parser *parser);
-static ASTNode *parse_unary(Parser *parser);
-static ASTNode *parse_power(Parser *parser);
-static ASTNode *parse_multiplicative(Parser *parser);
-static ASTNode *parse_additive(Parser *parser);
-static ASTNode *parse_relational(Parser *parser);
-static ASTNode *parse_equality(Parser *parser);
-static ASTNode *parse_logical_and(Parser *parser);
-static ASTNode *parse_logical_or(Parser *parser);
-static ASTNode *parse_assignment(Parser *parser);
+static ASTNode *parse_expression_bp(Parser *parser, int min_bp);
 
 // Parse primary expressions (literals, identifiers, parenthesized expressions)
 static ASTNode *parse_primary(Parser *parser)
 {
     DEBUG_PRINT("Parsing primary expression\n");
-    DEBUG_PRINT("Current token: type=%d, value='%s'\n", peek(parser).type, peek(parser).value);
-
-    if (match(parser, TOKEN_INTEGER))
-    {
-        DEBUG_PRINT("Found literal: %s\n", previous(parser).value);
-        return create_literal(previous(parser).value);
-    }
+    DEBUG_PRINT("Current token: type=%d\n", peek(parser).type);
 
-    if (match(parser, TOKEN_FLOAT))
+    if (match(parser, TOKEN_INTEGER) || match(parser, TOKEN_FLOAT) || match(parser, TOKEN_STRING))
     {
-        DEBUG_PRINT("Found literal: %s\n", previous(parser).value);
-        return create_literal(previous(parser).value);
+        Token token = previous(parser);
+        DEBUG_PRINT("Found literal: %.*s\n", token.length, token_text(&parser->tokens, &token));
+        return literal_node(parser, token);
     }
 
-    if (match(parser, TOKEN_STRING))
+    if (match(parser, TOKEN_IDENTIFIER))
     {
-        DEBUG_PRINT("Found literal: %s\n", previous(parser).value);
-        return create_literal(previous(parser).value);
+        Token token = previous(parser);
+        DEBUG_PRINT("Found identifier: %.*s\n", token.length, token_text(&parser->tokens, &token));
+        return create_identifier_atom(token_atom(parser, token));
     }
 
-    if (match(parser, TOKEN_IDENTIFIER))
+    if (match_subkind(parser, KW_TRUE))
     {
-        DEBUG_PRINT("Found identifier: %s\n", previous(parser).value);
-        return create_identifier(previous(parser).value);
+        DEBUG_PRINT("Found keyword: true\n");
+        return literal_node(parser, previous(parser));
     }
-
-    if (match(parser, TOKEN_KEYWORD))
+    if (match_subkind(parser, KW_FALSE))
     {
-        const char *value = previous(parser).value;
-        DEBUG_PRINT("Found keyword: %s\n", value);
-        if (strcmp(value, "true") == 0 || strcmp(value, "false") == 0)
-        {
-            return create_literal(value);
-        }
-        parser->current--; // Rewind if not a boolean keyword
+        DEBUG_PRINT("Found keyword: false\n");
+        return literal_node(parser, previous(parser));
     }
 
     if (match(parser, TOKEN_LPAREN))
@@ -175,243 +315,56 @@ static ASTNode *parse_primary(Parser *parser)
     return NULL;
 }
 
-// Parse unary expressions (-, +, not)
-static ASTNode *parse_unary(Parser *parser)
-{
-    DEBUG_PRINT("Parsing unary expression\n");
-
-    if (match(parser, TOKEN_OPERATOR))
-    {
-        const char *op = previous(parser).value;
-        if (strcmp(op, "-") == 0 || strcmp(op, "+") == 0)
-        {
-            DEBUG_PRINT("Found unary operator: %s\n", op);
-            ASTNode *right = parse_unary(parser);
-            if (right == NULL)
-                return NULL;
-            return create_unary_expr((char *)op, right);
-        }
-        parser->current--; // Rewind if not a unary operator
-    }
-    else if (match(parser, TOKEN_KEYWORD))
-    {
-        const char *keyword = previous(parser).value;
-        if (strcmp(keyword, "not") == 0)
-        {
-            DEBUG_PRINT("Found unary operator: not\n");
-            ASTNode *right = parse_unary(parser);
-            if (right == NULL)
-                return NULL;
-            return create_unary_expr((char *)"not", right);
-        }
-        parser->current--; // Rewind if not a unary operator keyword
-    }
-
-    return parse_primary(parser);
-}
-
-// Parse power expressions (right-associative)
-static ASTNode *parse_power(Parser *parser)
-{
-    ASTNode *left = parse_unary(parser);
-    if (!left)
-        return NULL;
-
-    if (check(parser, TOKEN_OPERATOR) && strcmp(peek(parser).value, "**") == 0)
-    {
-        advance(parser); // Consume the operator
-        const char *op = previous(parser).value;
-        ASTNode *right = parse_power(parser); // Right-associative
-        if (!right)
-        {
-            free_ast(left);
-            return NULL;
-        }
-        left = create_binary_expr((char *)op, left, right);
-    }
-
-    return left;
-}
-
-// Parse multiplicative expressions (*, /, %)
-static ASTNode *parse_multiplicative(Parser *parser)
+// Parse a prefix operator application or a primary expression
+static ASTNode *parse_prefix(Parser *parser)
 {
-    ASTNode *left = parse_power(parser);
-    if (!left)
-        return NULL;
+    if (is_at_end(parser) || !is_prefix_operator(peek(parser).subkind))
+        return parse_primary(parser);
 
-    while (check(parser, TOKEN_OPERATOR))
-    {
-        const char *op = peek(parser).value;
-        if (strcmp(op, "*") != 0 && strcmp(op, "/") != 0 && strcmp(op, "%") != 0)
-            break;
-
-        advance(parser); // Consume the operator
-        ASTNode *right = parse_power(parser);
-        if (!right)
-        {
-            free_ast(left);
-            return NULL;
-        }
-        left = create_binary_expr((char *)op, left, right);
-    }
-
-    return left;
-}
-
-// Parse additive expressions (+, -)
-static ASTNode *parse_additive(Parser *parser)
-{
-    ASTNode *left = parse_multiplicative(parser);
-    if (!left)
+    const char *op = token_subkind_text(advance(parser).subkind);
+    DEBUG_PRINT("Found unary operator: %s\n", op);
+    ASTNode *right = parse_expression_bp(parser, PREFIX_BP);
+    if (right == NULL)
         return NULL;
-
-    while (check(parser, TOKEN_OPERATOR))
-    {
-        const char *op = peek(parser).value;
-        if (strcmp(op, "+") != 0 && strcmp(op, "-") != 0)
-            break;
-
-        advance(parser); // Consume the operator
-        ASTNode *right = parse_multiplicative(parser);
-        if (!right)
-        {
-            free_ast(left);
-            return NULL;
-        }
-        left = create_binary_expr((char *)op, left, right);
-    }
-
-    return left;
+    return create_unary_expr((char *)op, right);
 }
 
-// Parse relational expressions (<, >, <=, >=)
-static ASTNode *parse_relational(Parser *parser)
+// Parse an expression whose infix operators all bind at least min_bp. Each
+// iteration consumes one operator and recurses once for its right operand.
+static ASTNode *parse_expression_bp(Parser *parser, int min_bp)
 {
-    ASTNode *left = parse_additive(parser);
+    ASTNode *left = parse_prefix(parser);
     if (!left)
         return NULL;
 
-    while (match(parser, TOKEN_OPERATOR))
+    while (!is_at_end(parser))
     {
-        const char *op = previous(parser).value;
-        if (strcmp(op, "<") != 0 && strcmp(op, ">") != 0 &&
-            strcmp(op, "<=") != 0 && strcmp(op, ">=") != 0)
-        {
-            parser->current--;
+        TokenSubkind subkind = peek(parser).subkind;
+        if (subkind > OP_POWER)
             break;
-        }
-
-        ASTNode *right = parse_additive(parser);
-        if (!right)
-        {
-            free_ast(left);
-            return NULL;
-        }
-        left = create_binary_expr((char *)op, left, right);
-    }
-
-    return left;
-}
-
-// Parse equality expressions (==, !=)
-static ASTNode *parse_equality(Parser *parser)
-{
-    ASTNode *left = parse_relational(parser);
-    if (!left)
-        return NULL;
-
-    while (match(parser, TOKEN_OPERATOR))
-    {
-        const char *op = previous(parser).value;
-        if (strcmp(op, "==") != 0 && strcmp(op, "!=") != 0)
-        {
-            parser->current--;
+        BindingPower bp = INFIX_BP[subkind];
+        if (bp.left == 0 || bp.left < min_bp)
             break;
-        }
-
-        ASTNode *right = parse_relational(parser);
-        if (!right)
-        {
-            free_ast(left);
-            return NULL;
-        }
-        left = create_binary_expr((char *)op, left, right);
-    }
-
-    return left;
-}
-
-// Parse logical AND expressions
-static ASTNode *parse_logical_and(Parser *parser)
-{
-    ASTNode *left = parse_equality(parser);
-    if (!left)
-        return NULL;
-
-    while (check(parser, TOKEN_KEYWORD) && strcmp(peek(parser).value, "and") == 0)
-    {
-        advance(parser); // Consume the operator
-        const char *op = previous(parser).value;
-        ASTNode *right = parse_equality(parser);
-        if (!right)
-        {
-            free_ast(left);
-            return NULL;
-        }
-        left = create_binary_expr((char *)op, left, right);
-    }
-
-    return left;
-}
-
-// Parse logical OR expressions
-static ASTNode *parse_logical_or(Parser *parser)
-{
-    ASTNode *left = parse_logical_and(parser);
-    if (!left)
-        return NULL;
-
-    while (check(parser, TOKEN_KEYWORD) && strcmp(peek(parser).value, "or") == 0)
-    {
-        advance(parser); // Consume the operator
-        const char *op = previous(parser).value;
-        ASTNode *right = parse_logical_and(parser);
-        if (!right)
-        {
-            free_ast(left);
-            return NULL;
-        }
-        left = create_binary_expr((char *)op, left, right);
-    }
-
-    return left;
-}
-
-// Parse assignment expressions
-static ASTNode *parse_assignment(Parser *parser)
-{
-    ASTNode *left = parse_logical_or(parser);
-    if (!left)
-        return NULL;
+        advance(parser);
 
-    if (match(parser, TOKEN_OPERATOR) && strcmp(previous(parser).value, "=") == 0)
-    {
         // Ensure left side is a valid assignment target
-        if (left->type != AST_IDENTIFIER)
+        if (subkind == OP_ASSIGN && left->type != AST_IDENTIFIER)
         {
             parser_error(parser, "Invalid assignment target");
             free_ast(left);
             return NULL;
         }
 
-        ASTNode *right = parse_assignment(parser);
+        ASTNode *right = parse_expression_bp(parser, bp.right);
         if (!right)
         {
             free_ast(left);
             return NULL;
         }
-        return create_assign_expr(left, right);
+        if (subkind == OP_ASSIGN)
+            left = create_assign_expr(left, right);
+        else
+            left = create_binary_expr((char *)token_subkind_text(subkind), left, right);
     }
 
     return left;
@@ -421,7 +374,7 @@ static ASTNode *parse_assignment(Parser *parser)
 ASTNode *parse_expression(Parser *parser)
 {
     DEBUG_PRINT("Parsing expression\n");
-    return parse_assignment(parser);
+    return parse_expression_bp(parser, 0);
 }
 
 // Parse a variable declaration
@@ -429,7 +382,7 @@ ASTNode *parse_expression(Parser *parser)
 ASTNode *parse_var_declaration(Parser *parser)
 {
     // Expect 'let' keyword
-    if (!match(parser, TOKEN_KEYWORD) || strcmp(previous(parser).value, "let") != 0)
+    if (!match_subkind(parser, KW_LET))
     {
         parser_error(parser, "Expected 'let' keyword");
         return NULL;
@@ -437,7 +390,7 @@ ASTNode *parse_var_declaration(Parser *parser)
 
     // Check for const modifier
     int is_const = 0;
-    if (match(parser, TOKEN_KEYWORD) && strcmp(previous(parser).value, "const") == 0)
+    if (match_subkind(parser, KW_CONST))
     {
         is_const = 1;
     }
@@ -448,7 +401,7 @@ ASTNode *parse_var_declaration(Parser *parser)
         parser_error(parser, "Expected variable name");
         return NULL;
     }
-    char *identifier = strdup(previous(parser).value);
+    const char *identifier = atom_text(token_atom(parser, previous(parser)));
 
     // Check for type annotation
     char *type_annotation = NULL;
@@ -457,17 +410,15 @@ ASTNode *parse_var_declaration(Parser *parser)
         if (!match(parser, TOKEN_KEYWORD))
         {
             parser_error(parser, "Expected type after ':'");
-            free(identifier);
             return NULL;
         }
-        type_annotation = strdup(previous(parser).value);
+        type_annotation = token_copy(parser, previous(parser));
     }
 
     // Expect '='
-    if (!match(parser, TOKEN_OPERATOR) || strcmp(previous(parser).value, "=") != 0)
+    if (!match_subkind(parser, OP_ASSIGN))
     {
         parser_error(parser, "Expected '=' after variable declaration");
-        free(identifier);
         free(type_annotation);
         return NULL;
     }
@@ -476,7 +427,6 @@ ASTNode *parse_var_declaration(Parser *parser)
     ASTNode *initializer = parse_expression(parser);
     if (!initializer)
     {
-        free(identifier);
         free(type_annotation);
         return NULL;
     }
@@ -485,13 +435,14 @@ ASTNode *parse_var_declaration(Parser *parser)
     if (!match(parser, TOKEN_SEMICOLON))
     {
         parser_error(parser, "Expected ';' after variable declaration");
-        free(identifier);
         free(type_annotation);
         free_ast(initializer);
         return NULL;
     }
 
-    return create_var_decl(is_const, identifier, type_annotation, initializer);
+    ASTNode *decl = create_var_decl(is_const, identifier, type_annotation, initializer);
+    free(type_annotation);
+    return decl;
 }
 
 // Parse a block of statements
@@ -551,6 +502,82 @@ ASTNode *parse_block(Parser *parser)
     return create_block(statements, stmt_count);
 }
 
+// Deferred function body: where its tokens are and how to parse them.
+typedef struct
+{
+    LazyBody base;
+    TokenArray tokens;    // Token array the function was parsed from
+    TokenStream *stream;  // Or the compact stream
+    int start;            // Index of the body's '{'
+    int end;              // Index just past its '}'
+    ASTArena *arena;      // Arena the function node was built in
+} ParserLazyBody;
+
+static ASTNode *parse_lazy_body(LazyBody *base)
+{
+    ParserLazyBody *lazy = (ParserLazyBody *)base;
+    Parser *parser = lazy->stream ? create_token_stream_parser(lazy->stream) : create_parser(lazy->tokens);
+    parser->current = lazy->start;
+    ASTArena *previous_arena = ast_arena_set_current(lazy->arena);
+    ASTNode *body = parse_block(parser);
+    // The block must end at the brace that was matched when it was skipped
+    if (body && parser->current != lazy->end)
+    {
+        parser_error(parser, "Expected '}' after block");
+        free_ast(body);
+        body = NULL;
+    }
+    ast_arena_set_current(previous_arena);
+    destroy_parser(parser);
+    return body;
+}
+
+// Kind of the token at index, without going through peek().
+static TokenType token_kind_at(Parser *parser, int index)
+{
+    return parser->stream ? (TokenType)parser->stream->kinds[index] : parser->tokens.tokens[index].type;
+}
+
+// Skip a brace-delimited body starting at the current '{' and record its
+// token range. Returns NULL (after reporting) if the braces do not match.
+static LazyBody *skip_function_body(Parser *parser)
+{
+    if (!check(parser, TOKEN_LBRACE))
+    {
+        parser_error(parser, "Expected '{' before block");
+        return NULL;
+    }
+    int start = parser->current;
+    int index = start;
+    int depth = 0;
+    for (;;)
+    {
+        TokenType kind = token_kind_at(parser, index);
+        if (kind == TOKEN_EOF)
+        {
+            parser->current = index;
+            parser_error(parser, "Expected '}' after block");
+            return NULL;
+        }
+        index++;
+        if (kind == TOKEN_LBRACE)
+            depth++;
+        else if (kind == TOKEN_RBRACE && --depth == 0)
+            break;
+    }
+    parser->current = index;
+
+    ASTArena *arena = ast_arena_current();
+    ParserLazyBody *lazy = arena ? ast_arena_alloc(arena, sizeof(ParserLazyBody)) : malloc(sizeof(ParserLazyBody));
+    lazy->base.parse = parse_lazy_body;
+    lazy->tokens = parser->tokens;
+    lazy->stream = parser->stream;
+    lazy->start = start;
+    lazy->end = index;
+    lazy->arena = arena;
+    return &lazy->base;
+}
+
 // Parse a function declaration
 // [comptime] fn identifier(params) [:type] { body }
 ASTNode *parse_function_declaration(Parser *parser)
@@ -558,25 +585,18 @@ ASTNode *parse_function_declaration(Parser *parser)
     printf("DEBUG: Starting function declaration parse\n");
     // Check for comptime modifier
     int is_comptime = 0;
-    if (match(parser, TOKEN_KEYWORD))
+    if (match_subkind(parser, KW_COMPTIME))
     {
-        printf("DEBUG: Found keyword: %s\n", previous(parser).value);
-        if (strcmp(previous(parser).value, "comptime") == 0)
-        {
-            is_comptime = 1;
-        }
-        else
-        {
-            // If it's not comptime, we need to rewind because it might be 'fn'
-            parser->current--;
-        }
+        printf("DEBUG: Found keyword: comptime\n");
+        is_comptime = 1;
     }
 
     // Expect 'fn' keyword
-    if (!match(parser, TOKEN_KEYWORD) || strcmp(previous(parser).value, "fn") != 0)
+    if (!match_subkind(parser, KW_FN))
     {
-        printf("DEBUG: Expected 'fn', got token type %d with value '%s'\n",
-               peek(parser).type, peek(parser).value);
+        Token token = peek(parser);
+        printf("DEBUG: Expected 'fn', got token type %d with value '%.*s'\n",
+               token.type, token.length, token_text(&parser->tokens, &token));
         parser_error(parser, "Expected 'fn' keyword");
         return NULL;
     }
@@ -589,14 +609,13 @@ ASTNode *parse_function_declaration(Parser *parser)
         parser_error(parser, "Expected function name");
         return NULL;
     }
-    char *name = strdup(previous(parser).value);
+    const char *name = atom_text(token_atom(parser, previous(parser)));
     printf("DEBUG: Found function name: %s\n", name);
 
     // Expect opening parenthesis
     if (!match(parser, TOKEN_LPAREN))
     {
         parser_error(parser, "Expected '(' after function name");
-        free(name);
         return NULL;
     }
 
@@ -622,7 +641,7 @@ ASTNode *parse_function_declaration(Parser *parser)
                 parser_error(parser, "Expected parameter name");
                 goto error;
             }
-            char *param_name = strdup(previous(parser).value);
+            const char *param_name = atom_text(token_atom(parser, previous(parser)));
 
             // Check for type annotation
             char *param_type = NULL;
@@ -631,15 +650,13 @@ ASTNode *parse_function_declaration(Parser *parser)
                 if (!match(parser, TOKEN_KEYWORD))
                 {
                     parser_error(parser, "Expected type after ':'");
-                    free(param_name);
                     goto error;
                 }
-                param_type = strdup(previous(parser).value);
+                param_type = token_copy(parser, previous(parser));
             }
 
             // Create parameter node (as a variable declaration)
             parameters[param_count++] = create_var_decl(0, param_name, param_type, NULL);
-            free(param_name);
             if (param_type)
                 free(param_type);
 
@@ -662,22 +679,29 @@ ASTNode *parse_function_declaration(Parser *parser)
             parser_error(parser, "Expected return type after ':'");
             goto error;
         }
-        return_type = strdup(previous(parser).value);
+        return_type = token_copy(parser, previous(parser));
     }
 
-    // Parse function body
-    ASTNode *body = parse_block(parser);
-    if (!body)
+    // Parse function body, or just find its end when bodies are lazy
+    ASTNode *body = NULL;
+    LazyBody *lazy_body = NULL;
+    if (parser->lazy_bodies && !parser->lexer)
+        lazy_body = skip_function_body(parser);
+    else
+        body = parse_block(parser);
+    if (!body && !lazy_body)
     {
         if (return_type)
             free(return_type);
         goto error;
     }
 
-    return create_func_def(name, parameters, param_count, return_type, body, is_comptime);
+    ASTNode *func = create_func_def(name, parameters, param_count, return_type, body, is_comptime);
+    func->data.func_def.lazy_body = lazy_body;
+    free(return_type);
+    return func;
 
 error:
-    free(name);
     if (parameters)
     {
         for (int i = 0; i < param_count; i++)
@@ -689,62 +713,238 @@ error:
     return NULL;
 }
 
-static ASTNode *parse_factor(Parser *parser)
+// Parse a struct declaration
+// struct identifier { field: type, ... }
+ASTNode *parse_struct_declaration(Parser *parser)
 {
-    DEBUG_PRINT("Parsing factor\n");
-    ASTNode *left = parse_unary(parser);
-    if (left == NULL)
+    if (!match_subkind(parser, KW_STRUCT))
+    {
+        parser_error(parser, "Expected 'struct' keyword");
+        return NULL;
+    }
+    if (!match(parser, TOKEN_IDENTIFIER))
+    {
+        parser_error(parser, "Expected struct name");
         return NULL;
+    }
+    const char *name = atom_text(token_atom(parser, previous(parser)));
+    if (!match(parser, TOKEN_LBRACE))
+    {
+        parser_error(parser, "Expected '{' after struct name");
+        return NULL;
+    }
 
-    // Use check/peek approach for multiplicative operators
-    while (check(parser, TOKEN_OPERATOR))
+    char **field_names = NULL;
+    char **field_types = NULL;
+    int field_count = 0;
+    int capacity = 0;
+    ASTNode *node = NULL;
+    while (!check(parser, TOKEN_RBRACE) && !is_at_end(parser))
     {
-        Token opToken = peek(parser);
-        // Only handle multiplicative operators
-        if (strcmp(opToken.value, "*") != 0 && strcmp(opToken.value, "/") != 0 && strcmp(opToken.value, "%") != 0)
-            break;
-        // Consume the operator
-        advance(parser);
-        DEBUG_PRINT("Found binary operator: %s\n", opToken.value);
-        ASTNode *right = parse_unary(parser);
-        if (right == NULL)
+        if (!match(parser, TOKEN_IDENTIFIER))
         {
-            free_ast(left);
-            return NULL;
+            parser_error(parser, "Expected field name");
+            goto done;
         }
-        // Create a binary expression node
-        left = create_binary_expr((char *)opToken.value, left, right);
+        const char *field_name = atom_text(token_atom(parser, previous(parser)));
+        if (!match(parser, TOKEN_COLON))
+        {
+            parser_error(parser, "Expected ':' after field name");
+            goto done;
+        }
+        if (!match(parser, TOKEN_KEYWORD) && !match(parser, TOKEN_IDENTIFIER))
+        {
+            parser_error(parser, "Expected field type");
+            goto done;
+        }
+        if (field_count == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 4;
+            field_names = realloc(field_names, capacity * sizeof(char *));
+            field_types = realloc(field_types, capacity * sizeof(char *));
+        }
+        field_names[field_count] = (char *)field_name;
+        field_types[field_count] = token_copy(parser, previous(parser));
+        field_count++;
+        if (!match(parser, TOKEN_COMMA))
+            break;
     }
 
-    return left;
+    if (!match(parser, TOKEN_RBRACE))
+    {
+        parser_error(parser, "Expected '}' after struct fields");
+        goto done;
+    }
+    node = create_struct_def(name, field_names, field_types, field_count);
+
+done:
+    for (int i = 0; i < field_count; i++)
+        free(field_types[i]);
+    free(field_names);
+    free(field_types);
+    return node;
 }
 
-static ASTNode *parse_term(Parser *parser)
+// Parse one top-level declaration
+ASTNode *parse_declaration(Parser *parser)
 {
-    DEBUG_PRINT("Parsing term\n");
-    ASTNode *left = parse_factor(parser);
-    if (left == NULL)
-        return NULL;
+    if (check_subkind(parser, KW_LET))
+        return parse_var_declaration(parser);
+    if (check_subkind(parser, KW_FN) || check_subkind(parser, KW_COMPTIME))
+        return parse_function_declaration(parser);
+    if (check_subkind(parser, KW_STRUCT))
+        return parse_struct_declaration(parser);
+    parser_error(parser, "Expected declaration");
+    return NULL;
+}
 
-    // Instead of match() and then rewinding, use a check/peek approach
-    while (check(parser, TOKEN_OPERATOR))
-    {
-        Token opToken = peek(parser);
-        // Only handle additive operators
-        if (strcmp(opToken.value, "+") != 0 && strcmp(opToken.value, "-") != 0)
-            break;
-        // Consume the operator
-        advance(parser);
-        DEBUG_PRINT("Found binary operator: %s\n", opToken.value);
-        ASTNode *right = parse_factor(parser);
-        if (right == NULL)
+//----------------------------------------------------------
+// Parallel parsing of top-level declarations
+//----------------------------------------------------------
+
+#define MAX_PARSE_THREADS 64
+
+// A worker's share of the declarations: starts[first, last) and their results.
+typedef struct
+{
+    const TokenArray *tokens;
+    const int *starts; // Token index of each declaration, plus the EOF index
+    int first;
+    int last;
+    ASTNode **decls;   // Indexed like starts
+    ASTArena *arena;
+    ParseError *errors;
+    int error_count;
+} ParseWorker;
+
+// Token indices where top-level declarations begin, followed by the index of
+// the EOF token. Anything before the first declaration is treated as one.
+static int *find_declarations(const TokenArray *tokens, int *count)
+{
+    int capacity = 64;
+    int *starts = malloc(capacity * sizeof(int));
+    int found = 0;
+    int depth = 0;
+    int eof = tokens->count - 1;
+    starts[found++] = 0;
+    for (int i = 0; i < eof; i++)
+    {
+        const Token *token = &tokens->tokens[i];
+        int begins = token->subkind == KW_LET || token->subkind == KW_STRUCT || token->subkind == KW_COMPTIME ||
+                     (token->subkind == KW_FN && (i == 0 || tokens->tokens[i - 1].subkind != KW_COMPTIME));
+        if (depth == 0 && begins && i > 0)
         {
-            free_ast(left);
-            return NULL;
+            if (found + 1 >= capacity)
+            {
+                capacity *= 2;
+                starts = realloc(starts, capacity * sizeof(int));
+            }
+            starts[found++] = i;
+        }
+        if (token->type == TOKEN_LBRACE)
+            depth++;
+        else if (token->type == TOKEN_RBRACE && depth > 0)
+            depth--;
+    }
+    *count = eof > 0 ? found : 0;
+    starts[*count] = eof;
+    return starts;
+}
+
+static void *parse_worker(void *arg)
+{
+    ParseWorker *worker = arg;
+    Parser *parser = create_parser(*worker->tokens);
+    parser->print_errors = 0;
+    ASTArena *previous_arena = ast_arena_set_current(worker->arena);
+    for (int k = worker->first; k < worker->last; k++)
+    {
+        parser->current = worker->starts[k];
+        worker->decls[k] = parse_declaration(parser);
+        if (worker->decls[k] && parser->current != worker->starts[k + 1])
+            parser_error(parser, "Expected end of declaration");
+    }
+    ast_arena_set_current(previous_arena);
+
+    worker->errors = parser->errors;
+    worker->error_count = parser->error_count;
+    parser->errors = NULL;
+    parser->error_count = 0;
+    destroy_parser(parser);
+    return NULL;
+}
+
+// Parse all top-level declarations, splitting them into contiguous runs of
+// roughly equal token counts. The first run is parsed on the calling thread.
+ParsedProgram parse_program_parallel(const TokenArray *tokens, int thread_count)
+{
+    int decl_count;
+    int *starts = find_declarations(tokens, &decl_count);
+    if (thread_count > MAX_PARSE_THREADS)
+        thread_count = MAX_PARSE_THREADS;
+    if (thread_count > decl_count)
+        thread_count = decl_count;
+    if (thread_count < 1)
+        thread_count = 1;
+
+    ASTNode **decls = calloc(decl_count + 1, sizeof(ASTNode *));
+    ParseWorker workers[MAX_PARSE_THREADS];
+    pthread_t threads[MAX_PARSE_THREADS];
+    int total_tokens = starts[decl_count];
+    int next = 0;
+    for (int w = 0; w < thread_count; w++)
+    {
+        int target = (int)((long)total_tokens * (w + 1) / thread_count);
+        int last = next;
+        while (last < decl_count && (starts[last] < target || last == next))
+            last++;
+        if (w == thread_count - 1)
+            last = decl_count;
+        workers[w] = (ParseWorker){tokens, starts, next, last, decls, create_ast_arena(), NULL, 0};
+        next = last;
+        if (w > 0 && pthread_create(&threads[w], NULL, parse_worker, &workers[w]) != 0)
+        {
+            fprintf(stderr, "Failed to start parser thread\n");
+            exit(1);
         }
-        // Create a binary expression node
-        left = create_binary_expr((char *)opToken.value, left, right);
     }
+    parse_worker(&workers[0]);
+    for (int w = 1; w < thread_count; w++)
+        pthread_join(threads[w], NULL);
+
+    // Merge in source order: workers hold consecutive runs.
+    ParsedProgram program = {0};
+    program.decls = decls;
+    for (int k = 0; k < decl_count; k++)
+        if (decls[k])
+            decls[program.decl_count++] = decls[k];
+    program.arenas = malloc(thread_count * sizeof(ASTArena *));
+    program.arena_count = thread_count;
+    int error_total = 0;
+    for (int w = 0; w < thread_count; w++)
+        error_total += workers[w].error_count;
+    program.errors = error_total ? malloc(error_total * sizeof(ParseError)) : NULL;
+    for (int w = 0; w < thread_count; w++)
+    {
+        program.arenas[w] = workers[w].arena;
+        if (workers[w].error_count)
+            memcpy(&program.errors[program.error_count], workers[w].errors,
+                   workers[w].error_count * sizeof(ParseError));
+        program.error_count += workers[w].error_count;
+        free(workers[w].errors);
+    }
+    free(starts);
+    return program;
+}
 
-    return left;
-}
\ No newline at end of file
+void free_parsed_program(ParsedProgram *program)
+{
+    for (int i = 0; i < program->error_count; i++)
+        free(program->errors[i].message);
+    free(program->errors);
+    for (int i = 0; i < program->arena_count; i++)
+        destroy_ast_arena(program->arenas[i]);
+    free(program->arenas);
+    free(program->decls);
+    memset(program, 0, sizeof(*program));
+}
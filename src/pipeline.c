@@ -0,0 +1,373 @@
+#include "../include/pipeline.h"
+#include "../include/semantic.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_QUEUE_CAPACITY 64
+#define SPIN_LIMIT 128
+
+static void *xmalloc(size_t size)
+{
+  void *ptr = malloc(size);
+  if (!ptr)
+  {
+    fprintf(stderr, "Memory allocation failed for %zu bytes\n", size);
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+static void *xrealloc(void *ptr, size_t size)
+{
+  ptr = realloc(ptr, size);
+  if (!ptr)
+  {
+    fprintf(stderr, "Memory allocation failed for %zu bytes\n", size);
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+//----------------------------------------------------------
+// SPSC queue
+//----------------------------------------------------------
+
+void spsc_queue_init(SpscQueue *queue, size_t capacity)
+{
+  size_t size = 2;
+  while (size < capacity)
+    size *= 2;
+  queue->items = xmalloc(size * sizeof(void *));
+  queue->mask = size - 1;
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+}
+
+void spsc_queue_destroy(SpscQueue *queue)
+{
+  free(queue->items);
+  queue->items = NULL;
+}
+
+int spsc_queue_try_push(SpscQueue *queue, void *item)
+{
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  if (tail - atomic_load_explicit(&queue->head, memory_order_acquire) > queue->mask)
+    return 0;
+  queue->items[tail & queue->mask] = item;
+  atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+  return 1;
+}
+
+void *spsc_queue_try_pop(SpscQueue *queue)
+{
+  size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  if (head == atomic_load_explicit(&queue->tail, memory_order_acquire))
+    return NULL;
+  void *item = queue->items[head & queue->mask];
+  atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+  return item;
+}
+
+void spsc_queue_push(SpscQueue *queue, void *item)
+{
+  for (int spins = 0; !spsc_queue_try_push(queue, item); spins++)
+    if (spins >= SPIN_LIMIT)
+      sched_yield();
+}
+
+void *spsc_queue_pop(SpscQueue *queue)
+{
+  void *item;
+  for (int spins = 0; !(item = spsc_queue_try_pop(queue)); spins++)
+    if (spins >= SPIN_LIMIT)
+      sched_yield();
+  return item;
+}
+
+//----------------------------------------------------------
+// Frontend stages
+//----------------------------------------------------------
+
+// Pushed after a stage's last item.
+static char end_of_stream;
+#define END_OF_STREAM ((void *)&end_of_stream)
+
+// Tokens of one top-level declaration, ending in an EOF token.
+typedef struct
+{
+  TokenArray tokens;
+  int base; // File-wide index of the first token
+} DeclTokens;
+
+typedef struct
+{
+  const char *source;
+  size_t length;
+  SpscQueue *to_parser;
+  SpscQueue *to_semantic; // NULL without checking
+  SpscQueue *to_lowering; // NULL without lowering
+  FrontendResult *result;
+} Pipeline;
+
+static void append_token(TokenArray *array, const Token *token)
+{
+  if (array->count == array->capacity)
+  {
+    array->capacity *= 2;
+    array->tokens = xrealloc(array->tokens, array->capacity * sizeof(Token));
+  }
+  array->tokens[array->count++] = *token;
+}
+
+// Terminate the current declaration with an EOF token at the position of next
+// and hand it to the parser.
+static void flush_declaration(Pipeline *pipeline, DeclTokens **decl, const Token *next, int index)
+{
+  Token eof = *next;
+  eof.type = TOKEN_EOF;
+  eof.subkind = TOKEN_SUB_NONE;
+  eof.value = NULL;
+  eof.length = 0;
+  eof.in_fstring = 0;
+  memset(&eof.literal, 0, sizeof(eof.literal));
+  eof.atom = ATOM_NONE;
+  append_token(&(*decl)->tokens, &eof);
+  spsc_queue_push(pipeline->to_parser, *decl);
+
+  *decl = xmalloc(sizeof(DeclTokens));
+  (*decl)->tokens = create_token_array();
+  (*decl)->tokens.source = pipeline->source;
+  (*decl)->base = index;
+}
+
+// Cut the token stream where a top-level declaration begins, by the same rule
+// as find_declarations in the parser: let, struct, comptime, or fn not
+// preceded by comptime, outside braces. Anything before the first
+// declaration is sent as one.
+static void *lexer_stage(void *arg)
+{
+  Pipeline *pipeline = arg;
+  Lexer *lexer = create_lexer(pipeline->source, pipeline->length);
+  DeclTokens *decl = xmalloc(sizeof(DeclTokens));
+  decl->tokens = create_token_array();
+  decl->tokens.source = pipeline->source;
+  decl->base = 0;
+  int index = 0;
+  int depth = 0;
+  TokenSubkind previous = TOKEN_SUB_NONE;
+  for (;; index++)
+  {
+    Token token = lexer_next_token(lexer);
+    if (token.type == TOKEN_EOF)
+    {
+      if (decl->tokens.count > 0)
+        flush_declaration(pipeline, &decl, &token, index);
+      break;
+    }
+    int begins = token.subkind == KW_LET || token.subkind == KW_STRUCT || token.subkind == KW_COMPTIME ||
+                 (token.subkind == KW_FN && previous != KW_COMPTIME);
+    if (depth == 0 && begins && decl->tokens.count > 0)
+      flush_declaration(pipeline, &decl, &token, index);
+    append_token(&decl->tokens, &token);
+    if (token.type == TOKEN_LBRACE)
+      depth++;
+    else if (token.type == TOKEN_RBRACE && depth > 0)
+      depth--;
+    previous = token.subkind;
+  }
+  free_token_array(&decl->tokens);
+  free(decl);
+  destroy_lexer(lexer);
+
+  pipeline->result->token_count = index + 1;
+  spsc_queue_push(pipeline->to_parser, END_OF_STREAM);
+  return NULL;
+}
+
+static void add_errors(FrontendResult *result, Parser *parser, int base)
+{
+  if (!parser->error_count)
+    return;
+  result->errors = xrealloc(result->errors, (result->error_count + parser->error_count) * sizeof(ParseError));
+  for (int i = 0; i < parser->error_count; i++)
+  {
+    ParseError error = parser->errors[i];
+    error.token_index += base;
+    result->errors[result->error_count++] = error;
+  }
+  parser->error_count = 0; // Messages now belong to the result
+}
+
+static void *parser_stage(void *arg)
+{
+  Pipeline *pipeline = arg;
+  FrontendResult *result = pipeline->result;
+  SpscQueue *next = pipeline->to_semantic ? pipeline->to_semantic : pipeline->to_lowering;
+  int capacity = 0;
+  ASTArena *previous_arena = ast_arena_set_current(result->arena);
+  for (;;)
+  {
+    DeclTokens *decl = spsc_queue_pop(pipeline->to_parser);
+    if (decl == END_OF_STREAM)
+      break;
+    Parser *parser = create_parser(decl->tokens);
+    parser->print_errors = 0;
+    ASTNode *node = parse_declaration(parser);
+    if (node && parser->current != decl->tokens.count - 1)
+      parser_error(parser, "Expected end of declaration");
+    add_errors(result, parser, decl->base);
+    destroy_parser(parser);
+    free_token_array(&decl->tokens);
+    free(decl);
+    if (!node)
+      continue;
+
+    if (result->decl_count == capacity)
+    {
+      capacity = capacity ? capacity * 2 : 64;
+      result->decls = xrealloc(result->decls, capacity * sizeof(ASTNode *));
+    }
+    result->decls[result->decl_count++] = node;
+    if (next && result->error_count == 0)
+      spsc_queue_push(next, node);
+  }
+  ast_arena_set_current(previous_arena);
+  if (next)
+    spsc_queue_push(next, END_OF_STREAM);
+  return NULL;
+}
+
+// Errors are recorded in the result rather than ending the process, since the
+// other stages are still running. Declarations arrive in order and only until
+// the first parse error, so the k-th one received is decls[k].
+static void *semantic_stage(void *arg)
+{
+  Pipeline *pipeline = arg;
+  SemanticContext context;
+  semantic_context_init(&context, create_symbol_table(NULL));
+  for (int k = 0;; k++)
+  {
+    ASTNode *decl = spsc_queue_pop(pipeline->to_semantic);
+    if (decl == END_OF_STREAM)
+      break;
+    int before = context.diagnostics.count;
+    semantic_check(&context, decl);
+    for (int i = before; i < context.diagnostics.count; i++)
+      context.diagnostics.items[i].decl = k;
+    if (pipeline->to_lowering && context.diagnostics.count == 0)
+      spsc_queue_push(pipeline->to_lowering, decl);
+  }
+  destroy_symbol_table(context.globals);
+  pipeline->result->semantic_errors = context.diagnostics;
+  if (pipeline->to_lowering)
+    spsc_queue_push(pipeline->to_lowering, END_OF_STREAM);
+  return NULL;
+}
+
+static void *lowering_stage(void *arg)
+{
+  Pipeline *pipeline = arg;
+  FrontendResult *result = pipeline->result;
+  FlatIndex *items = NULL;
+  uint32_t count = 0, capacity = 0;
+  for (;;)
+  {
+    ASTNode *decl = spsc_queue_pop(pipeline->to_lowering);
+    if (decl == END_OF_STREAM)
+      break;
+    if (count == capacity)
+    {
+      capacity = capacity ? capacity * 2 : 64;
+      items = xrealloc(items, capacity * sizeof(FlatIndex));
+    }
+    items[count++] = flat_ast_add_tree(result->flat, decl);
+  }
+  result->root = flat_ast_add_block(result->flat, items, count);
+  free(items);
+  return NULL;
+}
+
+static void start_stage(pthread_t *thread, void *(*stage)(void *), Pipeline *pipeline)
+{
+  if (pthread_create(thread, NULL, stage, pipeline) != 0)
+  {
+    fprintf(stderr, "Failed to start frontend thread\n");
+    exit(1);
+  }
+}
+
+// The last enabled stage runs on the calling thread.
+FrontendResult run_frontend_pipeline(const char *source, size_t length, const FrontendOptions *options)
+{
+  FrontendOptions defaults = {DEFAULT_QUEUE_CAPACITY, 1, 1};
+  if (!options)
+    options = &defaults;
+  size_t capacity = options->queue_capacity > 0 ? (size_t)options->queue_capacity : DEFAULT_QUEUE_CAPACITY;
+
+  FrontendResult result = {0};
+  result.arena = create_ast_arena();
+  result.flat = options->lower ? create_flat_ast() : NULL;
+
+  SpscQueue to_parser, to_semantic, to_lowering;
+  Pipeline pipeline = {source, length, &to_parser, NULL, NULL, &result};
+  spsc_queue_init(&to_parser, capacity);
+  if (options->check)
+  {
+    spsc_queue_init(&to_semantic, capacity);
+    pipeline.to_semantic = &to_semantic;
+  }
+  if (options->lower)
+  {
+    spsc_queue_init(&to_lowering, capacity);
+    pipeline.to_lowering = &to_lowering;
+  }
+
+  pthread_t lexer_thread, parser_thread, semantic_thread;
+  start_stage(&lexer_thread, lexer_stage, &pipeline);
+  if (options->lower)
+  {
+    start_stage(&parser_thread, parser_stage, &pipeline);
+    if (options->check)
+      start_stage(&semantic_thread, semantic_stage, &pipeline);
+    lowering_stage(&pipeline);
+    if (options->check)
+      pthread_join(semantic_thread, NULL);
+    pthread_join(parser_thread, NULL);
+  }
+  else if (options->check)
+  {
+    start_stage(&parser_thread, parser_stage, &pipeline);
+    semantic_stage(&pipeline);
+    pthread_join(parser_thread, NULL);
+  }
+  else
+  {
+    parser_stage(&pipeline);
+  }
+  pthread_join(lexer_thread, NULL);
+
+  spsc_queue_destroy(&to_parser);
+  if (options->check)
+    spsc_queue_destroy(&to_semantic);
+  if (options->lower)
+    spsc_queue_destroy(&to_lowering);
+  return result;
+}
+
+void free_frontend_result(FrontendResult *result)
+{
+  for (int i = 0; i < result->error_count; i++)
+    free(result->errors[i].message);
+  free(result->errors);
+  SemanticContext context = {NULL, result->semantic_errors};
+  semantic_context_destroy(&context);
+  free(result->decls);
+  destroy_ast_arena(result->arena);
+  if (result->flat)
+    destroy_flat_ast(result->flat);
+  memset(result, 0, sizeof(*result));
+}
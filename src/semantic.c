@@ -1,68 +1,333 @@
 #include "../include/semantic.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
 
-// Forward declarations for helper functions.
-static void check_expression_type(ASTNode *node, SymbolTable *table);
-static const char *get_expression_type(ASTNode *node, SymbolTable *table);
-static int is_numeric_type(const char *type);
-static int is_primitive_type(const char *type);
+#define MAX_SEMANTIC_THREADS 64
 
 // External function for test exits.
 extern void test_exit(int status);
 
-// Global static variables for current function context and loop depth.
-static const char *current_function_return_type = NULL;
-static int loop_depth = 0;
+// Debug helper: print the AST node type (for tracing).
+static void print_node_type(ASTNode *node)
+{
+  if (!node)
+  {
+    printf("DEBUG: Node is NULL\n");
+    return;
+  }
+  printf("DEBUG: Processing node type %d\n", node->type);
+}
+
+// State of one semantic walk. Each node pushes its type onto types when it is
+// left ("unknown" for statements), so by the time a node is left the types of
+// its visited children are at the top of the stack, in order. Types are
+// computed once per node instead of re-deriving them for every enclosing
+// expression, and are canonical, so they are compared by pointer.
+typedef struct
+{
+  const Type *saved_return_type; // Restored when a function definition is left
+  size_t type_base;              // Height of types when the node was entered
+} SemanticFrame;
+
+typedef struct
+{
+  Atom *items;
+  int count;
+  int capacity;
+} AtomList;
+
+typedef struct
+{
+  SymbolTable *table;      // Scope stack (blocks push and pop scopes)
+  const Type *return_type; // Of the enclosing function, NULL outside one
+  int loop_depth;
+  SemanticDiagnostics *diagnostics; // Where errors go (one list per thread)
+  int decl;                         // Declaration errors are attributed to
+  int failed;                       // Set by the first error; the walk stops
+  AtomList *deps;                   // Names looked up, or NULL if not recorded
+  SemanticFrame *frames;
+  size_t frame_count;
+  size_t frame_capacity;
+  const Type **types;
+  size_t type_count;
+  size_t type_capacity;
+} SemanticWalk;
 
-// Helper: returns true if the type is numeric.
-static int is_numeric_type(const char *type)
+static void *grow_array(void *array, size_t *capacity, size_t element_size)
 {
-  return strcmp(type, "i32") == 0 || strcmp(type, "i64") == 0 ||
-         strcmp(type, "f32") == 0 || strcmp(type, "f64") == 0;
+  *capacity = *capacity ? *capacity * 2 : 64;
+  array = realloc(array, *capacity * element_size);
+  if (!array)
+  {
+    fprintf(stderr, "Memory allocation failed in semantic analysis\n");
+    exit(EXIT_FAILURE);
+  }
+  return array;
+}
+
+static void add_diagnostic(SemanticDiagnostics *diagnostics, int decl, char *message)
+{
+  if (diagnostics->count == diagnostics->capacity)
+  {
+    size_t capacity = (size_t)diagnostics->capacity;
+    diagnostics->items = grow_array(diagnostics->items, &capacity, sizeof(SemanticDiagnostic));
+    diagnostics->capacity = (int)capacity;
+  }
+  diagnostics->items[diagnostics->count++] = (SemanticDiagnostic){decl, message};
 }
 
-// Helper: Report a semantic error and exit.
-static void semantic_error(const char *message, ...)
+// Helper: Record a semantic error. The caller stops the walk.
+static void semantic_error(SemanticWalk *walk, const char *message, ...)
 {
   va_list args;
   va_start(args, message);
-  vfprintf(stderr, message, args);
+  int length = vsnprintf(NULL, 0, message, args);
+  va_end(args);
+  char *text = malloc((size_t)length + 1);
+  if (!text)
+  {
+    fprintf(stderr, "Memory allocation failed in semantic analysis\n");
+    exit(EXIT_FAILURE);
+  }
+  va_start(args, message);
+  vsnprintf(text, (size_t)length + 1, message, args);
   va_end(args);
-  test_exit(1);
+  add_diagnostic(walk->diagnostics, walk->decl, text);
+  walk->failed = 1;
 }
 
-// Debug helper: print the AST node type (for tracing).
-static void print_node_type(ASTNode *node)
+static void push_type(SemanticWalk *walk, const Type *type)
 {
-  if (!node)
+  if (walk->type_count == walk->type_capacity)
+    walk->types = grow_array(walk->types, &walk->type_capacity, sizeof(const Type *));
+  walk->types[walk->type_count++] = type;
+}
+
+// A shared node stands for the same expression in several places, where it
+// may have different types, and function bodies are checked on several
+// threads at once; so it keeps no type of its own.
+static void set_value_type(ASTNode *node, const Type *type)
+{
+  if (!(node->flags & AST_NODE_SHARED))
+    node->value_type = type;
+}
+
+// Name lookups go through these so that incremental checking can record what
+// a declaration depends on. Every name is recorded, local or global: a local
+// one costs a lookup when the fingerprint is taken, but never a wrong reuse.
+static void add_dependency(SemanticWalk *walk, Atom name)
+{
+  AtomList *deps = walk->deps;
+  if (deps->count == deps->capacity)
   {
-    printf("DEBUG: Node is NULL\n");
-    return;
+    size_t capacity = (size_t)deps->capacity;
+    deps->items = grow_array(deps->items, &capacity, sizeof(Atom));
+    deps->capacity = (int)capacity;
   }
-  printf("DEBUG: Processing node type %d\n", node->type);
+  deps->items[deps->count++] = name;
+}
+
+static Symbol *lookup_name(SemanticWalk *walk, Atom name)
+{
+  if (walk->deps)
+    add_dependency(walk, name);
+  return lookup_symbol_atom(walk->table, name);
+}
+
+static Symbol *lookup_local_name(SemanticWalk *walk, Atom name)
+{
+  if (walk->deps)
+    add_dependency(walk, name);
+  return lookup_symbol_local(walk->table, name);
+}
+
+// Struct types carry their name as text, which need not be interned yet.
+static Symbol *lookup_struct_name(SemanticWalk *walk, const char *name)
+{
+  if (walk->deps)
+    return lookup_name(walk, intern_cstring(name));
+  return lookup_symbol(walk->table, name);
 }
 
-// Helper: Get function parameter count (expects a function definition node).
-static int get_func_param_count(ASTNode *func_def)
+static void enter_scope(SemanticWalk *walk)
 {
-  if (func_def->type != AST_FUNC_DEF)
+  push_scope(walk->table);
+}
+
+static void leave_scope(SemanticWalk *walk)
+{
+  pop_scope(walk->table);
+}
+
+// Parameters are declared by their function definition, not visited.
+static int is_parameter(ASTNode *node, ASTNode *parent)
+{
+  return parent && parent->type == AST_FUNC_DEF && node != parent->data.func_def.body;
+}
+
+// The block of a for loop, which sees the loop iterator.
+static int is_loop_block(ASTNode *node, ASTNode *parent)
+{
+  return parent && parent->type == AST_FOR_STMT && node == parent->data.for_stmt.block;
+}
+
+// Type of the i-th visited child, "unknown" if there is none.
+static const Type *child_type(const Type **children, size_t count, size_t i)
+{
+  return i < count ? children[i] : create_type(TYPE_UNKNOWN);
+}
+
+// Determine the type of an expression from the types of its children.
+static const Type *expression_type(SemanticWalk *walk, ASTNode *node, const Type **children, size_t count)
+{
+  switch (node->type)
   {
-    semantic_error("Internal Error: Expected function definition node\n");
+  case AST_IDENTIFIER:
+  {
+    Symbol *symbol = lookup_name(walk, node->data.identifier.atom);
+    return symbol ? symbol->type : create_type(TYPE_UNKNOWN);
+  }
+  case AST_LITERAL:
+  {
+    printf("DEBUG: Checking literal value '%s'\n", node->data.literal.value);
+    switch (node->data.literal.parsed.kind)
+    {
+    case LITERAL_STRING:
+      return create_type(TYPE_STRING);
+    case LITERAL_BOOL:
+      return create_type(TYPE_BOOL);
+    case LITERAL_FLOAT:
+      return create_type(TYPE_F64);
+    case LITERAL_INT:
+      return create_type(TYPE_I32);
+    default:
+      break;
+    }
+    // Text the lexer did not recognize as a literal.
+    char first_char = node->data.literal.value[0];
+    if (first_char == '"')
+      return create_type(TYPE_STRING);
+    if (first_char == 't' || first_char == 'f')
+      return create_type(TYPE_BOOL);
+    if (strchr(node->data.literal.value, '.'))
+      return create_type(TYPE_F64);
+    return create_type(TYPE_I32);
+  }
+  case AST_FUNC_CALL:
+  {
+    Symbol *func = lookup_name(walk, node->data.func_call.atom);
+    return func ? func->type : create_type(TYPE_UNKNOWN);
+  }
+  case AST_BINARY_EXPR:
+  {
+    const Type *left_type = child_type(children, count, 0);
+    const Type *right_type = child_type(children, count, 1);
+    const Type *f64 = create_type(TYPE_F64);
+    const Type *i32 = create_type(TYPE_I32);
+    if (strcmp(node->data.binary_expr.op, "**") == 0)
+    {
+      if (!is_numeric_type(left_type) || !is_numeric_type(right_type))
+      {
+        semantic_error(walk, "Semantic Error: Power operator requires numeric operands, got %s and %s\n",
+                       type_to_string(left_type), type_to_string(right_type));
+        return create_type(TYPE_ERROR);
+      }
+      return (left_type == f64 || right_type == f64) ? f64 : i32;
+    }
+    if (strcmp(node->data.binary_expr.op, "==") == 0 ||
+        strcmp(node->data.binary_expr.op, "!=") == 0 ||
+        strcmp(node->data.binary_expr.op, "<") == 0 ||
+        strcmp(node->data.binary_expr.op, "<=") == 0 ||
+        strcmp(node->data.binary_expr.op, ">") == 0 ||
+        strcmp(node->data.binary_expr.op, ">=") == 0)
+    {
+      if (left_type != right_type)
+      {
+        semantic_error(walk, "Semantic Error: Comparison operands must be of the same type, got %s and %s\n",
+                       type_to_string(left_type), type_to_string(right_type));
+        return create_type(TYPE_ERROR);
+      }
+      return create_type(TYPE_BOOL);
+    }
+    if (left_type == right_type)
+      return left_type;
+    if ((left_type == f64 && right_type == i32) || (left_type == i32 && right_type == f64))
+      return f64;
+    return create_type(TYPE_UNKNOWN);
+  }
+  case AST_UNARY_EXPR:
+    return child_type(children, count, 0);
+  case AST_ARRAY_LITERAL:
+  {
+    return type_array_of(child_type(children, count, 0));
+  }
+  case AST_ARRAY_INDEX:
+  {
+    const Type *array_type = child_type(children, count, 0);
+    if (array_type->kind == TYPE_ARRAY)
+      return array_type->info.element;
+    return create_type(TYPE_UNKNOWN);
+  }
+  case AST_FIELD_ACCESS:
+  {
+    const Type *struct_type = child_type(children, count, 0);
+    if (struct_type->kind != TYPE_STRUCT)
+    {
+      semantic_error(walk, "Semantic Error: Cannot access field '%s' of non-struct type '%s'\n",
+                     node->data.field_access.field_name, type_to_string(struct_type));
+      return create_type(TYPE_ERROR);
+    }
+    const char *struct_name = struct_type->info.struct_info->name;
+    Symbol *struct_sym = lookup_struct_name(walk, struct_name);
+    if (!struct_sym || !struct_sym->node || struct_sym->node->type != AST_STRUCT_DEF)
+    {
+      semantic_error(walk, "Semantic Error: Undefined struct type '%s'\n", struct_name);
+      return create_type(TYPE_ERROR);
+    }
+    ASTNode *struct_def = struct_sym->node;
+    for (int i = 0; i < struct_def->data.struct_def.field_count; i++)
+    {
+      if (strcmp(struct_def->data.struct_def.field_names[i],
+                 node->data.field_access.field_name) == 0)
+      {
+        return type_from_string(struct_def->data.struct_def.field_types[i]);
+      }
+    }
+    semantic_error(walk, "Semantic Error: Struct '%s' has no field named '%s'\n",
+                   struct_name, node->data.field_access.field_name);
+    return create_type(TYPE_ERROR);
+  }
+  default:
+    return create_type(TYPE_UNKNOWN);
   }
-  return func_def->data.func_def.param_count;
 }
 
-// Recursively visit the AST to perform semantic checks.
-void semantic_visit(ASTNode *node, SymbolTable *table)
+// Checks made when a node is entered: declarations and scopes that its
+// children depend on, and nodes without children.
+static ASTWalkAction semantic_enter(ASTNode *node, ASTNode *parent, void *context)
 {
-  if (!node)
-    return;
+  SemanticWalk *walk = context;
+
+  if (walk->frame_count == walk->frame_capacity)
+    walk->frames = grow_array(walk->frames, &walk->frame_capacity, sizeof(SemanticFrame));
+  walk->frames[walk->frame_count++] = (SemanticFrame){walk->return_type, walk->type_count};
+
+  if (is_parameter(node, parent))
+    return AST_WALK_SKIP;
 
   print_node_type(node);
 
+  // Only case statements may appear between a switch expression and its finally block.
+  if (parent && parent->type == AST_SWITCH_STMT && node != parent->data.switch_stmt.expr &&
+      node != parent->data.switch_stmt.finally_block && node->type != AST_CASE_STMT)
+  {
+    semantic_error(walk, "Semantic Error: Expected case statement in switch\n");
+    return AST_WALK_STOP;
+  }
+
   switch (node->type)
   {
   case AST_VAR_DECL:
@@ -71,596 +336,972 @@ void semantic_visit(ASTNode *node, SymbolTable *table)
            node->data.var_decl.identifier);
 
     // Check for duplicate declarations in the current scope.
-    for (int i = 0; i < table->count; i++)
+    if (lookup_local_name(walk, node->data.var_decl.atom))
     {
-      if (strcmp(table->symbols[i]->name, node->data.var_decl.identifier) == 0)
-      {
-        semantic_error("Semantic Error: Duplicate declaration of '%s' in current scope\n",
-                       node->data.var_decl.identifier);
-      }
+      semantic_error(walk, "Semantic Error: Duplicate declaration of '%s' in current scope\n",
+                     node->data.var_decl.identifier);
+      return AST_WALK_STOP;
     }
 
     // Require a type annotation.
     if (!node->data.var_decl.type_annotation)
     {
-      semantic_error("Semantic Error: Missing type annotation for variable '%s'\n",
+      semantic_error(walk, "Semantic Error: Missing type annotation for variable '%s'\n",
                      node->data.var_decl.identifier);
+      return AST_WALK_STOP;
     }
 
-    // Check initializer, if present.
     if (node->data.var_decl.initializer)
     {
       printf("DEBUG: Checking initializer for '%s'\n",
              node->data.var_decl.identifier);
-      semantic_visit(node->data.var_decl.initializer, table);
-      const char *init_type = get_expression_type(node->data.var_decl.initializer, table);
-      printf("DEBUG: Initializer type is '%s'\n", init_type);
-      if (strcmp(init_type, node->data.var_decl.type_annotation) != 0)
-      {
-        semantic_error("Semantic Error: Type mismatch in initialization of '%s'. Expected %s, got %s\n",
-                       node->data.var_decl.identifier,
-                       node->data.var_decl.type_annotation,
-                       init_type);
-      }
     }
-
-    // Add the variable to the current symbol table.
-    printf("DEBUG: Adding symbol '%s' with type '%s'\n",
-           node->data.var_decl.identifier,
-           node->data.var_decl.type_annotation);
-    add_symbol(table, node->data.var_decl.identifier,
-               node->data.var_decl.type_annotation);
     break;
   }
 
   case AST_IDENTIFIER:
   {
     // Ensure the identifier was declared.
-    Symbol *symbol = lookup_symbol(table, node->data.identifier.name);
+    Symbol *symbol = lookup_name(walk, node->data.identifier.atom);
     if (!symbol)
     {
-      semantic_error("Semantic Error: Undeclared identifier '%s'\n",
+      semantic_error(walk, "Semantic Error: Undeclared identifier '%s'\n",
                      node->data.identifier.name);
+      return AST_WALK_STOP;
     }
     break;
   }
 
   case AST_FUNC_DEF:
   {
-    // Save previous return type.
-    const char *prev_return_type = current_function_return_type;
-
-    // Set current function return type.
-    current_function_return_type = node->data.func_def.return_type
-                                       ? node->data.func_def.return_type
-                                       : "void";
+    // Set current function return type; the previous one is in the frame.
+    walk->return_type = node->data.func_def.return_type
+                            ? type_from_string(node->data.func_def.return_type)
+                            : create_type(TYPE_VOID);
 
     // Check for duplicate function declarations.
-    for (int i = 0; i < table->count; i++)
+    if (lookup_local_name(walk, node->data.func_def.atom))
     {
-      if (strcmp(table->symbols[i]->name, node->data.func_def.name) == 0)
-      {
-        semantic_error("Semantic Error: Duplicate function declaration '%s' in current scope\n",
-                       node->data.func_def.name);
-      }
+      semantic_error(walk, "Semantic Error: Duplicate function declaration '%s' in current scope\n",
+                     node->data.func_def.name);
+      return AST_WALK_STOP;
     }
 
     // Add function to symbol table before analyzing its body.
-    add_symbol_with_node(table, node->data.func_def.name,
-                         current_function_return_type, node);
-
-    // Create a new scope for the function body.
-    SymbolTable *func_scope = create_symbol_table(table);
+    add_symbol_atom(walk->table, node->data.func_def.atom, walk->return_type, node);
 
-    // Add function parameters to the new scope.
+    // Create a new scope for the function body and add the parameters to it.
+    enter_scope(walk);
     for (int i = 0; i < node->data.func_def.param_count; i++)
     {
       ASTNode *param = node->data.func_def.parameters[i];
       if (param->type != AST_VAR_DECL)
       {
-        semantic_error("Semantic Error: Invalid parameter in function '%s'\n",
+        semantic_error(walk, "Semantic Error: Invalid parameter in function '%s'\n",
                        node->data.func_def.name);
+        return AST_WALK_STOP;
       }
-      add_symbol(func_scope, param->data.var_decl.identifier,
-                 param->data.var_decl.type_annotation);
+      add_symbol_atom(walk->table, param->data.var_decl.atom,
+                      type_from_string(param->data.var_decl.type_annotation), NULL);
     }
 
-    // Analyze the function body.
-    semantic_visit(node->data.func_def.body, func_scope);
-    destroy_symbol_table(func_scope);
-
-    // Restore the previous function return type.
-    current_function_return_type = prev_return_type;
+    // Parse a deferred body so it is visited.
+    if (!func_def_body(node))
+    {
+      semantic_error(walk, "Semantic Error: Syntax error in body of function '%s'\n",
+                     node->data.func_def.name);
+      return AST_WALK_STOP;
+    }
     break;
   }
 
   case AST_FUNC_CALL:
   {
     // Check if the function exists.
-    Symbol *func = lookup_symbol(table, node->data.func_call.name);
+    Symbol *func = lookup_name(walk, node->data.func_call.atom);
     if (!func)
     {
-      semantic_error("Semantic Error: Call to undefined function '%s'\n",
+      semantic_error(walk, "Semantic Error: Call to undefined function '%s'\n",
                      node->data.func_call.name);
+      return AST_WALK_STOP;
     }
-    // If available, check parameter count and argument types.
-    if (func->node && func->node->type == AST_FUNC_DEF)
+    // Arguments are only checked against a known function definition.
+    if (!func->node || func->node->type != AST_FUNC_DEF)
+      return AST_WALK_SKIP;
+    int expected_params = func->node->data.func_def.param_count;
+    if (node->data.func_call.arg_count != expected_params)
     {
-      int expected_params = func->node->data.func_def.param_count;
-      if (node->data.func_call.arg_count != expected_params)
-      {
-        semantic_error("Semantic Error: Function '%s' expects %d arguments, but got %d\n",
-                       node->data.func_call.name,
-                       expected_params,
-                       node->data.func_call.arg_count);
-      }
-      for (int i = 0; i < node->data.func_call.arg_count; i++)
-      {
-        semantic_visit(node->data.func_call.arguments[i], table);
-        const char *arg_type = get_expression_type(node->data.func_call.arguments[i], table);
-        const char *param_type = func->node->data.func_def.parameters[i]->data.var_decl.type_annotation;
-        if (strcmp(arg_type, param_type) != 0)
-        {
-          semantic_error("Semantic Error: Argument %d of call to '%s' has wrong type. Expected %s, got %s\n",
-                         i + 1, node->data.func_call.name, param_type, arg_type);
-        }
-      }
+      semantic_error(walk, "Semantic Error: Function '%s' expects %d arguments, but got %d\n",
+                     node->data.func_call.name,
+                     expected_params,
+                     node->data.func_call.arg_count);
+      return AST_WALK_STOP;
     }
     break;
   }
 
   case AST_BLOCK:
-  {
-    // Create a new scope for the block.
-    SymbolTable *block_scope = create_symbol_table(table);
-    for (int i = 0; i < node->data.block.stmt_count; i++)
-    {
-      semantic_visit(node->data.block.statements[i], block_scope);
-    }
-    destroy_symbol_table(block_scope);
-    break;
-  }
-
-  case AST_BINARY_EXPR:
-  {
-    semantic_visit(node->data.binary_expr.left, table);
-    semantic_visit(node->data.binary_expr.right, table);
-    check_expression_type(node, table);
-    break;
-  }
-
-  case AST_UNARY_EXPR:
-  {
-    semantic_visit(node->data.unary_expr.operand, table);
-    check_expression_type(node, table);
-    break;
-  }
-
-  case AST_IF_STMT:
-  {
-    // Analyze the main if condition and block.
-    semantic_visit(node->data.if_stmt.condition, table);
-    semantic_visit(node->data.if_stmt.if_block, table);
-    // Analyze each elif branch.
-    for (int i = 0; i < node->data.if_stmt.elif_count; i++)
-    {
-      semantic_visit(node->data.if_stmt.elif_conds[i], table);
-      semantic_visit(node->data.if_stmt.elif_blocks[i], table);
-      const char *cond_type = get_expression_type(node->data.if_stmt.elif_conds[i], table);
-      if (strcmp(cond_type, "bool") != 0)
-      {
-        semantic_error("Semantic Error: Elif condition must be boolean, got %s\n", cond_type);
-      }
-    }
-    // Analyze the else block if present.
-    if (node->data.if_stmt.else_block)
-    {
-      semantic_visit(node->data.if_stmt.else_block, table);
-    }
-    // Verify that the main if condition is boolean.
-    const char *main_cond_type = get_expression_type(node->data.if_stmt.condition, table);
-    if (strcmp(main_cond_type, "bool") != 0)
+    if (is_loop_block(node, parent))
     {
-      semantic_error("Semantic Error: If condition must be boolean, got %s\n", main_cond_type);
+      // Scope for the loop iterator (using "i32" as a placeholder type).
+      enter_scope(walk);
+      add_symbol_atom(walk->table, parent->data.for_stmt.iterator_atom, create_type(TYPE_I32), NULL);
     }
+    // Create a new scope for the block.
+    enter_scope(walk);
     break;
-  }
 
   case AST_WHILE_STMT:
-  {
-    loop_depth++;
-    semantic_visit(node->data.while_stmt.condition, table);
-    semantic_visit(node->data.while_stmt.block, table);
-    loop_depth--;
-    break;
-  }
-
   case AST_FOR_STMT:
-  {
-    loop_depth++;
-    // Create a new scope for the loop.
-    SymbolTable *loop_scope = create_symbol_table(table);
-    // Add the iterator variable (using "i32" as a placeholder type).
-    add_symbol(loop_scope, node->data.for_stmt.iterator, "i32");
-    semantic_visit(node->data.for_stmt.start_expr, table);
-    semantic_visit(node->data.for_stmt.end_expr, table);
-    semantic_visit(node->data.for_stmt.block, loop_scope);
-    destroy_symbol_table(loop_scope);
-    loop_depth--;
+    walk->loop_depth++;
     break;
-  }
 
-  case AST_ASSIGN_EXPR:
-  {
-    semantic_visit(node->data.assign_expr.left, table);
-    semantic_visit(node->data.assign_expr.right, table);
-    const char *left_type = get_expression_type(node->data.assign_expr.left, table);
-    const char *right_type = get_expression_type(node->data.assign_expr.right, table);
-    if (strcmp(left_type, right_type) != 0)
+  case AST_RETURN_STMT:
+    if (!walk->return_type)
     {
-      semantic_error("Semantic Error: Type mismatch in assignment. Expected %s, got %s\n",
-                     left_type, right_type);
+      semantic_error(walk, "Semantic Error: Return statement outside of function\n");
+      return AST_WALK_STOP;
     }
     break;
-  }
-
-  case AST_EXPR_STMT:
-    semantic_visit(node->data.expr_stmt.expr, table);
-    break;
 
-  case AST_PRINT_STMT:
-    semantic_visit(node->data.print_stmt.expr, table);
+  case AST_BREAK_STMT:
+    if (walk->loop_depth == 0)
+    {
+      semantic_error(walk, "Semantic Error: Break statement outside of loop\n");
+      return AST_WALK_STOP;
+    }
     break;
 
-  case AST_PROMPT_STMT:
-    semantic_visit(node->data.prompt_stmt.expr, table);
+  case AST_CONTINUE_STMT:
+    if (walk->loop_depth == 0)
+    {
+      semantic_error(walk, "Semantic Error: Continue statement outside of loop\n");
+      return AST_WALK_STOP;
+    }
     break;
 
-  case AST_LITERAL:
-    // Literals need no further checking.
+  case AST_SWITCH_STMT:
+    // Create a new scope for the switch.
+    enter_scope(walk);
     break;
 
-  case AST_RETURN_STMT:
+  case AST_CASE_STMT:
   {
-    if (!current_function_return_type)
+    // Case statements should only occur within a switch.
+    if (!parent || parent->type != AST_SWITCH_STMT)
     {
-      semantic_error("Semantic Error: Return statement outside of function\n");
+      semantic_error(walk, "Semantic Error: Case statement outside of switch\n");
+      return AST_WALK_STOP;
     }
-    if (node->data.return_stmt.expr)
+    ASTNode *switch_expr = parent->data.switch_stmt.expr;
+    Symbol *switch_expr_sym = NULL;
+    if (switch_expr->type == AST_IDENTIFIER)
     {
-      semantic_visit(node->data.return_stmt.expr, table);
-      const char *expr_type = get_expression_type(node->data.return_stmt.expr, table);
-      if (strcmp(current_function_return_type, expr_type) != 0)
+      switch_expr_sym = lookup_name(walk, switch_expr->data.identifier.atom);
+      if (!switch_expr_sym)
       {
-        semantic_error("Semantic Error: Return type mismatch. Expected %s, got %s\n",
-                       current_function_return_type, expr_type);
+        semantic_error(walk, "Semantic Error: Undefined variable in switch expression\n");
+        return AST_WALK_STOP;
       }
     }
-    else if (strcmp(current_function_return_type, "void") != 0)
+    // (Basic type check for literal cases; can be extended.)
+    if (switch_expr_sym && node->data.case_stmt.expr->type == AST_LITERAL)
     {
-      semantic_error("Semantic Error: Expected return value in non-void function\n");
+      if (node->data.case_stmt.expr->data.literal.parsed.kind == LITERAL_STRING &&
+          switch_expr_sym->type && switch_expr_sym->type != create_type(TYPE_STRING))
+      {
+        semantic_error(walk, "Semantic Error: Case expression type does not match switch expression type\n");
+        return AST_WALK_STOP;
+      }
     }
     break;
   }
 
-  case AST_ARRAY_LITERAL:
+  case AST_STRUCT_DEF:
   {
-    if (node->data.array_literal.element_count > 0)
+    // Check for duplicate struct definitions.
+    Symbol *existing = lookup_name(walk, node->data.struct_def.atom);
+    if (existing)
     {
-      semantic_visit(node->data.array_literal.elements[0], table);
-      const char *first_type = get_expression_type(node->data.array_literal.elements[0], table);
-      for (int i = 1; i < node->data.array_literal.element_count; i++)
+      semantic_error(walk, "Semantic Error: Duplicate definition of struct '%s'\n",
+                     node->data.struct_def.name);
+      return AST_WALK_STOP;
+    }
+    // Check for duplicate field names.
+    for (int i = 0; i < node->data.struct_def.field_count; i++)
+    {
+      for (int j = i + 1; j < node->data.struct_def.field_count; j++)
       {
-        semantic_visit(node->data.array_literal.elements[i], table);
-        const char *curr_type = get_expression_type(node->data.array_literal.elements[i], table);
-        if (strcmp(first_type, curr_type) != 0)
+        if (strcmp(node->data.struct_def.field_names[i],
+                   node->data.struct_def.field_names[j]) == 0)
         {
-          semantic_error("Semantic Error: Array literal contains mixed types: %s and %s\n",
-                         first_type, curr_type);
+          semantic_error(walk, "Semantic Error: Duplicate field name '%s' in struct '%s'\n",
+                         node->data.struct_def.field_names[i],
+                         node->data.struct_def.name);
+          return AST_WALK_STOP;
         }
       }
     }
-    break;
-  }
-
-  case AST_ARRAY_INDEX:
-  {
-    semantic_visit(node->data.array_index.array, table);
-    semantic_visit(node->data.array_index.index, table);
-    const char *array_type = get_expression_type(node->data.array_index.array, table);
-    if (strstr(array_type, "[]") == NULL)
-    {
-      semantic_error("Semantic Error: Cannot index non-array type %s\n", array_type);
-    }
-    const char *index_type = get_expression_type(node->data.array_index.index, table);
-    if (strcmp(index_type, "i32") != 0 && strcmp(index_type, "i64") != 0)
+    // Verify each field type.
+    for (int i = 0; i < node->data.struct_def.field_count; i++)
     {
-      semantic_error("Semantic Error: Array index must be integer type, got %s\n", index_type);
+      const char *field_type = node->data.struct_def.field_types[i];
+      if (strncmp(field_type, "struct ", 7) == 0)
+      {
+        Symbol *ref_struct = lookup_struct_name(walk, field_type + 7);
+        if (!ref_struct || !ref_struct->node || ref_struct->node->type != AST_STRUCT_DEF)
+        {
+          semantic_error(walk, "Semantic Error: Field '%s' references undefined struct type '%s'\n",
+                         node->data.struct_def.field_names[i], field_type + 7);
+          return AST_WALK_STOP;
+        }
+      }
+      else if (!is_primitive_type(type_from_string(field_type)))
+      {
+        semantic_error(walk, "Semantic Error: Invalid type '%s' for field '%s' in struct '%s'\n",
+                       field_type, node->data.struct_def.field_names[i],
+                       node->data.struct_def.name);
+        return AST_WALK_STOP;
+      }
     }
+    // Add the struct to the symbol table.
+    add_symbol_atom(walk->table, node->data.struct_def.atom, type_struct_named(node->data.struct_def.name), node);
     break;
   }
 
-  case AST_BREAK_STMT:
-  {
-    if (loop_depth == 0)
-    {
-      semantic_error("Semantic Error: Break statement outside of loop\n");
-    }
+  case AST_EXPR_STMT:
+  case AST_PRINT_STMT:
+  case AST_PROMPT_STMT:
+  case AST_LITERAL:
+  case AST_BINARY_EXPR:
+  case AST_UNARY_EXPR:
+  case AST_IF_STMT:
+  case AST_ASSIGN_EXPR:
+  case AST_ARRAY_LITERAL:
+  case AST_ARRAY_INDEX:
+  case AST_FSTRING:
+  case AST_STRING_INTERP:
+  case AST_FIELD_ACCESS:
+    // Checked when left, once the types of their children are known.
     break;
+
+  default:
+    semantic_error(walk, "Semantic Error: Unhandled AST node type %d\n", node->type);
+    return AST_WALK_STOP;
   }
+  return AST_WALK_CONTINUE;
+}
 
-  case AST_CONTINUE_STMT:
+// Checks made when a node is left, against the types of its children; then
+// push the node's own type.
+static ASTWalkAction semantic_leave(ASTNode *node, ASTNode *parent, void *context)
+{
+  SemanticWalk *walk = context;
+  SemanticFrame frame = walk->frames[--walk->frame_count];
+  const Type **children = &walk->types[frame.type_base];
+  size_t count = walk->type_count - frame.type_base;
+  walk->type_count = frame.type_base;
+
+  if (is_parameter(node, parent))
+  {
+    set_value_type(node, create_type(TYPE_UNKNOWN));
+    push_type(walk, create_type(TYPE_UNKNOWN));
+    return AST_WALK_CONTINUE;
+  }
+
+  switch (node->type)
   {
-    if (loop_depth == 0)
+  case AST_VAR_DECL:
+  {
+    if (node->data.var_decl.initializer)
     {
-      semantic_error("Semantic Error: Continue statement outside of loop\n");
+      const Type *init_type = child_type(children, count, 0);
+      printf("DEBUG: Initializer type is '%s'\n", type_to_string(init_type));
+      if (init_type != type_from_string(node->data.var_decl.type_annotation))
+      {
+        semantic_error(walk, "Semantic Error: Type mismatch in initialization of '%s'. Expected %s, got %s\n",
+                       node->data.var_decl.identifier,
+                       node->data.var_decl.type_annotation,
+                       type_to_string(init_type));
+        return AST_WALK_STOP;
+      }
+      // A literal of the right kind must also be in range, checked on the
+      // value the lexer parsed.
+      ASTNode *initializer = node->data.var_decl.initializer;
+      if (initializer->type == AST_LITERAL && initializer->data.literal.parsed.kind != LITERAL_NONE &&
+          !is_literal_compatible_with_type(&initializer->data.literal.parsed, init_type))
+      {
+        semantic_error(walk, "Semantic Error: Literal %s out of range for %s in initialization of '%s'\n",
+                       initializer->data.literal.value,
+                       node->data.var_decl.type_annotation,
+                       node->data.var_decl.identifier);
+        return AST_WALK_STOP;
+      }
     }
+
+    // Add the variable to the current symbol table.
+    printf("DEBUG: Adding symbol '%s' with type '%s'\n",
+           node->data.var_decl.identifier,
+           node->data.var_decl.type_annotation);
+    add_symbol_atom(walk->table, node->data.var_decl.atom,
+                    type_from_string(node->data.var_decl.type_annotation), NULL);
     break;
   }
 
-  case AST_SWITCH_STMT:
+  case AST_FUNC_DEF:
+    // Close the function scope and restore the previous function return type.
+    leave_scope(walk);
+    walk->return_type = frame.saved_return_type;
+    break;
+
+  case AST_FUNC_CALL:
   {
-    // Check the switch expression.
-    semantic_visit(node->data.switch_stmt.expr, table);
-    Symbol *switch_expr_sym = NULL;
-    if (node->data.switch_stmt.expr->type == AST_IDENTIFIER)
+    // Arguments were visited only if the callee is a function definition.
+    Symbol *func = lookup_name(walk, node->data.func_call.atom);
+    for (int i = 0; i < node->data.func_call.arg_count && (size_t)i < count; i++)
     {
-      switch_expr_sym = lookup_symbol(table, node->data.switch_stmt.expr->data.identifier.name);
-      if (!switch_expr_sym)
+      const Type *arg_type = children[i];
+      const char *param_type = func->node->data.func_def.parameters[i]->data.var_decl.type_annotation;
+      if (arg_type != type_from_string(param_type))
       {
-        semantic_error("Semantic Error: Undefined variable in switch expression\n");
+        semantic_error(walk, "Semantic Error: Argument %d of call to '%s' has wrong type. Expected %s, got %s\n",
+                       i + 1, node->data.func_call.name, param_type, type_to_string(arg_type));
+        return AST_WALK_STOP;
       }
     }
+    break;
+  }
 
-    // Create a new scope for the switch.
-    SymbolTable *switch_scope = create_symbol_table(table);
-    for (int i = 0; i < node->data.switch_stmt.case_count; i++)
+  case AST_BLOCK:
+    leave_scope(walk);
+    if (is_loop_block(node, parent))
+      leave_scope(walk);
+    break;
+
+  case AST_WHILE_STMT:
+  case AST_FOR_STMT:
+    walk->loop_depth--;
+    break;
+
+  case AST_IF_STMT:
+  {
+    // Children: condition, if block, (elif condition, elif block)*, else block.
+    for (int i = 0; i < node->data.if_stmt.elif_count; i++)
     {
-      ASTNode *case_node = node->data.switch_stmt.cases[i];
-      if (case_node->type != AST_CASE_STMT)
+      const Type *cond_type = child_type(children, count, 2 + 2 * (size_t)i);
+      if (cond_type != create_type(TYPE_BOOL))
       {
-        semantic_error("Semantic Error: Expected case statement in switch\n");
+        semantic_error(walk, "Semantic Error: Elif condition must be boolean, got %s\n", type_to_string(cond_type));
+        return AST_WALK_STOP;
       }
-      semantic_visit(case_node->data.case_stmt.expr, switch_scope);
-      // (Basic type check for literal cases; can be extended.)
-      if (switch_expr_sym && case_node->data.case_stmt.expr->type == AST_LITERAL)
-      {
-        if (strchr(case_node->data.case_stmt.expr->data.literal.value, '"') != NULL &&
-            switch_expr_sym->type && strcmp(switch_expr_sym->type, "string") != 0)
-        {
-          semantic_error("Semantic Error: Case expression type does not match switch expression type\n");
-        }
-      }
-      semantic_visit(case_node->data.case_stmt.statement, switch_scope);
     }
-    if (node->data.switch_stmt.finally_block)
+    // Verify that the main if condition is boolean.
+    const Type *main_cond_type = child_type(children, count, 0);
+    if (main_cond_type != create_type(TYPE_BOOL))
     {
-      semantic_visit(node->data.switch_stmt.finally_block, switch_scope);
+      semantic_error(walk, "Semantic Error: If condition must be boolean, got %s\n", type_to_string(main_cond_type));
+      return AST_WALK_STOP;
     }
-    destroy_symbol_table(switch_scope);
     break;
   }
 
-  case AST_CASE_STMT:
-    // Case statements should only occur within a switch.
-    semantic_error("Semantic Error: Case statement outside of switch\n");
+  case AST_ASSIGN_EXPR:
+  {
+    const Type *left_type = child_type(children, count, 0);
+    const Type *right_type = child_type(children, count, 1);
+    if (left_type != right_type)
+    {
+      semantic_error(walk, "Semantic Error: Type mismatch in assignment. Expected %s, got %s\n",
+                     type_to_string(left_type), type_to_string(right_type));
+      return AST_WALK_STOP;
+    }
     break;
+  }
 
-  case AST_FSTRING:
+  case AST_RETURN_STMT:
   {
-    for (int i = 0; i < node->data.fstring.part_count; i++)
+    if (node->data.return_stmt.expr)
     {
-      ASTNode *part = node->data.fstring.parts[i];
-      semantic_visit(part, table);
-      if (part->type != AST_LITERAL && part->type != AST_STRING_INTERP)
+      const Type *expr_type = child_type(children, count, 0);
+      if (walk->return_type != expr_type)
       {
-        semantic_error("Semantic Error: Invalid f-string part\n");
+        semantic_error(walk, "Semantic Error: Return type mismatch. Expected %s, got %s\n",
+                       type_to_string(walk->return_type), type_to_string(expr_type));
+        return AST_WALK_STOP;
       }
     }
+    else if (walk->return_type != create_type(TYPE_VOID))
+    {
+      semantic_error(walk, "Semantic Error: Expected return value in non-void function\n");
+      return AST_WALK_STOP;
+    }
     break;
   }
 
-  case AST_STRING_INTERP:
+  case AST_ARRAY_LITERAL:
   {
-    semantic_visit(node->data.string_interp.expr, table);
+    for (size_t i = 1; i < count; i++)
+    {
+      if (children[0] != children[i])
+      {
+        semantic_error(walk, "Semantic Error: Array literal contains mixed types: %s and %s\n",
+                       type_to_string(children[0]), type_to_string(children[i]));
+        return AST_WALK_STOP;
+      }
+    }
     break;
   }
 
-  case AST_STRUCT_DEF:
+  case AST_ARRAY_INDEX:
   {
-    // Check for duplicate struct definitions.
-    Symbol *existing = lookup_symbol(table, node->data.struct_def.name);
-    if (existing)
+    const Type *array_type = child_type(children, count, 0);
+    if (array_type->kind != TYPE_ARRAY)
     {
-      semantic_error("Semantic Error: Duplicate definition of struct '%s'\n",
-                     node->data.struct_def.name);
+      semantic_error(walk, "Semantic Error: Cannot index non-array type %s\n", type_to_string(array_type));
+      return AST_WALK_STOP;
     }
-    // Check for duplicate field names.
-    for (int i = 0; i < node->data.struct_def.field_count; i++)
+    const Type *index_type = child_type(children, count, 1);
+    if (index_type != create_type(TYPE_I32) && index_type != create_type(TYPE_I64))
     {
-      for (int j = i + 1; j < node->data.struct_def.field_count; j++)
-      {
-        if (strcmp(node->data.struct_def.field_names[i],
-                   node->data.struct_def.field_names[j]) == 0)
-        {
-          semantic_error("Semantic Error: Duplicate field name '%s' in struct '%s'\n",
-                         node->data.struct_def.field_names[i],
-                         node->data.struct_def.name);
-        }
-      }
+      semantic_error(walk, "Semantic Error: Array index must be integer type, got %s\n", type_to_string(index_type));
+      return AST_WALK_STOP;
     }
-    // Verify each field type.
-    for (int i = 0; i < node->data.struct_def.field_count; i++)
+    break;
+  }
+
+  case AST_SWITCH_STMT:
+    leave_scope(walk);
+    break;
+
+  case AST_FSTRING:
+  {
+    for (int i = 0; i < node->data.fstring.part_count; i++)
     {
-      const char *field_type = node->data.struct_def.field_types[i];
-      if (strncmp(field_type, "struct ", 7) == 0)
-      {
-        Symbol *ref_struct = lookup_symbol(table, field_type + 7);
-        if (!ref_struct || !ref_struct->node || ref_struct->node->type != AST_STRUCT_DEF)
-        {
-          semantic_error("Semantic Error: Field '%s' references undefined struct type '%s'\n",
-                         node->data.struct_def.field_names[i], field_type + 7);
-        }
-      }
-      else if (!is_primitive_type(field_type))
+      ASTNode *part = node->data.fstring.parts[i];
+      if (part->type != AST_LITERAL && part->type != AST_STRING_INTERP)
       {
-        semantic_error("Semantic Error: Invalid type '%s' for field '%s' in struct '%s'\n",
-                       field_type, node->data.struct_def.field_names[i],
-                       node->data.struct_def.name);
+        semantic_error(walk, "Semantic Error: Invalid f-string part\n");
+        return AST_WALK_STOP;
       }
     }
-    // Add the struct to the symbol table.
-    char type_name[256];
-    snprintf(type_name, sizeof(type_name), "struct %s", node->data.struct_def.name);
-    add_symbol_with_node(table, node->data.struct_def.name, type_name, node);
     break;
   }
 
   case AST_FIELD_ACCESS:
-  {
-    semantic_visit(node->data.field_access.struct_expr, table);
-    const char *struct_type = get_expression_type(node->data.field_access.struct_expr, table);
-    if (strcmp(struct_type, "unknown") == 0)
+    if (child_type(children, count, 0) == create_type(TYPE_UNKNOWN))
     {
-      semantic_error("Semantic Error: Invalid field access\n");
+      semantic_error(walk, "Semantic Error: Invalid field access\n");
+      return AST_WALK_STOP;
     }
     break;
-  }
 
   default:
-    semantic_error("Semantic Error: Unhandled AST node type %d\n", node->type);
+    break;
   }
+
+  const Type *type = expression_type(walk, node, children, count);
+  if (walk->failed)
+    return AST_WALK_STOP;
+  // Operators must produce a known type.
+  if ((node->type == AST_BINARY_EXPR || node->type == AST_UNARY_EXPR) && type == create_type(TYPE_UNKNOWN))
+  {
+    semantic_error(walk, "Semantic Error: Invalid type in expression\n");
+    return AST_WALK_STOP;
+  }
+  set_value_type(node, type);
+  push_type(walk, type);
+  return AST_WALK_CONTINUE;
 }
 
-// Helper: Determine the type of an expression.
-static const char *get_expression_type(ASTNode *node, SymbolTable *table)
+// Walk a tree with the given scope stack, recording errors for declaration
+// decl, and the names it looks up in deps unless that is NULL. A failed walk
+// stops at its first error and closes the scopes it opened. Returns 1 if the
+// tree checked without errors.
+static int check_tree(ASTNode *node, SymbolTable *table, const Type *return_type,
+                      SemanticDiagnostics *diagnostics, int decl, AtomList *deps)
 {
-  if (!node)
-    return "unknown";
+  SemanticWalk walk = {0};
+  walk.table = table;
+  walk.return_type = return_type;
+  walk.diagnostics = diagnostics;
+  walk.decl = decl;
+  walk.deps = deps;
+  int depth = table->depth;
+  ASTVisitor visitor = {semantic_enter, semantic_leave, &walk};
+  ast_walk(node, &visitor);
+  while (table->depth > depth)
+    pop_scope(table);
+  free(walk.frames);
+  free(walk.types);
+  return !walk.failed;
+}
 
-  switch (node->type)
+void semantic_context_init(SemanticContext *context, SymbolTable *globals)
+{
+  memset(context, 0, sizeof(*context));
+  context->globals = globals;
+}
+
+void semantic_context_destroy(SemanticContext *context)
+{
+  for (int i = 0; i < context->diagnostics.count; i++)
+    free(context->diagnostics.items[i].message);
+  free(context->diagnostics.items);
+  memset(&context->diagnostics, 0, sizeof(context->diagnostics));
+}
+
+int semantic_check(SemanticContext *context, ASTNode *node)
+{
+  int before = context->diagnostics.count;
+  check_tree(node, context->globals, NULL, &context->diagnostics, 0, NULL);
+  return context->diagnostics.count - before;
+}
+
+// A function body checked on a worker: the function is already declared in
+// the global scope, and sees the globals declared up to and including it.
+typedef struct
+{
+  ASTNode *func;
+  int decl;
+  int visible_globals;
+  AtomList *deps; // Where the body's lookups are recorded, or NULL
+} BodyJob;
+
+typedef struct
+{
+  SymbolTable *globals; // Read-only while workers run
+  const BodyJob *jobs;
+  int first;
+  int last;
+  SemanticDiagnostics diagnostics;
+} SemanticWorker;
+
+// Check a function body in a scope of its own whose parent is the global
+// scope, as check_tree does when it reaches the definition.
+static void check_body(SemanticWorker *worker, const BodyJob *job)
+{
+  ASTNode *func = job->func;
+  SymbolTable *locals = create_symbol_table(worker->globals);
+  locals->parent_limit = job->visible_globals;
+  SemanticWalk walk = {0};
+  walk.diagnostics = &worker->diagnostics;
+  walk.decl = job->decl;
+  for (int i = 0; i < func->data.func_def.param_count; i++)
   {
-  case AST_IDENTIFIER:
+    ASTNode *param = func->data.func_def.parameters[i];
+    if (param->type != AST_VAR_DECL)
+    {
+      semantic_error(&walk, "Semantic Error: Invalid parameter in function '%s'\n",
+                     func->data.func_def.name);
+      destroy_symbol_table(locals);
+      return;
+    }
+    add_symbol_atom(locals, param->data.var_decl.atom,
+                    type_from_string(param->data.var_decl.type_annotation), NULL);
+    set_value_type(param, create_type(TYPE_UNKNOWN));
+  }
+  const Type *return_type = func->data.func_def.return_type
+                                ? type_from_string(func->data.func_def.return_type)
+                                : create_type(TYPE_VOID);
+  if (check_tree(func->data.func_def.body, locals, return_type, &worker->diagnostics, job->decl, job->deps))
+    set_value_type(func, create_type(TYPE_UNKNOWN));
+  destroy_symbol_table(locals);
+}
+
+static void *semantic_worker(void *arg)
+{
+  SemanticWorker *worker = arg;
+  for (int k = worker->first; k < worker->last; k++)
+    check_body(worker, &worker->jobs[k]);
+  return NULL;
+}
+
+// Append diagnostics ordered by declaration, merging two runs that each are.
+static void merge_diagnostics(SemanticDiagnostics *out, const SemanticDiagnostics *a, const SemanticDiagnostics *b)
+{
+  int i = 0, j = 0;
+  while (i < a->count || j < b->count)
   {
-    Symbol *symbol = lookup_symbol(table, node->data.identifier.name);
-    return symbol ? symbol->type : "unknown";
+    int take_a = j == b->count || (i < a->count && a->items[i].decl <= b->items[j].decl);
+    SemanticDiagnostic next = take_a ? a->items[i++] : b->items[j++];
+    add_diagnostic(out, next.decl, next.message);
   }
-  case AST_LITERAL:
+}
+
+// Check queued function bodies, split into contiguous runs, one per worker;
+// the first run is checked on the calling thread. Workers hold consecutive
+// runs of declarations, so their lists concatenate into out in declaration
+// order.
+static void check_bodies(SymbolTable *globals, const BodyJob *jobs, int job_count, int thread_count,
+                         SemanticDiagnostics *out)
+{
+  if (thread_count > MAX_SEMANTIC_THREADS)
+    thread_count = MAX_SEMANTIC_THREADS;
+  if (thread_count > job_count)
+    thread_count = job_count;
+  if (thread_count < 1)
+    thread_count = 1;
+  SemanticWorker workers[MAX_SEMANTIC_THREADS];
+  pthread_t threads[MAX_SEMANTIC_THREADS];
+  for (int w = 0; w < thread_count; w++)
   {
-    printf("DEBUG: Checking literal value '%s'\n", node->data.literal.value);
-    char first_char = node->data.literal.value[0];
-    if (first_char == '"')
-      return "string";
-    if (first_char == 't' || first_char == 'f')
-      return "bool";
-    if (strchr(node->data.literal.value, '.'))
-      return "f64";
-    return "i32";
+    workers[w] = (SemanticWorker){globals, jobs, job_count * w / thread_count,
+                                  job_count * (w + 1) / thread_count, {0}};
+    if (w > 0 && pthread_create(&threads[w], NULL, semantic_worker, &workers[w]) != 0)
+    {
+      fprintf(stderr, "Failed to start semantic analysis thread\n");
+      exit(1);
+    }
   }
-  case AST_FUNC_CALL:
+  semantic_worker(&workers[0]);
+  for (int w = 1; w < thread_count; w++)
+    pthread_join(threads[w], NULL);
+
+  for (int w = 0; w < thread_count; w++)
   {
-    Symbol *func = lookup_symbol(table, node->data.func_call.name);
-    return func ? func->type : "unknown";
+    for (int i = 0; i < workers[w].diagnostics.count; i++)
+      add_diagnostic(out, workers[w].diagnostics.items[i].decl, workers[w].diagnostics.items[i].message);
+    free(workers[w].diagnostics.items);
   }
-  case AST_BINARY_EXPR:
+}
+
+static void *checked_malloc(size_t size)
+{
+  void *memory = malloc(size ? size : 1);
+  if (!memory)
   {
-    const char *left_type = get_expression_type(node->data.binary_expr.left, table);
-    const char *right_type = get_expression_type(node->data.binary_expr.right, table);
-    if (strcmp(node->data.binary_expr.op, "**") == 0)
-    {
-      if (!is_numeric_type(left_type) || !is_numeric_type(right_type))
-      {
-        semantic_error("Semantic Error: Power operator requires numeric operands, got %s and %s\n",
-                       left_type, right_type);
-      }
-      return (strcmp(left_type, "f64") == 0 || strcmp(right_type, "f64") == 0) ? "f64" : "i32";
-    }
-    if (strcmp(node->data.binary_expr.op, "==") == 0 ||
-        strcmp(node->data.binary_expr.op, "!=") == 0 ||
-        strcmp(node->data.binary_expr.op, "<") == 0 ||
-        strcmp(node->data.binary_expr.op, "<=") == 0 ||
-        strcmp(node->data.binary_expr.op, ">") == 0 ||
-        strcmp(node->data.binary_expr.op, ">=") == 0)
-    {
-      if (strcmp(left_type, right_type) != 0)
-      {
-        semantic_error("Semantic Error: Comparison operands must be of the same type, got %s and %s\n",
-                       left_type, right_type);
-      }
-      return "bool";
-    }
-    if (strcmp(left_type, right_type) == 0)
-      return left_type;
-    if ((strcmp(left_type, "f64") == 0 && strcmp(right_type, "i32") == 0) ||
-        (strcmp(left_type, "i32") == 0 && strcmp(right_type, "f64") == 0))
-      return "f64";
-    return "unknown";
+    fprintf(stderr, "Memory allocation failed in semantic analysis\n");
+    exit(EXIT_FAILURE);
   }
-  case AST_UNARY_EXPR:
-    return get_expression_type(node->data.unary_expr.operand, table);
-  case AST_ARRAY_LITERAL:
+  return memory;
+}
+
+// Declare a function in the global scope and queue its body, or record a
+// duplicate declaration. Returns 1 if the body was queued.
+static int queue_body(SymbolTable *globals, ASTNode *decl, int k, SemanticDiagnostics *serial,
+                      BodyJob *jobs, int *job_count, AtomList *deps)
+{
+  if (lookup_symbol_local(globals, decl->data.func_def.atom))
+  {
+    SemanticWalk walk = {.diagnostics = serial, .decl = k};
+    semantic_error(&walk, "Semantic Error: Duplicate function declaration '%s' in current scope\n",
+                   decl->data.func_def.name);
+    return 0;
+  }
+  const Type *return_type = decl->data.func_def.return_type
+                                ? type_from_string(decl->data.func_def.return_type)
+                                : create_type(TYPE_VOID);
+  add_symbol_atom(globals, decl->data.func_def.atom, return_type, decl);
+  // Deferred bodies are parsed here, before any worker reads the tree.
+  if (!func_def_body(decl))
+  {
+    SemanticWalk walk = {.diagnostics = serial, .decl = k};
+    semantic_error(&walk, "Semantic Error: Syntax error in body of function '%s'\n",
+                   decl->data.func_def.name);
+    return 0;
+  }
+  jobs[(*job_count)++] = (BodyJob){decl, k, globals->count, deps};
+  return 1;
+}
+
+// Declarations other than function definitions are checked in order on the
+// calling thread, and each function is declared there before its body is
+// queued, so the global scope is complete and read-only once the workers
+// start.
+int semantic_check_program(SemanticContext *context, ASTNode **decls, int count, int thread_count)
+{
+  SymbolTable *globals = context->globals;
+  SemanticDiagnostics serial = {0};
+  BodyJob *jobs = checked_malloc(count * sizeof(BodyJob));
+  int job_count = 0;
+  for (int k = 0; k < count; k++)
+  {
+    if (decls[k]->type == AST_FUNC_DEF)
+      queue_body(globals, decls[k], k, &serial, jobs, &job_count, NULL);
+    else
+      check_tree(decls[k], globals, NULL, &serial, k, NULL);
+  }
+
+  SemanticDiagnostics bodies = {0};
+  check_bodies(globals, jobs, job_count, thread_count, &bodies);
+  int before = context->diagnostics.count;
+  merge_diagnostics(&context->diagnostics, &serial, &bodies);
+  free(serial.items);
+  free(bodies.items);
+  free(jobs);
+  return context->diagnostics.count - before;
+}
+
+// Cached result of checking one top-level declaration.
+typedef struct
+{
+  ASTNode *node;        // NULL once the result has moved to a newer update
+  Atom *deps;           // Names it looked up, sorted, without repeats
+  int dep_count;
+  uint64_t fingerprint; // Of what deps resolved to before the declaration
+  char **messages;      // Its errors, in the order they were found
+  int message_count;
+  int declared;         // Whether it added a global, described by the rest
+  Atom name;
+  const Type *type;
+  ASTNode *symbol_node;
+} DeclResult;
+
+struct SemanticProgram
+{
+  SymbolTable *globals;
+  DeclResult *results; // One per declaration of the last update
+  int count;
+  SemanticDiagnostics diagnostics; // Messages are owned by results
+  int rechecked;
+};
+
+static uint64_t mix(uint64_t hash, uint64_t value)
+{
+  hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+static uint64_t hash_text(uint64_t hash, const char *text)
+{
+  for (; text && *text; text++)
+    hash = mix(hash, (unsigned char)*text);
+  return hash;
+}
+
+// Everything about a global symbol that checking its users reads: its type,
+// and the signature of a function or the fields of a struct. 0 if unbound.
+static uint64_t symbol_interface(const Symbol *symbol)
+{
+  if (!symbol)
+    return 0;
+  ASTNode *node = symbol->node;
+  uint64_t hash = mix((uintptr_t)symbol->type, node ? (uint64_t)node->type + 1 : 0);
+  if (node && node->type == AST_FUNC_DEF)
   {
-    if (node->data.array_literal.element_count > 0)
+    hash = mix(hash, (uint64_t)node->data.func_def.param_count);
+    for (int i = 0; i < node->data.func_def.param_count; i++)
     {
-      const char *elem_type = get_expression_type(node->data.array_literal.elements[0], table);
-      static char array_type[64];
-      snprintf(array_type, sizeof(array_type), "%s[]", elem_type);
-      return array_type;
+      ASTNode *param = node->data.func_def.parameters[i];
+      hash = mix(hash, param->type == AST_VAR_DECL
+                           ? (uintptr_t)type_from_string(param->data.var_decl.type_annotation)
+                           : 0);
     }
-    return "unknown[]";
   }
-  case AST_ARRAY_INDEX:
+  else if (node && node->type == AST_STRUCT_DEF)
   {
-    const char *array_type = get_expression_type(node->data.array_index.array, table);
-    static char elem_type[64];
-    size_t len = strlen(array_type);
-    if (len > 2)
+    for (int i = 0; i < node->data.struct_def.field_count; i++)
     {
-      strncpy(elem_type, array_type, len - 2);
-      elem_type[len - 2] = '\0';
-      return elem_type;
+      hash = hash_text(hash, node->data.struct_def.field_names[i]);
+      hash = mix(hash, (uintptr_t)type_from_string(node->data.struct_def.field_types[i]));
     }
-    return "unknown";
   }
-  case AST_FIELD_ACCESS:
+  return hash | 1;
+}
+
+// What the names a declaration depends on resolve to in the global scope,
+// seeing only the first visible globals: those declared before it.
+static uint64_t dependency_fingerprint(SymbolTable *globals, int visible, const Atom *deps, int count)
+{
+  SymbolTable view = {0};
+  view.parent = globals;
+  view.parent_limit = visible;
+  uint64_t hash = 0;
+  for (int i = 0; i < count; i++)
+    hash = mix(mix(hash, deps[i]), symbol_interface(lookup_symbol_atom(&view, deps[i])));
+  return hash;
+}
+
+static int compare_atoms(const void *a, const void *b)
+{
+  Atom x = *(const Atom *)a, y = *(const Atom *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void free_result(DeclResult *result)
+{
+  for (int i = 0; i < result->message_count; i++)
+    free(result->messages[i]);
+  free(result->messages);
+  free(result->deps);
+}
+
+SemanticProgram *create_semantic_program(void)
+{
+  SemanticProgram *program = calloc(1, sizeof(SemanticProgram));
+  if (!program)
   {
-    const char *struct_type = get_expression_type(node->data.field_access.struct_expr, table);
-    if (strncmp(struct_type, "struct ", 7) != 0)
+    fprintf(stderr, "Memory allocation failed in semantic analysis\n");
+    exit(EXIT_FAILURE);
+  }
+  program->globals = create_symbol_table(NULL);
+  return program;
+}
+
+void destroy_semantic_program(SemanticProgram *program)
+{
+  if (!program)
+    return;
+  for (int k = 0; k < program->count; k++)
+    free_result(&program->results[k]);
+  free(program->results);
+  free(program->diagnostics.items);
+  destroy_symbol_table(program->globals);
+  free(program);
+}
+
+// Slot of node in an open-addressing table of result indices (-1 if empty).
+static size_t result_slot(const int *slots, size_t mask, const DeclResult *results, const ASTNode *node)
+{
+  size_t slot = ((uintptr_t)node >> 4) * 0x9e3779b97f4a7c15ull & mask;
+  while (slots[slot] >= 0 && results[slots[slot]].node != node)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+// The global scope is rebuilt in declaration order. A declaration seen in the
+// last update whose dependencies still resolve as they did is not walked
+// again: its global, if it declared one, is added back and its errors are
+// kept. The others are checked as semantic_check_program does, recording the
+// names they look up, which a function's body adds to its own name.
+int semantic_program_update(SemanticProgram *program, ASTNode **decls, int count, int thread_count)
+{
+  DeclResult *old = program->results;
+  size_t mask = 15;
+  while (mask + 1 < 2 * (size_t)program->count)
+    mask = mask * 2 + 1;
+  int *slots = checked_malloc((mask + 1) * sizeof(int));
+  memset(slots, -1, (mask + 1) * sizeof(int));
+  for (int k = 0; k < program->count; k++)
+    slots[result_slot(slots, mask, old, old[k].node)] = k;
+
+  destroy_symbol_table(program->globals);
+  SymbolTable *globals = program->globals = create_symbol_table(NULL);
+  DeclResult *results = calloc(count ? count : 1, sizeof(DeclResult));
+  AtomList *deps = calloc(count ? count : 1, sizeof(AtomList));
+  int *visible = checked_malloc(count * sizeof(int));
+  BodyJob *jobs = checked_malloc(count * sizeof(BodyJob));
+  if (!results || !deps)
+  {
+    fprintf(stderr, "Memory allocation failed in semantic analysis\n");
+    exit(EXIT_FAILURE);
+  }
+  SemanticDiagnostics serial = {0};
+  int job_count = 0;
+  program->rechecked = 0;
+  for (int k = 0; k < count; k++)
+  {
+    ASTNode *decl = decls[k];
+    visible[k] = globals->count;
+    int index = slots[result_slot(slots, mask, old, decl)];
+    if (index >= 0 &&
+        dependency_fingerprint(globals, visible[k], old[index].deps, old[index].dep_count) == old[index].fingerprint)
     {
-      semantic_error("Semantic Error: Cannot access field '%s' of non-struct type '%s'\n",
-                     node->data.field_access.field_name, struct_type);
+      // Taken once: a node listed twice is checked again the second time.
+      results[k] = old[index];
+      old[index].node = NULL;
+      if (results[k].declared)
+        add_symbol_atom(globals, results[k].name, results[k].type, results[k].symbol_node);
+      continue;
     }
-    Symbol *struct_sym = lookup_symbol(table, struct_type + 7); // Skip "struct " prefix.
-    if (!struct_sym || !struct_sym->node || struct_sym->node->type != AST_STRUCT_DEF)
+
+    program->rechecked++;
+    results[k].node = decl;
+    if (decl->type == AST_FUNC_DEF)
     {
-      semantic_error("Semantic Error: Undefined struct type '%s'\n", struct_type + 7);
+      // The duplicate check looks the function's own name up.
+      SemanticWalk walk = {.deps = &deps[k]};
+      add_dependency(&walk, decl->data.func_def.atom);
+      queue_body(globals, decl, k, &serial, jobs, &job_count, &deps[k]);
     }
-    ASTNode *struct_def = struct_sym->node;
-    for (int i = 0; i < struct_def->data.struct_def.field_count; i++)
+    else
+      check_tree(decl, globals, NULL, &serial, k, &deps[k]);
+    if (globals->count > visible[k])
     {
-      if (strcmp(struct_def->data.struct_def.field_names[i],
-                 node->data.field_access.field_name) == 0)
+      Symbol *symbol = globals->symbols[globals->count - 1];
+      results[k].declared = 1;
+      results[k].name = symbol->atom;
+      results[k].type = symbol->type;
+      results[k].symbol_node = symbol->node;
+    }
+  }
+  free(slots);
+
+  SemanticDiagnostics bodies = {0};
+  check_bodies(globals, jobs, job_count, thread_count, &bodies);
+  SemanticDiagnostics *lists[] = {&serial, &bodies};
+  for (int l = 0; l < 2; l++)
+  {
+    for (int i = 0; i < lists[l]->count; i++)
+    {
+      DeclResult *result = &results[lists[l]->items[i].decl];
+      result->messages = realloc(result->messages, (result->message_count + 1) * sizeof(char *));
+      if (!result->messages)
       {
-        return struct_def->data.struct_def.field_types[i];
+        fprintf(stderr, "Memory allocation failed in semantic analysis\n");
+        exit(EXIT_FAILURE);
       }
+      result->messages[result->message_count++] = lists[l]->items[i].message;
     }
-    semantic_error("Semantic Error: Struct '%s' has no field named '%s'\n",
-                   struct_type + 7, node->data.field_access.field_name);
-    return "unknown";
+    free(lists[l]->items);
   }
-  default:
-    return "unknown";
+
+  program->diagnostics.count = 0;
+  for (int k = 0; k < count; k++)
+  {
+    DeclResult *result = &results[k];
+    if (deps[k].items)
+    {
+      // Checked in this update: keep what it looked up.
+      qsort(deps[k].items, deps[k].count, sizeof(Atom), compare_atoms);
+      int unique = 0;
+      for (int i = 0; i < deps[k].count; i++)
+        if (unique == 0 || deps[k].items[unique - 1] != deps[k].items[i])
+          deps[k].items[unique++] = deps[k].items[i];
+      result->deps = deps[k].items;
+      result->dep_count = unique;
+      result->fingerprint = dependency_fingerprint(globals, visible[k], result->deps, unique);
+    }
+    for (int i = 0; i < result->message_count; i++)
+      add_diagnostic(&program->diagnostics, k, result->messages[i]);
   }
+
+  for (int k = 0; k < program->count; k++)
+    if (old[k].node)
+      free_result(&old[k]);
+  free(old);
+  free(deps);
+  free(visible);
+  free(jobs);
+  program->results = results;
+  program->count = count;
+  return program->diagnostics.count;
+}
+
+const SemanticDiagnostics *semantic_program_diagnostics(const SemanticProgram *program)
+{
+  return &program->diagnostics;
 }
 
-// Helper: Check that an expression's type is not "unknown".
-static void check_expression_type(ASTNode *node, SymbolTable *table)
+int semantic_program_rechecked(const SemanticProgram *program)
 {
-  const char *type = get_expression_type(node, table);
-  if (strcmp(type, "unknown") == 0)
+  return program->rechecked;
+}
+
+// Visit the AST to perform semantic checks, without recursion, and exit
+// through test_exit on the first error.
+void semantic_visit(ASTNode *node, SymbolTable *table)
+{
+  SemanticContext context;
+  semantic_context_init(&context, table);
+  if (semantic_check(&context, node))
   {
-    semantic_error("Semantic Error: Invalid type in expression\n");
+    fputs(context.diagnostics.items[0].message, stderr);
+    semantic_context_destroy(&context);
+    test_exit(1);
+    return;
   }
+  semantic_context_destroy(&context);
 }
 
 // Entry point: perform semantic analysis starting from the root AST node.
@@ -672,16 +1313,3 @@ void semantic_analysis(ASTNode *root)
   destroy_symbol_table(global);
   printf("DEBUG: Completed semantic analysis\n");
 }
-
-// Helper: Check if a type is one of the recognized primitive types.
-static int is_primitive_type(const char *type)
-{
-  return strcmp(type, "i32") == 0 ||
-         strcmp(type, "i64") == 0 ||
-         strcmp(type, "f32") == 0 ||
-         strcmp(type, "f64") == 0 ||
-         strcmp(type, "bool") == 0 ||
-         strcmp(type, "char") == 0 ||
-         strcmp(type, "string") == 0 ||
-         strcmp(type, "void") == 0;
-}
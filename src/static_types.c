@@ -6,6 +6,8 @@
 #include <limits.h>
 #include <float.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
 
 //----------------------------------------------------------
 // Memory Allocation Helpers
@@ -33,39 +35,264 @@ static char *xstrdup(const char *s)
 }
 
 //----------------------------------------------------------
-// Create a new type instance.
+// Type context: canonical types.
+//
+// Types without an identity (every kind but structs, arrays and opaque
+// names) are preallocated for each combination of flags. The others are
+// hash-consed in a table keyed by kind, flags and identity (the interned name
+// of a struct or opaque type, the canonical element type of an array), which
+// is shared by all threads behind a lock.
 //----------------------------------------------------------
-Type *create_type(BasicTypeKind kind)
+#define FLAG_VARIANTS 4 // is_const * 2 + is_comptime
+#define FLAGS(is_const, is_comptime) (((is_const) ? 2 : 0) | ((is_comptime) ? 1 : 0))
+
+static Type basic_types[TYPE_ERROR + 1][FLAG_VARIANTS];
+static pthread_once_t basic_types_once = PTHREAD_ONCE_INIT;
+
+typedef struct
+{
+    uint64_t key; // Kind, flags and identity
+    Type *type;
+} TypeSlot;
+
+static struct
+{
+    pthread_mutex_t lock;
+    TypeSlot *slots;
+    size_t slot_count; // Power of two
+    size_t used;
+} derived_types = {PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0};
+
+static const char *kind_name(BasicTypeKind kind)
+{
+    switch (kind)
+    {
+    case TYPE_I32:
+        return "i32";
+    case TYPE_I64:
+        return "i64";
+    case TYPE_F32:
+        return "f32";
+    case TYPE_F64:
+        return "f64";
+    case TYPE_BOOL:
+        return "bool";
+    case TYPE_CHAR:
+        return "char";
+    case TYPE_STRING:
+        return "string";
+    case TYPE_VOID:
+        return "void";
+    case TYPE_UNKNOWN:
+        return "unknown";
+    case TYPE_ERROR:
+        return "error";
+    default:
+        return "invalid";
+    }
+}
+
+// Interned spelling of a type: flags, then prefix, base name and suffix.
+// Unknown and error types are spelled without flags.
+static const char *type_name(const char *prefix, const char *base, const char *suffix, BasicTypeKind kind,
+                             bool is_const, bool is_comptime)
+{
+    bool flags = kind != TYPE_UNKNOWN && kind != TYPE_ERROR;
+    const char *comptime = flags && is_comptime ? "comptime " : "";
+    const char *constant = flags && is_const ? "const " : "";
+    size_t size = strlen(comptime) + strlen(constant) + strlen(prefix) + strlen(base) + strlen(suffix) + 1;
+    char *buffer = (char *)xmalloc(size);
+    snprintf(buffer, size, "%s%s%s%s%s", comptime, constant, prefix, base, suffix);
+    const char *name = atom_text(intern_cstring(buffer));
+    free(buffer);
+    return name;
+}
+
+static void init_basic_types(void)
+{
+    for (int kind = 0; kind <= TYPE_ERROR; kind++)
+    {
+        for (int flags = 0; flags < FLAG_VARIANTS; flags++)
+        {
+            Type *type = &basic_types[kind][flags];
+            type->kind = (BasicTypeKind)kind;
+            type->is_const = flags & 2;
+            type->is_comptime = flags & 1;
+            type->name = type_name("", kind_name(kind), "", kind, type->is_const, type->is_comptime);
+            type->info.struct_info = NULL;
+        }
+    }
+}
+
+static uint64_t derived_key(BasicTypeKind kind, int flags, uint64_t identity)
+{
+    return identity << 8 | (uint64_t)kind << 2 | (uint64_t)flags;
+}
+
+static size_t key_hash(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key;
+}
+
+static void insert_derived(TypeSlot slot)
+{
+    size_t mask = derived_types.slot_count - 1;
+    size_t i = key_hash(slot.key) & mask;
+    while (derived_types.slots[i].type)
+        i = (i + 1) & mask;
+    derived_types.slots[i] = slot;
+}
+
+// The canonical derived type for key, created by make (under the lock) on
+// first use.
+static Type *intern_derived(uint64_t key, Type *(*make)(const void *arg), const void *arg)
 {
+    pthread_mutex_lock(&derived_types.lock);
+    if (derived_types.slot_count)
+    {
+        size_t mask = derived_types.slot_count - 1;
+        for (size_t i = key_hash(key) & mask; derived_types.slots[i].type; i = (i + 1) & mask)
+        {
+            if (derived_types.slots[i].key == key)
+            {
+                Type *found = derived_types.slots[i].type;
+                pthread_mutex_unlock(&derived_types.lock);
+                return found;
+            }
+        }
+    }
+    if ((derived_types.used + 1) * 2 > derived_types.slot_count)
+    {
+        TypeSlot *old = derived_types.slots;
+        size_t old_count = derived_types.slot_count;
+        derived_types.slot_count = old_count ? old_count * 2 : 64;
+        derived_types.slots = calloc(derived_types.slot_count, sizeof(TypeSlot));
+        if (!derived_types.slots)
+        {
+            fprintf(stderr, "Error: Failed to allocate type table\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < old_count; i++)
+            if (old[i].type)
+                insert_derived(old[i]);
+        free(old);
+    }
+    Type *type = make(arg);
+    insert_derived((TypeSlot){key, type});
+    derived_types.used++;
+    pthread_mutex_unlock(&derived_types.lock);
+    return type;
+}
+
+typedef struct
+{
+    BasicTypeKind kind;
+    bool is_const;
+    bool is_comptime;
+    Atom name;            // Struct or opaque name
+    const Type *element;  // Array element
+} DerivedSpec;
+
+static Type *make_derived(const void *arg)
+{
+    const DerivedSpec *spec = arg;
     Type *type = (Type *)xmalloc(sizeof(Type));
-    type->kind = kind;
-    type->is_const = false;
-    type->is_comptime = false;
+    type->kind = spec->kind;
+    type->is_const = spec->is_const;
+    type->is_comptime = spec->is_comptime;
+    type->info.struct_info = NULL;
+    if (spec->kind == TYPE_ARRAY)
+    {
+        type->name = type_name("", spec->element->name, "[]", spec->kind, spec->is_const, spec->is_comptime);
+        type->info.element = spec->element;
+    }
+    else if (spec->kind == TYPE_STRUCT)
+    {
+        type->name = type_name("struct ", atom_text(spec->name), "", spec->kind, spec->is_const, spec->is_comptime);
+        type->info.struct_info = (StructType *)xmalloc(sizeof(StructType));
+        type->info.struct_info->name = xstrdup(atom_text(spec->name));
+        type->info.struct_info->fields = NULL;
+        type->info.struct_info->field_count = 0;
+    }
+    else
+    {
+        type->name = atom_text(spec->name);
+    }
     return type;
 }
 
+static Type *derived_type(const DerivedSpec *spec)
+{
+    uint64_t identity = spec->kind == TYPE_ARRAY ? (uint64_t)(uintptr_t)spec->element : spec->name;
+    return intern_derived(derived_key(spec->kind, FLAGS(spec->is_const, spec->is_comptime), identity),
+                          make_derived, spec);
+}
+
+Type *type_get(BasicTypeKind kind, bool is_const, bool is_comptime)
+{
+    pthread_once(&basic_types_once, init_basic_types);
+    if (kind == TYPE_STRUCT || kind == TYPE_ARRAY || kind > TYPE_ERROR)
+        kind = TYPE_ERROR;
+    return &basic_types[kind][FLAGS(is_const, is_comptime)];
+}
+
+Type *type_with_flags(const Type *type, bool is_const, bool is_comptime)
+{
+    if (!type)
+        return type_get(TYPE_UNKNOWN, false, false);
+    if (type->is_const == is_const && type->is_comptime == is_comptime)
+        return (Type *)type;
+    if (type->kind == TYPE_ARRAY)
+        return derived_type(&(DerivedSpec){TYPE_ARRAY, is_const, is_comptime, ATOM_NONE, type->info.element});
+    if (type->kind == TYPE_STRUCT)
+        return derived_type(&(DerivedSpec){TYPE_STRUCT, is_const, is_comptime,
+                                           intern_cstring(type->info.struct_info->name), NULL});
+    if (type->kind == TYPE_UNKNOWN && type != type_get(TYPE_UNKNOWN, false, false))
+        return (Type *)type; // Opaque names carry no flags
+    return type_get(type->kind, is_const, is_comptime);
+}
+
+Type *type_array_of(const Type *element)
+{
+    if (!element)
+        element = type_get(TYPE_UNKNOWN, false, false);
+    return derived_type(&(DerivedSpec){TYPE_ARRAY, false, false, ATOM_NONE, element});
+}
+
+Type *type_struct_named(const char *name)
+{
+    return derived_type(&(DerivedSpec){TYPE_STRUCT, false, false, intern_cstring(name), NULL});
+}
+
 //----------------------------------------------------------
-// Create a const type instance.
+// Get the canonical plain type of a kind.
+//----------------------------------------------------------
+Type *create_type(BasicTypeKind kind)
+{
+    return type_get(kind, false, false);
+}
+
+//----------------------------------------------------------
+// Get the canonical const type of a kind.
 //----------------------------------------------------------
 Type *create_const_type(BasicTypeKind kind)
 {
-    Type *type = create_type(kind);
-    type->is_const = true;
-    return type;
+    return type_get(kind, true, false);
 }
 
 //----------------------------------------------------------
-// Create a comptime type instance.
+// Get the canonical comptime type of a kind.
 //----------------------------------------------------------
 Type *create_comptime_type(BasicTypeKind kind)
 {
-    Type *type = create_type(kind);
-    type->is_comptime = true;
-    return type;
+    return type_get(kind, false, true);
 }
 
 //----------------------------------------------------------
-// Convert a type string to a Type instance.
+// Convert a type string to its canonical type.
 //----------------------------------------------------------
 Type *type_from_string(const char *type_str)
 {
@@ -87,7 +314,15 @@ Type *type_from_string(const char *type_str)
         return create_type(TYPE_STRING);
     if (strcmp(type_str, "void") == 0)
         return create_type(TYPE_VOID);
-    return create_type(TYPE_UNKNOWN);
+    if (strcmp(type_str, "unknown") == 0)
+        return create_type(TYPE_UNKNOWN);
+
+    size_t length = strlen(type_str);
+    if (length > 2 && strcmp(type_str + length - 2, "[]") == 0)
+        return type_array_of(type_from_string(atom_text(intern_string(type_str, length - 2))));
+    if (strncmp(type_str, "struct ", 7) == 0 && type_str[7])
+        return type_struct_named(type_str + 7);
+    return derived_type(&(DerivedSpec){TYPE_UNKNOWN, false, false, intern_cstring(type_str), NULL});
 }
 
 //----------------------------------------------------------
@@ -95,51 +330,7 @@ Type *type_from_string(const char *type_str)
 //----------------------------------------------------------
 const char *type_to_string(const Type *type)
 {
-    if (!type)
-        return "unknown";
-    static char buffer[256];
-    const char *base_type;
-    switch (type->kind)
-    {
-    case TYPE_I32:
-        base_type = "i32";
-        break;
-    case TYPE_I64:
-        base_type = "i64";
-        break;
-    case TYPE_F32:
-        base_type = "f32";
-        break;
-    case TYPE_F64:
-        base_type = "f64";
-        break;
-    case TYPE_BOOL:
-        base_type = "bool";
-        break;
-    case TYPE_CHAR:
-        base_type = "char";
-        break;
-    case TYPE_STRING:
-        base_type = "string";
-        break;
-    case TYPE_VOID:
-        base_type = "void";
-        break;
-    case TYPE_STRUCT:
-        snprintf(buffer, sizeof(buffer), "struct %s", type->info.struct_info->name);
-        return buffer;
-    case TYPE_UNKNOWN:
-        return "unknown";
-    case TYPE_ERROR:
-        return "error";
-    default:
-        return "invalid";
-    }
-    snprintf(buffer, sizeof(buffer), "%s%s%s",
-             type->is_comptime ? "comptime " : "",
-             type->is_const ? "const " : "",
-             base_type);
-    return buffer;
+    return type ? type->name : "unknown";
 }
 
 //----------------------------------------------------------
@@ -147,18 +338,7 @@ const char *type_to_string(const Type *type)
 //----------------------------------------------------------
 bool types_are_equal(const Type *t1, const Type *t2)
 {
-    if (!t1 || !t2)
-        return false;
-    if (t1->kind != t2->kind ||
-        t1->is_const != t2->is_const ||
-        t1->is_comptime != t2->is_comptime)
-        return false;
-    // For struct types, compare struct names.
-    if (t1->kind == TYPE_STRUCT && t2->kind == TYPE_STRUCT)
-    {
-        return strcmp(t1->info.struct_info->name, t2->info.struct_info->name) == 0;
-    }
-    return true;
+    return t1 && t1 == t2;
 }
 
 //----------------------------------------------------------
@@ -185,6 +365,7 @@ Type *get_binary_op_type(const char *op, const Type *left, const Type *right)
     if (!op || !left || !right)
         return create_type(TYPE_ERROR);
     bool is_comptime = left->is_comptime && right->is_comptime;
+    BasicTypeKind kind = TYPE_ERROR;
     // Arithmetic operators.
     if (strcmp(op, "+") == 0 || strcmp(op, "-") == 0 ||
         strcmp(op, "*") == 0 || strcmp(op, "/") == 0 ||
@@ -192,66 +373,37 @@ Type *get_binary_op_type(const char *op, const Type *left, const Type *right)
     {
         // Handle string concatenation.
         if (strcmp(op, "+") == 0 && (left->kind == TYPE_STRING || right->kind == TYPE_STRING))
-        {
-            Type *result = create_type(TYPE_STRING);
-            result->is_comptime = is_comptime;
-            return result;
-        }
+            kind = TYPE_STRING;
         // Numeric operations.
-        if (is_numeric_type(left) && is_numeric_type(right))
+        else if (is_numeric_type(left) && is_numeric_type(right))
         {
             if (left->kind == TYPE_F64 || right->kind == TYPE_F64)
-            {
-                Type *result = create_type(TYPE_F64);
-                result->is_comptime = is_comptime;
-                return result;
-            }
-            if (left->kind == TYPE_F32 || right->kind == TYPE_F32)
-            {
-                Type *result = create_type(TYPE_F32);
-                result->is_comptime = is_comptime;
-                return result;
-            }
-            if (left->kind == TYPE_I64 || right->kind == TYPE_I64)
-            {
-                Type *result = create_type(TYPE_I64);
-                result->is_comptime = is_comptime;
-                return result;
-            }
-            Type *result = create_type(TYPE_I32);
-            result->is_comptime = is_comptime;
-            return result;
+                kind = TYPE_F64;
+            else if (left->kind == TYPE_F32 || right->kind == TYPE_F32)
+                kind = TYPE_F32;
+            else if (left->kind == TYPE_I64 || right->kind == TYPE_I64)
+                kind = TYPE_I64;
+            else
+                kind = TYPE_I32;
         }
     }
     // Comparison operators.
-    if (strcmp(op, "==") == 0 || strcmp(op, "!=") == 0 ||
-        strcmp(op, "<") == 0 || strcmp(op, ">") == 0 ||
-        strcmp(op, "<=") == 0 || strcmp(op, ">=") == 0)
+    else if (strcmp(op, "==") == 0 || strcmp(op, "!=") == 0 ||
+             strcmp(op, "<") == 0 || strcmp(op, ">") == 0 ||
+             strcmp(op, "<=") == 0 || strcmp(op, ">=") == 0)
     {
-        if (left->kind == right->kind)
-        {
-            Type *result = create_type(TYPE_BOOL);
-            result->is_comptime = is_comptime;
-            return result;
-        }
-        if (is_numeric_type(left) && is_numeric_type(right))
-        {
-            Type *result = create_type(TYPE_BOOL);
-            result->is_comptime = is_comptime;
-            return result;
-        }
+        if (left->kind == right->kind || (is_numeric_type(left) && is_numeric_type(right)))
+            kind = TYPE_BOOL;
     }
     // Logical operators.
-    if (strcmp(op, "and") == 0 || strcmp(op, "or") == 0 || strcmp(op, "xor") == 0)
+    else if (strcmp(op, "and") == 0 || strcmp(op, "or") == 0 || strcmp(op, "xor") == 0)
     {
         if (left->kind == TYPE_BOOL && right->kind == TYPE_BOOL)
-        {
-            Type *result = create_type(TYPE_BOOL);
-            result->is_comptime = is_comptime;
-            return result;
-        }
+            kind = TYPE_BOOL;
     }
-    return create_type(TYPE_ERROR);
+    if (kind == TYPE_ERROR)
+        return create_type(TYPE_ERROR);
+    return type_get(kind, false, is_comptime);
 }
 
 //----------------------------------------------------------
@@ -261,28 +413,11 @@ Type *get_unary_op_type(const char *op, const Type *operand)
 {
     if (!op || !operand)
         return create_type(TYPE_ERROR);
-    Type *result = NULL;
-    if (strcmp(op, "-") == 0 || strcmp(op, "+") == 0)
-    {
-        if (is_numeric_type(operand))
-            result = create_type(operand->kind);
-        else
-            return create_type(TYPE_ERROR);
-    }
-    else if (strcmp(op, "not") == 0)
-    {
-        if (operand->kind == TYPE_BOOL)
-            result = create_type(TYPE_BOOL);
-        else
-            return create_type(TYPE_ERROR);
-    }
-    else
-    {
-        return create_type(TYPE_ERROR);
-    }
-    if (result)
-        result->is_comptime = operand->is_comptime;
-    return result;
+    if ((strcmp(op, "-") == 0 || strcmp(op, "+") == 0) && is_numeric_type(operand))
+        return type_get(operand->kind, false, operand->is_comptime);
+    if (strcmp(op, "not") == 0 && operand->kind == TYPE_BOOL)
+        return type_get(TYPE_BOOL, false, operand->is_comptime);
+    return create_type(TYPE_ERROR);
 }
 
 //----------------------------------------------------------
@@ -294,24 +429,11 @@ bool type_is_condition_compatible(const Type *type)
 }
 
 //----------------------------------------------------------
-// Free a type instance.
+// Types are canonical and live for the whole process.
 //----------------------------------------------------------
 void free_type(Type *type)
 {
-    if (!type)
-        return;
-    if (type->kind == TYPE_STRUCT)
-    {
-        for (int i = 0; i < type->info.struct_info->field_count; i++)
-        {
-            free(type->info.struct_info->fields[i].name);
-            free_type(type->info.struct_info->fields[i].type);
-        }
-        free(type->info.struct_info->fields);
-        free(type->info.struct_info->name);
-        free(type->info.struct_info);
-    }
-    free(type);
+    (void)type;
 }
 
 //----------------------------------------------------------
@@ -343,30 +465,25 @@ const char *get_type_default_value(const Type *type)
 }
 
 //----------------------------------------------------------
-// Check if a literal string value is compatible with a type.
+// Check if an already parsed literal value is compatible with a type.
 //----------------------------------------------------------
-bool is_literal_compatible_with_type(const char *literal_value, const Type *type)
+bool is_literal_compatible_with_type(const LiteralValue *literal, const Type *type)
 {
-    if (!literal_value || !type)
+    if (!literal || !type)
         return false;
     switch (type->kind)
     {
     case TYPE_I32:
     case TYPE_I64:
-        return value_fits_in_type(literal_value, type);
     case TYPE_F32:
     case TYPE_F64:
-        return value_fits_in_type(literal_value, type);
+        return literal_value_fits_in_type(literal, type);
     case TYPE_BOOL:
-        return strcmp(literal_value, "true") == 0 || strcmp(literal_value, "false") == 0;
-    case TYPE_CHAR:
-        return strlen(literal_value) == 1 ||
-               (strlen(literal_value) == 2 && literal_value[0] == '\\');
+        return literal->kind == LITERAL_BOOL;
     case TYPE_STRING:
-        return literal_value[0] == '"' &&
-               literal_value[strlen(literal_value) - 1] == '"';
+        return literal->kind == LITERAL_STRING;
     default:
-        return false;
+        return false; // The lexer has no character literals
     }
 }
 
@@ -377,38 +494,74 @@ Type *get_literal_type(const char *literal_value)
 {
     if (!literal_value)
         return create_type(TYPE_ERROR);
-    Type *type = NULL;
+    BasicTypeKind kind;
     if (literal_value[0] == '"')
-        type = create_type(TYPE_STRING);
+        kind = TYPE_STRING;
     else if (strcmp(literal_value, "true") == 0 || strcmp(literal_value, "false") == 0)
-        type = create_type(TYPE_BOOL);
+        kind = TYPE_BOOL;
     else if (literal_value[0] == '\'')
-        type = create_type(TYPE_CHAR);
+        kind = TYPE_CHAR;
     else if (strchr(literal_value, '.') || strchr(literal_value, 'e') || strchr(literal_value, 'E'))
-        type = create_type(TYPE_F64);
+        kind = TYPE_F64;
     else
     {
-        bool is_integer = true;
         const char *c = literal_value;
         if (*c == '-')
             c++;
         while (*c)
         {
             if (!isdigit(*c))
-            {
-                is_integer = false;
-                break;
-            }
+                return create_type(TYPE_ERROR);
             c++;
         }
-        if (is_integer)
-            type = create_type(TYPE_I32);
-        else
-            return create_type(TYPE_ERROR);
+        kind = TYPE_I32;
+    }
+    return create_comptime_type(kind); // All literals are comptime.
+}
+
+//----------------------------------------------------------
+// Get the type of an already parsed literal value.
+//----------------------------------------------------------
+Type *get_literal_value_type(const LiteralValue *literal)
+{
+    switch (literal->kind)
+    {
+    case LITERAL_INT:
+        return create_comptime_type(TYPE_I32); // All literals are comptime.
+    case LITERAL_FLOAT:
+        return create_comptime_type(TYPE_F64);
+    case LITERAL_BOOL:
+        return create_comptime_type(TYPE_BOOL);
+    case LITERAL_STRING:
+        return create_comptime_type(TYPE_STRING);
+    default:
+        return NULL;
+    }
+}
+
+//----------------------------------------------------------
+// Check if an already parsed literal value fits in the target type.
+//----------------------------------------------------------
+bool literal_value_fits_in_type(const LiteralValue *literal, const Type *type)
+{
+    if (!literal || !type)
+        return false;
+    switch (type->kind)
+    {
+    case TYPE_I32:
+        return literal->kind == LITERAL_INT && !literal->overflow &&
+               literal->as.integer >= INT_MIN && literal->as.integer <= INT_MAX;
+    case TYPE_I64:
+        return literal->kind == LITERAL_INT && !literal->overflow;
+    case TYPE_F32:
+        return (literal->kind == LITERAL_FLOAT && !literal->overflow &&
+                literal->as.real >= -FLT_MAX && literal->as.real <= FLT_MAX) ||
+               literal->kind == LITERAL_INT;
+    case TYPE_F64:
+        return (literal->kind == LITERAL_FLOAT && !literal->overflow) || literal->kind == LITERAL_INT;
+    default:
+        return false;
     }
-    if (type)
-        type->is_comptime = true; // All literals are comptime.
-    return type;
 }
 
 //----------------------------------------------------------
@@ -441,6 +594,14 @@ bool is_numeric_type(const Type *type)
     return type && (is_integer_type(type) || is_float_type(type));
 }
 
+//----------------------------------------------------------
+// Check if a type is a primitive type.
+//----------------------------------------------------------
+bool is_primitive_type(const Type *type)
+{
+    return type && type->kind <= TYPE_VOID;
+}
+
 //----------------------------------------------------------
 // Check if a type is an integer type.
 //----------------------------------------------------------
@@ -458,110 +619,28 @@ bool is_float_type(const Type *type)
 }
 
 //----------------------------------------------------------
-// Check if a value would fit in the target numeric type.
+// Create a new struct type.
 //----------------------------------------------------------
-bool value_fits_in_type(const char *value, const Type *type)
+Type *create_struct_type(const char *name, StructField *fields, int field_count)
 {
-    if (!value)
-        return false;
-    switch (type->kind)
-    {
-    case TYPE_I32:
+    Type *type = type_struct_named(name);
+    StructType *info = type->info.struct_info;
+    pthread_mutex_lock(&derived_types.lock);
+    int adopt = info->fields == NULL && field_count > 0;
+    if (adopt)
     {
-        bool is_integer = true;
-        const char *c = value;
-        while (isspace(*c))
-            c++;
-        if (*c == '+' || *c == '-')
-            c++;
-        while (*c)
-        {
-            if (*c == '.')
-            {
-                is_integer = false;
-                break;
-            }
-            if (!isdigit(*c))
-                return false;
-            c++;
-        }
-        if (is_integer)
-        {
-            long val = strtol(value, NULL, 10);
-            return val >= INT_MIN && val <= INT_MAX;
-        }
-        return false;
+        // Copy fields (assumes caller has properly initialized each StructField).
+        StructField *copy = xmalloc(field_count * sizeof(StructField));
+        memcpy(copy, fields, field_count * sizeof(StructField));
+        info->field_count = field_count;
+        info->fields = copy;
     }
-    case TYPE_I64:
+    pthread_mutex_unlock(&derived_types.lock);
+    if (!adopt)
     {
-        bool is_integer = true;
-        const char *c = value;
-        while (isspace(*c))
-            c++;
-        if (*c == '+' || *c == '-')
-            c++;
-        while (*c)
-        {
-            if (*c == '.')
-            {
-                is_integer = false;
-                break;
-            }
-            if (!isdigit(*c))
-                return false;
-            c++;
-        }
-        if (is_integer)
-        {
-            long long val = strtoll(value, NULL, 10);
-            return val >= LLONG_MIN && val <= LLONG_MAX;
-        }
-        return false;
+        for (int i = 0; i < field_count; i++)
+            free(fields[i].name);
     }
-    case TYPE_F32:
-    {
-        char *endptr;
-        float val = strtof(value, &endptr);
-        if (*endptr != '\0' && !isspace(*endptr))
-            return false;
-        return val >= -FLT_MAX && val <= FLT_MAX;
-    }
-    case TYPE_F64:
-    {
-        char *endptr;
-        double val = strtod(value, &endptr);
-        if (*endptr != '\0' && !isspace(*endptr))
-            return false;
-        return val >= -DBL_MAX && val <= DBL_MAX;
-    }
-    case TYPE_BOOL:
-        return strcmp(value, "true") == 0 || strcmp(value, "false") == 0;
-    case TYPE_STRING:
-        return true;
-    case TYPE_VOID:
-    case TYPE_ERROR:
-    case TYPE_UNKNOWN:
-    case TYPE_CHAR:
-        return false;
-    }
-    return false;
-}
-
-//----------------------------------------------------------
-// Create a new struct type.
-//----------------------------------------------------------
-Type *create_struct_type(const char *name, StructField *fields, int field_count)
-{
-    Type *type = (Type *)xmalloc(sizeof(Type));
-    type->kind = TYPE_STRUCT;
-    type->is_const = false;
-    type->is_comptime = false;
-    type->info.struct_info = (StructType *)xmalloc(sizeof(StructType));
-    type->info.struct_info->name = xstrdup(name);
-    type->info.struct_info->field_count = field_count;
-    type->info.struct_info->fields = xmalloc(field_count * sizeof(StructField));
-    // Copy fields (assumes caller has properly initialized each StructField).
-    memcpy(type->info.struct_info->fields, fields, field_count * sizeof(StructField));
     return type;
 }
 
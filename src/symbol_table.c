@@ -4,6 +4,16 @@
 #include <string.h>
 
 #define INITIAL_CAPACITY 16
+#define INITIAL_SLOTS 32
+#define SYMBOLS_PER_BLOCK 64
+
+// Symbols are allocated in blocks so their addresses stay valid while the
+// table grows.
+typedef struct SymbolBlock
+{
+    struct SymbolBlock *next;
+    Symbol symbols[SYMBOLS_PER_BLOCK];
+} SymbolBlock;
 
 // Memory allocation helper functions.
 static void *xmalloc(size_t size)
@@ -17,28 +27,112 @@ static void *xmalloc(size_t size)
     return ptr;
 }
 
-static char *xstrdup(const char *s)
+static void *xrealloc(void *ptr, size_t size)
 {
-    char *ptr = strdup(s);
+    ptr = realloc(ptr, size);
     if (!ptr)
     {
-        fprintf(stderr, "Memory allocation failed in strdup\n");
+        fprintf(stderr, "Failed to resize symbol table\n");
         exit(EXIT_FAILURE);
     }
     return ptr;
 }
 
+static uint32_t slot_hash(Atom atom)
+{
+    return atom * 0x9E3779B1u;
+}
+
+// Index of the slot for atom: its own if present, otherwise the empty slot
+// where it would go. The table is never full.
+static uint32_t find_slot(const SymbolTable *table, Atom atom)
+{
+    uint32_t mask = table->slot_count - 1;
+    uint32_t i = slot_hash(atom) & mask;
+    while (table->slots[i].atom != ATOM_NONE && table->slots[i].atom != atom)
+        i = (i + 1) & mask;
+    return i;
+}
+
+// Double the slot array, rehashing names and updating the symbols' slots.
+static void grow_slots(SymbolTable *table)
+{
+    SymbolSlot *old = table->slots;
+    uint32_t old_count = table->slot_count;
+    table->slot_count = old_count ? old_count * 2 : INITIAL_SLOTS;
+    table->slots = calloc(table->slot_count, sizeof(SymbolSlot));
+    if (!table->slots)
+    {
+        fprintf(stderr, "Failed to resize symbol table\n");
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < old_count; i++)
+    {
+        if (old[i].atom == ATOM_NONE)
+            continue;
+        uint32_t slot = find_slot(table, old[i].atom);
+        table->slots[slot] = old[i];
+        for (Symbol *sym = old[i].symbol; sym; sym = sym->shadowed)
+            sym->slot = slot;
+    }
+    free(old);
+}
+
+static Symbol *new_symbol(SymbolTable *table)
+{
+    if (!table->free_symbols)
+    {
+        SymbolBlock *block = xmalloc(sizeof(SymbolBlock));
+        block->next = table->blocks;
+        table->blocks = block;
+        for (int i = SYMBOLS_PER_BLOCK - 1; i >= 0; i--)
+        {
+            block->symbols[i].shadowed = table->free_symbols;
+            table->free_symbols = &block->symbols[i];
+        }
+    }
+    Symbol *sym = table->free_symbols;
+    table->free_symbols = sym->shadowed;
+    return sym;
+}
+
 // Create a new symbol table. The 'parent' pointer allows nested scopes.
+// Storage is allocated on the first declaration.
 SymbolTable *create_symbol_table(SymbolTable *parent)
 {
     SymbolTable *table = (SymbolTable *)xmalloc(sizeof(SymbolTable));
-    table->symbols = (Symbol **)xmalloc(INITIAL_CAPACITY * sizeof(Symbol *));
-    table->count = 0;
-    table->capacity = INITIAL_CAPACITY;
+    memset(table, 0, sizeof(SymbolTable));
     table->parent = parent;
+    table->parent_limit = -1;
     return table;
 }
 
+void push_scope(SymbolTable *table)
+{
+    if (table->depth == table->scope_capacity)
+    {
+        table->scope_capacity = table->scope_capacity ? table->scope_capacity * 2 : INITIAL_CAPACITY;
+        table->scope_starts = xrealloc(table->scope_starts, table->scope_capacity * sizeof(int));
+    }
+    table->scope_starts[table->depth++] = table->count;
+}
+
+// Unbind the innermost scope's symbols, newest first, so each name goes back
+// to the binding it shadowed.
+void pop_scope(SymbolTable *table)
+{
+    if (table->depth == 0)
+        return;
+    int start = table->scope_starts[--table->depth];
+    while (table->count > start)
+    {
+        Symbol *sym = table->symbols[--table->count];
+        table->slots[sym->slot].symbol = sym->shadowed;
+        sym->shadowed = table->free_symbols;
+        table->free_symbols = sym;
+    }
+}
+
 // Add a symbol to the table (without an associated AST node).
 void add_symbol(SymbolTable *table, const char *name, const char *type)
 {
@@ -48,55 +142,100 @@ void add_symbol(SymbolTable *table, const char *name, const char *type)
 // Add a symbol along with an associated AST node (for functions, structs, etc.).
 void add_symbol_with_node(SymbolTable *table, const char *name, const char *type, ASTNode *node)
 {
-    // Resize the symbol array if needed.
+    add_symbol_atom(table, intern_cstring(name), type_from_string(type), node);
+}
+
+// Add a symbol whose name is already interned. It becomes the name's binding
+// in the innermost scope, shadowing any outer one.
+void add_symbol_atom(SymbolTable *table, Atom name, const Type *type, ASTNode *node)
+{
+    // The empty name cannot be bound (ATOM_NONE marks a free slot).
+    if (name == ATOM_NONE)
+        return;
+
+    // Keep the slots at most half full.
+    if ((table->slot_used + 1) * 2 > table->slot_count)
+        grow_slots(table);
     if (table->count >= table->capacity)
     {
-        table->capacity *= 2;
-        table->symbols = realloc(table->symbols, table->capacity * sizeof(Symbol *));
-        if (!table->symbols)
-        {
-            fprintf(stderr, "Failed to resize symbol table\n");
-            exit(EXIT_FAILURE);
-        }
+        table->capacity = table->capacity ? table->capacity * 2 : INITIAL_CAPACITY;
+        table->symbols = xrealloc(table->symbols, table->capacity * sizeof(Symbol *));
+    }
+
+    uint32_t slot = find_slot(table, name);
+    if (table->slots[slot].atom == ATOM_NONE)
+    {
+        table->slots[slot].atom = name;
+        table->slot_used++;
     }
 
     // Allocate and initialize a new symbol.
-    Symbol *sym = (Symbol *)xmalloc(sizeof(Symbol));
-    sym->name = xstrdup(name);
-    sym->type = xstrdup(type);
+    Symbol *sym = new_symbol(table);
+    sym->atom = name;
+    sym->name = atom_text(name);
+    sym->type = type;
     sym->node = node;
+    sym->shadowed = table->slots[slot].symbol;
+    sym->depth = table->depth;
+    sym->index = table->count;
+    sym->slot = slot;
 
+    table->slots[slot].symbol = sym;
     table->symbols[table->count++] = sym;
 }
 
 // Look up a symbol in the current table; if not found, search parent tables.
+// A name that was never interned cannot belong to any symbol.
 Symbol *lookup_symbol(SymbolTable *table, const char *name)
 {
+    Atom atom = intern_find(name, strlen(name));
+    return atom == ATOM_NONE ? NULL : lookup_symbol_atom(table, atom);
+}
+
+// Innermost binding of a name in this table only.
+static Symbol *binding(const SymbolTable *table, Atom name)
+{
+    if (table->slot_used == 0 || name == ATOM_NONE)
+        return NULL;
+    return table->slots[find_slot(table, name)].symbol;
+}
+
+// Look up an interned name in the current table and then its parents.
+Symbol *lookup_symbol_atom(SymbolTable *table, Atom name)
+{
+    int limit = -1;
     while (table)
     {
-        for (int i = 0; i < table->count; i++)
-        {
-            if (strcmp(table->symbols[i]->name, name) == 0)
-            {
-                return table->symbols[i];
-            }
-        }
+        Symbol *sym = binding(table, name);
+        while (sym && limit >= 0 && sym->index >= limit)
+            sym = sym->shadowed;
+        if (sym)
+            return sym;
+        limit = table->parent_limit;
         table = table->parent;
     }
     return NULL;
 }
 
+Symbol *lookup_symbol_local(SymbolTable *table, Atom name)
+{
+    Symbol *sym = binding(table, name);
+    return sym && sym->depth == table->depth ? sym : NULL;
+}
+
 // Destroy a symbol table and free all its symbols.
 void destroy_symbol_table(SymbolTable *table)
 {
     if (!table)
         return;
-    for (int i = 0; i < table->count; i++)
+    while (table->blocks)
     {
-        free(table->symbols[i]->name);
-        free(table->symbols[i]->type);
-        free(table->symbols[i]);
+        SymbolBlock *next = table->blocks->next;
+        free(table->blocks);
+        table->blocks = next;
     }
+    free(table->slots);
     free(table->symbols);
+    free(table->scope_starts);
     free(table);
 }
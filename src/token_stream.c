@@ -0,0 +1,136 @@
+#include "../include/token_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_CAPACITY 64
+
+static void *xrealloc(void *ptr, size_t size)
+{
+  void *result = realloc(ptr, size);
+  if (!result)
+  {
+    fprintf(stderr, "Memory allocation failed for %zu bytes\n", size);
+    exit(EXIT_FAILURE);
+  }
+  return result;
+}
+
+static void grow_stream(TokenStream *stream)
+{
+  stream->capacity = stream->capacity ? stream->capacity * 2 : INITIAL_CAPACITY;
+  stream->kinds = xrealloc(stream->kinds, stream->capacity * sizeof(uint8_t));
+  stream->subkinds = xrealloc(stream->subkinds, stream->capacity * sizeof(uint8_t));
+  stream->offsets = xrealloc(stream->offsets, stream->capacity * sizeof(uint32_t));
+  stream->lengths = xrealloc(stream->lengths, stream->capacity * sizeof(uint32_t));
+}
+
+// Tokens are pulled from a streaming lexer, so no full Token array is ever
+// materialized.
+TokenStream tokenize_stream(const char *source, size_t length)
+{
+  TokenStream stream;
+  memset(&stream, 0, sizeof(stream));
+  stream.source = source;
+  stream.source_length = length;
+  if (length > UINT32_MAX)
+  {
+    fprintf(stderr, "Source too large for a token stream (%zu bytes)\n", length);
+    exit(EXIT_FAILURE);
+  }
+
+  Lexer *lexer = create_lexer(source, length);
+  for (;;)
+  {
+    Token token = lexer_next_token(lexer);
+    if (stream.count == stream.capacity)
+      grow_stream(&stream);
+    stream.kinds[stream.count] = (uint8_t)token.type;
+    stream.subkinds[stream.count] = (uint8_t)token.subkind;
+    stream.offsets[stream.count] = (uint32_t)token.offset;
+    stream.lengths[stream.count] = (uint32_t)token.length;
+    stream.count++;
+    if (token.type == TOKEN_EOF)
+      break;
+  }
+  destroy_lexer(lexer);
+  return stream;
+}
+
+void free_token_stream(TokenStream *stream)
+{
+  free(stream->kinds);
+  free(stream->subkinds);
+  free(stream->offsets);
+  free(stream->lengths);
+  free(stream->line_starts);
+  memset(stream, 0, sizeof(*stream));
+}
+
+Token token_stream_get(const TokenStream *stream, int index)
+{
+  Token token;
+  memset(&token, 0, sizeof(token));
+  token.type = (TokenType)stream->kinds[index];
+  token.subkind = (TokenSubkind)stream->subkinds[index];
+  token.offset = stream->offsets[index];
+  token.length = (int)stream->lengths[index];
+  return token;
+}
+
+// Record where every line starts.
+static void build_line_starts(TokenStream *stream)
+{
+  int capacity = 64;
+  stream->line_starts = xrealloc(NULL, capacity * sizeof(uint32_t));
+  stream->line_starts[0] = 0;
+  stream->line_count = 1;
+
+  const char *source = stream->source;
+  size_t length = stream->source_length;
+  const char *newline;
+  size_t pos = 0;
+  while (pos < length && (newline = memchr(source + pos, '\n', length - pos)) != NULL)
+  {
+    pos = (size_t)(newline - source) + 1;
+    if (stream->line_count == capacity)
+    {
+      capacity *= 2;
+      stream->line_starts = xrealloc(stream->line_starts, capacity * sizeof(uint32_t));
+    }
+    stream->line_starts[stream->line_count++] = (uint32_t)pos;
+  }
+}
+
+void token_stream_offset_position(TokenStream *stream, size_t offset, int *line, int *column)
+{
+  if (stream->line_count == 0)
+    build_line_starts(stream);
+
+  // Last line starting at or before offset.
+  int lo = 0;
+  int hi = stream->line_count - 1;
+  while (lo < hi)
+  {
+    int mid = lo + (hi - lo + 1) / 2;
+    if (stream->line_starts[mid] <= offset)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+  *line = lo + 1;
+  *column = (int)(offset - stream->line_starts[lo]) + 1;
+}
+
+void token_stream_position(TokenStream *stream, int index, int *line, int *column)
+{
+  size_t offset = stream->offsets[index];
+  if (stream->kinds[index] == TOKEN_STRING && offset > 0)
+    offset--; // The opening quote
+  token_stream_offset_position(stream, offset, line, column);
+}
+
+size_t token_stream_memory(const TokenStream *stream)
+{
+  return (size_t)stream->capacity * (2 * sizeof(uint8_t) + 2 * sizeof(uint32_t));
+}
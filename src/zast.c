@@ -0,0 +1,534 @@
+#include "../include/zast.h"
+#include "../include/parser.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ZAST_MAGIC "ZAST"
+#define ZAST_BYTE_ORDER 0x01020304u
+#define ZAST_ALIGN 8
+// Node tags, operators and literal kinds are stored as enum values, so a file
+// is only read by code that numbers them the same way. Renumbering within an
+// enum should come with a new ZAST_VERSION; changing its size is caught here.
+#define ZAST_ABI ((uint32_t)AST_NODE_TYPE_COUNT | (uint32_t)TOKEN_SUBKIND_COUNT << 8 | \
+                  (uint32_t)LITERAL_KIND_COUNT << 16)
+
+typedef struct
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t byte_order;    // ZAST_BYTE_ORDER as written by the producer
+  uint32_t node_size;     // sizeof(FlatNode)
+  uint32_t literal_size;  // sizeof(FlatLiteral)
+  uint32_t root;
+  uint64_t source_hash;
+  uint64_t source_length;
+  uint64_t file_size;
+  uint32_t node_count;
+  uint32_t extra_count;
+  uint32_t literal_count;
+  uint32_t string_size;   // Literal text followed by name text
+  uint32_t name_count;    // Name 0 is the empty name (ATOM_NONE)
+  uint32_t abi;           // ZAST_ABI as written by the producer
+  uint64_t nodes_offset;  // Section offsets from the start of the file
+  uint64_t extra_offset;
+  uint64_t literals_offset;
+  uint64_t names_offset;  // name_count (offset, length) pairs into strings
+  uint64_t strings_offset;
+} ZastHeader;
+
+struct ZastFile
+{
+  FlatAST view;     // Arrays inside the mapping (cache hits)
+  FlatAST *owned;   // Freshly parsed AST (cache misses)
+  FlatIndex root;
+  void *map;
+  size_t map_size;
+  Atom *atom_map;
+};
+
+static void *xmalloc(size_t size)
+{
+  void *ptr = malloc(size);
+  if (!ptr)
+  {
+    fprintf(stderr, "Memory allocation failed for %zu bytes\n", size);
+    exit(EXIT_FAILURE);
+  }
+  return ptr;
+}
+
+// FNV-1a, 64-bit.
+uint64_t zast_hash_source(const char *source, size_t length)
+{
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < length; i++)
+  {
+    hash ^= (unsigned char)source[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+//----------------------------------------------------------
+// Names
+//----------------------------------------------------------
+
+// Atom -> name id table used while writing.
+typedef struct
+{
+  Atom *names;   // By id
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t *slots; // Open addressing: id + 1, 0 when empty
+  uint32_t slot_count;
+} NameTable;
+
+static void name_table_grow(NameTable *table)
+{
+  free(table->slots);
+  table->slot_count = table->slot_count ? table->slot_count * 2 : 256;
+  table->slots = calloc(table->slot_count, sizeof(uint32_t));
+  for (uint32_t id = 0; id < table->count; id++)
+  {
+    uint32_t i = (table->names[id] * 2654435761u) & (table->slot_count - 1);
+    while (table->slots[i])
+      i = (i + 1) & (table->slot_count - 1);
+    table->slots[i] = id + 1;
+  }
+}
+
+static uint32_t name_id(NameTable *table, Atom atom)
+{
+  if (atom == ATOM_NONE)
+    return 0;
+  if ((table->count + 1) * 2 > table->slot_count)
+    name_table_grow(table);
+  uint32_t i = (atom * 2654435761u) & (table->slot_count - 1);
+  while (table->slots[i])
+  {
+    if (table->names[table->slots[i] - 1] == atom)
+      return table->slots[i] - 1;
+    i = (i + 1) & (table->slot_count - 1);
+  }
+  if (table->count == table->capacity)
+  {
+    table->capacity *= 2;
+    table->names = realloc(table->names, table->capacity * sizeof(Atom));
+  }
+  table->names[table->count] = atom;
+  table->slots[i] = table->count + 1;
+  return table->count++;
+}
+
+// Replace every name field of the nodes with its id.
+static void map_names(FlatNode *nodes, uint32_t node_count, uint32_t *extra, NameTable *table)
+{
+  for (uint32_t k = 1; k < node_count; k++)
+  {
+    FlatNode *node = &nodes[k];
+    switch ((ASTNodeType)node->tag)
+    {
+    case AST_VAR_DECL:
+      node->a = name_id(table, node->a);
+      node->c = name_id(table, node->c);
+      break;
+    case AST_FOR_STMT:
+    case AST_IDENTIFIER:
+    case AST_FUNC_CALL:
+      node->a = name_id(table, node->a);
+      break;
+    case AST_FUNC_DEF:
+      node->a = name_id(table, node->a);
+      extra[node->c] = name_id(table, extra[node->c]);
+      break;
+    case AST_STRUCT_DEF:
+      node->a = name_id(table, node->a);
+      for (uint32_t i = 0; i < 2 * node->c; i++)
+        extra[node->b + i] = name_id(table, extra[node->b + i]);
+      break;
+    case AST_FIELD_ACCESS:
+      node->b = name_id(table, node->b);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+//----------------------------------------------------------
+// Writing
+//----------------------------------------------------------
+
+static uint64_t align_up(uint64_t offset)
+{
+  return (offset + ZAST_ALIGN - 1) & ~(uint64_t)(ZAST_ALIGN - 1);
+}
+
+static int write_section(FILE *out, uint64_t offset, const void *data, size_t size)
+{
+  if (fseek(out, (long)offset, SEEK_SET) != 0)
+    return -1;
+  return size && fwrite(data, 1, size, out) != size ? -1 : 0;
+}
+
+int zast_write(const char *path, const FlatAST *ast, FlatIndex root, uint64_t source_hash, uint64_t source_length)
+{
+  // Names are process-local atoms; store them as ids into a name table.
+  FlatNode *nodes = xmalloc(ast->node_count * sizeof(FlatNode));
+  uint32_t *extra = xmalloc((ast->extra_count + 1) * sizeof(uint32_t));
+  memcpy(nodes, ast->nodes, ast->node_count * sizeof(FlatNode));
+  memcpy(extra, ast->extra, ast->extra_count * sizeof(uint32_t));
+  NameTable table = {xmalloc(64 * sizeof(Atom)), 1, 64, NULL, 0};
+  table.names[0] = ATOM_NONE;
+  map_names(nodes, ast->node_count, extra, &table);
+
+  uint32_t *name_entries = xmalloc(2 * table.count * sizeof(uint32_t));
+  uint64_t string_size = ast->string_size;
+  for (uint32_t id = 0; id < table.count; id++)
+  {
+    name_entries[2 * id] = (uint32_t)string_size;
+    name_entries[2 * id + 1] = (uint32_t)atom_length(table.names[id]);
+    string_size += atom_length(table.names[id]) + 1;
+  }
+
+  ZastHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, ZAST_MAGIC, 4);
+  header.version = ZAST_VERSION;
+  header.abi = ZAST_ABI;
+  header.byte_order = ZAST_BYTE_ORDER;
+  header.node_size = sizeof(FlatNode);
+  header.literal_size = sizeof(FlatLiteral);
+  header.root = root;
+  header.source_hash = source_hash;
+  header.source_length = source_length;
+  header.node_count = ast->node_count;
+  header.extra_count = ast->extra_count;
+  header.literal_count = ast->literal_count;
+  header.string_size = (uint32_t)string_size;
+  header.name_count = table.count;
+  header.nodes_offset = align_up(sizeof(ZastHeader));
+  header.extra_offset = align_up(header.nodes_offset + (uint64_t)header.node_count * sizeof(FlatNode));
+  header.literals_offset = align_up(header.extra_offset + (uint64_t)header.extra_count * sizeof(uint32_t));
+  header.names_offset = align_up(header.literals_offset + (uint64_t)header.literal_count * sizeof(FlatLiteral));
+  header.strings_offset = align_up(header.names_offset + (uint64_t)header.name_count * 2 * sizeof(uint32_t));
+  header.file_size = header.strings_offset + string_size;
+
+  size_t path_length = strlen(path);
+  char *temp_path = xmalloc(path_length + 16);
+  snprintf(temp_path, path_length + 16, "%s.tmp%d", path, (int)getpid());
+  FILE *out = fopen(temp_path, "wb");
+  int status = out ? 0 : -1;
+  if (out)
+  {
+    status |= write_section(out, 0, &header, sizeof(header));
+    status |= write_section(out, header.nodes_offset, nodes, header.node_count * sizeof(FlatNode));
+    status |= write_section(out, header.extra_offset, extra, header.extra_count * sizeof(uint32_t));
+    status |= write_section(out, header.literals_offset, ast->literals, header.literal_count * sizeof(FlatLiteral));
+    status |= write_section(out, header.names_offset, name_entries, header.name_count * 2 * sizeof(uint32_t));
+    status |= write_section(out, header.strings_offset, ast->strings, ast->string_size);
+    for (uint32_t id = 0; id < table.count && status == 0; id++)
+    {
+      size_t length = atom_length(table.names[id]) + 1;
+      if (fwrite(atom_text(table.names[id]), 1, length, out) != length)
+        status = -1;
+    }
+    status |= fclose(out) != 0 ? -1 : 0;
+    if (status == 0)
+      status = rename(temp_path, path) != 0 ? -1 : 0;
+    if (status != 0)
+      unlink(temp_path);
+  }
+
+  free(temp_path);
+  free(name_entries);
+  free(table.names);
+  free(table.slots);
+  free(extra);
+  free(nodes);
+  return status;
+}
+
+//----------------------------------------------------------
+// Reading
+//----------------------------------------------------------
+
+static int section_fits(uint64_t offset, uint64_t count, uint64_t size, uint64_t file_size)
+{
+  return offset % ZAST_ALIGN == 0 && offset <= file_size && count <= (file_size - offset) / (size ? size : 1);
+}
+
+static int header_valid(const ZastHeader *header, uint64_t file_size, uint64_t source_hash, uint64_t source_length)
+{
+  return memcmp(header->magic, ZAST_MAGIC, 4) == 0 && header->version == ZAST_VERSION &&
+         header->abi == ZAST_ABI &&
+         header->byte_order == ZAST_BYTE_ORDER && header->node_size == sizeof(FlatNode) &&
+         header->literal_size == sizeof(FlatLiteral) && header->file_size == file_size &&
+         header->source_hash == source_hash && header->source_length == source_length &&
+         header->node_count > 0 && header->root < header->node_count && header->name_count > 0 &&
+         section_fits(header->nodes_offset, header->node_count, sizeof(FlatNode), file_size) &&
+         section_fits(header->extra_offset, header->extra_count, sizeof(uint32_t), file_size) &&
+         section_fits(header->literals_offset, header->literal_count, sizeof(FlatLiteral), file_size) &&
+         section_fits(header->names_offset, header->name_count, 2 * sizeof(uint32_t), file_size) &&
+         section_fits(header->strings_offset, header->string_size, 1, file_size);
+}
+
+// Children precede their parents, so every child index must be below that of
+// the node referring to it; this also rules out cycles.
+static int children_valid(const uint32_t *children, uint64_t count, uint32_t index)
+{
+  for (uint64_t i = 0; i < count; i++)
+    if (children[i] >= index)
+      return 0;
+  return 1;
+}
+
+// Whether extra[start, start + count) lies within the extra section.
+static int run_fits(const ZastHeader *header, uint32_t start, uint64_t count)
+{
+  return (uint64_t)start + count <= header->extra_count;
+}
+
+// Every reference from the sections into themselves is in bounds: child
+// indices, extra runs, literal indices, name ids and string offsets, and
+// tags, operators and literal kinds are values of their enums.
+static int sections_valid(const ZastHeader *header, const char *base)
+{
+  const FlatNode *nodes = (const FlatNode *)(base + header->nodes_offset);
+  const uint32_t *extra = (const uint32_t *)(base + header->extra_offset);
+  const FlatLiteral *literals = (const FlatLiteral *)(base + header->literals_offset);
+  const char *strings = base + header->strings_offset;
+  uint32_t names = header->name_count;
+
+  // Every string is NUL-terminated within the section.
+  if (header->string_size == 0 || strings[header->string_size - 1] != '\0')
+    return 0;
+  for (uint32_t i = 0; i < header->literal_count; i++)
+  {
+    const FlatLiteral *literal = &literals[i];
+    if ((unsigned)literal->value.kind >= LITERAL_KIND_COUNT || (uint64_t)literal->text + literal->length >= header->string_size)
+      return 0;
+    if (literal->value.kind == LITERAL_STRING &&
+        (uint64_t)literal->contents + literal->value.as.string.length >= header->string_size)
+      return 0;
+  }
+
+  for (uint32_t k = 1; k < header->node_count; k++)
+  {
+    const FlatNode *node = &nodes[k];
+    if (node->tag >= AST_NODE_TYPE_COUNT || node->op >= TOKEN_SUBKIND_COUNT)
+      return 0;
+    int valid = 1;
+    switch ((ASTNodeType)node->tag)
+    {
+    case AST_VAR_DECL:
+      valid = node->a < names && node->b < k && node->c < names;
+      break;
+    case AST_PRINT_STMT:
+    case AST_PROMPT_STMT:
+    case AST_EXPR_STMT:
+    case AST_RETURN_STMT:
+    case AST_STRING_INTERP:
+    case AST_UNARY_EXPR:
+      valid = node->a < k;
+      break;
+    case AST_WHILE_STMT:
+    case AST_BINARY_EXPR:
+    case AST_ASSIGN_EXPR:
+    case AST_ARRAY_INDEX:
+    case AST_CASE_STMT:
+      valid = node->a < k && node->b < k;
+      break;
+    case AST_IF_STMT:
+      // extra[c..] = else block, elif count, (cond, block)*
+      valid = node->a < k && node->b < k && run_fits(header, node->c, 2) &&
+              run_fits(header, node->c, 2 + 2 * (uint64_t)extra[node->c + 1]) &&
+              children_valid(&extra[node->c], 1, k) &&
+              children_valid(&extra[node->c + 2], 2 * (uint64_t)extra[node->c + 1], k);
+      break;
+    case AST_FOR_STMT:
+      valid = node->a < names && node->b < k && run_fits(header, node->c, 2) && children_valid(&extra[node->c], 2, k);
+      break;
+    case AST_FUNC_DEF:
+      // extra[c..] = return type, param count, params*
+      valid = node->a < names && node->b < k && run_fits(header, node->c, 2) && extra[node->c] < names &&
+              run_fits(header, node->c, 2 + (uint64_t)extra[node->c + 1]) &&
+              children_valid(&extra[node->c + 2], extra[node->c + 1], k);
+      break;
+    case AST_BLOCK:
+    case AST_ARRAY_LITERAL:
+    case AST_FSTRING:
+      valid = run_fits(header, node->a, node->b) && children_valid(&extra[node->a], node->b, k);
+      break;
+    case AST_LITERAL:
+      valid = node->a < header->literal_count;
+      break;
+    case AST_IDENTIFIER:
+      valid = node->a < names;
+      break;
+    case AST_FUNC_CALL:
+      valid = node->a < names && run_fits(header, node->b, node->c) && children_valid(&extra[node->b], node->c, k);
+      break;
+    case AST_SWITCH_STMT:
+      // extra[b..] = finally block, case count, cases*
+      valid = node->a < k && run_fits(header, node->b, 2) &&
+              run_fits(header, node->b, 2 + (uint64_t)extra[node->b + 1]) &&
+              children_valid(&extra[node->b], 1, k) && children_valid(&extra[node->b + 2], extra[node->b + 1], k);
+      break;
+    case AST_STRUCT_DEF:
+      valid = node->a < names && run_fits(header, node->b, 2 * (uint64_t)node->c);
+      for (uint64_t i = 0; valid && i < 2 * (uint64_t)node->c; i++)
+        valid = extra[node->b + i] < names;
+      break;
+    case AST_FIELD_ACCESS:
+      valid = node->a < k && node->b < names;
+      break;
+    case AST_BREAK_STMT:
+    case AST_CONTINUE_STMT:
+      break;
+    }
+    if (!valid)
+      return 0;
+  }
+  return 1;
+}
+
+ZastFile *zast_open(const char *path, uint64_t source_hash, uint64_t source_length)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ZastHeader))
+  {
+    close(fd);
+    return NULL;
+  }
+  void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return NULL;
+
+  const ZastHeader *header = map;
+  if (!header_valid(header, (uint64_t)st.st_size, source_hash, source_length) || !sections_valid(header, map))
+  {
+    munmap(map, (size_t)st.st_size);
+    return NULL;
+  }
+
+  const char *base = map;
+  const char *strings = base + header->strings_offset;
+  const uint32_t *names = (const uint32_t *)(base + header->names_offset);
+  Atom *atom_map = xmalloc(header->name_count * sizeof(Atom));
+  for (uint32_t id = 0; id < header->name_count; id++)
+  {
+    uint32_t offset = names[2 * id];
+    uint32_t length = names[2 * id + 1];
+    if ((uint64_t)offset + length >= header->string_size)
+    {
+      free(atom_map);
+      munmap(map, (size_t)st.st_size);
+      return NULL;
+    }
+    atom_map[id] = intern_string(strings + offset, length);
+  }
+
+  ZastFile *file = xmalloc(sizeof(ZastFile));
+  memset(file, 0, sizeof(ZastFile));
+  file->view.nodes = (FlatNode *)(base + header->nodes_offset);
+  file->view.node_count = file->view.node_capacity = header->node_count;
+  file->view.extra = (uint32_t *)(base + header->extra_offset);
+  file->view.extra_count = file->view.extra_capacity = header->extra_count;
+  file->view.literals = (FlatLiteral *)(base + header->literals_offset);
+  file->view.literal_count = file->view.literal_capacity = header->literal_count;
+  file->view.strings = (char *)strings;
+  file->view.string_size = file->view.string_capacity = header->string_size;
+  file->view.atom_map = atom_map;
+  file->root = header->root;
+  file->map = map;
+  file->map_size = (size_t)st.st_size;
+  file->atom_map = atom_map;
+  return file;
+}
+
+void zast_close(ZastFile *file)
+{
+  if (!file)
+    return;
+  if (file->owned)
+    destroy_flat_ast(file->owned);
+  if (file->map)
+    munmap(file->map, file->map_size);
+  free(file->atom_map);
+  free(file);
+}
+
+const FlatAST *zast_ast(const ZastFile *file)
+{
+  return file->owned ? file->owned : &file->view;
+}
+
+FlatIndex zast_root(const ZastFile *file)
+{
+  return file->root;
+}
+
+int zast_from_cache(const ZastFile *file)
+{
+  return file->map != NULL;
+}
+
+//----------------------------------------------------------
+// Frontend
+//----------------------------------------------------------
+
+ZastFile *zast_load_source(const char *source_path, const char *cache_path, int thread_count)
+{
+  SourceBuffer source;
+  if (source_buffer_open(&source, source_path) != 0)
+    return NULL;
+  uint64_t hash = zast_hash_source(source.data, source.length);
+
+  ZastFile *cached = zast_open(cache_path, hash, source.length);
+  if (cached)
+  {
+    source_buffer_close(&source);
+    return cached;
+  }
+
+  TokenArray tokens = tokenize_parallel(source.data, source.length, thread_count);
+  ParsedProgram program = parse_program_parallel(&tokens, thread_count);
+  ZastFile *file = NULL;
+  if (program.error_count > 0)
+  {
+    for (int i = 0; i < program.error_count; i++)
+      fprintf(stderr, "%s\n", program.errors[i].message);
+  }
+  else
+  {
+    FlatAST *ast = create_flat_ast();
+    FlatIndex *decls = xmalloc((program.decl_count + 1) * sizeof(FlatIndex));
+    for (int i = 0; i < program.decl_count; i++)
+      decls[i] = flat_ast_add_tree(ast, program.decls[i]);
+    FlatIndex root = flat_ast_add_block(ast, decls, (uint32_t)program.decl_count);
+    free(decls);
+
+    // A cache that cannot be written only costs the next build a parse.
+    zast_write(cache_path, ast, root, hash, source.length);
+
+    file = xmalloc(sizeof(ZastFile));
+    memset(file, 0, sizeof(ZastFile));
+    file->owned = ast;
+    file->root = root;
+  }
+
+  free_parsed_program(&program);
+  free_token_array(&tokens);
+  source_buffer_close(&source);
+  return file;
+}
@@ -303,14 +303,14 @@ namespace zir
                 return false; // Can't have terminator instructions except at the end
 
             // Check for label references to the other block
-            if (instr->referencesLabel(other->getName()))
+            if (instr->referencesLabel(other->getNameAtom()))
                 return false;
         }
 
         // Check for label references to this block in the other block
         for (const auto &instr : other->instructions)
         {
-            if (instr->referencesLabel(getName()))
+            if (instr->referencesLabel(getNameAtom()))
                 return false;
         }
 
@@ -564,10 +564,10 @@ namespace zir
             {
                 // This is a terminator we want to modify
                 // First, check if it has a target label
-                if (!instr->getTargetLabel().empty())
+                if (instr->getTargetLabelAtom() != ATOM_NONE)
                 {
                     // Update target to point to 'to' block
-                    instr->setTargetLabel(to->getName());
+                    instr->setTargetLabel(to->getNameAtom());
                 }
 
                 // We found and modified the terminator, so we can stop searching
@@ -719,7 +719,7 @@ namespace zir
 
         // Create a new basic block to insert between this block and the successor
         std::stringstream newBlockName;
-        newBlockName << name << "_to_" << succ->getName() << "_split";
+        newBlockName << getName() << "_to_" << succ->getName() << "_split";
         auto newBlock = std::make_shared<ZIRBasicBlockImpl>(newBlockName.str());
 
         // If this block has a parent function, add the new block to the same function
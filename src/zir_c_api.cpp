@@ -338,9 +338,7 @@ extern "C"
         if (!handle)
             return nullptr;
         auto *block_ptr = handle_to_block(handle);
-        static thread_local std::string current_name;
-        current_name = (*block_ptr)->getName();
-        return current_name.c_str();
+        return (*block_ptr)->getName();
     }
 
     void zir_set_block_name(zir_block_handle handle, const char *name)
@@ -384,7 +382,7 @@ extern "C"
         auto *function_ptr = handle_to_function(handle);
         if (!function_ptr || !*function_ptr)
             return nullptr;
-        return (*function_ptr)->getName().c_str();
+        return (*function_ptr)->getName();
     }
 
     void zir_set_function_name(zir_function_handle handle, const char *name)
@@ -470,7 +468,7 @@ extern "C"
             return nullptr;
 
         auto *inst_ptr = reinterpret_cast<std::shared_ptr<ZIRInstructionImpl> *>(handle);
-        return (*inst_ptr)->getName().c_str();
+        return (*inst_ptr)->getName();
     }
 
     zir_value_handle zir_instruction_get_left_operand(zir_instruction_handle handle)
@@ -19,7 +19,7 @@ namespace zir
             throw std::invalid_argument("Cannot add null block to function");
         }
 
-        std::cout << "Debug: Adding block to function " << name << std::endl;
+        std::cout << "Debug: Adding block to function " << getName() << std::endl;
         std::cout << "Debug: Block parent before: " << block->getParentFunction() << std::endl;
 
         // Step 1: Clear previous parent if any
@@ -46,7 +46,7 @@ namespace zir
             return;
         }
 
-        std::cout << "Debug: Removing block from function " << name << std::endl;
+        std::cout << "Debug: Removing block from function " << getName() << std::endl;
         std::cout << "Debug: Block parent before: " << block->getParentFunction() << std::endl;
 
         auto it = std::find(blocks.begin(), blocks.end(), block);
@@ -156,7 +156,7 @@ namespace zir
             for (size_t i = 0; i < block->getInstructionCount(); i++)
             {
                 auto instr = block->getInstruction(i);
-                if (!instr || instr->getResult().empty())
+                if (!instr || !instr->hasResult())
                     continue;
 
                 resultToInstruction[instr->getResult()] = instr;
@@ -0,0 +1,138 @@
+#include "../../../include/ast.h"
+#include "../../../include/comptime.h"
+#include "../../../include/semantic.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEPTH 100000
+#define RUNS 5
+
+void test_exit(int status)
+{
+    exit(status);
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Left-nested a + 3 * 3 + 3 ... chain, DEPTH operators deep
+static ASTNode *build_chain(const char *leaf)
+{
+    ASTNode *chain = leaf[0] == 'x' ? create_identifier(leaf) : create_literal(leaf);
+    for (int i = 0; i < DEPTH; i++)
+        chain = create_binary_expr(i % 2 ? "*" : "+", chain, create_literal("3"));
+    return chain;
+}
+
+// Reference: the same count on the native stack
+static long count_recursive(const ASTNode *node)
+{
+    if (node->type != AST_BINARY_EXPR)
+        return 1;
+    return 1 + count_recursive(node->data.binary_expr.left) + count_recursive(node->data.binary_expr.right);
+}
+
+static ASTWalkAction count_node(ASTNode *node, ASTNode *parent, void *context)
+{
+    (void)node;
+    (void)parent;
+    (*(long *)context)++;
+    return AST_WALK_CONTINUE;
+}
+
+static int saved_stdout;
+
+// The passes print debug lines per node; time them without the terminal
+static void quiet_stdout(void)
+{
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+}
+
+static void restore_stdout(void)
+{
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+}
+
+static void report(const char *name, double seconds)
+{
+    printf("%-28s %12.2f %12.1f\n", name, seconds * 1000, seconds * 1e9 / (2.0 * DEPTH + 1));
+}
+
+int main()
+{
+    printf("AST walk benchmark: %d-deep expression chains (%d nodes)\n", DEPTH, 2 * DEPTH + 1);
+    printf("%-28s %12s %12s\n", "pass", "time (ms)", "ns/node");
+
+    ASTNode *chain = build_chain("1");
+    double best_walk = 1e30, best_recursive = 1e30;
+    long walked = 0, recursed = 0;
+    for (int run = 0; run < RUNS; run++)
+    {
+        ASTVisitor visitor = {count_node, NULL, &walked};
+        walked = 0;
+        double start = now_seconds();
+        ast_walk(chain, &visitor);
+        double t1 = now_seconds();
+        recursed = count_recursive(chain);
+        double t2 = now_seconds();
+        if (t1 - start < best_walk)
+            best_walk = t1 - start;
+        if (t2 - t1 < best_recursive)
+            best_recursive = t2 - t1;
+    }
+    if (walked != recursed)
+    {
+        printf("MISMATCH: walked %ld nodes, recursion counted %ld\n", walked, recursed);
+        return 1;
+    }
+    report("ast_walk (count)", best_walk);
+    report("native recursion (count)", best_recursive);
+
+    quiet_stdout();
+    double start = now_seconds();
+    int comptime = is_comptime_expr(chain);
+    double t1 = now_seconds();
+    ComptimeValue *value = evaluate_comptime_expr(chain);
+    double t2 = now_seconds();
+    restore_stdout();
+    if (!comptime || !value)
+    {
+        printf("FAILED: chain should evaluate at compile time\n");
+        return 1;
+    }
+    free_comptime_value(value);
+    report("is_comptime_expr", t1 - start);
+    report("evaluate_comptime_expr", t2 - t1);
+
+    start = now_seconds();
+    free_ast(chain);
+    report("free_ast", now_seconds() - start);
+
+    // let x: i32 = 1; let y: i32 = x + 3 * 3 + ...;
+    ASTNode **statements = malloc(2 * sizeof(ASTNode *));
+    statements[0] = create_var_decl(0, "x", "i32", create_literal("1"));
+    statements[1] = create_var_decl(0, "y", "i32", build_chain("x"));
+    ASTNode *block = create_block(statements, 2);
+    quiet_stdout();
+    start = now_seconds();
+    semantic_analysis(block);
+    t1 = now_seconds();
+    restore_stdout();
+    report("semantic_analysis", t1 - start);
+
+    free_ast(block);
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include "../../../include/flat_ast.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define STATEMENTS 200000
+#define RUNS 5
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Random expression tree of the given depth
+static ASTNode *build_expr(int depth)
+{
+    static const char *ops[] = {"+", "-", "*", "<", "and"};
+    char text[16];
+    if (depth == 0 || rand() % 4 == 0)
+    {
+        if (rand() % 2)
+        {
+            snprintf(text, sizeof(text), "%d", rand() % 1000);
+            return create_literal(text);
+        }
+        snprintf(text, sizeof(text), "v%d", rand() % 64);
+        return create_identifier(text);
+    }
+    if (rand() % 8 == 0)
+    {
+        int count = 1 + rand() % 3;
+        ASTNode **args = malloc(count * sizeof(ASTNode *));
+        for (int i = 0; i < count; i++)
+            args[i] = build_expr(depth - 1);
+        return create_func_call("call", args, count);
+    }
+    ASTNode *left = build_expr(depth - 1);
+    return create_binary_expr((char *)ops[rand() % 5], left, build_expr(depth - 1));
+}
+
+static ASTNode *build_program(void)
+{
+    ASTNode **statements = malloc(STATEMENTS * sizeof(ASTNode *));
+    char name[32];
+    for (int i = 0; i < STATEMENTS; i++)
+    {
+        snprintf(name, sizeof(name), "x%d", i % 512);
+        statements[i] = create_var_decl(0, name, "i32", build_expr(4));
+    }
+    return create_block(statements, STATEMENTS);
+}
+
+// Pointer tree traversal: count nodes and sum integer literals
+static long walk_tree(const ASTNode *node, long *sum)
+{
+    if (!node)
+        return 0;
+    switch (node->type)
+    {
+    case AST_BLOCK:
+    {
+        long count = 1;
+        for (int i = 0; i < node->data.block.stmt_count; i++)
+            count += walk_tree(node->data.block.statements[i], sum);
+        return count;
+    }
+    case AST_VAR_DECL:
+        return 1 + walk_tree(node->data.var_decl.initializer, sum);
+    case AST_BINARY_EXPR:
+        return 1 + walk_tree(node->data.binary_expr.left, sum) + walk_tree(node->data.binary_expr.right, sum);
+    case AST_FUNC_CALL:
+    {
+        long count = 1;
+        for (int i = 0; i < node->data.func_call.arg_count; i++)
+            count += walk_tree(node->data.func_call.arguments[i], sum);
+        return count;
+    }
+    case AST_LITERAL:
+        *sum += node->data.literal.parsed.as.integer;
+        return 1;
+    default:
+        return 1;
+    }
+}
+
+// The same traversal over flat indices
+static long walk_flat(const FlatAST *ast, FlatIndex index, long *sum)
+{
+    const FlatNode *node = flat_node(ast, index);
+    switch (node->tag)
+    {
+    case AST_BLOCK:
+    {
+        long count = 1;
+        const uint32_t *items = flat_extra(ast, node->a);
+        for (uint32_t i = 0; i < node->b; i++)
+            count += walk_flat(ast, items[i], sum);
+        return count;
+    }
+    case AST_VAR_DECL:
+        return 1 + walk_flat(ast, node->b, sum);
+    case AST_BINARY_EXPR:
+        return 1 + walk_flat(ast, node->a, sum) + walk_flat(ast, node->b, sum);
+    case AST_FUNC_CALL:
+    {
+        long count = 1;
+        const uint32_t *items = flat_extra(ast, node->b);
+        for (uint32_t i = 0; i < node->c; i++)
+            count += walk_flat(ast, items[i], sum);
+        return count;
+    }
+    case AST_LITERAL:
+        *sum += flat_literal(ast, index)->value.as.integer;
+        return 1;
+    default:
+        return 1;
+    }
+}
+
+// Order-independent passes need no recursion at all
+static long scan_flat(const FlatAST *ast, long *sum)
+{
+    for (FlatIndex i = 1; i < ast->node_count; i++)
+        if (ast->nodes[i].tag == AST_LITERAL)
+            *sum += ast->literals[ast->nodes[i].a].value.as.integer;
+    return ast->node_count - 1;
+}
+
+int main()
+{
+    srand(42);
+    ASTArena *arena = create_ast_arena();
+    ast_arena_set_current(arena);
+    ASTNode *program = build_program();
+    ast_arena_set_current(NULL);
+    size_t tree_nodes = ast_arena_node_count(arena);
+
+    double start = now_seconds();
+    FlatAST *flat = create_flat_ast();
+    FlatIndex root = flat_ast_add_tree(flat, program);
+    double convert = now_seconds() - start;
+
+    printf("Flat AST benchmark: %zu nodes\n", tree_nodes);
+    printf("%-22s %12s %12s\n", "representation", "bytes", "bytes/node");
+    printf("%-22s %12zu %12.1f\n", "pointer tree (arena)", ast_arena_memory(arena),
+           (double)ast_arena_memory(arena) / tree_nodes);
+    printf("%-22s %12zu %12.1f\n", "flat", flat_ast_memory(flat), (double)flat_ast_memory(flat) / tree_nodes);
+    printf("sizeof(ASTNode) = %zu, sizeof(FlatNode) = %zu\n", sizeof(ASTNode), sizeof(FlatNode));
+    printf("conversion: %.2f ms\n\n", convert * 1000);
+
+    double best_tree = 1e30, best_flat = 1e30, best_scan = 1e30;
+    long tree_sum = 0, flat_sum = 0, scan_sum = 0, tree_count = 0, flat_count = 0;
+    for (int run = 0; run < RUNS; run++)
+    {
+        tree_sum = flat_sum = scan_sum = 0;
+        start = now_seconds();
+        tree_count = walk_tree(program, &tree_sum);
+        double t1 = now_seconds();
+        flat_count = walk_flat(flat, root, &flat_sum);
+        double t2 = now_seconds();
+        scan_flat(flat, &scan_sum);
+        double t3 = now_seconds();
+        if (t1 - start < best_tree)
+            best_tree = t1 - start;
+        if (t2 - t1 < best_flat)
+            best_flat = t2 - t1;
+        if (t3 - t2 < best_scan)
+            best_scan = t3 - t2;
+    }
+    if (tree_count != flat_count || tree_sum != flat_sum || tree_sum != scan_sum)
+    {
+        printf("MISMATCH: %ld/%ld nodes, sums %ld %ld %ld\n", tree_count, flat_count, tree_sum, flat_sum, scan_sum);
+        return 1;
+    }
+    printf("%-22s %12s %10s\n", "traversal", "time (ms)", "speedup");
+    printf("%-22s %12.2f %9.2fx\n", "pointer tree", best_tree * 1000, 1.0);
+    printf("%-22s %12.2f %9.2fx\n", "flat (recursive)", best_flat * 1000, best_tree / best_flat);
+    printf("%-22s %12.2f %9.2fx\n", "flat (linear scan)", best_scan * 1000, best_tree / best_scan);
+
+    destroy_flat_ast(flat);
+    destroy_ast_arena(arena);
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "../../include/ast.h"
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Nodes built while an arena is current come from the arena
+void test_arena_nodes(void)
+{
+    ASTArena *arena = create_ast_arena();
+    assert(ast_arena_set_current(arena) == NULL);
+    assert(ast_arena_current() == arena);
+
+    ASTNode *sum = create_binary_expr("+", create_identifier("x"), create_literal("\"a\\tb\""));
+    assert(sum->flags & AST_NODE_IN_ARENA);
+    assert(sum->data.binary_expr.left->flags & AST_NODE_IN_ARENA);
+    assert(strcmp(sum->data.binary_expr.op, "+") == 0);
+    ASTNode *text = sum->data.binary_expr.right;
+    assert(text->data.literal.parsed.kind == LITERAL_STRING);
+    assert(strcmp(text->data.literal.parsed.as.string.text, "a\tb") == 0);
+
+    // Heap child arrays are moved into the arena
+    ASTNode **statements = malloc(2 * sizeof(ASTNode *));
+    statements[0] = create_expr_stmt(sum);
+    statements[1] = create_print_stmt(create_literal("1"));
+    ASTNode *block = create_block(statements, 2);
+    assert(block->data.block.statements != statements);
+    assert(block->data.block.statements[0]->data.expr_stmt.expr == sum);
+
+    assert(ast_arena_node_count(arena) == 7);
+    assert(ast_arena_memory(arena) > 0);
+
+    free_ast(block); // No-op for arena nodes
+    assert(block->data.block.stmt_count == 2);
+
+    assert(ast_arena_set_current(NULL) == arena);
+    ASTNode *heap = create_literal("7");
+    assert(heap->flags == 0);
+    free_ast(heap);
+
+    destroy_ast_arena(arena);
+    printf("✓ Arena node test passed\n");
+}
+
+// A whole parse can be allocated from an arena and released in one call
+void test_arena_parse(void)
+{
+    const char *source = "fn add(a: i32, b: i32): i32 { let s = a + b; let t = s * 2; let u = \"done\"; }";
+    TokenArray tokens = tokenize(source);
+    Parser *parser = create_parser(tokens);
+
+    ASTArena *arena = create_ast_arena();
+    ASTArena *previous = ast_arena_set_current(arena);
+    ASTNode *func = parse_function_declaration(parser);
+    ast_arena_set_current(previous);
+
+    assert(func && func->type == AST_FUNC_DEF);
+    assert(func->flags & AST_NODE_IN_ARENA);
+    assert(func->data.func_def.param_count == 2);
+    assert(func->data.func_def.parameters[1]->flags & AST_NODE_IN_ARENA);
+    assert(strcmp(func->data.func_def.return_type, "i32") == 0);
+    assert(func->data.func_def.body->data.block.stmt_count == 3);
+    assert(ast_arena_node_count(arena) > 10);
+
+    destroy_ast_arena(arena);
+    destroy_parser(parser);
+    free_token_array(&tokens);
+    printf("✓ Arena parse test passed\n");
+}
+
+// Destroying the current arena detaches it from the thread
+void test_destroy_current(void)
+{
+    ASTArena *arena = create_ast_arena();
+    ast_arena_set_current(arena);
+    for (int i = 0; i < 10000; i++)
+        create_identifier("node");
+    assert(ast_arena_node_count(arena) == 10000);
+    assert(ast_arena_alloc(arena, 100000) != NULL); // Oversized request
+    destroy_ast_arena(arena);
+    assert(ast_arena_current() == NULL);
+
+    ASTNode *heap = create_identifier("after");
+    assert(heap->flags == 0);
+    free_ast(heap);
+    printf("✓ Destroy current arena test passed\n");
+}
+
+int main()
+{
+    printf("Running AST arena tests...\n");
+
+    test_arena_nodes();
+    test_arena_parse();
+    test_destroy_current();
+
+    printf("All AST arena tests passed!\n");
+    return 0;
+}
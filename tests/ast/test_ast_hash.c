@@ -0,0 +1,171 @@
+#include "../../include/ast_hash.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// (name + 1) * (name + 1)
+static ASTNode *square_plus_one(const char *name)
+{
+    ASTNode *left = create_binary_expr("+", create_identifier(name), create_literal("1"));
+    ASTNode *right = create_binary_expr("+", create_identifier(name), create_literal("1"));
+    return create_binary_expr("*", left, right);
+}
+
+static ASTNode *call_with(ASTNode *arg)
+{
+    ASTNode **args = malloc(sizeof(ASTNode *));
+    args[0] = arg;
+    return create_func_call("f", args, 1);
+}
+
+// Equal structure hashes equally; operators, values and names matter
+void test_structural_hash(void)
+{
+    ASTNode *a = square_plus_one("a");
+    ASTNode *b = square_plus_one("a");
+    ASTNode *c = square_plus_one("b");
+    assert(a != b);
+    assert(ast_structural_hash(a) == ast_structural_hash(b));
+    assert(ast_structurally_equal(a, b));
+    assert(ast_structural_hash(a) != ast_structural_hash(c));
+    assert(!ast_structurally_equal(a, c));
+
+    ASTNode *one = create_literal("1");
+    ASTNode *one_float = create_literal("1.0");
+    ASTNode *text = create_literal("\"1\"");
+    assert(ast_structural_hash(one) != ast_structural_hash(one_float));
+    assert(ast_structural_hash(one) != ast_structural_hash(text));
+    assert(!ast_structurally_equal(one, one_float));
+
+    // Operand order matters
+    ASTNode *x_minus_y = create_binary_expr("-", create_identifier("x"), create_identifier("y"));
+    ASTNode *y_minus_x = create_binary_expr("-", create_identifier("y"), create_identifier("x"));
+    assert(ast_structural_hash(x_minus_y) != ast_structural_hash(y_minus_x));
+
+    assert(ast_is_pure_kind(AST_BINARY_EXPR) && !ast_is_pure_kind(AST_FUNC_CALL));
+
+    free_ast(a);
+    free_ast(b);
+    free_ast(c);
+    free_ast(one);
+    free_ast(one_float);
+    free_ast(text);
+    free_ast(x_minus_y);
+    free_ast(y_minus_x);
+    printf("✓ Structural hash test passed\n");
+}
+
+// Identical pure subexpressions become one shared node
+void test_hash_cons(void)
+{
+    // let x = (a + 1) * (a + 1); let y = a + 1; f(a + 1) + f(a + 1);
+    ASTNode **statements = malloc(3 * sizeof(ASTNode *));
+    statements[0] = create_var_decl(0, "x", "i32", square_plus_one("a"));
+    statements[1] = create_var_decl(0, "y", "i32",
+                                    create_binary_expr("+", create_identifier("a"), create_literal("1")));
+    ASTNode *a_plus_one = create_binary_expr("+", create_identifier("a"), create_literal("1"));
+    statements[2] = create_expr_stmt(create_binary_expr("+", call_with(a_plus_one),
+                                                        call_with(create_binary_expr("+", create_identifier("a"),
+                                                                                     create_literal("1")))));
+    ASTNode *block = create_block(statements, 3);
+
+    ExprTable *table = create_expr_table();
+    assert(hash_cons_ast(table, block) == block);
+
+    ASTNode *square = statements[0]->data.var_decl.initializer;
+    ASTNode *shared = square->data.binary_expr.left;
+    assert(square->data.binary_expr.right == shared);
+    assert(statements[1]->data.var_decl.initializer == shared);
+    assert(shared->flags & AST_NODE_SHARED);
+
+    // Calls are not pure, but their arguments are consed
+    ASTNode *sum = statements[2]->data.expr_stmt.expr;
+    ASTNode *first_call = sum->data.binary_expr.left;
+    ASTNode *second_call = sum->data.binary_expr.right;
+    assert(first_call != second_call);
+    assert(!(sum->flags & AST_NODE_SHARED) && !(first_call->flags & AST_NODE_SHARED));
+    assert(first_call->data.func_call.arguments[0] == shared);
+    assert(second_call->data.func_call.arguments[0] == shared);
+
+    // a, 1, a + 1, (a + 1) * (a + 1)
+    assert(expr_table_count(table) == 4);
+    assert(expr_table_uses(table, shared) == 5);
+    assert(expr_table_uses(table, square) == 1);
+    assert(expr_table_uses(table, shared->data.binary_expr.left) == 5);
+    assert(expr_table_occurrences(table) == 7 + 3 + 6);
+
+    // Duplicate detection for a tree outside the table
+    ASTNode *probe = square_plus_one("a");
+    assert(expr_table_find(table, probe) == square);
+    assert(expr_table_find(table, probe->data.binary_expr.left) == shared);
+    ASTNode *missing = square_plus_one("z");
+    assert(expr_table_find(table, missing) == NULL);
+
+    // A pure root is itself replaced; consing again finds the shared node
+    ASTNode *root = hash_cons_ast(table, probe);
+    assert(root == square);
+    assert(expr_table_uses(table, square) == 2);
+    assert(hash_cons_ast(table, square) == square);
+
+    // Trees are freed first, then the canonical nodes
+    free_ast(block);
+    free_ast(missing);
+    destroy_expr_table(table);
+    printf("✓ Hash-consing test passed\n");
+}
+
+// Arena duplicates stay in their arena
+void test_arena_cons(void)
+{
+    ASTArena *arena = create_ast_arena();
+    ast_arena_set_current(arena);
+    ASTNode *expr = create_binary_expr("-", square_plus_one("q"), square_plus_one("q"));
+    ast_arena_set_current(NULL);
+
+    ExprTable *table = create_expr_table();
+    ASTNode *root = hash_cons_ast(table, expr);
+    assert(root == expr);
+    assert(root->data.binary_expr.left == root->data.binary_expr.right);
+    assert(expr_table_count(table) == 5);
+    destroy_expr_table(table);
+    destroy_ast_arena(arena);
+    printf("✓ Arena hash-consing test passed\n");
+}
+
+// Deep chains hash and cons without recursion
+void test_deep_chain(void)
+{
+    const int depth = 100000;
+    ASTNode *left = create_identifier("v");
+    ASTNode *right = create_identifier("v");
+    for (int i = 0; i < depth; i++)
+    {
+        left = create_binary_expr("+", left, create_literal("2"));
+        right = create_binary_expr("+", right, create_literal("2"));
+    }
+    assert(ast_structural_hash(left) == ast_structural_hash(right));
+    assert(ast_structurally_equal(left, right));
+
+    ExprTable *table = create_expr_table();
+    ASTNode *eq = create_binary_expr("==", left, right);
+    ASTNode *root = hash_cons_ast(table, eq);
+    assert(root->data.binary_expr.left == root->data.binary_expr.right);
+    // v, 2, one node per level, and the comparison
+    assert(expr_table_count(table) == (size_t)depth + 3);
+    destroy_expr_table(table);
+    printf("✓ Deep chain hash-consing test passed\n");
+}
+
+int main()
+{
+    printf("Running AST hashing tests...\n");
+
+    test_structural_hash();
+    test_hash_cons();
+    test_arena_cons();
+    test_deep_chain();
+
+    printf("All AST hashing tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,218 @@
+#include "../../include/ast.h"
+#include "../../include/comptime.h"
+#include "../../include/semantic.h"
+#include "../test_utils.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Deeper than any native-stack recursion over ASTNode would survive comfortably
+#define DEPTH 100000
+
+typedef struct
+{
+    char trace[256];
+    int length;
+    ASTNodeType stop_at;
+    ASTNodeType skip;
+} Trace;
+
+static char node_letter(const ASTNode *node)
+{
+    switch (node->type)
+    {
+    case AST_BINARY_EXPR:
+        return node->data.binary_expr.op[0];
+    case AST_LITERAL:
+        return node->data.literal.value[0];
+    case AST_IDENTIFIER:
+        return node->data.identifier.name[0];
+    case AST_IF_STMT:
+        return 'I';
+    case AST_BLOCK:
+        return 'B';
+    default:
+        return '?';
+    }
+}
+
+static ASTWalkAction trace_pre(ASTNode *node, ASTNode *parent, void *context)
+{
+    Trace *trace = context;
+    trace->trace[trace->length++] = '(';
+    trace->trace[trace->length++] = node_letter(node);
+    if (parent && parent->type == AST_BINARY_EXPR)
+        assert(node == parent->data.binary_expr.left || node == parent->data.binary_expr.right);
+    if (node->type == trace->stop_at)
+        return AST_WALK_STOP;
+    return node->type == trace->skip ? AST_WALK_SKIP : AST_WALK_CONTINUE;
+}
+
+static ASTWalkAction trace_post(ASTNode *node, ASTNode *parent, void *context)
+{
+    Trace *trace = context;
+    trace->trace[trace->length++] = ')';
+    return AST_WALK_CONTINUE;
+}
+
+static void run_trace(ASTNode *root, Trace *trace, int expect_finished)
+{
+    ASTVisitor visitor = {trace_pre, trace_post, trace};
+    trace->length = 0;
+    assert(ast_walk(root, &visitor) == expect_finished);
+    trace->trace[trace->length] = '\0';
+}
+
+// Left-nested chain 1 + 1 + ... + 1 with the given number of operators
+static ASTNode *build_chain(int depth)
+{
+    ASTNode *chain = create_literal("1");
+    for (int i = 0; i < depth; i++)
+        chain = create_binary_expr("+", chain, create_literal("1"));
+    return chain;
+}
+
+static int saved_stdout = -1;
+
+// The passes print a debug line per node; keep them out of the test output
+static void quiet_stdout(void)
+{
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+}
+
+static void restore_stdout(void)
+{
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+}
+
+// Pre and post callbacks run in depth-first order with NULL children skipped
+void test_walk_order(void)
+{
+    // if (a) { 1 * 2 } elif (b) { 3 } (no else)
+    ASTNode **if_statements = malloc(sizeof(ASTNode *));
+    if_statements[0] = create_binary_expr("*", create_literal("1"), create_literal("2"));
+    ASTNode **elif_conds = malloc(sizeof(ASTNode *));
+    ASTNode **elif_blocks = malloc(sizeof(ASTNode *));
+    ASTNode **elif_statements = malloc(sizeof(ASTNode *));
+    elif_statements[0] = create_literal("3");
+    elif_conds[0] = create_identifier("b");
+    elif_blocks[0] = create_block(elif_statements, 1);
+    ASTNode *node = create_if_stmt(create_identifier("a"), create_block(if_statements, 1),
+                                   elif_conds, elif_blocks, 1, NULL);
+    assert(ast_child_count(node) == 5);
+    assert(ast_child(node, 4) == NULL);
+
+    Trace trace = {.stop_at = AST_PRINT_STMT, .skip = AST_PRINT_STMT};
+    run_trace(node, &trace, 1);
+    assert(strcmp(trace.trace, "(I(a)(B(*(1)(2)))(b)(B(3)))") == 0);
+
+    // Skipped children still get the post callback for their parent
+    trace.skip = AST_BINARY_EXPR;
+    run_trace(node, &trace, 1);
+    assert(strcmp(trace.trace, "(I(a)(B(*))(b)(B(3)))") == 0);
+
+    // Stopping runs no further callbacks
+    trace.skip = AST_PRINT_STMT;
+    trace.stop_at = AST_LITERAL;
+    run_trace(node, &trace, 0);
+    assert(strcmp(trace.trace, "(I(a)(B(*(1") == 0);
+
+    free_ast(node);
+    printf("✓ Walk order test passed\n");
+}
+
+static ASTWalkAction count_node(ASTNode *node, ASTNode *parent, void *context)
+{
+    (*(long *)context)++;
+    return AST_WALK_CONTINUE;
+}
+
+// Deep chains are walked and freed without recursion
+void test_deep_walk_and_free(void)
+{
+    ASTNode *chain = build_chain(DEPTH);
+    long count = 0;
+    ASTVisitor visitor = {count_node, NULL, &count};
+    assert(ast_walk(chain, &visitor) == 1);
+    assert(count == 2L * DEPTH + 1);
+
+    // Right-nested chains exercise the stack the other way round
+    ASTNode *right = create_literal("1");
+    for (int i = 0; i < DEPTH; i++)
+        right = create_binary_expr("-", create_literal("2"), right);
+    count = 0;
+    visitor.post = count_node;
+    visitor.pre = NULL;
+    assert(ast_walk(right, &visitor) == 1);
+    assert(count == 2L * DEPTH + 1);
+
+    free_ast(chain);
+    free_ast(right);
+    printf("✓ Deep walk and free test passed\n");
+}
+
+// The comptime evaluator and checker handle deep chains
+void test_deep_comptime(void)
+{
+    ASTNode *chain = build_chain(DEPTH);
+    quiet_stdout();
+    bool comptime = is_comptime_expr(chain);
+    ComptimeValue *value = evaluate_comptime_expr(chain);
+    restore_stdout();
+    assert(comptime);
+    assert(value && value->value.i_val == DEPTH + 1);
+    free_comptime_value(value);
+
+    // A non-constant leaf anywhere makes the chain non-comptime
+    ASTNode *with_name = create_binary_expr("+", chain, create_identifier("x"));
+    quiet_stdout();
+    comptime = is_comptime_expr(with_name);
+    value = evaluate_comptime_expr(with_name);
+    restore_stdout();
+    assert(!comptime);
+    assert(value == NULL);
+
+    free_ast(with_name);
+    printf("✓ Deep comptime test passed\n");
+}
+
+// Semantic analysis of a deep initializer
+void test_deep_semantic(void)
+{
+    ASTNode **statements = malloc(2 * sizeof(ASTNode *));
+    statements[0] = create_var_decl(0, "x", "i32", create_literal("5"));
+    ASTNode *chain = create_identifier("x");
+    for (int i = 0; i < DEPTH; i++)
+        chain = create_binary_expr(i % 2 ? "*" : "+", chain, create_literal("3"));
+    statements[1] = create_var_decl(0, "y", "i32", chain);
+    ASTNode *block = create_block(statements, 2);
+
+    quiet_stdout();
+    semantic_analysis(block); // Exits on a semantic error
+    restore_stdout();
+
+    free_ast(block);
+    printf("✓ Deep semantic analysis test passed\n");
+}
+
+int main()
+{
+    printf("Running AST walk tests...\n");
+
+    test_walk_order();
+    test_deep_walk_and_free();
+    test_deep_comptime();
+    test_deep_semantic();
+
+    printf("All AST walk tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,317 @@
+#include "../../include/flat_ast.h"
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEEP 200000
+
+static ASTNode **node_list(int count, ...)
+{
+    ASTNode **items = malloc(count * sizeof(ASTNode *));
+    va_list args;
+    va_start(args, count);
+    for (int i = 0; i < count; i++)
+        items[i] = va_arg(args, ASTNode *);
+    va_end(args);
+    return items;
+}
+
+static int same_string(const char *a, const char *b)
+{
+    if (!a || !b)
+        return a == b;
+    return strcmp(a, b) == 0;
+}
+
+static int same_tree(const ASTNode *a, const ASTNode *b);
+
+static int same_list(ASTNode **a, ASTNode **b, int count)
+{
+    for (int i = 0; i < count; i++)
+        if (!same_tree(a[i], b[i]))
+            return 0;
+    return 1;
+}
+
+// Structural equality of two pointer trees
+static int same_tree(const ASTNode *a, const ASTNode *b)
+{
+    if (!a || !b)
+        return a == b;
+    if (a->type != b->type)
+        return 0;
+    switch (a->type)
+    {
+    case AST_VAR_DECL:
+        return a->data.var_decl.is_const == b->data.var_decl.is_const &&
+               a->data.var_decl.atom == b->data.var_decl.atom &&
+               same_string(a->data.var_decl.type_annotation, b->data.var_decl.type_annotation) &&
+               same_tree(a->data.var_decl.initializer, b->data.var_decl.initializer);
+    case AST_PRINT_STMT:
+    case AST_PROMPT_STMT:
+    case AST_EXPR_STMT:
+    case AST_RETURN_STMT:
+    case AST_STRING_INTERP:
+        return same_tree(a->data.expr_stmt.expr, b->data.expr_stmt.expr);
+    case AST_IF_STMT:
+        return a->data.if_stmt.elif_count == b->data.if_stmt.elif_count &&
+               same_tree(a->data.if_stmt.condition, b->data.if_stmt.condition) &&
+               same_tree(a->data.if_stmt.if_block, b->data.if_stmt.if_block) &&
+               same_list(a->data.if_stmt.elif_conds, b->data.if_stmt.elif_conds, a->data.if_stmt.elif_count) &&
+               same_list(a->data.if_stmt.elif_blocks, b->data.if_stmt.elif_blocks, a->data.if_stmt.elif_count) &&
+               same_tree(a->data.if_stmt.else_block, b->data.if_stmt.else_block);
+    case AST_WHILE_STMT:
+        return same_tree(a->data.while_stmt.condition, b->data.while_stmt.condition) &&
+               same_tree(a->data.while_stmt.block, b->data.while_stmt.block);
+    case AST_FOR_STMT:
+        return a->data.for_stmt.iterator_atom == b->data.for_stmt.iterator_atom &&
+               same_tree(a->data.for_stmt.start_expr, b->data.for_stmt.start_expr) &&
+               same_tree(a->data.for_stmt.end_expr, b->data.for_stmt.end_expr) &&
+               same_tree(a->data.for_stmt.block, b->data.for_stmt.block);
+    case AST_FUNC_DEF:
+        return a->data.func_def.atom == b->data.func_def.atom &&
+               a->data.func_def.param_count == b->data.func_def.param_count &&
+               a->data.func_def.is_comptime == b->data.func_def.is_comptime &&
+               same_string(a->data.func_def.return_type, b->data.func_def.return_type) &&
+               same_list(a->data.func_def.parameters, b->data.func_def.parameters, a->data.func_def.param_count) &&
+               same_tree(a->data.func_def.body, b->data.func_def.body);
+    case AST_BLOCK:
+        return a->data.block.stmt_count == b->data.block.stmt_count &&
+               same_list(a->data.block.statements, b->data.block.statements, a->data.block.stmt_count);
+    case AST_BINARY_EXPR:
+        return strcmp(a->data.binary_expr.op, b->data.binary_expr.op) == 0 &&
+               same_tree(a->data.binary_expr.left, b->data.binary_expr.left) &&
+               same_tree(a->data.binary_expr.right, b->data.binary_expr.right);
+    case AST_UNARY_EXPR:
+        return strcmp(a->data.unary_expr.op, b->data.unary_expr.op) == 0 &&
+               same_tree(a->data.unary_expr.operand, b->data.unary_expr.operand);
+    case AST_LITERAL:
+        return strcmp(a->data.literal.value, b->data.literal.value) == 0 &&
+               a->data.literal.parsed.kind == b->data.literal.parsed.kind &&
+               (a->data.literal.parsed.kind != LITERAL_STRING ||
+                strcmp(a->data.literal.parsed.as.string.text, b->data.literal.parsed.as.string.text) == 0);
+    case AST_IDENTIFIER:
+        return a->data.identifier.atom == b->data.identifier.atom;
+    case AST_FUNC_CALL:
+        return a->data.func_call.atom == b->data.func_call.atom &&
+               a->data.func_call.arg_count == b->data.func_call.arg_count &&
+               same_list(a->data.func_call.arguments, b->data.func_call.arguments, a->data.func_call.arg_count);
+    case AST_ASSIGN_EXPR:
+        return same_tree(a->data.assign_expr.left, b->data.assign_expr.left) &&
+               same_tree(a->data.assign_expr.right, b->data.assign_expr.right);
+    case AST_ARRAY_LITERAL:
+        return a->data.array_literal.element_count == b->data.array_literal.element_count &&
+               same_list(a->data.array_literal.elements, b->data.array_literal.elements,
+                         a->data.array_literal.element_count);
+    case AST_ARRAY_INDEX:
+        return same_tree(a->data.array_index.array, b->data.array_index.array) &&
+               same_tree(a->data.array_index.index, b->data.array_index.index);
+    case AST_SWITCH_STMT:
+        return a->data.switch_stmt.case_count == b->data.switch_stmt.case_count &&
+               same_tree(a->data.switch_stmt.expr, b->data.switch_stmt.expr) &&
+               same_list(a->data.switch_stmt.cases, b->data.switch_stmt.cases, a->data.switch_stmt.case_count) &&
+               same_tree(a->data.switch_stmt.finally_block, b->data.switch_stmt.finally_block);
+    case AST_CASE_STMT:
+        return same_tree(a->data.case_stmt.expr, b->data.case_stmt.expr) &&
+               same_tree(a->data.case_stmt.statement, b->data.case_stmt.statement);
+    case AST_FSTRING:
+        return a->data.fstring.part_count == b->data.fstring.part_count &&
+               same_list(a->data.fstring.parts, b->data.fstring.parts, a->data.fstring.part_count);
+    case AST_STRUCT_DEF:
+        if (a->data.struct_def.atom != b->data.struct_def.atom ||
+            a->data.struct_def.field_count != b->data.struct_def.field_count)
+            return 0;
+        for (int i = 0; i < a->data.struct_def.field_count; i++)
+            if (strcmp(a->data.struct_def.field_names[i], b->data.struct_def.field_names[i]) != 0 ||
+                strcmp(a->data.struct_def.field_types[i], b->data.struct_def.field_types[i]) != 0)
+                return 0;
+        return 1;
+    case AST_FIELD_ACCESS:
+        return a->data.field_access.field_atom == b->data.field_access.field_atom &&
+               same_tree(a->data.field_access.struct_expr, b->data.field_access.struct_expr);
+    case AST_BREAK_STMT:
+    case AST_CONTINUE_STMT:
+        return 1;
+    }
+    return 0;
+}
+
+// A program touching every node type
+static ASTNode *build_program(void)
+{
+    char *field_names[] = {"x", "y"};
+    char *field_types[] = {"i32", "f64"};
+    ASTNode *loop_body = create_block(node_list(3,
+        create_expr_stmt(create_assign_expr(create_identifier("total"),
+            create_binary_expr("+", create_identifier("total"),
+                create_array_index(create_identifier("items"), create_identifier("i"))))),
+        create_break_stmt(),
+        create_continue_stmt()), 3);
+    ASTNode *if_stmt = create_if_stmt(
+        create_binary_expr("<", create_identifier("total"), create_literal("10")),
+        create_block(node_list(1, create_print_stmt(create_literal("\"small\""))), 1),
+        node_list(2, create_unary_expr("not", create_identifier("done")),
+                  create_binary_expr("==", create_identifier("total"), create_literal("1.5"))),
+        node_list(2, create_block(NULL, 0),
+                  create_block(node_list(1, create_prompt_stmt(create_literal("\"a\\tb\""))), 1)),
+        2,
+        create_block(node_list(1, create_return_stmt(NULL)), 1));
+    ASTNode *body = create_block(node_list(7,
+        create_var_decl(1, "items", "i32[]", create_array_literal(node_list(3,
+            create_literal("1"), create_literal("2"), create_unary_expr("-", create_literal("3"))), 3)),
+        create_var_decl(0, "total", NULL, create_literal("0")),
+        create_for_stmt("i", create_literal("0"), create_literal("3"), loop_body),
+        create_while_stmt(create_literal("false"), create_block(NULL, 0)),
+        if_stmt,
+        create_switch_stmt(create_identifier("total"),
+            node_list(1, create_case_stmt(create_literal("6"), create_expr_stmt(create_func_call("log", NULL, 0)))), 1,
+            create_block(NULL, 0)),
+        create_print_stmt(create_fstring(node_list(2, create_literal("\"sum \""),
+            create_string_interp(create_field_access(create_identifier("point"), "x"))), 2))), 7);
+    ASTNode *func = create_func_def("sum", node_list(2, create_identifier("a"), create_identifier("b")), 2,
+                                    "i32", body, 1);
+    ASTNode *program = create_block(node_list(2,
+        create_struct_def("Point", field_names, field_types, 2), func), 2);
+    return program;
+}
+
+// Conversion to the flat form and back reproduces the tree
+void test_round_trip(void)
+{
+    ASTNode *program = build_program();
+    FlatAST *flat = create_flat_ast();
+    FlatIndex root = flat_ast_add_tree(flat, program);
+    assert(root == flat->node_count - 1);
+    assert(flat_node(flat, root)->tag == AST_BLOCK);
+
+    ASTNode *rebuilt = flat_ast_to_tree(flat, root);
+    assert(same_tree(program, rebuilt));
+
+    free_ast(rebuilt);
+    free_ast(program);
+    destroy_flat_ast(flat);
+    printf("✓ Flat AST round trip test passed\n");
+}
+
+// Nodes are 16 bytes, and children always precede their parents
+void test_layout(void)
+{
+    assert(sizeof(FlatNode) == 16);
+
+    ASTNode *program = build_program();
+    FlatAST *flat = create_flat_ast();
+    FlatIndex root = flat_ast_add_tree(flat, program);
+    for (FlatIndex i = 1; i < flat->node_count; i++)
+    {
+        const FlatNode *node = flat_node(flat, i);
+        if (node->tag == AST_BINARY_EXPR || node->tag == AST_ASSIGN_EXPR)
+        {
+            assert(node->a < i && node->b < i);
+            assert(node->a != FLAT_NONE && node->b != FLAT_NONE);
+        }
+        if (node->tag == AST_BLOCK)
+            for (uint32_t k = 0; k < node->b; k++)
+                assert(flat_extra(flat, node->a)[k] < i);
+    }
+
+    // The function's parameters and return type live in extra data
+    const FlatNode *program_node = flat_node(flat, root);
+    const FlatNode *func = flat_node(flat, flat_extra(flat, program_node->a)[1]);
+    assert(func->tag == AST_FUNC_DEF && func->flags == 1);
+    assert(strcmp(atom_text(func->a), "sum") == 0);
+    assert(strcmp(atom_text(flat_extra(flat, func->c)[0]), "i32") == 0);
+    assert(flat_extra(flat, func->c)[1] == 2);
+
+    // Literals keep their pre-parsed values
+    const FlatNode *decl = flat_node(flat, flat_extra(flat, flat_node(flat, func->b)->a)[1]);
+    assert(decl->tag == AST_VAR_DECL && decl->flags == 0);
+    const FlatLiteral *zero = flat_literal(flat, decl->b);
+    assert(zero->value.kind == LITERAL_INT && zero->value.as.integer == 0);
+    assert(strcmp(flat_literal_text(flat, zero), "0") == 0);
+
+    assert(flat_ast_memory(flat) > 0);
+    free_ast(program);
+    destroy_flat_ast(flat);
+    printf("✓ Flat AST layout test passed\n");
+}
+
+// Parsed trees convert too, and several trees can share one flat AST
+void test_parsed_trees(void)
+{
+    const char *sources[] = {
+        "let a: i32 = -(1 + 2) * 3 ** 2;",
+        "let b = x = y or not z and \"s\\n\" != 2.5;",
+    };
+    FlatAST *flat = create_flat_ast();
+    for (int i = 0; i < 2; i++)
+    {
+        TokenArray tokens = tokenize(sources[i]);
+        Parser *parser = create_parser(tokens);
+        ASTNode *decl = parse_var_declaration(parser);
+        assert(decl && !parser->had_error);
+
+        FlatIndex index = flat_ast_add_tree(flat, decl);
+        ASTNode *rebuilt = flat_ast_to_tree(flat, index);
+        assert(same_tree(decl, rebuilt));
+
+        free_ast(rebuilt);
+        free_ast(decl);
+        destroy_parser(parser);
+        free_token_array(&tokens);
+    }
+    destroy_flat_ast(flat);
+    printf("✓ Flat AST parsed trees test passed\n");
+}
+
+// A chain far deeper than the native stack allows for recursion converts
+// both ways
+void test_deep_chain(void)
+{
+    // let s: i32 = 0 + 1 + 1 + ... + 1;
+    ASTNode *chain = create_literal("0");
+    for (int i = 0; i < DEEP; i++)
+        chain = create_binary_expr("+", chain, create_literal("1"));
+    ASTNode *decl = create_var_decl(0, "s", "i32", chain);
+
+    FlatAST *flat = create_flat_ast();
+    FlatIndex root = flat_ast_add_tree(flat, decl);
+    assert(root == flat->node_count - 1);
+    assert(flat->node_count == 2 * DEEP + 3);
+    int depth = 0;
+    for (FlatIndex i = flat_node(flat, root)->b; flat_node(flat, i)->tag == AST_BINARY_EXPR; i = flat_node(flat, i)->a)
+        depth++;
+    assert(depth == DEEP);
+
+    ASTNode *rebuilt = flat_ast_to_tree(flat, root);
+    depth = 0;
+    ASTNode *node = rebuilt->data.var_decl.initializer;
+    for (; node->type == AST_BINARY_EXPR; node = node->data.binary_expr.left)
+    {
+        assert(strcmp(node->data.binary_expr.op, "+") == 0);
+        assert(strcmp(node->data.binary_expr.right->data.literal.value, "1") == 0);
+        depth++;
+    }
+    assert(depth == DEEP && strcmp(node->data.literal.value, "0") == 0);
+
+    free_ast(rebuilt);
+    free_ast(decl);
+    destroy_flat_ast(flat);
+    printf("✓ Flat AST deep chain test passed\n");
+}
+
+int main()
+{
+    printf("Running flat AST tests...\n");
+
+    test_round_trip();
+    test_layout();
+    test_parsed_trees();
+    test_deep_chain();
+
+    printf("All flat AST tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include "../../include/semantic.h"
+#include "../test_utils.h"
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DECLS 120
+#define EDITS 400
+
+static ASTNode **node_list(int count, ...)
+{
+    ASTNode **items = malloc((count ? count : 1) * sizeof(ASTNode *));
+    va_list args;
+    va_start(args, count);
+    for (int i = 0; i < count; i++)
+        items[i] = va_arg(args, ASTNode *);
+    va_end(args);
+    return items;
+}
+
+static char *name_of(char *buffer, const char *format, int n)
+{
+    snprintf(buffer, 32, format, n);
+    return buffer;
+}
+
+static ASTNode *function(const char *name, const char *param_type, ASTNode *result)
+{
+    return create_func_def(name, node_list(1, create_var_decl(0, "a", (char *)param_type, NULL)), 1, "i32",
+                           create_block(node_list(1, create_return_stmt(result)), 1), 0);
+}
+
+// Declaration i of a module, in one of a few versions; version 3 leaves it
+// out. Functions call earlier functions, read earlier globals and access the
+// fields of earlier structs, so most edits change what later ones see.
+static ASTNode *make_decl(int i, int version)
+{
+    char name[32], other[32];
+    if (version == 3)
+        return NULL;
+    switch (i % 6)
+    {
+    case 0:
+        // let g: i32 = 7;  (bool: an error, f64: a new type)
+        if (version == 1)
+            return create_var_decl(0, name_of(name, "g_%d", i), "bool", create_literal("1"));
+        if (version == 2)
+            return create_var_decl(0, name_of(name, "g_%d", i), "f64", create_literal("1.5"));
+        return create_var_decl(0, name_of(name, "g_%d", i), "i32", create_literal("7"));
+    case 1:
+        // fn f(a: i32): i32 { return a * g; }  (a new signature, a new body)
+        if (version == 2)
+            return function(name_of(name, "f_%d", i), "i32", create_literal("2"));
+        return function(name_of(name, "f_%d", i), version == 1 ? "f64" : "i32",
+                        create_binary_expr("*", create_identifier("a"),
+                                           create_identifier(name_of(other, "g_%d", i - 1))));
+    case 2:
+        // fn h(a: i32): i32 { return f(a) + 1; }  (f(1.5), or f itself)
+        if (version == 2)
+            return function(name_of(name, "h_%d", i), "i32", create_identifier(name_of(other, "f_%d", i - 1)));
+        return function(name_of(name, "h_%d", i), "i32",
+                        create_binary_expr("+",
+                                           create_func_call(name_of(other, "f_%d", i - 1),
+                                                            node_list(1, version == 1 ? create_literal("1.5")
+                                                                                      : create_identifier("a")),
+                                                            1),
+                                           create_literal("1")));
+    case 3:
+        // struct S { x: i32, y: f64 }  (x: f64, or x twice)
+        return create_struct_def(name_of(name, "S_%d", i), (char *[]){"x", version == 2 ? "x" : "y"},
+                                 (char *[]){version == 1 ? "f64" : "i32", "f64"}, 2);
+    case 4:
+        // fn u(a: struct S): i32 { return a.x; }  (a.y, or a.z)
+        name_of(other, "struct S_%d", i - 1);
+        return function(name_of(name, "u_%d", i), other,
+                        create_field_access(create_identifier("a"), version == 0 ? "x" : version == 1 ? "y" : "z"));
+    default:
+        // let v: i32 = h(2);  (f64, or h(g))
+        return create_var_decl(0, name_of(name, "v_%d", i), version == 1 ? "f64" : "i32",
+                               create_func_call(name_of(other, "h_%d", i - 3),
+                                                node_list(1, version == 2
+                                                                 ? create_identifier(name_of(other, "g_%d", i - 5))
+                                                                 : create_literal("2")),
+                                                1));
+    }
+}
+
+// Present declarations of a module, in order.
+static int collect(ASTNode **module, const int *order, int count, ASTNode **decls)
+{
+    int n = 0;
+    for (int k = 0; k < count; k++)
+        if (module[order[k]])
+            decls[n++] = module[order[k]];
+    return n;
+}
+
+// The program's diagnostics are the ones a full check reports.
+static void assert_matches_full_check(SemanticProgram *program, ASTNode **decls, int count)
+{
+    SemanticContext context;
+    semantic_context_init(&context, create_symbol_table(NULL));
+    int errors = semantic_check_program(&context, decls, count, 2);
+    const SemanticDiagnostics *diagnostics = semantic_program_diagnostics(program);
+    assert(diagnostics->count == errors);
+    for (int i = 0; i < errors; i++)
+    {
+        assert(diagnostics->items[i].decl == context.diagnostics.items[i].decl);
+        assert(strcmp(diagnostics->items[i].message, context.diagnostics.items[i].message) == 0);
+    }
+    destroy_symbol_table(context.globals);
+    semantic_context_destroy(&context);
+}
+
+static int has_message(SemanticProgram *program, const char *text)
+{
+    const SemanticDiagnostics *diagnostics = semantic_program_diagnostics(program);
+    for (int i = 0; i < diagnostics->count; i++)
+        if (strstr(diagnostics->items[i].message, text))
+            return 1;
+    return 0;
+}
+
+// Replace declaration i by a new node, freeing the old one once the program
+// no longer refers to it.
+static void edit(SemanticProgram *program, ASTNode **module, int *order, int i, int version, ASTNode **decls)
+{
+    ASTNode *old = module[i];
+    module[i] = make_decl(i, version);
+    int count = collect(module, order, DECLS, decls);
+    semantic_program_update(program, decls, count, 2);
+    free_ast(old);
+    assert_matches_full_check(program, decls, count);
+}
+
+// Only the edited declaration and those using what it changed are walked
+void test_rechecks_dependents(void)
+{
+    ASTNode *module[DECLS];
+    int order[DECLS];
+    ASTNode *decls[DECLS];
+    for (int i = 0; i < DECLS; i++)
+    {
+        module[i] = make_decl(i, 0);
+        order[i] = i;
+    }
+    SemanticProgram *program = create_semantic_program();
+    assert(semantic_program_update(program, decls, collect(module, order, DECLS, decls), 2) == 0);
+    assert(semantic_program_rechecked(program) == DECLS);
+    assert(semantic_program_update(program, decls, DECLS, 2) == 0);
+    assert(semantic_program_rechecked(program) == 0);
+
+    // A new body with the same signature: only the function itself
+    edit(program, module, order, 13, 2, decls);
+    assert(semantic_program_rechecked(program) == 1);
+
+    // A new signature: the function and its caller h_14
+    edit(program, module, order, 13, 1, decls);
+    assert(semantic_program_rechecked(program) == 2);
+    assert(has_message(program, "Argument 1 of call to 'f_13' has wrong type"));
+
+    // A global changing type: f_19, which reads it, and v_23, which passes it
+    edit(program, module, order, 23, 2, decls);
+    assert(semantic_program_rechecked(program) == 1);
+    edit(program, module, order, 18, 2, decls);
+    assert(semantic_program_rechecked(program) == 3);
+    assert(has_message(program, "Return type mismatch"));
+
+    // Struct fields: the struct and u_22, which reads one
+    edit(program, module, order, 21, 1, decls);
+    assert(semantic_program_rechecked(program) == 2);
+    assert(has_message(program, "Expected i32, got f64"));
+
+    // Removing a function leaves its caller with an error, restoring it clears it
+    edit(program, module, order, 14, 3, decls);
+    assert(semantic_program_rechecked(program) == 1);
+    assert(has_message(program, "Call to undefined function 'h_14'"));
+    edit(program, module, order, 14, 0, decls);
+    assert(semantic_program_rechecked(program) == 2);
+    assert(!has_message(program, "h_14"));
+
+    destroy_semantic_program(program);
+    for (int i = 0; i < DECLS; i++)
+        free_ast(module[i]);
+    printf("✓ Rechecks dependents test passed\n");
+}
+
+// Random edits, removals and moves keep the results equal to a full check
+void test_random_edits(void)
+{
+    ASTNode *module[DECLS];
+    int order[DECLS];
+    ASTNode *decls[DECLS];
+    for (int i = 0; i < DECLS; i++)
+    {
+        module[i] = make_decl(i, 0);
+        order[i] = i;
+    }
+    SemanticProgram *program = create_semantic_program();
+    semantic_program_update(program, decls, collect(module, order, DECLS, decls), 1);
+
+    srand(7);
+    long rechecked = 0;
+    for (int e = 0; e < EDITS; e++)
+    {
+        if (e % 5 == 4)
+        {
+            // Move a declaration past its neighbour
+            int k = rand() % (DECLS - 1);
+            int swap = order[k];
+            order[k] = order[k + 1];
+            order[k + 1] = swap;
+            int count = collect(module, order, DECLS, decls);
+            semantic_program_update(program, decls, count, 1 + e % 3);
+            assert_matches_full_check(program, decls, count);
+        }
+        else
+            edit(program, module, order, rand() % DECLS, rand() % 4, decls);
+        rechecked += semantic_program_rechecked(program);
+    }
+    // Most declarations were reused most of the time
+    assert(rechecked < (long)EDITS * DECLS / 10);
+
+    destroy_semantic_program(program);
+    for (int i = 0; i < DECLS; i++)
+        free_ast(module[i]);
+    printf("✓ Random edits test passed\n");
+}
+
+int main()
+{
+    printf("Running incremental semantic analysis tests...\n");
+
+    test_rechecks_dependents();
+    test_random_edits();
+
+    printf("All incremental semantic analysis tests passed!\n");
+    return 0;
+}
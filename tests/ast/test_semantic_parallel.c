@@ -0,0 +1,239 @@
+#include "../../include/semantic.h"
+#include "../test_utils.h"
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DECLS 600
+
+static ASTNode **node_list(int count, ...)
+{
+    ASTNode **items = malloc(count * sizeof(ASTNode *));
+    va_list args;
+    va_start(args, count);
+    for (int i = 0; i < count; i++)
+        items[i] = va_arg(args, ASTNode *);
+    va_end(args);
+    return items;
+}
+
+static ASTNode *name_call(const char *format, int n, ASTNode *arg)
+{
+    char name[32];
+    snprintf(name, sizeof(name), format, n);
+    return create_func_call(name, node_list(1, arg), 1);
+}
+
+static ASTNode *name_ref(const char *format, int n)
+{
+    char name[32];
+    snprintf(name, sizeof(name), format, n);
+    return create_identifier(name);
+}
+
+static ASTNode *function(const char *format, int n, ASTNode **body, int count)
+{
+    char name[32];
+    snprintf(name, sizeof(name), format, n);
+    return create_func_def(name, node_list(1, create_var_decl(0, "a", "i32", NULL)), 1, "i32",
+                           create_block(body, count), 0);
+}
+
+static ASTNode *global(const char *format, int n, char *type, ASTNode *init)
+{
+    char name[32];
+    snprintf(name, sizeof(name), format, n);
+    return create_var_decl(0, name, type, init);
+}
+
+// A module of functions calling earlier functions and reading earlier
+// globals, with a few kinds of errors sprinkled in. Declarations an error
+// replaces cause more errors where they are used.
+static ASTNode **generate_module(int count, int *decl_count)
+{
+    ASTNode **decls = malloc(2 * count * sizeof(ASTNode *));
+    int n = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (i % 97 == 13)
+        {
+            // fn bad(a: i32): i32 { let s: bool = a; }
+            decls[n++] = function("bad_%d", i, node_list(1, create_var_decl(0, "s", "bool", create_identifier("a"))), 1);
+        }
+        else if (i % 97 == 41)
+        {
+            // fn ahead(a: i32): i32 { return later; } let later: i32 = 1;
+            decls[n++] = function("ahead_%d", i, node_list(1, create_return_stmt(name_ref("later_%d", i))), 1);
+            decls[n++] = global("later_%d", i, "i32", create_literal("1"));
+        }
+        else if (i % 97 == 70)
+            decls[n++] = global("wrong_%d", i, "bool", create_literal("1"));
+        else if (i % 97 == 85)
+        {
+            decls[n++] = function("dup_%d", i, node_list(1, create_return_stmt(create_literal("1"))), 1);
+            decls[n++] = function("dup_%d", i, node_list(1, create_return_stmt(create_literal("2"))), 1);
+        }
+        else if (i % 5 == 0)
+            decls[n++] = global("g_%d", i, "i32", create_literal("7"));
+        else if (i % 5 == 1)
+        {
+            // fn f(a: i32): i32 { let x: i32 = a * g; return x; }
+            ASTNode *x = create_var_decl(0, "x", "i32", create_binary_expr("*", create_identifier("a"),
+                                                                         name_ref("g_%d", i - 1)));
+            decls[n++] = function("f_%d", i, node_list(2, x, create_return_stmt(create_identifier("x"))), 2);
+        }
+        else if (i % 5 == 2)
+        {
+            // fn h(a: i32): i32 { if (a < 0) { return 0; } return f(a) + 1; }
+            ASTNode *condition = create_binary_expr("<", create_identifier("a"), create_literal("0"));
+            ASTNode *early = create_block(node_list(1, create_return_stmt(create_literal("0"))), 1);
+            ASTNode *check = create_if_stmt(condition, early, NULL, NULL, 0, NULL);
+            ASTNode *result = create_binary_expr("+", name_call("f_%d", i - 1, create_identifier("a")),
+                                                 create_literal("1"));
+            decls[n++] = function("h_%d", i, node_list(2, check, create_return_stmt(result)), 2);
+        }
+        else if (i % 5 == 3)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "S_%d", i);
+            decls[n++] = create_struct_def(name, (char *[]){"x", "y"}, (char *[]){"i32", "f64"}, 2);
+        }
+        else
+            decls[n++] = global("v_%d", i, "i32", name_call("h_%d", i - 2, create_literal("2")));
+    }
+    *decl_count = n;
+    return decls;
+}
+
+static int has_message(const SemanticContext *context, const char *text)
+{
+    for (int i = 0; i < context->diagnostics.count; i++)
+        if (strstr(context->diagnostics.items[i].message, text))
+            return 1;
+    return 0;
+}
+
+static SemanticContext check_program(ASTNode **decls, int count, int threads)
+{
+    SemanticContext context;
+    semantic_context_init(&context, create_symbol_table(NULL));
+    int errors = semantic_check_program(&context, decls, count, threads);
+    assert(errors == context.diagnostics.count);
+    return context;
+}
+
+static void free_context(SemanticContext *context)
+{
+    destroy_symbol_table(context->globals);
+    semantic_context_destroy(context);
+}
+
+// Diagnostics come out the same, in declaration order, whatever the thread
+// count, and match checking each declaration in turn
+void test_deterministic_diagnostics(void)
+{
+    int decl_count;
+    ASTNode **decls = generate_module(DECLS, &decl_count);
+
+    SemanticContext serial;
+    semantic_context_init(&serial, create_symbol_table(NULL));
+    int *owner = malloc(decl_count * sizeof(int));
+    for (int k = 0; k < decl_count; k++)
+    {
+        int added = semantic_check(&serial, decls[k]);
+        for (int i = serial.diagnostics.count - added; i < serial.diagnostics.count; i++)
+            owner[i] = k;
+    }
+    assert(serial.diagnostics.count > 4 * (DECLS / 97));
+    assert(strstr(serial.diagnostics.items[0].message, "Type mismatch in initialization of 's'"));
+    assert(has_message(&serial, "Undeclared identifier 'later_41'"));
+    assert(has_message(&serial, "Call to undefined function 'f_41'"));
+    assert(has_message(&serial, "Type mismatch in initialization of 'wrong_70'"));
+    assert(has_message(&serial, "Duplicate function declaration 'dup_85'"));
+
+    int threads[] = {1, 2, 8, 64};
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+    {
+        SemanticContext context = check_program(decls, decl_count, threads[t]);
+        assert(context.diagnostics.count == serial.diagnostics.count);
+        for (int i = 0; i < context.diagnostics.count; i++)
+        {
+            assert(context.diagnostics.items[i].decl == owner[i]);
+            assert(strcmp(context.diagnostics.items[i].message, serial.diagnostics.items[i].message) == 0);
+        }
+        free_context(&context);
+    }
+
+    free(owner);
+    free_context(&serial);
+    for (int k = 0; k < decl_count; k++)
+        free_ast(decls[k]);
+    free(decls);
+    printf("✓ Deterministic diagnostics test passed\n");
+}
+
+// Bodies are typed by the workers too
+void test_parallel_types(void)
+{
+    // let base: f64 = 1.5;
+    // fn scale(a: f64): f64 { return a * base; }
+    // fn twice(a: f64): f64 { return scale(a) + scale(a); }
+    ASTNode *base = create_var_decl(0, "base", "f64", create_literal("1.5"));
+    ASTNode *product = create_binary_expr("*", create_identifier("a"), create_identifier("base"));
+    ASTNode *scale = create_func_def("scale", node_list(1, create_var_decl(0, "a", "f64", NULL)), 1, "f64",
+                                     create_block(node_list(1, create_return_stmt(product)), 1), 0);
+    ASTNode *sum = create_binary_expr("+", create_func_call("scale", node_list(1, create_identifier("a")), 1),
+                                      create_func_call("scale", node_list(1, create_identifier("a")), 1));
+    ASTNode *twice = create_func_def("twice", node_list(1, create_var_decl(0, "a", "f64", NULL)), 1, "f64",
+                                     create_block(node_list(1, create_return_stmt(sum)), 1), 0);
+    ASTNode *decls[] = {base, scale, twice};
+
+    SemanticContext context = check_program(decls, 3, 2);
+    assert(context.diagnostics.count == 0);
+    assert(sum->value_type == create_type(TYPE_F64));
+    assert(product->value_type == create_type(TYPE_F64));
+    assert(twice->value_type == create_type(TYPE_UNKNOWN));
+    // Locals were checked in scopes of their own
+    assert(context.globals->count == 3 && context.globals->depth == 0);
+
+    free_context(&context);
+    for (int k = 0; k < 3; k++)
+        free_ast(decls[k]);
+    printf("✓ Parallel types test passed\n");
+}
+
+// A bad declaration does not stop the others from being checked
+void test_errors_do_not_exit(void)
+{
+    ASTNode **body = malloc(sizeof(ASTNode *));
+    body[0] = create_break_stmt();
+    ASTNode *func = create_func_def("loose_break", NULL, 0, "void", create_block(body, 1), 0);
+
+    SemanticContext context;
+    semantic_context_init(&context, create_symbol_table(NULL));
+    assert(semantic_check(&context, func) == 1);
+    assert(strcmp(context.diagnostics.items[0].message,
+                  "Semantic Error: Break statement outside of loop\n") == 0);
+    // The scopes the failed check opened were closed again
+    assert(context.globals->depth == 0);
+    assert(semantic_check(&context, func) == 1);
+    assert(strstr(context.diagnostics.items[1].message, "Duplicate function declaration"));
+
+    free_context(&context);
+    free_ast(func);
+    printf("✓ Errors do not exit test passed\n");
+}
+
+int main()
+{
+    printf("Running parallel semantic analysis tests...\n");
+
+    test_deterministic_diagnostics();
+    test_parallel_types();
+    test_errors_do_not_exit();
+
+    printf("All parallel semantic analysis tests passed!\n");
+    return 0;
+}
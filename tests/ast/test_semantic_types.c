@@ -0,0 +1,197 @@
+#include "../../include/ast_hash.h"
+#include "../../include/comptime.h"
+#include "../../include/flat_ast.h"
+#include "../../include/parser.h"
+#include "../../include/semantic.h"
+#include "../test_utils.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEEP 20000
+
+static ASTNode **node_list(ASTNode *a, ASTNode *b)
+{
+    ASTNode **items = malloc(2 * sizeof(ASTNode *));
+    items[0] = a;
+    items[1] = b;
+    return items;
+}
+
+// Every expression carries the type the checker computed for it
+void test_node_types(void)
+{
+    // let x: f64 = 1.5; let b: bool = x * 2 < x;
+    ASTNode *product = create_binary_expr("*", create_identifier("x"), create_literal("2"));
+    ASTNode *compare = create_binary_expr("<", product, create_identifier("x"));
+    ASTNode *x = create_var_decl(0, "x", "f64", create_literal("1.5"));
+    ASTNode *b = create_var_decl(0, "b", "bool", compare);
+    ASTNode *program = create_block(node_list(x, b), 2);
+    assert(compare->value_type == NULL);
+
+    SymbolTable *global = create_symbol_table(NULL);
+    semantic_visit(program, global);
+    assert(x->data.var_decl.initializer->value_type == create_type(TYPE_F64));
+    assert(product->data.binary_expr.left->value_type == create_type(TYPE_F64));
+    assert(product->data.binary_expr.right->value_type == create_type(TYPE_I32));
+    assert(product->value_type == create_type(TYPE_F64));
+    assert(compare->value_type == create_type(TYPE_BOOL));
+    // Statements have no type of their own
+    assert(b->value_type == create_type(TYPE_UNKNOWN));
+    destroy_symbol_table(global);
+    free_ast(program);
+    printf("✓ Node types test passed\n");
+}
+
+// A long chain is typed in one pass, each node once
+void test_deep_chain(void)
+{
+    // let s: string = "a" + "a" + ... + "a";
+    ASTNode *chain = create_literal("\"a\"");
+    for (int i = 0; i < DEEP; i++)
+        chain = create_binary_expr("+", chain, create_literal("\"a\""));
+    ASTNode *decl = create_var_decl(0, "s", "string", chain);
+
+    SymbolTable *global = create_symbol_table(NULL);
+    semantic_visit(decl, global);
+    int depth = 0;
+    for (ASTNode *node = chain; node->type == AST_BINARY_EXPR; node = node->data.binary_expr.left)
+    {
+        assert(node->value_type == create_type(TYPE_STRING));
+        depth++;
+    }
+    assert(depth == DEEP);
+    destroy_symbol_table(global);
+    free_ast(decl);
+    printf("✓ Deep chain test passed\n");
+}
+
+// Lowering keeps the types, and so does rebuilding a tree from the flat form
+void test_flat_types(void)
+{
+    ASTNode *sum = create_binary_expr("+", create_literal("1"), create_literal("2"));
+    ASTNode *decl = create_var_decl(1, "n", "i32", sum);
+    SymbolTable *global = create_symbol_table(NULL);
+    semantic_visit(decl, global);
+
+    FlatAST *flat = create_flat_ast();
+    FlatIndex root = flat_ast_add_tree(flat, decl);
+    FlatIndex init = flat_node(flat, root)->b;
+    assert(flat_type(flat, init) == create_type(TYPE_I32));
+    assert(flat_type(flat, root) == create_type(TYPE_UNKNOWN));
+    assert(flat_type(flat, FLAT_NONE) == NULL);
+
+    ASTNode *rebuilt = flat_ast_to_tree(flat, root);
+    assert(rebuilt->data.var_decl.initializer->value_type == create_type(TYPE_I32));
+
+    // An unchecked tree lowers without types
+    ASTNode *unchecked = create_literal("3");
+    assert(flat_type(flat, flat_ast_add_tree(flat, unchecked)) == NULL);
+
+    free_ast(unchecked);
+    free_ast(rebuilt);
+    destroy_flat_ast(flat);
+    destroy_symbol_table(global);
+    free_ast(decl);
+    printf("✓ Flat types test passed\n");
+}
+
+// fn name(a: type): type { return a; }
+static ASTNode *identity(const char *name, char *type)
+{
+    ASTNode **params = malloc(sizeof(ASTNode *));
+    params[0] = create_var_decl(0, "a", type, NULL);
+    ASTNode **body = malloc(sizeof(ASTNode *));
+    body[0] = create_return_stmt(create_identifier("a"));
+    return create_func_def(name, params, 1, type, create_block(body, 1), 0);
+}
+
+// A hash-consed identifier shared by bodies of different types keeps no type,
+// even when the bodies are checked on different threads
+void test_shared_nodes(void)
+{
+    ExprTable *table = create_expr_table();
+    ASTNode *decls[] = {hash_cons_ast(table, identity("f", "i32")), hash_cons_ast(table, identity("g", "f64"))};
+    ASTNode *shared = decls[0]->data.func_def.body->data.block.statements[0]->data.return_stmt.expr;
+    assert(shared->flags & AST_NODE_SHARED);
+    assert(shared == decls[1]->data.func_def.body->data.block.statements[0]->data.return_stmt.expr);
+
+    SemanticContext context;
+    semantic_context_init(&context, create_symbol_table(NULL));
+    assert(semantic_check_program(&context, decls, 2, 2) == 0);
+    assert(shared->value_type == NULL);
+    assert(decls[0]->value_type == create_type(TYPE_UNKNOWN));
+
+    FlatAST *flat = create_flat_ast();
+    FlatIndex root = flat_ast_add_tree(flat, decls[1]);
+    FlatIndex body = flat_node(flat, root)->b;
+    assert(flat_type(flat, body) == create_type(TYPE_UNKNOWN));
+    FlatIndex ret = flat_extra(flat, flat_node(flat, body)->a)[0];
+    assert(flat_type(flat, flat_node(flat, ret)->a) == NULL);
+
+    destroy_flat_ast(flat);
+    destroy_symbol_table(context.globals);
+    semantic_context_destroy(&context);
+    free_ast(decls[0]);
+    free_ast(decls[1]);
+    destroy_expr_table(table);
+    printf("✓ Shared nodes test passed\n");
+}
+
+// An out-of-range literal is rejected from the value the lexer parsed
+void test_literal_range(void)
+{
+    TokenArray tokens = tokenize("let small: i32 = 2147483647;\n"
+                                 "let big: i32 = 2147483648;\n"
+                                 "let huge: f64 = 1e999;\n");
+    ParsedProgram program = parse_program_parallel(&tokens, 1);
+    assert(program.error_count == 0 && program.decl_count == 3);
+    ASTNode *big = program.decls[1]->data.var_decl.initializer;
+    assert(big->data.literal.parsed.kind == LITERAL_INT && big->data.literal.parsed.as.integer > INT32_MAX);
+
+    SemanticContext context;
+    semantic_context_init(&context, create_symbol_table(NULL));
+    assert(semantic_check_program(&context, program.decls, program.decl_count, 1) == 2);
+    assert(context.diagnostics.items[0].decl == 1);
+    assert(strstr(context.diagnostics.items[0].message, "Literal 2147483648 out of range for i32"));
+    assert(context.diagnostics.items[1].decl == 2);
+
+    destroy_symbol_table(context.globals);
+    semantic_context_destroy(&context);
+    free_parsed_program(&program);
+    free_token_array(&tokens);
+    printf("✓ Literal range test passed\n");
+}
+
+// The comptime evaluator takes literal types from the checked tree
+void test_comptime_reuses_types(void)
+{
+    ASTNode *sum = create_binary_expr("+", create_literal("40"), create_literal("2"));
+    ASTNode *decl = create_var_decl(1, "n", "i32", sum);
+    SymbolTable *global = create_symbol_table(NULL);
+    semantic_visit(decl, global);
+
+    ComptimeValue *value = evaluate_comptime_expr(sum);
+    assert(value && value->value.i_val == 42);
+    assert(value->type == create_comptime_type(TYPE_I32));
+    free_comptime_value(value);
+    destroy_symbol_table(global);
+    free_ast(decl);
+    printf("✓ Comptime type reuse test passed\n");
+}
+
+int main()
+{
+    printf("Running semantic type tests...\n");
+
+    test_node_types();
+    test_deep_chain();
+    test_flat_types();
+    test_shared_nodes();
+    test_literal_range();
+    test_comptime_reuses_types();
+
+    printf("All semantic type tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "../../include/static_types.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THREADS 8
+
+// Every spelling of a type gives the same object
+void test_canonical_types(void)
+{
+    assert(create_type(TYPE_I32) == create_type(TYPE_I32));
+    assert(type_from_string("i32") == create_type(TYPE_I32));
+    assert(type_from_string("f64") == create_type(TYPE_F64));
+    assert(type_from_string(NULL) == create_type(TYPE_UNKNOWN));
+    assert(types_are_equal(type_from_string("bool"), create_type(TYPE_BOOL)));
+    assert(!types_are_equal(create_type(TYPE_I32), create_type(TYPE_I64)));
+    assert(strcmp(type_to_string(create_type(TYPE_STRING)), "string") == 0);
+    assert(strcmp(type_to_string(NULL), "unknown") == 0);
+
+    // Freeing a canonical type is harmless
+    free_type(create_type(TYPE_CHAR));
+    assert(create_type(TYPE_CHAR)->kind == TYPE_CHAR);
+    printf("✓ Canonical types test passed\n");
+}
+
+// Flags select a distinct canonical type without changing the plain one
+void test_flags(void)
+{
+    Type *i32 = create_type(TYPE_I32);
+    Type *constant = create_const_type(TYPE_I32);
+    Type *comptime = create_comptime_type(TYPE_I32);
+    assert(constant != i32 && comptime != i32 && constant != comptime);
+    assert(constant->is_const && !constant->is_comptime);
+    assert(type_with_flags(i32, false, true) == comptime);
+    assert(type_with_flags(comptime, false, false) == i32);
+    assert(type_get(TYPE_I32, true, true) == type_with_flags(constant, true, true));
+    assert(strcmp(type_to_string(type_get(TYPE_I32, true, true)), "comptime const i32") == 0);
+
+    // Literals are comptime, and so are operations on comptime operands
+    Type *literal = get_literal_type("42");
+    assert(literal == comptime && get_literal_type("1.5") == create_comptime_type(TYPE_F64));
+    assert(get_binary_op_type("+", literal, literal) == comptime);
+    assert(get_binary_op_type("+", literal, i32) == i32);
+    assert(get_binary_op_type("<", literal, literal) == create_comptime_type(TYPE_BOOL));
+    assert(get_unary_op_type("-", literal) == comptime);
+    assert(!i32->is_comptime);
+    printf("✓ Flags test passed\n");
+}
+
+// Array and struct types are hash-consed by their element type and name
+void test_derived_types(void)
+{
+    Type *ints = type_array_of(create_type(TYPE_I32));
+    assert(ints->kind == TYPE_ARRAY && ints->info.element == create_type(TYPE_I32));
+    assert(type_from_string("i32[]") == ints);
+    assert(strcmp(type_to_string(ints), "i32[]") == 0);
+    assert(type_from_string("i32[][]") == type_array_of(ints));
+    assert(type_array_of(create_type(TYPE_F64)) != ints);
+    assert(type_with_flags(type_with_flags(ints, true, false), false, false) == ints);
+
+    StructField *fields = malloc(sizeof(StructField));
+    fields[0].name = strdup("x");
+    fields[0].type = create_type(TYPE_I32);
+    Type *point = create_struct_type("Point", fields, 1);
+    free(fields);
+    assert(point->kind == TYPE_STRUCT && type_struct_named("Point") == point);
+    assert(type_from_string("struct Point") == point);
+    assert(strcmp(type_to_string(point), "struct Point") == 0);
+    assert(strcmp(type_to_string(type_with_flags(point, true, true)), "comptime const struct Point") == 0);
+    assert(type_with_flags(type_with_flags(point, true, true), false, false) == point);
+    assert(lookup_struct_field(point, "x")->type == create_type(TYPE_I32));
+
+    // A redefinition keeps the first definition's fields
+    fields = malloc(sizeof(StructField));
+    fields[0].name = strdup("y");
+    fields[0].type = create_type(TYPE_F64);
+    assert(create_struct_type("Point", fields, 1) == point);
+    free(fields);
+    assert(lookup_struct_field(point, "y") == NULL);
+
+    // Other names are opaque types, equal only to themselves
+    Type *handle = type_from_string("Handle");
+    assert(handle->kind == TYPE_UNKNOWN && handle != create_type(TYPE_UNKNOWN));
+    assert(type_from_string("Handle") == handle && type_from_string("Other") != handle);
+    assert(strcmp(type_to_string(handle), "Handle") == 0);
+
+    // Names of any length are spelled in full
+    char long_name[600];
+    memcpy(long_name, "struct ", 7);
+    memset(long_name + 7, 'L', 500);
+    strcpy(long_name + 507, "[]");
+    Type *longs = type_from_string(long_name);
+    assert(longs->kind == TYPE_ARRAY && longs->info.element->kind == TYPE_STRUCT);
+    assert(strcmp(type_to_string(longs), long_name) == 0);
+    printf("✓ Derived types test passed\n");
+}
+
+static int literal_fits(const char *text, BasicTypeKind kind)
+{
+    LiteralValue literal = parse_literal_text(text, strlen(text));
+    int fits = is_literal_compatible_with_type(&literal, create_type(kind));
+    if (literal.kind == LITERAL_STRING)
+        free((char *)literal.as.string.text);
+    return fits;
+}
+
+// Literals are checked against a type through the value the lexer parsed
+void test_literal_compatibility(void)
+{
+    assert(literal_fits("2147483647", TYPE_I32));
+    assert(!literal_fits("2147483648", TYPE_I32));
+    assert(literal_fits("2147483648", TYPE_I64));
+    assert(!literal_fits("99999999999999999999", TYPE_I64)); // Overflows int64
+    assert(!literal_fits("1.5", TYPE_I32));
+    assert(literal_fits("1.5", TYPE_F32) && literal_fits("3", TYPE_F64));
+    assert(!literal_fits("1e300", TYPE_F32) && literal_fits("1e300", TYPE_F64));
+    assert(literal_fits("true", TYPE_BOOL) && !literal_fits("1", TYPE_BOOL));
+    assert(literal_fits("\"text\"", TYPE_STRING) && !literal_fits("true", TYPE_STRING));
+    assert(!is_literal_compatible_with_type(NULL, create_type(TYPE_I32)));
+    printf("✓ Literal compatibility test passed\n");
+}
+
+static void *intern_types(void *arg)
+{
+    Type **out = arg;
+    char name[32];
+    for (int i = 0; i < 200; i++)
+    {
+        snprintf(name, sizeof(name), "struct S%d", i);
+        out[i] = type_array_of(type_from_string(name));
+    }
+    return NULL;
+}
+
+// Threads interning the same types concurrently get the same objects
+void test_concurrent_interning(void)
+{
+    static Type *results[THREADS][200];
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++)
+        pthread_create(&threads[t], NULL, intern_types, results[t]);
+    for (int t = 0; t < THREADS; t++)
+        pthread_join(threads[t], NULL);
+    for (int t = 1; t < THREADS; t++)
+        assert(memcmp(results[t], results[0], sizeof(results[0])) == 0);
+    assert(results[0][7] == type_from_string("struct S7[]"));
+    printf("✓ Concurrent interning test passed\n");
+}
+
+int main()
+{
+    printf("Running static type tests...\n");
+
+    test_canonical_types();
+    test_flags();
+    test_derived_types();
+    test_literal_compatibility();
+    test_concurrent_interning();
+
+    printf("All static type tests passed!\n");
+    return 0;
+}
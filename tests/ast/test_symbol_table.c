@@ -0,0 +1,144 @@
+#include "../../include/semantic.h"
+#include "../../include/symbol_table.h"
+#include "../test_utils.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MANY 20000
+
+// Inner bindings shadow outer ones until their scope is popped
+void test_shadowing(void)
+{
+    SymbolTable *table = create_symbol_table(NULL);
+    Atom x = intern_cstring("x");
+    Atom y = intern_cstring("y");
+    add_symbol_atom(table, x, create_type(TYPE_I32), NULL);
+    Symbol *outer = lookup_symbol_atom(table, x);
+    assert(outer && outer->type == create_type(TYPE_I32) && outer->depth == 0);
+    assert(lookup_symbol_local(table, x) == outer);
+
+    push_scope(table);
+    assert(lookup_symbol_atom(table, x) == outer);
+    assert(lookup_symbol_local(table, x) == NULL);
+    add_symbol_atom(table, x, create_type(TYPE_F64), NULL);
+    add_symbol_atom(table, y, create_type(TYPE_BOOL), NULL);
+    Symbol *inner = lookup_symbol_atom(table, x);
+    assert(inner != outer && inner->type == create_type(TYPE_F64));
+    assert(inner->shadowed == outer && inner->depth == 1);
+    assert(lookup_symbol_local(table, x) == inner);
+    assert(lookup_symbol(table, "y") != NULL);
+
+    push_scope(table);
+    push_scope(table);
+    assert(lookup_symbol_atom(table, x) == inner && lookup_symbol_local(table, x) == NULL);
+    pop_scope(table);
+    pop_scope(table);
+
+    pop_scope(table);
+    assert(lookup_symbol_atom(table, x) == outer);
+    assert(lookup_symbol_atom(table, y) == NULL);
+    assert(table->count == 1 && table->depth == 0);
+
+    // The outermost scope stays
+    pop_scope(table);
+    assert(lookup_symbol_atom(table, x) == outer);
+    destroy_symbol_table(table);
+    printf("✓ Shadowing test passed\n");
+}
+
+// Popped symbols are reused and lookups keep working as the table grows
+void test_growth_and_reuse(void)
+{
+    SymbolTable *table = create_symbol_table(NULL);
+    char name[32];
+    const void *blocks = NULL;
+    for (int round = 0; round < 3; round++)
+    {
+        push_scope(table);
+        for (int i = 0; i < MANY; i++)
+        {
+            snprintf(name, sizeof(name), "sym_%d", i);
+            add_symbol(table, name, i % 2 ? "i32" : "bool");
+        }
+        for (int i = 0; i < MANY; i += 997)
+        {
+            snprintf(name, sizeof(name), "sym_%d", i);
+            Symbol *sym = lookup_symbol(table, name);
+            assert(sym && strcmp(sym->name, name) == 0);
+            assert(lookup_symbol_local(table, sym->atom) == sym);
+        }
+        Symbol *first = table->symbols[0];
+        pop_scope(table);
+        assert(table->count == 0);
+        assert(lookup_symbol(table, "sym_0") == NULL);
+
+        // The last symbol popped is handed out first
+        push_scope(table);
+        add_symbol(table, "reused", "i32");
+        assert(lookup_symbol(table, "reused") == first);
+        pop_scope(table);
+
+        // Later rounds allocate no new symbol storage
+        if (round == 0)
+            blocks = table->blocks;
+        assert((const void *)table->blocks == blocks);
+    }
+    destroy_symbol_table(table);
+    printf("✓ Growth and reuse test passed\n");
+}
+
+// Tables still chain to a parent table
+void test_parent_chain(void)
+{
+    SymbolTable *globals = create_symbol_table(NULL);
+    SymbolTable *locals = create_symbol_table(globals);
+    add_symbol(globals, "g", "i32");
+    add_symbol(locals, "l", "f64");
+    assert(lookup_symbol(locals, "g") == lookup_symbol(globals, "g"));
+    assert(lookup_symbol(globals, "l") == NULL);
+    assert(lookup_symbol_local(locals, intern_cstring("g")) == NULL);
+    destroy_symbol_table(locals);
+    destroy_symbol_table(globals);
+    printf("✓ Parent chain test passed\n");
+}
+
+// A large scope and nested shadowing pass semantic analysis
+void test_semantic_scopes(void)
+{
+    ASTNode **statements = malloc((MANY + 1) * sizeof(ASTNode *));
+    char name[32];
+    for (int i = 0; i < MANY; i++)
+    {
+        snprintf(name, sizeof(name), "v_%d", i);
+        statements[i] = create_var_decl(0, name, "i32", create_literal("1"));
+    }
+    // fn f(v_0: i32): i32 { let v_1: i32 = v_0; }
+    ASTNode **params = malloc(sizeof(ASTNode *));
+    params[0] = create_var_decl(0, "v_0", "i32", NULL);
+    ASTNode **body = malloc(sizeof(ASTNode *));
+    body[0] = create_var_decl(0, "v_1", "i32", create_identifier("v_0"));
+    statements[MANY] = create_func_def("f", params, 1, "i32", create_block(body, 1), 0);
+    ASTNode *program = create_block(statements, MANY + 1);
+
+    SymbolTable *global = create_symbol_table(NULL);
+    semantic_visit(program, global);
+    // The block's scope was popped again
+    assert(global->depth == 0 && global->count == 0);
+    destroy_symbol_table(global);
+    free_ast(program);
+    printf("✓ Semantic scopes test passed\n");
+}
+
+int main()
+{
+    printf("Running symbol table tests...\n");
+
+    test_shadowing();
+    test_growth_and_reuse();
+    test_parent_chain();
+    test_semantic_scopes();
+
+    printf("All symbol table tests passed!\n");
+    return 0;
+}
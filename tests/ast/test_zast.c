@@ -0,0 +1,224 @@
+#include "../../include/zast.h"
+#include "../../include/intern.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char source_path[64];
+static char cache_path[64];
+
+static void write_file(const char *path, const char *text)
+{
+    FILE *file = fopen(path, "wb");
+    assert(file != NULL);
+    fputs(text, file);
+    fclose(file);
+}
+
+static const char *MODULE =
+    "let limit: i32 = 10 * (2 + 3);\n"
+    "fn add(a: i32, b: i32): i32 { let sum = a + b; let text = \"hi\\n\"; }\n"
+    "struct Point { x: i32, y: f64 }\n"
+    "comptime fn twice(n): i32 { let r = n * 2.5; }\n"
+    "let flag = !true;\n";
+
+// Rewrite the first copy of node in a cache file with its a field replaced.
+static void patch_node(const char *path, const FlatNode *node, uint32_t a)
+{
+    FILE *file = fopen(path, "r+b");
+    assert(file != NULL);
+    static char data[1 << 16];
+    size_t size = fread(data, 1, sizeof(data), file);
+    char *found = NULL;
+    for (size_t offset = 0; !found && offset + sizeof(FlatNode) <= size; offset += 8)
+        if (memcmp(data + offset, node, sizeof(FlatNode)) == 0)
+            found = data + offset;
+    assert(found != NULL);
+    FlatNode patched = *node;
+    patched.a = a;
+    fseek(file, (long)(found - data), SEEK_SET);
+    fwrite(&patched, sizeof(FlatNode), 1, file);
+    fclose(file);
+}
+
+// Same nodes, literals and names, whichever way the names are stored
+static void assert_same_ast(const FlatAST *a, const FlatAST *b)
+{
+    assert(a->node_count == b->node_count);
+    assert(a->extra_count == b->extra_count);
+    assert(a->literal_count == b->literal_count);
+    for (uint32_t k = 1; k < a->node_count; k++)
+    {
+        const FlatNode *x = flat_node(a, k);
+        const FlatNode *y = flat_node(b, k);
+        assert(x->tag == y->tag && x->op == y->op && x->flags == y->flags);
+        switch (x->tag)
+        {
+        case AST_VAR_DECL:
+            assert(flat_atom(a, x->a) == flat_atom(b, y->a));
+            assert(flat_atom(a, x->c) == flat_atom(b, y->c));
+            assert(x->b == y->b);
+            break;
+        case AST_IDENTIFIER:
+            assert(flat_atom(a, x->a) == flat_atom(b, y->a));
+            break;
+        case AST_FUNC_DEF:
+            assert(flat_atom(a, x->a) == flat_atom(b, y->a));
+            assert(flat_atom(a, a->extra[x->c]) == flat_atom(b, b->extra[y->c]));
+            assert(x->b == y->b);
+            break;
+        case AST_STRUCT_DEF:
+            assert(flat_atom(a, x->a) == flat_atom(b, y->a) && x->c == y->c);
+            for (uint32_t i = 0; i < 2 * x->c; i++)
+                assert(flat_atom(a, a->extra[x->b + i]) == flat_atom(b, b->extra[y->b + i]));
+            break;
+        case AST_LITERAL:
+        {
+            const FlatLiteral *p = flat_literal(a, k);
+            const FlatLiteral *q = flat_literal(b, k);
+            assert(strcmp(flat_literal_text(a, p), flat_literal_text(b, q)) == 0);
+            LiteralValue u = flat_literal_value(a, p);
+            LiteralValue v = flat_literal_value(b, q);
+            assert(u.kind == v.kind);
+            if (u.kind == LITERAL_STRING)
+                assert(strcmp(u.as.string.text, v.as.string.text) == 0);
+            break;
+        }
+        default:
+            assert(x->a == y->a && x->b == y->b && x->c == y->c);
+            break;
+        }
+    }
+}
+
+// A cold load parses and writes the cache; a warm load maps it
+void test_cold_and_warm(void)
+{
+    write_file(source_path, MODULE);
+    unlink(cache_path);
+
+    ZastFile *cold = zast_load_source(source_path, cache_path, 4);
+    assert(cold && !zast_from_cache(cold));
+    assert(access(cache_path, R_OK) == 0);
+    const FlatAST *ast = zast_ast(cold);
+    const FlatNode *root = flat_node(ast, zast_root(cold));
+    assert(root->tag == AST_BLOCK && root->b == 5);
+
+    ZastFile *warm = zast_load_source(source_path, cache_path, 4);
+    assert(warm && zast_from_cache(warm));
+    assert(zast_root(warm) == zast_root(cold));
+    assert_same_ast(ast, zast_ast(warm));
+
+    // Declarations convert back to pointer trees
+    const FlatAST *mapped = zast_ast(warm);
+    const uint32_t *decls = flat_extra(mapped, flat_node(mapped, zast_root(warm))->a);
+    ASTNode *func = flat_ast_to_tree(mapped, decls[1]);
+    assert(func->type == AST_FUNC_DEF);
+    assert(strcmp(func->data.func_def.name, "add") == 0);
+    assert(strcmp(func->data.func_def.return_type, "i32") == 0);
+    assert(func->data.func_def.param_count == 2);
+    assert(func->data.func_def.body->data.block.stmt_count == 2);
+    free_ast(func);
+
+    zast_close(warm);
+    zast_close(cold);
+    printf("✓ Cold and warm load test passed\n");
+}
+
+// Editing the source invalidates the cache
+void test_stale_cache(void)
+{
+    write_file(source_path, MODULE);
+    unlink(cache_path);
+    zast_close(zast_load_source(source_path, cache_path, 2));
+
+    write_file(source_path, "let only = 1;\n");
+    ZastFile *file = zast_load_source(source_path, cache_path, 2);
+    assert(file && !zast_from_cache(file));
+    assert(flat_node(zast_ast(file), zast_root(file))->b == 1);
+    zast_close(file);
+
+    // The rewritten cache matches the new source
+    file = zast_load_source(source_path, cache_path, 2);
+    assert(file && zast_from_cache(file));
+    const FlatAST *ast = zast_ast(file);
+    const uint32_t *decls = flat_extra(ast, flat_node(ast, zast_root(file))->a);
+    assert(flat_atom(ast, flat_node(ast, decls[0])->a) == intern_cstring("only"));
+    zast_close(file);
+    printf("✓ Stale cache test passed\n");
+}
+
+// Damaged or foreign files are rejected, not trusted
+void test_rejects_bad_files(void)
+{
+    write_file(source_path, MODULE);
+    unlink(cache_path);
+    zast_close(zast_load_source(source_path, cache_path, 1));
+
+    FILE *file = fopen(source_path, "rb");
+    char source[1024];
+    size_t length = fread(source, 1, sizeof(source), file);
+    fclose(file);
+    uint64_t hash = zast_hash_source(source, length);
+
+    ZastFile *cache = zast_open(cache_path, hash, length);
+    assert(cache != NULL);
+    zast_close(cache);
+    assert(zast_open(cache_path, hash + 1, length) == NULL);
+    assert(zast_open(cache_path, hash, length + 1) == NULL);
+
+    // Wrong magic
+    file = fopen(cache_path, "r+b");
+    fputc('X', file);
+    fclose(file);
+    assert(zast_open(cache_path, hash, length) == NULL);
+
+    // An intact header over a node whose operand is out of range, and over a
+    // node that is its own child
+    zast_close(zast_load_source(source_path, cache_path, 1));
+    cache = zast_open(cache_path, hash, length);
+    const FlatAST *ast = zast_ast(cache);
+    FlatNode first = *flat_node(ast, 1);
+    FlatIndex binary = 1;
+    while (flat_node(ast, binary)->tag != AST_BINARY_EXPR)
+        binary++;
+    FlatNode operator_node = *flat_node(ast, binary);
+    zast_close(cache);
+    assert(first.tag != AST_BREAK_STMT && first.tag != AST_CONTINUE_STMT);
+    patch_node(cache_path, &first, 0x7fffffff);
+    assert(zast_open(cache_path, hash, length) == NULL);
+    zast_close(zast_load_source(source_path, cache_path, 1));
+    patch_node(cache_path, &operator_node, binary);
+    assert(zast_open(cache_path, hash, length) == NULL);
+
+    // Truncated
+    zast_close(zast_load_source(source_path, cache_path, 1));
+    assert(truncate(cache_path, 40) == 0);
+    assert(zast_open(cache_path, hash, length) == NULL);
+
+    // Missing, and a syntax error leaves no AST
+    unlink(cache_path);
+    assert(zast_open(cache_path, hash, length) == NULL);
+    write_file(source_path, "let broken = ;\n");
+    assert(zast_load_source(source_path, cache_path, 1) == NULL);
+    assert(access(cache_path, F_OK) != 0);
+    printf("✓ Bad cache file test passed\n");
+}
+
+int main()
+{
+    printf("Running binary AST cache tests...\n");
+    snprintf(source_path, sizeof(source_path), "/tmp/test_zast_%d.zx", (int)getpid());
+    snprintf(cache_path, sizeof(cache_path), "/tmp/test_zast_%d.zast", (int)getpid());
+
+    test_cold_and_warm();
+    test_stale_cache();
+    test_rejects_bad_files();
+
+    unlink(source_path);
+    unlink(cache_path);
+    printf("All binary AST cache tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "../../../include/lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SOURCE_BYTES (32u << 20)
+#define RUNS 3
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Generate a large source resembling generated code
+static char *generate_source(size_t *length)
+{
+    const char *lines[] = {
+        "let value_%d: i32 = (x + %d) * 2 - y ** 3\n",
+        "fn compute_%d(a: i32, b: f64): f64 { let r = a * b + %d.5e-3; }\n",
+        "print(f\"item {value_%d} of {total + %d}\")\n",
+        "let message_%d = \"a plain string literal %d\"\n",
+        "// generated comment %d %d\n",
+    };
+    char *source = malloc(SOURCE_BYTES + 256);
+    size_t used = 0;
+    for (int i = 0; used < SOURCE_BYTES; i++)
+        used += sprintf(source + used, lines[i % 5], i, i);
+    *length = used;
+    return source;
+}
+
+int main()
+{
+    size_t length;
+    char *source = generate_source(&length);
+    printf("Parallel lexer benchmark: %.1f MiB of source\n", length / (1024.0 * 1024.0));
+    printf("%8s %12s %12s %10s %10s\n", "threads", "time (ms)", "MiB/s", "speedup", "tokens");
+
+    double baseline = 0;
+    for (int threads = 1; threads <= 16; threads *= 2)
+    {
+        double best = 1e30;
+        int count = 0;
+        for (int run = 0; run < RUNS; run++)
+        {
+            double start = now_seconds();
+            TokenArray tokens = tokenize_parallel(source, length, threads);
+            double elapsed = now_seconds() - start;
+            count = tokens.count;
+            free_token_array(&tokens);
+            if (elapsed < best)
+                best = elapsed;
+        }
+        if (threads == 1)
+            baseline = best;
+        printf("%8d %12.2f %12.1f %9.2fx %10d\n", threads, best * 1000,
+               length / (1024.0 * 1024.0) / best, baseline / best, count);
+    }
+
+    free(source);
+    return 0;
+}
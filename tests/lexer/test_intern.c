@@ -0,0 +1,141 @@
+#include "../../include/intern.h"
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include "../../include/symbol_table.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+// Equal strings share one atom and one copy of their text
+void test_intern_basics(void)
+{
+    Atom a = intern_cstring("counter");
+    Atom b = intern_string("counter_value", 7);
+    assert(a != ATOM_NONE);
+    assert(a == b);
+    assert(strcmp(atom_text(a), "counter") == 0);
+    assert(atom_length(a) == 7);
+    assert(atom_text(a) == atom_text(b));
+
+    assert(intern_cstring("counters") != a);
+    assert(intern_string("", 0) == ATOM_NONE);
+    assert(strcmp(atom_text(ATOM_NONE), "") == 0);
+
+    assert(intern_find("never_interned_name", 19) == ATOM_NONE);
+    assert(intern_find("counter", 7) == a);
+
+    printf("✓ Intern basics test passed\n");
+}
+
+// Identifier tokens carry atoms and share the interned text
+void test_lexer_atoms(void)
+{
+    const char *source = "let total = total + other;";
+    TokenArray tokens = tokenize(source);
+
+    assert(tokens.tokens[1].type == TOKEN_IDENTIFIER);
+    assert(tokens.tokens[1].atom == intern_cstring("total"));
+    assert(tokens.tokens[1].atom == tokens.tokens[3].atom);
+    assert(tokens.tokens[1].value == tokens.tokens[3].value);
+    assert(tokens.tokens[5].atom != tokens.tokens[1].atom);
+    assert(tokens.tokens[0].atom == ATOM_NONE); // Keywords are not interned
+    free_token_array(&tokens);
+
+    // Zero-copy tokens intern too
+    TokenArray spans = tokenize_source(source, strlen(source));
+    assert(spans.tokens[1].value == NULL);
+    assert(spans.tokens[1].atom == intern_cstring("total"));
+    free_token_array(&spans);
+
+    printf("✓ Lexer atoms test passed\n");
+}
+
+// AST names and symbols resolve through the same atoms
+void test_ast_and_symbols(void)
+{
+    const char *source = "let width: i32 = width2;";
+    TokenArray tokens = tokenize(source);
+    Parser *parser = create_parser(tokens);
+    ASTNode *decl = parse_var_declaration(parser);
+    assert(decl && decl->type == AST_VAR_DECL);
+    assert(decl->data.var_decl.atom == intern_cstring("width"));
+    assert(decl->data.var_decl.identifier == atom_text(decl->data.var_decl.atom));
+    ASTNode *init = decl->data.var_decl.initializer;
+    assert(init->type == AST_IDENTIFIER);
+    assert(init->data.identifier.atom == tokens.tokens[5].atom);
+
+    SymbolTable *globals = create_symbol_table(NULL);
+    SymbolTable *scope = create_symbol_table(globals);
+    add_symbol(globals, "width", "i32");
+    Symbol *symbol = lookup_symbol_atom(scope, decl->data.var_decl.atom);
+    assert(symbol && symbol->type == type_from_string("i32"));
+    assert(lookup_symbol(scope, "width") == symbol);
+    assert(lookup_symbol_atom(scope, init->data.identifier.atom) == NULL);
+    assert(lookup_symbol(scope, "not_a_symbol_anywhere") == NULL);
+    destroy_symbol_table(scope);
+    destroy_symbol_table(globals);
+
+    free_ast(decl);
+    destroy_parser(parser);
+    free_token_array(&tokens);
+    printf("✓ AST and symbol atoms test passed\n");
+}
+
+#define THREADS 4
+#define NAMES 2000
+
+static Atom thread_atoms[THREADS][NAMES];
+
+static void *intern_names(void *arg)
+{
+    int t = *(int *)arg;
+    char name[32];
+    for (int i = 0; i < NAMES; i++)
+    {
+        // Every thread interns the same names starting at a different offset
+        int k = (i + t * (NAMES / THREADS)) % NAMES;
+        snprintf(name, sizeof(name), "thread_name_%d", k);
+        thread_atoms[t][k] = intern_cstring(name);
+    }
+    return NULL;
+}
+
+// Concurrent interning agrees on every atom
+void test_concurrent_interning(void)
+{
+    pthread_t threads[THREADS];
+    int ids[THREADS];
+    for (int t = 0; t < THREADS; t++)
+    {
+        ids[t] = t;
+        pthread_create(&threads[t], NULL, intern_names, &ids[t]);
+    }
+    for (int t = 0; t < THREADS; t++)
+        pthread_join(threads[t], NULL);
+
+    char name[32];
+    for (int k = 0; k < NAMES; k++)
+    {
+        snprintf(name, sizeof(name), "thread_name_%d", k);
+        for (int t = 0; t < THREADS; t++)
+            assert(thread_atoms[t][k] == thread_atoms[0][k]);
+        assert(strcmp(atom_text(thread_atoms[0][k]), name) == 0);
+    }
+    assert(intern_count() >= NAMES);
+
+    printf("✓ Concurrent interning test passed\n");
+}
+
+int main()
+{
+    printf("Running string interner tests...\n");
+
+    test_intern_basics();
+    test_lexer_atoms();
+    test_ast_and_symbols();
+    test_concurrent_interning();
+
+    printf("All string interner tests passed!\n");
+    return 0;
+}
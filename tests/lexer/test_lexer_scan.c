@@ -0,0 +1,146 @@
+#include "../../include/lexer.h"
+#include "../../include/lexer_scan.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFFER_SIZE 200
+
+// Fill buf with a run of `fill` characters followed by `stop` at position run_len.
+static void make_run(char *buf, size_t run_len, char fill, char stop)
+{
+    memset(buf, fill, BUFFER_SIZE);
+    buf[run_len] = stop;
+}
+
+// Run every kernel at every level on buf[offset..length) and check the
+// results agree with the scalar kernels.
+static void check_all_levels(const char *buf, size_t offset, size_t length)
+{
+    lexer_scan_set_level(SCAN_SCALAR);
+    size_t ws = scan_whitespace(buf, offset, length);
+    size_t id = scan_identifier(buf, offset, length);
+    size_t dg = scan_digits(buf, offset, length);
+    size_t st = scan_string_body(buf, offset, length, 0);
+    size_t fs = scan_string_body(buf, offset, length, 1);
+
+    for (int level = SCAN_SSE2; level <= SCAN_AVX2; level++)
+    {
+        if (lexer_scan_set_level((ScanLevel)level) != (ScanLevel)level)
+            continue; // Not supported on this CPU.
+        assert(scan_whitespace(buf, offset, length) == ws);
+        assert(scan_identifier(buf, offset, length) == id);
+        assert(scan_digits(buf, offset, length) == dg);
+        assert(scan_string_body(buf, offset, length, 0) == st);
+        assert(scan_string_body(buf, offset, length, 1) == fs);
+    }
+}
+
+// Test that runs stop at every class boundary, at every alignment
+void test_run_boundaries(void)
+{
+    const char fills[] = {' ', '\t', 'a', 'Z', '_', '7', 'x'};
+    const char stops[] = {'\0', '\n', '"', '\\', '{', '}', '(', '@', '[', '`', '/', ':', (char)0x80, (char)0xFF, '\x7f'};
+    char buf[BUFFER_SIZE];
+
+    for (size_t f = 0; f < sizeof(fills); f++)
+    {
+        for (size_t s = 0; s < sizeof(stops); s++)
+        {
+            for (size_t run = 0; run < 80; run++)
+            {
+                make_run(buf, run, fills[f], stops[s]);
+                for (size_t offset = 0; offset < 5 && offset <= run; offset++)
+                {
+                    check_all_levels(buf, offset, BUFFER_SIZE);
+                    check_all_levels(buf, offset, run + 1);
+                    check_all_levels(buf, offset, run);
+                }
+            }
+        }
+    }
+
+    // Every byte value as the stop character after a long run.
+    for (int c = 0; c < 256; c++)
+    {
+        make_run(buf, 40, 'q', (char)c);
+        check_all_levels(buf, 3, BUFFER_SIZE);
+        make_run(buf, 40, ' ', (char)c);
+        check_all_levels(buf, 3, BUFFER_SIZE);
+        make_run(buf, 40, '5', (char)c);
+        check_all_levels(buf, 3, BUFFER_SIZE);
+    }
+
+    lexer_scan_set_level(SCAN_AVX2);
+    printf("✓ Scan kernel boundary test passed\n");
+}
+
+// Test that random text classifies the same at every level
+void test_random_text(void)
+{
+    char buf[BUFFER_SIZE];
+    srand(12345);
+    for (int round = 0; round < 2000; round++)
+    {
+        for (size_t i = 0; i < BUFFER_SIZE; i++)
+        {
+            // Bias towards long runs of the interesting classes.
+            int r = rand() % 100;
+            buf[i] = r < 30 ? 'a' + rand() % 26 : r < 50 ? ' ' : r < 65 ? '0' + rand() % 10 : r < 70 ? '_' : (char)(rand() % 256);
+        }
+        check_all_levels(buf, (size_t)(rand() % 64), BUFFER_SIZE);
+    }
+
+    lexer_scan_set_level(SCAN_AVX2);
+    printf("✓ Scan kernel random text test passed\n");
+}
+
+// Test that tokenizing gives identical tokens at every level
+void test_tokenize_all_levels(void)
+{
+    const char *source =
+        "let a_really_long_identifier_name_that_spans_many_vector_widths: i32 = 1234567890123456789012345678901234567\n"
+        "        \t\t    let y = 3.14159265358979e-10 // a comment that is long enough to cross blocks\n"
+        "print(\"a plain string literal that is more than thirty two bytes long\\n with escapes \\\" inside\")\n"
+        "print(f\"an f-string with a long plain prefix before {a_really_long_identifier_name_that_spans_many_vector_widths + 1} and after\")\n";
+
+    lexer_scan_set_level(SCAN_SCALAR);
+    TokenArray expected = tokenize(source);
+
+    for (int level = SCAN_SSE2; level <= SCAN_AVX2; level++)
+    {
+        if (lexer_scan_set_level((ScanLevel)level) != (ScanLevel)level)
+            continue;
+        TokenArray tokens = tokenize(source);
+        assert(tokens.count == expected.count);
+        for (int i = 0; i < tokens.count; i++)
+        {
+            assert(tokens.tokens[i].type == expected.tokens[i].type);
+            assert(tokens.tokens[i].subkind == expected.tokens[i].subkind);
+            assert(tokens.tokens[i].offset == expected.tokens[i].offset);
+            assert(tokens.tokens[i].length == expected.tokens[i].length);
+            assert(tokens.tokens[i].line == expected.tokens[i].line);
+            assert(tokens.tokens[i].column == expected.tokens[i].column);
+            assert(strcmp(tokens.tokens[i].value, expected.tokens[i].value) == 0);
+        }
+        free_token_array(&tokens);
+    }
+
+    free_token_array(&expected);
+    lexer_scan_set_level(SCAN_AVX2);
+    printf("✓ Tokenize at every scan level test passed\n");
+}
+
+int main()
+{
+    printf("Running lexer scan tests...\n");
+    printf("Best scan level: %d\n", lexer_scan_level());
+
+    test_run_boundaries();
+    test_random_text();
+    test_tokenize_all_levels();
+
+    printf("All lexer scan tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Check two tokens are the same span at the same position
+static void assert_same_token(const Token *a, const Token *b)
+{
+    assert(a->type == b->type);
+    assert(a->subkind == b->subkind);
+    assert(a->offset == b->offset);
+    assert(a->length == b->length);
+    assert(a->line == b->line);
+    assert(a->column == b->column);
+}
+
+// Test that pulling tokens one at a time matches batch tokenizing
+void test_stream_matches_batch(void)
+{
+    const char *source = "let x: i32 = 42 // comment\n"
+                         "fn add(a: i32, b: i32): i32 { return a + b; }\n"
+                         "print(f\"sum: {add(x, 2)} and {x ** 2}!\")\n"
+                         "let s = \"plain \\\"quoted\\\"\"";
+    size_t length = strlen(source);
+    TokenArray expected = tokenize_source(source, length);
+
+    Lexer *lexer = create_lexer(source, length);
+    for (int i = 0; i < expected.count; i++)
+    {
+        Token token = lexer_next_token(lexer);
+        assert_same_token(&token, &expected.tokens[i]);
+        assert(memcmp(lexer_token_text(lexer, &token), token_text(&expected, &expected.tokens[i]),
+                      (size_t)token.length) == 0);
+    }
+
+    // EOF is sticky.
+    assert(lexer_next_token(lexer).type == TOKEN_EOF);
+    assert(lexer_peek_token(lexer, 3).type == TOKEN_EOF);
+
+    destroy_lexer(lexer);
+    free_token_array(&expected);
+    printf("✓ Stream matches batch test passed\n");
+}
+
+// Test peeking ahead does not consume tokens
+void test_peek_lookahead(void)
+{
+    const char *source = "a b c d e f g h i j";
+    Lexer *lexer = create_lexer(source, strlen(source));
+
+    for (int k = 0; k < LEXER_LOOKAHEAD; k++)
+    {
+        Token token = lexer_peek_token(lexer, k);
+        assert(token.type == TOKEN_IDENTIFIER);
+        assert(lexer_token_text(lexer, &token)[0] == 'a' + k);
+    }
+    Token first = lexer_next_token(lexer);
+    assert(lexer_token_text(lexer, &first)[0] == 'a');
+    Token next = lexer_peek_token(lexer, LEXER_LOOKAHEAD - 1);
+    assert(lexer_token_text(lexer, &next)[0] == 'i');
+
+    destroy_lexer(lexer);
+    printf("✓ Peek lookahead test passed\n");
+}
+
+// Test that lexing a large input keeps token memory bounded
+void test_bounded_memory(void)
+{
+    const char *line = "let value = (x + 1) * 2 - f\"{y}\"\n";
+    size_t line_length = strlen(line);
+    int lines = 20000;
+    char *source = malloc(line_length * lines + 1);
+    for (int i = 0; i < lines; i++)
+        memcpy(source + i * line_length, line, line_length);
+    source[line_length * lines] = '\0';
+
+    Lexer *lexer = create_lexer(source, line_length * lines);
+    int count = 0;
+    while (lexer_next_token(lexer).type != TOKEN_EOF)
+    {
+        assert(lexer->ring_count <= LEXER_LOOKAHEAD);
+        count++;
+    }
+    assert(count == lines * 12);
+    // Only a single lexeme's tokens are ever held outside the ring.
+    assert(lexer->pending.capacity <= 16);
+
+    destroy_lexer(lexer);
+    free(source);
+    printf("✓ Bounded memory test passed\n");
+}
+
+// Test that the parser can consume the stream directly
+void test_stream_parser(void)
+{
+    const char *source = "fn scale(v: i32, k: i32): i32 { let r = v * k + 1; let s = r ** 2; }";
+
+    Lexer *lexer = create_lexer(source, strlen(source));
+    Parser *parser = create_stream_parser(lexer);
+    ASTNode *node = parse_function_declaration(parser);
+    assert(!parser->had_error);
+    assert(node != NULL);
+    assert(node->type == AST_FUNC_DEF);
+    assert(strcmp(node->data.func_def.name, "scale") == 0);
+    assert(node->data.func_def.param_count == 2);
+    assert(strcmp(node->data.func_def.return_type, "i32") == 0);
+    assert(node->data.func_def.body->data.block.stmt_count == 2);
+
+    free_ast(node);
+    destroy_parser(parser);
+    destroy_lexer(lexer);
+    printf("✓ Stream parser test passed\n");
+}
+
+int main()
+{
+    printf("Running streaming lexer tests...\n");
+
+    test_stream_matches_batch();
+    test_peek_lookahead();
+    test_bounded_memory();
+    test_stream_parser();
+
+    printf("All streaming lexer tests passed!\n");
+    return 0;
+}
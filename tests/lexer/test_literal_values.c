@@ -0,0 +1,136 @@
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include "../../include/ast.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Test that numeric tokens carry their parsed values
+void test_numeric_tokens(void)
+{
+    TokenArray tokens = tokenize("42 0 9223372036854775807 9223372036854775808 3.5 1e3 .25 2.5e-2");
+
+    assert(tokens.tokens[0].literal.kind == LITERAL_INT);
+    assert(tokens.tokens[0].literal.as.integer == 42);
+    assert(tokens.tokens[1].literal.as.integer == 0);
+    assert(tokens.tokens[2].literal.as.integer == INT64_MAX);
+    assert(!tokens.tokens[2].literal.overflow);
+    // Overflow is detected at lex time and the value saturates.
+    assert(tokens.tokens[3].literal.overflow);
+    assert(tokens.tokens[3].literal.as.integer == INT64_MAX);
+
+    assert(tokens.tokens[4].literal.kind == LITERAL_FLOAT);
+    assert(tokens.tokens[4].literal.as.real == 3.5);
+    assert(tokens.tokens[5].literal.as.real == 1000.0);
+    assert(tokens.tokens[6].literal.as.real == 0.25);
+    assert(tokens.tokens[7].literal.as.real == 2.5e-2);
+
+    free_token_array(&tokens);
+    printf("✓ Numeric literal tokens test passed\n");
+}
+
+// Test bool and string tokens, and that other tokens carry no value
+void test_bool_and_string_tokens(void)
+{
+    const char *source = "true false \"plain\" \"tab\\there\" x let";
+    TokenArray tokens = tokenize_source(source, strlen(source));
+
+    assert(tokens.tokens[0].literal.kind == LITERAL_BOOL && tokens.tokens[0].literal.as.boolean == 1);
+    assert(tokens.tokens[1].literal.kind == LITERAL_BOOL && tokens.tokens[1].literal.as.boolean == 0);
+
+    assert(tokens.tokens[2].literal.kind == LITERAL_STRING);
+    assert(!tokens.tokens[2].literal.as.string.has_escapes);
+    assert(tokens.tokens[2].literal.as.string.length == 5);
+    assert(tokens.tokens[3].literal.as.string.has_escapes);
+    assert(tokens.tokens[3].literal.as.string.length == 8); // "tab\there" unescaped
+
+    assert(tokens.tokens[4].literal.kind == LITERAL_NONE);
+    assert(tokens.tokens[5].literal.kind == LITERAL_NONE);
+
+    free_token_array(&tokens);
+    printf("✓ Bool and string literal tokens test passed\n");
+}
+
+// Test classifying literal source text
+void test_parse_literal_text(void)
+{
+    LiteralValue value = parse_literal_text("-17", 3);
+    assert(value.kind == LITERAL_INT && value.as.integer == -17);
+    value = parse_literal_text("-9223372036854775808", 20);
+    assert(value.kind == LITERAL_INT && !value.overflow && value.as.integer == INT64_MIN);
+    value = parse_literal_text("6.02e23", 7);
+    assert(value.kind == LITERAL_FLOAT && value.as.real == 6.02e23);
+    value = parse_literal_text("1e999", 5);
+    assert(value.kind == LITERAL_FLOAT && value.overflow);
+    value = parse_literal_text("false", 5);
+    assert(value.kind == LITERAL_BOOL && value.as.boolean == 0);
+    value = parse_literal_text("12abc", 5);
+    assert(value.kind == LITERAL_NONE);
+    value = parse_literal_text("name", 4);
+    assert(value.kind == LITERAL_NONE);
+
+    value = parse_literal_text("\"a\\\"b\\n\"", 8);
+    assert(value.kind == LITERAL_STRING);
+    assert(value.as.string.length == 4);
+    assert(memcmp(value.as.string.text, "a\"b\n", 4) == 0);
+    free((char *)value.as.string.text);
+    printf("✓ Literal text parsing test passed\n");
+}
+
+// Test that AST literal nodes carry the lexer's values
+void test_ast_literals(void)
+{
+    const char *source = "let s = \"hi\\tthere\"; let n = 7; let f = 0.5; let b = true;";
+    TokenArray tokens = tokenize(source);
+    Parser *parser = create_parser(tokens);
+
+    ASTNode *decl = parse_var_declaration(parser);
+    LiteralValue *value = &decl->data.var_decl.initializer->data.literal.parsed;
+    assert(value->kind == LITERAL_STRING);
+    assert(strcmp(value->as.string.text, "hi\tthere") == 0);
+    free_ast(decl);
+
+    decl = parse_var_declaration(parser);
+    value = &decl->data.var_decl.initializer->data.literal.parsed;
+    assert(value->kind == LITERAL_INT && value->as.integer == 7);
+    free_ast(decl);
+
+    decl = parse_var_declaration(parser);
+    value = &decl->data.var_decl.initializer->data.literal.parsed;
+    assert(value->kind == LITERAL_FLOAT && value->as.real == 0.5);
+    free_ast(decl);
+
+    decl = parse_var_declaration(parser);
+    value = &decl->data.var_decl.initializer->data.literal.parsed;
+    assert(value->kind == LITERAL_BOOL && value->as.boolean == 1);
+    free_ast(decl);
+
+    destroy_parser(parser);
+    free_token_array(&tokens);
+
+    // Literals built directly from source text are parsed the same way.
+    ASTNode *node = create_literal("\"quoted\"");
+    assert(node->data.literal.parsed.kind == LITERAL_STRING);
+    assert(strcmp(node->data.literal.parsed.as.string.text, "quoted") == 0);
+    free_ast(node);
+    node = create_literal("3000000000");
+    assert(node->data.literal.parsed.kind == LITERAL_INT);
+    assert(node->data.literal.parsed.as.integer == 3000000000LL);
+    free_ast(node);
+    printf("✓ AST literal values test passed\n");
+}
+
+int main()
+{
+    printf("Running literal value tests...\n");
+
+    test_numeric_tokens();
+    test_bool_and_string_tokens();
+    test_parse_literal_text();
+    test_ast_literals();
+
+    printf("All literal value tests passed!\n");
+    return 0;
+}
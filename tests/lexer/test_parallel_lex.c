@@ -0,0 +1,129 @@
+#include "../../include/lexer.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Check a parallel token stream is identical to the single-threaded one
+static void check_parallel(const char *source, size_t length)
+{
+    TokenArray expected = tokenize_source(source, length);
+    for (int threads = 1; threads <= 9; threads++)
+    {
+        TokenArray tokens = tokenize_parallel(source, length, threads);
+        assert(tokens.count == expected.count);
+        assert(tokens.source == source);
+        for (int i = 0; i < tokens.count; i++)
+        {
+            const Token *a = &tokens.tokens[i];
+            const Token *e = &expected.tokens[i];
+            assert(a->type == e->type);
+            assert(a->subkind == e->subkind);
+            assert(a->offset == e->offset);
+            assert(a->length == e->length);
+            assert(a->line == e->line);
+            assert(a->column == e->column);
+            assert(a->in_fstring == e->in_fstring);
+        }
+        free_token_array(&tokens);
+    }
+    free_token_array(&expected);
+}
+
+// Build a source by repeating fragments in a pseudo-random order
+static char *build_source(const char **fragments, int fragment_count, int pieces, unsigned seed)
+{
+    size_t capacity = 1;
+    for (int i = 0; i < fragment_count; i++)
+        capacity += strlen(fragments[i]) * pieces;
+    char *source = malloc(capacity);
+    source[0] = '\0';
+    srand(seed);
+    size_t length = 0;
+    for (int i = 0; i < pieces; i++)
+    {
+        const char *fragment = fragments[rand() % fragment_count];
+        size_t n = strlen(fragment);
+        memcpy(source + length, fragment, n);
+        length += n;
+    }
+    source[length] = '\0';
+    return source;
+}
+
+// Test that chunk boundaries never land inside literals or comments
+void test_literals_span_newlines(void)
+{
+    const char *fragments[] = {
+        "let x = 1\n",
+        "let s = \"multi\nline\nstring\"\n",
+        "print(f\"a {x +\n 1} b\n c\")\n",
+        "print(f\"escaped \\\nnewline {y}\")\n",
+        "// a comment with a \"quote\n",
+        "let t = \"escaped \\\" quote\n still open\"\n",
+        "let n = 1f\"after a number\n\"\n",
+        "let m = xf\"identifier then string\n\"\n",
+        "let e = 1.5ef\"scientific then f\n\"\n",
+        "z = a ** 2 <= b\n\n",
+    };
+    int fragment_count = sizeof(fragments) / sizeof(fragments[0]);
+    for (unsigned seed = 1; seed <= 40; seed++)
+    {
+        char *source = build_source(fragments, fragment_count, 200, seed);
+        check_parallel(source, strlen(source));
+        free(source);
+    }
+    printf("✓ Literals spanning newlines test passed\n");
+}
+
+// Test inputs that stop the lexer early
+void test_early_stop(void)
+{
+    const char *unterminated = "let a = 1\nlet b = 2\nlet s = \"never closed\nlet c = 3\nlet d = 4\n";
+    check_parallel(unterminated, strlen(unterminated));
+
+    const char with_nul[] = "let a = 1\nlet b = 2\n\0let c = 3\nlet d = 4\n";
+    check_parallel(with_nul, sizeof(with_nul) - 1);
+
+    const char *tiny = "x";
+    check_parallel(tiny, strlen(tiny));
+    check_parallel("", 0);
+    printf("✓ Early stop test passed\n");
+}
+
+// Test that tokenize gives the same result above the parallel threshold
+void test_large_tokenize(void)
+{
+    const char *fragments[] = {"let value = 42 + x\n", "print(f\"{value}\n\")\n", "// note\n"};
+    char *source = build_source(fragments, 3, 80000, 7);
+    size_t length = strlen(source);
+    assert(length >= (1 << 20));
+
+    TokenArray tokens = tokenize(source);
+    TokenArray spans = tokenize_source(source, length);
+    assert(tokens.count == spans.count);
+    for (int i = 0; i < tokens.count; i++)
+    {
+        assert(tokens.tokens[i].offset == spans.tokens[i].offset);
+        assert(tokens.tokens[i].line == spans.tokens[i].line);
+        assert(token_text_equals(&spans, &spans.tokens[i], tokens.tokens[i].value) ||
+               tokens.tokens[i].type == TOKEN_EOF);
+    }
+
+    free_token_array(&tokens);
+    free_token_array(&spans);
+    free(source);
+    printf("✓ Large tokenize test passed\n");
+}
+
+int main()
+{
+    printf("Running parallel lexing tests...\n");
+
+    test_literals_span_newlines();
+    test_early_stop();
+    test_large_tokenize();
+
+    printf("All parallel lexing tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "../../include/lexer.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Check an incrementally re-lexed stream is identical to a full tokenize
+static void assert_same_tokens(const TokenArray *actual, const TokenArray *expected)
+{
+    assert(actual->count == expected->count);
+    for (int i = 0; i < actual->count; i++)
+    {
+        const Token *a = &actual->tokens[i];
+        const Token *e = &expected->tokens[i];
+        assert(a->type == e->type);
+        assert(a->subkind == e->subkind);
+        assert(a->offset == e->offset);
+        assert(a->length == e->length);
+        assert(a->line == e->line);
+        assert(a->column == e->column);
+        assert(a->in_fstring == e->in_fstring);
+        assert((a->value == NULL) == (e->value == NULL));
+        if (a->value)
+            assert(strcmp(a->value, e->value) == 0);
+    }
+}
+
+// Apply edit to source, re-lex both ways and compare. Returns the number of
+// tokens the incremental path scanned.
+static int check_edit(const char *source, size_t offset, size_t removed, const char *inserted, int copy_values)
+{
+    SourceEdit edit = {offset, removed, inserted, strlen(inserted)};
+    size_t new_length;
+    char *edited = apply_source_edit(source, strlen(source), &edit, &new_length);
+
+    TokenArray old = copy_values ? tokenize(source) : tokenize_source(source, strlen(source));
+    TokenArray expected = copy_values ? tokenize(edited) : tokenize_source(edited, new_length);
+    int relexed;
+    TokenArray actual = retokenize(&old, edited, new_length, &edit, &relexed);
+    assert_same_tokens(&actual, &expected);
+
+    free_token_array(&old);
+    free_token_array(&expected);
+    free_token_array(&actual);
+    free(edited);
+    return relexed;
+}
+
+// Test simple edits in both token modes
+void test_simple_edits(void)
+{
+    const char *source = "let x = 1\nlet y = x + 2\nprint(y)\n";
+    for (int copy = 0; copy <= 1; copy++)
+    {
+        check_edit(source, 4, 1, "value", copy);   // rename
+        check_edit(source, 8, 0, "10 * ", copy);   // insert
+        check_edit(source, 10, 14, "", copy);      // delete a line
+        check_edit(source, 0, 0, "// header\n", copy);
+        check_edit(source, strlen(source), 0, "let z = 3", copy);
+        check_edit(source, 9, 1, " ", copy);       // join lines
+    }
+    printf("✓ Simple edits test passed\n");
+}
+
+// Test that an edit in a large file only re-scans a few tokens
+void test_edit_is_local(void)
+{
+    const char *line = "let value = (x + 1) * 2 - \"text\"\n";
+    size_t line_length = strlen(line);
+    int lines = 2000;
+    char *source = malloc(line_length * lines + 1);
+    for (int i = 0; i < lines; i++)
+        memcpy(source + i * line_length, line, line_length);
+    source[line_length * lines] = '\0';
+
+    size_t middle = line_length * (lines / 2) + 4; // the "value" identifier
+    int relexed = check_edit(source, middle, 5, "renamed", 0);
+    assert(relexed <= 3);
+    // Inserting a line shifts lines of everything after it.
+    relexed = check_edit(source, middle, 0, "z\nlet ", 0);
+    assert(relexed <= 4);
+
+    free(source);
+    printf("✓ Edit locality test passed (%d tokens re-scanned)\n", relexed);
+}
+
+// Test edits that open, close and move strings and f-strings across lines
+void test_string_edits(void)
+{
+    const char *source = "let a = \"multi\nline\" + b\nprint(f\"x={a}\n y={b + 1}\")\nlet c = 3\n";
+    for (int copy = 0; copy <= 1; copy++)
+    {
+        check_edit(source, 10, 0, "more\n", copy);       // grow a multi-line string
+        check_edit(source, 37, 0, "z + ", copy);          // edit inside an interpolation
+        check_edit(source, 33, 0, "pre ", copy);          // edit f-string text
+        check_edit(source, 0, 0, "let q = 1 ", copy);     // shift the f-string's line
+        check_edit(source, 8, 1, "", copy);               // delete the opening quote
+        check_edit(source, 25, 1, "", copy);              // turn f"..." into a plain string
+    }
+    printf("✓ String edits test passed\n");
+}
+
+// Test random edits against full re-tokenizing
+void test_random_edits(void)
+{
+    const char *fragments[] = {
+        "let ", "x", "y1", " = ", "42", "3.5e-2", " + ", "** ", "(", ")", "{", "}", "\n", "  ",
+        "\"str\"", "\"two\nlines\"", "f\"a{x}b\"", "f\"{y + 1}\n{x}\"", "// note\n", "fn ", "<=", "!=", ",", ";"};
+    int fragment_count = sizeof(fragments) / sizeof(fragments[0]);
+    char source[512];
+    char inserted[64];
+
+    srand(2024);
+    for (int round = 0; round < 3000; round++)
+    {
+        source[0] = '\0';
+        int pieces = 5 + rand() % 30;
+        for (int i = 0; i < pieces; i++)
+            strcat(source, fragments[rand() % fragment_count]);
+
+        inserted[0] = '\0';
+        int inserted_pieces = rand() % 3;
+        for (int i = 0; i < inserted_pieces; i++)
+            strcat(inserted, fragments[rand() % fragment_count]);
+
+        size_t length = strlen(source);
+        size_t offset = rand() % (length + 1);
+        size_t removed = rand() % 6;
+        if (removed > length - offset)
+            removed = length - offset;
+        check_edit(source, offset, removed, inserted, round & 1);
+    }
+    printf("✓ Random edits test passed\n");
+}
+
+int main()
+{
+    printf("Running incremental re-lexing tests...\n");
+
+    test_simple_edits();
+    test_edit_is_local();
+    test_string_edits();
+    test_random_edits();
+
+    printf("All incremental re-lexing tests passed!\n");
+    return 0;
+}
@@ -79,10 +79,10 @@ void test_basic_fstring(void)
     verify_token(tokens.tokens[1], TOKEN_IDENTIFIER, "msg", 1, 5);
     verify_token(tokens.tokens[2], TOKEN_OPERATOR, "=", 1, 9);
     verify_token(tokens.tokens[3], TOKEN_FSTRING, "Value is ", 1, 13);
-    verify_token(tokens.tokens[4], TOKEN_IDENTIFIER, "x", 1, 21);
-    verify_token(tokens.tokens[5], TOKEN_OPERATOR, "+", 1, 23);
-    verify_token(tokens.tokens[6], TOKEN_INTEGER, "1", 1, 25);
-    verify_token(tokens.tokens[7], TOKEN_SEMICOLON, ";", 1, 28);
+    verify_token(tokens.tokens[4], TOKEN_IDENTIFIER, "x", 1, 23);
+    verify_token(tokens.tokens[5], TOKEN_OPERATOR, "+", 1, 25);
+    verify_token(tokens.tokens[6], TOKEN_INTEGER, "1", 1, 27);
+    verify_token(tokens.tokens[7], TOKEN_SEMICOLON, ";", 1, 30);
 
     printf("✓ Basic f-string test passed\n");
     free_token_array(&tokens);
@@ -95,8 +95,8 @@ void test_numeric_fstring(void)
     TokenArray tokens = tokenize(input);
 
     verify_token(tokens.tokens[0], TOKEN_FSTRING, "Count: ", 1, 3);
-    verify_token(tokens.tokens[1], TOKEN_INTEGER, "42", 1, 9);
-    verify_token(tokens.tokens[2], TOKEN_SEMICOLON, ";", 1, 13);
+    verify_token(tokens.tokens[1], TOKEN_INTEGER, "42", 1, 11);
+    verify_token(tokens.tokens[2], TOKEN_SEMICOLON, ";", 1, 15);
 
     printf("✓ Numeric f-string test passed\n");
     free_token_array(&tokens);
@@ -109,8 +109,8 @@ void test_identifier_fstring(void)
     TokenArray tokens = tokenize(input);
 
     verify_token(tokens.tokens[0], TOKEN_FSTRING, "Name: ", 1, 3);
-    verify_token(tokens.tokens[1], TOKEN_IDENTIFIER, "name", 1, 8);
-    verify_token(tokens.tokens[2], TOKEN_SEMICOLON, ";", 1, 14);
+    verify_token(tokens.tokens[1], TOKEN_IDENTIFIER, "name", 1, 10);
+    verify_token(tokens.tokens[2], TOKEN_SEMICOLON, ";", 1, 16);
 
     printf("✓ Identifier f-string test passed\n");
     free_token_array(&tokens);
@@ -125,14 +125,48 @@ void test_multiline_fstring(void)
     verify_token(tokens.tokens[0], TOKEN_KEYWORD, "let", 1, 1);
     verify_token(tokens.tokens[1], TOKEN_IDENTIFIER, "msg", 1, 5);
     verify_token(tokens.tokens[2], TOKEN_OPERATOR, "=", 1, 9);
-    verify_token(tokens.tokens[3], TOKEN_FSTRING, "First line\nValue: ", 2, 13);
-    verify_token(tokens.tokens[4], TOKEN_IDENTIFIER, "x", 2, 8);
-    verify_token(tokens.tokens[5], TOKEN_SEMICOLON, ";", 2, 10);
+    verify_token(tokens.tokens[3], TOKEN_FSTRING, "First line\nValue: ", 1, 13);
+    verify_token(tokens.tokens[4], TOKEN_IDENTIFIER, "x", 2, 9);
+    verify_token(tokens.tokens[5], TOKEN_SEMICOLON, ";", 2, 12);
 
     printf("✓ Multi-line f-string test passed\n");
     free_token_array(&tokens);
 }
 
+// Test nested f-string interpolation positions
+void test_nested_fstring(void)
+{
+    const char *input = "f\"a{f\"b{y}\"}c\" z";
+    TokenArray tokens = tokenize(input);
+
+    verify_token(tokens.tokens[0], TOKEN_FSTRING, "a", 1, 3);
+    verify_token(tokens.tokens[1], TOKEN_FSTRING, "b", 1, 7);
+    verify_token(tokens.tokens[2], TOKEN_IDENTIFIER, "y", 1, 9);
+    verify_token(tokens.tokens[3], TOKEN_FSTRING, "c", 1, 13);
+    verify_token(tokens.tokens[4], TOKEN_IDENTIFIER, "z", 1, 16);
+    assert(tokens.tokens[2].in_fstring && !tokens.tokens[4].in_fstring);
+
+    printf("✓ Nested f-string test passed\n");
+    free_token_array(&tokens);
+}
+
+// Braces and strings inside an interpolation do not end it
+void test_interpolation_braces(void)
+{
+    const char *input = "f\"{ {x} }{\"}\"}\";\nlet";
+    TokenArray tokens = tokenize(input);
+
+    verify_token(tokens.tokens[0], TOKEN_LBRACE, "{", 1, 5);
+    verify_token(tokens.tokens[1], TOKEN_IDENTIFIER, "x", 1, 6);
+    verify_token(tokens.tokens[2], TOKEN_RBRACE, "}", 1, 7);
+    verify_token(tokens.tokens[3], TOKEN_STRING, "}", 1, 11);
+    verify_token(tokens.tokens[4], TOKEN_SEMICOLON, ";", 1, 16);
+    verify_token(tokens.tokens[5], TOKEN_KEYWORD, "let", 2, 1);
+
+    printf("✓ Interpolation braces test passed\n");
+    free_token_array(&tokens);
+}
+
 // Test single line comments
 void test_single_line_comments(void)
 {
@@ -180,10 +214,10 @@ void test_single_line_comments(void)
     verify_token(tokens.tokens[1], TOKEN_IDENTIFIER, "msg", 1, 5);
     verify_token(tokens.tokens[2], TOKEN_OPERATOR, "=", 1, 9);
     verify_token(tokens.tokens[3], TOKEN_FSTRING, "Value is ", 1, 13);
-    verify_token(tokens.tokens[4], TOKEN_IDENTIFIER, "x", 1, 21);
-    verify_token(tokens.tokens[5], TOKEN_OPERATOR, "+", 1, 23);
-    verify_token(tokens.tokens[6], TOKEN_INTEGER, "1", 1, 25);
-    verify_token(tokens.tokens[7], TOKEN_SEMICOLON, ";", 1, 28);
+    verify_token(tokens.tokens[4], TOKEN_IDENTIFIER, "x", 1, 23);
+    verify_token(tokens.tokens[5], TOKEN_OPERATOR, "+", 1, 25);
+    verify_token(tokens.tokens[6], TOKEN_INTEGER, "1", 1, 27);
+    verify_token(tokens.tokens[7], TOKEN_SEMICOLON, ";", 1, 30);
     // Comment should be ignored, next token should be on next line
     verify_token(tokens.tokens[8], TOKEN_KEYWORD, "let", 2, 1);
     verify_token(tokens.tokens[9], TOKEN_IDENTIFIER, "y", 2, 5);
@@ -207,6 +241,8 @@ int main()
     test_numeric_fstring();
     test_identifier_fstring();
     test_multiline_fstring();
+    test_nested_fstring();
+    test_interpolation_braces();
     test_single_line_comments();
 
     printf("All token position tracking tests passed!\n");
@@ -0,0 +1,121 @@
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Check that span tokens match the copying tokenizer token for token.
+static void assert_same_tokens(const TokenArray *owned, const TokenArray *spans)
+{
+    assert(owned->count == spans->count);
+    for (int i = 0; i < owned->count; i++)
+    {
+        const Token *a = &owned->tokens[i];
+        const Token *b = &spans->tokens[i];
+        assert(b->value == NULL);
+        assert(a->type == b->type);
+        assert(a->line == b->line);
+        assert(a->column == b->column);
+        assert(a->offset == b->offset);
+        if (a->type != TOKEN_EOF)
+        {
+            assert(a->length == b->length);
+            assert(memcmp(token_text(owned, a), token_text(spans, b), a->length) == 0);
+        }
+    }
+}
+
+// Test that span tokens point into the source buffer
+void test_span_tokens(void)
+{
+    const char *source = "let x: i32 = 42 ** 2; // comment\nlet s: string = \"hi\";";
+    TokenArray owned = tokenize(source);
+    TokenArray spans = tokenize_source(source, strlen(source));
+
+    assert(spans.source == source);
+    assert_same_tokens(&owned, &spans);
+    assert(token_text_equals(&spans, &spans.tokens[0], "let"));
+    assert(token_text(&spans, &spans.tokens[1]) == source + 4);
+
+    free_token_array(&owned);
+    free_token_array(&spans);
+    printf("✓ Span tokens test passed\n");
+}
+
+// Test f-string interpolation spans are rebased onto the outer source
+void test_fstring_spans(void)
+{
+    const char *source = "f\"Hello, {name}! Age: {age + 1}\"";
+    TokenArray owned = tokenize(source);
+    TokenArray spans = tokenize_source(source, strlen(source));
+
+    assert_same_tokens(&owned, &spans);
+    assert(spans.tokens[1].type == TOKEN_IDENTIFIER);
+    assert(token_text_equals(&spans, &spans.tokens[1], "name"));
+    assert(spans.tokens[1].offset == 10);
+
+    free_token_array(&owned);
+    free_token_array(&spans);
+    printf("✓ F-string span test passed\n");
+}
+
+// Test lexing a buffer that is not NUL-terminated
+void test_unterminated_buffer(void)
+{
+    char buffer[] = {'a', ' ', '+', ' ', '1', '2', 'X'};
+    TokenArray spans = tokenize_source(buffer, 6);
+
+    assert(spans.count == 4);
+    assert(token_text_equals(&spans, &spans.tokens[0], "a"));
+    assert(token_text_equals(&spans, &spans.tokens[2], "12"));
+    assert(spans.tokens[3].type == TOKEN_EOF);
+
+    free_token_array(&spans);
+    printf("✓ Unterminated buffer test passed\n");
+}
+
+// Test lexing and parsing a memory-mapped file
+void test_mapped_file(void)
+{
+    char path[] = "/tmp/zacklang_spans_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    FILE *file = fdopen(fd, "w");
+    fputs("value * (2 + 3)", file);
+    fclose(file);
+
+    SourceBuffer buffer;
+    assert(source_buffer_open(&buffer, path) == 0);
+    assert(buffer.is_mapped);
+    assert(buffer.length == strlen("value * (2 + 3)"));
+
+    TokenArray tokens = tokenize_source(buffer.data, buffer.length);
+    Parser *parser = create_parser(tokens);
+    ASTNode *expr = parse_expression(parser);
+    assert(!parser->had_error);
+    assert(expr != NULL && expr->type == AST_BINARY_EXPR);
+    assert(strcmp(expr->data.binary_expr.op, "*") == 0);
+    assert(strcmp(expr->data.binary_expr.left->data.identifier.name, "value") == 0);
+    assert(strcmp(expr->data.binary_expr.right->data.binary_expr.right->data.literal.value, "3") == 0);
+
+    free_ast(expr);
+    destroy_parser(parser);
+    free_token_array(&tokens);
+    source_buffer_close(&buffer);
+    remove(path);
+    printf("✓ Mapped file test passed\n");
+}
+
+int main()
+{
+    printf("Running token span tests...\n");
+
+    test_span_tokens();
+    test_fstring_spans();
+    test_unterminated_buffer();
+    test_mapped_file();
+
+    printf("All token span tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "../../include/lexer.h"
+#include "../../include/parser.h"
+#include "../../include/token_stream.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test the compact stream holds the same tokens as tokenize_source
+void test_same_tokens(void)
+{
+    const char *source = "let x: i32 = 42\nfn f(a: f64) { let s = \"str\"; }\nprint(f\"v={x + 1}\")\n";
+    size_t length = strlen(source);
+    TokenArray expected = tokenize_source(source, length);
+    TokenStream stream = tokenize_stream(source, length);
+
+    assert(stream.count == expected.count);
+    for (int i = 0; i < stream.count; i++)
+    {
+        Token token = token_stream_get(&stream, i);
+        assert(token.type == expected.tokens[i].type);
+        assert(token.subkind == expected.tokens[i].subkind);
+        assert(token.offset == expected.tokens[i].offset);
+        assert(token.length == expected.tokens[i].length);
+        assert(token.value == NULL);
+    }
+    assert(stream.kinds[stream.count - 1] == TOKEN_EOF);
+    assert(stream.line_count == 0); // No position asked for yet
+
+    free_token_stream(&stream);
+    free_token_array(&expected);
+    printf("✓ Compact stream tokens test passed\n");
+}
+
+// Test lazily computed positions match the lexer's for plain code
+void test_lazy_positions(void)
+{
+    const char *source = "let alpha = 1\n\n  let beta = alpha * 2 // note\n\tprint(\"multi\nline\", beta)\n";
+    size_t length = strlen(source);
+    TokenArray expected = tokenize_source(source, length);
+    TokenStream stream = tokenize_stream(source, length);
+
+    for (int i = 0; i < stream.count; i++)
+    {
+        int line, column;
+        token_stream_position(&stream, i, &line, &column);
+        if (expected.tokens[i].type == TOKEN_STRING)
+        {
+            // The lexer reports multi-line strings on their last line; the
+            // stream reports where the literal starts.
+            assert(line == 4 && column == 8);
+            continue;
+        }
+        assert(line == expected.tokens[i].line);
+        assert(column == expected.tokens[i].column);
+    }
+    assert(stream.line_count == 6);
+
+    int line, column;
+    token_stream_offset_position(&stream, 0, &line, &column);
+    assert(line == 1 && column == 1);
+    token_stream_offset_position(&stream, length, &line, &column);
+    assert(line == 6 && column == 1);
+
+    free_token_stream(&stream);
+    free_token_array(&expected);
+    printf("✓ Lazy positions test passed\n");
+}
+
+// Test the stream is several times smaller than a Token array
+void test_memory(void)
+{
+    const char *line = "let value = (x + 1) * 2\n";
+    size_t line_length = strlen(line);
+    int lines = 5000;
+    char *source = malloc(line_length * lines + 1);
+    for (int i = 0; i < lines; i++)
+        memcpy(source + i * line_length, line, line_length);
+    source[line_length * lines] = '\0';
+
+    TokenArray tokens = tokenize_source(source, line_length * lines);
+    TokenStream stream = tokenize_stream(source, line_length * lines);
+    size_t array_bytes = (size_t)tokens.capacity * sizeof(Token);
+    size_t stream_bytes = token_stream_memory(&stream);
+    assert(stream_bytes * 3 < array_bytes);
+
+    free_token_stream(&stream);
+    free_token_array(&tokens);
+    free(source);
+    printf("✓ Compact stream memory test passed (%zu vs %zu bytes)\n", stream_bytes, array_bytes);
+}
+
+// Test the parser can consume the compact stream
+void test_parser_over_stream(void)
+{
+    const char *source = "fn area(w: f64, h: f64): f64 { let a = w * h; }";
+    TokenStream stream = tokenize_stream(source, strlen(source));
+    Parser *parser = create_token_stream_parser(&stream);
+    ASTNode *node = parse_function_declaration(parser);
+    assert(!parser->had_error);
+    assert(node && node->type == AST_FUNC_DEF);
+    assert(strcmp(node->data.func_def.name, "area") == 0);
+    assert(node->data.func_def.param_count == 2);
+    free_ast(node);
+    destroy_parser(parser);
+    free_token_stream(&stream);
+
+    // Errors look up their line lazily.
+    const char *bad = "fn broken(\n\n  a: i32 { }";
+    stream = tokenize_stream(bad, strlen(bad));
+    parser = create_token_stream_parser(&stream);
+    node = parse_function_declaration(parser);
+    assert(parser->had_error);
+    assert(stream.line_count == 3);
+    if (node)
+        free_ast(node);
+    destroy_parser(parser);
+    free_token_stream(&stream);
+    printf("✓ Parser over compact stream test passed\n");
+}
+
+int main()
+{
+    printf("Running compact token stream tests...\n");
+
+    test_same_tokens();
+    test_lazy_positions();
+    test_memory();
+    test_parser_over_stream();
+
+    printf("All compact token stream tests passed!\n");
+    return 0;
+}
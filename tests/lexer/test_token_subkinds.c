@@ -0,0 +1,82 @@
+#include "../../include/lexer.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+// Test that every keyword classifies to its own subkind and back
+void test_keyword_round_trip(void)
+{
+    for (int kind = KW_LET; kind <= KW_VOID; kind++)
+    {
+        const char *text = token_subkind_text((TokenSubkind)kind);
+        assert(strlen(text) > 0);
+        assert(classify_keyword(text, strlen(text)) == (TokenSubkind)kind);
+    }
+    printf("✓ Keyword round trip test passed\n");
+}
+
+// Test identifiers that share a length and first character with keywords
+void test_keyword_near_misses(void)
+{
+    const char *identifiers[] = {"lets", "le", "i", "i16", "f16", "fo", "iff", "ex",
+                                 "els", "elsa", "cast", "chart", "stream", "strict",
+                                 "swatch", "continues", "comptimes", "compile",
+                                 "finale", "x", "_let", "Let"};
+    for (size_t i = 0; i < sizeof(identifiers) / sizeof(identifiers[0]); i++)
+    {
+        assert(classify_keyword(identifiers[i], strlen(identifiers[i])) == TOKEN_SUB_NONE);
+    }
+    printf("✓ Keyword near-miss test passed\n");
+}
+
+// Test operator classification and the longest-match rule
+void test_operators(void)
+{
+    const char *source = "= == != < <= > >= * ** + - / % & |";
+    TokenSubkind expected[] = {OP_ASSIGN, OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE,
+                               OP_STAR, OP_POWER, OP_PLUS, OP_MINUS, OP_SLASH,
+                               OP_PERCENT, OP_AMP, OP_PIPE};
+    TokenArray tokens = tokenize(source);
+
+    assert(tokens.count == (int)(sizeof(expected) / sizeof(expected[0])) + 1);
+    for (int i = 0; i < tokens.count - 1; i++)
+    {
+        assert(tokens.tokens[i].type == TOKEN_OPERATOR);
+        assert(tokens.tokens[i].subkind == expected[i]);
+        assert(strcmp(token_subkind_text(expected[i]), tokens.tokens[i].value) == 0);
+    }
+
+    free_token_array(&tokens);
+    printf("✓ Operator subkind test passed\n");
+}
+
+// Test that identifiers, literals and punctuation carry no subkind
+void test_plain_tokens(void)
+{
+    TokenArray tokens = tokenize("let total: i32 = (count + 1);");
+
+    assert(tokens.tokens[0].subkind == KW_LET);
+    assert(tokens.tokens[1].subkind == TOKEN_SUB_NONE);
+    assert(tokens.tokens[2].subkind == TOKEN_SUB_NONE);
+    assert(tokens.tokens[3].subkind == KW_I32);
+    assert(tokens.tokens[4].subkind == OP_ASSIGN);
+    assert(tokens.tokens[5].subkind == TOKEN_SUB_NONE);
+    assert(tokens.tokens[7].subkind == OP_PLUS);
+    assert(tokens.tokens[8].subkind == TOKEN_SUB_NONE);
+
+    free_token_array(&tokens);
+    printf("✓ Plain token subkind test passed\n");
+}
+
+int main()
+{
+    printf("Running token subkind tests...\n");
+
+    test_keyword_round_trip();
+    test_keyword_near_misses();
+    test_operators();
+    test_plain_tokens();
+
+    printf("All token subkind tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,636 @@
+#include "../../../include/ast.h"
+#include "../../../include/comptime.h"
+#include "../../../include/lexer.h"
+#include "../../../include/parser.h"
+#include "../../../include/pipeline.h"
+#include "../../../include/semantic.h"
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Frontend throughput benchmark: generate a Zacklang corpus, then time the
+// lexer, the parser, semantic analysis (full, parallel and after a one-function
+// edit), lowering and the comptime evaluator on it, and the pipelined frontend
+// against the stages run one after another.
+// The results are written as JSON.
+//
+// The parser only accepts top-level let, fn and struct declarations whose
+// bodies hold let statements, so the corpus has two parts. The declarations
+// (many functions, deep expressions, structs) go through every stage. The
+// f-string-heavy and comptime-recursive functions are only lexed, and the
+// comptime recursion is evaluated on an equivalent AST built directly.
+//
+// Usage: test_frontend_bench [--functions=N] [--statements=N] [--deep=N]
+//        [--depth=N] [--fstrings=N] [--comptime=N] [--fib=N] [--runs=N]
+//        [--threads=N] [--seed=N] [--json=PATH]
+
+#ifndef BENCH_VERSION
+#define BENCH_VERSION "unknown"
+#endif
+
+typedef struct
+{
+    int functions;    // fn declarations
+    int statements;   // let statements per function body
+    int deep;         // let declarations with deep initializers
+    int depth;        // operators per deep initializer
+    int fstrings;     // f-string-heavy functions (lexed only)
+    int comptime;     // recursive comptime functions (lexed only)
+    int fib;          // argument of the evaluated comptime recursion
+    int runs;         // best of this many runs is reported
+    int threads;      // parallel semantic analysis workers (0: one per CPU)
+    unsigned seed;
+    const char *json; // Output path, "-" for stdout
+} BenchConfig;
+
+void test_exit(int status)
+{
+    exit(status);
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//----------------------------------------------------------
+// Corpus generation
+//----------------------------------------------------------
+
+typedef struct
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static void append(Buffer *buffer, const char *format, ...)
+{
+    va_list args;
+    for (;;)
+    {
+        va_start(args, format);
+        size_t room = buffer->capacity - buffer->length;
+        int written = vsnprintf(buffer->data + buffer->length, room, format, args);
+        va_end(args);
+        if (written >= 0 && (size_t)written < room)
+        {
+            buffer->length += written;
+            return;
+        }
+        buffer->capacity = buffer->capacity * 2 + (written > 0 ? written : 0) + 4096;
+        buffer->data = realloc(buffer->data, buffer->capacity);
+        if (!buffer->data)
+        {
+            fprintf(stderr, "Out of memory generating the corpus\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+// i32 operand: a name in scope or a small literal
+static void append_operand(Buffer *out, char names[][32], int name_count)
+{
+    if (name_count > 0 && rand() % 2)
+        append(out, "%s", names[rand() % name_count]);
+    else
+        append(out, "%d", 1 + rand() % 9);
+}
+
+// i32 expression with operators and parentheses; products are of two
+// operands, so comptime values stay small
+static void append_expression(Buffer *out, char names[][32], int name_count, int terms)
+{
+    append_operand(out, names, name_count);
+    for (int i = 1; i < terms; i++)
+    {
+        switch (rand() % 4)
+        {
+        case 0:
+            append(out, " * ");
+            append_operand(out, names, name_count);
+            append(out, " + ");
+            break;
+        case 1:
+            append(out, " - (");
+            append_operand(out, names, name_count);
+            append(out, " + ");
+            append_operand(out, names, name_count);
+            append(out, ") + ");
+            break;
+        default:
+            append(out, rand() % 2 ? " + " : " - ");
+            break;
+        }
+        append_operand(out, names, name_count);
+    }
+}
+
+// Declarations every stage accepts
+static void generate_declarations(Buffer *out, const BenchConfig *config)
+{
+    char names[64][32];
+    for (int d = 0; d < config->deep; d++)
+    {
+        append(out, "let deep_%d: i32 = ", d);
+        append_expression(out, names, 0, config->depth / 2 + 1);
+        append(out, ";\n");
+    }
+
+    for (int f = 0; f < config->functions; f++)
+    {
+        if (f % 8 == 7)
+            append(out, "struct Record_%d { id: i32, weight: f64, label: string, ok: bool }\n", f);
+
+        int name_count = 0;
+        int params = 1 + f % 3;
+        append(out, "%sfn func_%d(", f % 5 == 0 ? "comptime " : "", f);
+        for (int p = 0; p < params; p++)
+        {
+            snprintf(names[name_count++], sizeof(names[0]), "p%d", p);
+            append(out, "%sp%d: i32", p ? ", " : "", p);
+        }
+        append(out, "): i32 {\n");
+        for (int s = 0; s < config->statements; s++)
+        {
+            if (s % 4 == 3)
+            {
+                append(out, "    let c%d: bool = %s < ", s, names[rand() % name_count]);
+                append_operand(out, names, name_count);
+                append(out, ";\n");
+                continue;
+            }
+            append(out, "    let v%d: i32 = ", s);
+            append_expression(out, names, name_count, 2 + rand() % 6);
+            append(out, ";\n");
+            if (name_count < 64)
+                snprintf(names[name_count++], sizeof(names[0]), "v%d", s);
+        }
+        append(out, "}\n");
+    }
+}
+
+// Constructs only the lexer handles: f-strings and control flow
+static void generate_lexer_only(Buffer *out, const BenchConfig *config)
+{
+    for (int f = 0; f < config->fstrings; f++)
+    {
+        append(out, "fn show_%d(count: i32, name: string) {\n", f);
+        append(out, "    print(f\"{name}: {count} items, {count * %d} total\");\n", f + 2);
+        append(out, "    print(f\"nested {f\"inner {count + 1} of {name}\"} done\");\n");
+        append(out, "    print(f\"escaped \\{braces\\} and {count - %d}\\n\");\n", f);
+        append(out, "}\n");
+    }
+    for (int f = 0; f < config->comptime; f++)
+    {
+        append(out, "comptime fn fib_%d(n: i32): i32 {\n", f);
+        append(out, "    if (n <= 1) {\n        return n;\n    }\n");
+        append(out, "    return fib_%d(n - 1) + fib_%d(n - 2);\n}\n", f, f);
+        append(out, "let fib_value_%d: i32 = fib_%d(%d);\n", f, f, 10 + f % 10);
+    }
+}
+
+// comptime fn fibonacci(n: i32): i32 { if (n <= 1) { return n; } return fibonacci(n - 1) + fibonacci(n - 2); }
+static ASTNode *build_fibonacci(void)
+{
+    ASTNode **params = malloc(sizeof(ASTNode *));
+    params[0] = create_var_decl(1, "n", "i32", NULL);
+
+    ASTNode **if_stmts = malloc(sizeof(ASTNode *));
+    if_stmts[0] = create_return_stmt(create_identifier("n"));
+    ASTNode *condition = create_binary_expr("<=", create_identifier("n"), create_literal("1"));
+
+    ASTNode *calls[2];
+    for (int i = 0; i < 2; i++)
+    {
+        ASTNode **args = malloc(sizeof(ASTNode *));
+        args[0] = create_binary_expr("-", create_identifier("n"), create_literal(i == 0 ? "1" : "2"));
+        calls[i] = create_func_call("fibonacci", args, 1);
+    }
+
+    ASTNode **body = malloc(2 * sizeof(ASTNode *));
+    body[0] = create_if_stmt(condition, create_block(if_stmts, 1), NULL, NULL, 0, NULL);
+    body[1] = create_return_stmt(create_binary_expr("+", calls[0], calls[1]));
+    return create_func_def("fibonacci", params, 1, "i32", create_block(body, 2), 1);
+}
+
+//----------------------------------------------------------
+// Measurement
+//----------------------------------------------------------
+
+static int saved_stdout = -1;
+
+// The parser, semantic analysis and evaluator print debug lines; time them
+// without a terminal in the way
+static void quiet_stdout(void)
+{
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+}
+
+static void restore_stdout(void)
+{
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+}
+
+static ASTWalkAction count_node(ASTNode *node, ASTNode *parent, void *context)
+{
+    (void)node;
+    (void)parent;
+    (*(long *)context)++;
+    return AST_WALK_CONTINUE;
+}
+
+static long count_nodes(ASTNode *root)
+{
+    long count = 0;
+    ASTVisitor visitor = {count_node, NULL, &count};
+    ast_walk(root, &visitor);
+    return count;
+}
+
+// Parse every declaration into a block; NULL on a syntax error
+static ASTNode *parse_all(TokenArray tokens)
+{
+    Parser *parser = create_parser(tokens);
+    int count = 0, capacity = 256;
+    ASTNode **decls = malloc(capacity * sizeof(ASTNode *));
+    while (parser->tokens.tokens[parser->current].type != TOKEN_EOF)
+    {
+        ASTNode *decl = parse_declaration(parser);
+        if (!decl || parser->had_error)
+        {
+            for (int i = 0; i < count; i++)
+                free_ast(decls[i]);
+            free(decls);
+            free_ast(decl);
+            destroy_parser(parser);
+            return NULL;
+        }
+        if (count == capacity)
+        {
+            capacity *= 2;
+            decls = realloc(decls, capacity * sizeof(ASTNode *));
+        }
+        decls[count++] = decl;
+    }
+    destroy_parser(parser);
+    return create_block(decls, count);
+}
+
+static int parse_arguments(int argc, char **argv, BenchConfig *config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = strchr(arg, '=');
+        if (strncmp(arg, "--", 2) != 0 || !value)
+            return 0;
+        size_t name_length = value - arg - 2;
+        value++;
+        struct
+        {
+            const char *name;
+            int *field;
+        } options[] = {
+            {"functions", &config->functions}, {"statements", &config->statements},
+            {"deep", &config->deep},           {"depth", &config->depth},
+            {"fstrings", &config->fstrings},   {"comptime", &config->comptime},
+            {"fib", &config->fib},             {"runs", &config->runs},
+            {"threads", &config->threads},
+        };
+        int matched = 0;
+        for (size_t o = 0; o < sizeof(options) / sizeof(options[0]); o++)
+        {
+            if (strlen(options[o].name) == name_length && strncmp(arg + 2, options[o].name, name_length) == 0)
+            {
+                *options[o].field = atoi(value);
+                matched = 1;
+            }
+        }
+        if (!matched && name_length == 4 && strncmp(arg + 2, "seed", 4) == 0)
+            config->seed = (unsigned)strtoul(value, NULL, 10), matched = 1;
+        if (!matched && name_length == 4 && strncmp(arg + 2, "json", 4) == 0)
+            config->json = value, matched = 1;
+        if (!matched)
+            return 0;
+    }
+    return config->runs > 0 && config->threads >= 0 && config->functions >= 0 && config->statements > 0 && config->depth >= 0;
+}
+
+int main(int argc, char **argv)
+{
+    BenchConfig config = {2000, 12, 20, 5000, 500, 50, 18, 3, 0, 42, "frontend_bench.json"};
+    if (!parse_arguments(argc, argv, &config))
+    {
+        fprintf(stderr, "usage: %s [--functions=N] [--statements=N] [--deep=N] [--depth=N] [--fstrings=N]\n"
+                        "       [--comptime=N] [--fib=N] [--runs=N] [--threads=N] [--seed=N] [--json=PATH|-]\n",
+                        argv[0]);
+        return 2;
+    }
+    if (config.threads == 0)
+        config.threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    srand(config.seed);
+
+    Buffer declarations = {NULL, 0, 0};
+    generate_declarations(&declarations, &config);
+    Buffer corpus = {NULL, 0, 0};
+    append(&corpus, "%s", declarations.data ? declarations.data : "");
+    generate_lexer_only(&corpus, &config);
+
+    // tokenize: the whole corpus
+    double best_lex = 1e30;
+    int token_count = 0;
+    for (int run = 0; run < config.runs; run++)
+    {
+        double start = now_seconds();
+        TokenArray tokens = tokenize(corpus.data);
+        double elapsed = now_seconds() - start;
+        token_count = tokens.count;
+        free_token_array(&tokens);
+        if (elapsed < best_lex)
+            best_lex = elapsed;
+    }
+
+    // Parser: the declarations
+    TokenArray decl_tokens = tokenize(declarations.data);
+    double best_parse = 1e30;
+    ASTNode *program = NULL;
+    for (int run = 0; run < config.runs; run++)
+    {
+        free_ast(program);
+        quiet_stdout();
+        double start = now_seconds();
+        program = parse_all(decl_tokens);
+        double elapsed = now_seconds() - start;
+        restore_stdout();
+        if (!program)
+        {
+            fprintf(stderr, "Generated corpus failed to parse\n");
+            return 1;
+        }
+        if (elapsed < best_parse)
+            best_parse = elapsed;
+    }
+    long node_count = count_nodes(program);
+
+    // Semantic analysis of the parsed declarations
+    double best_semantic = 1e30;
+    for (int run = 0; run < config.runs; run++)
+    {
+        quiet_stdout();
+        double start = now_seconds();
+        semantic_analysis(program); // Exits on a semantic error
+        double elapsed = now_seconds() - start;
+        restore_stdout();
+        if (elapsed < best_semantic)
+            best_semantic = elapsed;
+    }
+
+    // The same declarations with function bodies checked in parallel
+    double best_semantic_parallel = 1e30;
+    for (int run = 0; run < config.runs; run++)
+    {
+        SemanticContext context;
+        semantic_context_init(&context, create_symbol_table(NULL));
+        quiet_stdout();
+        double start = now_seconds();
+        int errors = semantic_check_program(&context, program->data.block.statements,
+                                            program->data.block.stmt_count, config.threads);
+        double elapsed = now_seconds() - start;
+        restore_stdout();
+        destroy_symbol_table(context.globals);
+        semantic_context_destroy(&context);
+        if (errors)
+        {
+            fprintf(stderr, "Generated corpus failed semantic analysis\n");
+            return 1;
+        }
+        if (elapsed < best_semantic_parallel)
+            best_semantic_parallel = elapsed;
+    }
+
+    // Incremental re-check after editing one function in the middle of the
+    // module: the edit replaces it by a copy, a new node with the same
+    // signature, so only that function is walked again
+    ASTNode **decls = program->data.block.statements;
+    int decl_count = program->data.block.stmt_count;
+    int edited = decl_count / 2;
+    while (edited < decl_count - 1 && decls[edited]->type != AST_FUNC_DEF)
+        edited++;
+    SemanticProgram *incremental = create_semantic_program();
+    quiet_stdout();
+    semantic_program_update(incremental, decls, decl_count, config.threads);
+    restore_stdout();
+    double best_incremental = 1e30;
+    int rechecked = 0;
+    for (int run = 0; run < config.runs; run++)
+    {
+        FlatAST *flat = create_flat_ast();
+        ASTNode *old = decls[edited];
+        decls[edited] = flat_ast_to_tree(flat, flat_ast_add_tree(flat, old));
+        destroy_flat_ast(flat);
+        quiet_stdout();
+        double start = now_seconds();
+        int errors = semantic_program_update(incremental, decls, decl_count, config.threads);
+        double elapsed = now_seconds() - start;
+        restore_stdout();
+        free_ast(old);
+        if (errors)
+        {
+            fprintf(stderr, "Edited corpus failed semantic analysis\n");
+            return 1;
+        }
+        rechecked = semantic_program_rechecked(incremental);
+        if (elapsed < best_incremental)
+            best_incremental = elapsed;
+    }
+    destroy_semantic_program(incremental);
+
+    // Lowering into a FlatAST
+    double best_lower = 1e30;
+    for (int run = 0; run < config.runs; run++)
+    {
+        double start = now_seconds();
+        FlatAST *flat = create_flat_ast();
+        flat_ast_add_tree(flat, program);
+        double elapsed = now_seconds() - start;
+        destroy_flat_ast(flat);
+        if (elapsed < best_lower)
+            best_lower = elapsed;
+    }
+
+    // The same stages, pipelined per declaration
+    double best_lex_decls = 1e30;
+    for (int run = 0; run < config.runs; run++)
+    {
+        double start = now_seconds();
+        TokenArray tokens = tokenize(declarations.data);
+        double elapsed = now_seconds() - start;
+        free_token_array(&tokens);
+        if (elapsed < best_lex_decls)
+            best_lex_decls = elapsed;
+    }
+    double serial = best_lex_decls + best_parse + best_semantic + best_lower;
+    double best_pipeline = 1e30;
+    for (int run = 0; run < config.runs; run++)
+    {
+        quiet_stdout();
+        double start = now_seconds();
+        FrontendResult result = run_frontend_pipeline(declarations.data, declarations.length, NULL);
+        double elapsed = now_seconds() - start;
+        restore_stdout();
+        if (result.error_count || result.decl_count != program->data.block.stmt_count)
+        {
+            fprintf(stderr, "Pipelined frontend disagrees with the serial parse\n");
+            return 1;
+        }
+        free_frontend_result(&result);
+        if (elapsed < best_pipeline)
+            best_pipeline = elapsed;
+    }
+
+    // Comptime evaluator: the deep initializers, then recursive calls
+    long deep_nodes = 0;
+    double best_deep = 1e30;
+    for (int run = 0; run < config.runs; run++)
+    {
+        deep_nodes = 0;
+        double elapsed = 0;
+        for (int i = 0; i < config.deep; i++)
+        {
+            ASTNode *init = program->data.block.statements[i]->data.var_decl.initializer;
+            deep_nodes += count_nodes(init);
+            quiet_stdout();
+            double start = now_seconds();
+            ComptimeValue *value = evaluate_comptime_expr(init);
+            elapsed += now_seconds() - start;
+            restore_stdout();
+            if (!value)
+            {
+                fprintf(stderr, "Deep initializer %d did not evaluate\n", i);
+                return 1;
+            }
+            free_comptime_value(value);
+        }
+        if (elapsed < best_deep)
+            best_deep = elapsed;
+    }
+
+    ASTNode *fibonacci = build_fibonacci();
+    SymbolTable *table = create_symbol_table(NULL);
+    add_symbol_with_node(table, "fibonacci", "fn(i32): i32", fibonacci);
+    char argument[16];
+    snprintf(argument, sizeof(argument), "%d", config.fib);
+    ASTNode **args = malloc(sizeof(ASTNode *));
+    args[0] = create_literal(argument);
+    ASTNode *call = create_func_call("fibonacci", args, 1);
+    long fib_calls = 0, a = 0, b = 1; // Calls made by fibonacci(n): 2 * F(n + 1) - 1
+    for (int i = 0; i < config.fib; i++)
+    {
+        long next = a + b;
+        a = b;
+        b = next;
+    }
+    fib_calls = 2 * b - 1;
+    double best_fib = 1e30;
+    long long fib_value = 0;
+    for (int run = 0; run < config.runs; run++)
+    {
+        quiet_stdout();
+        double start = now_seconds();
+        ComptimeValue *value = evaluate_comptime_expr_with_symbols(call, table);
+        double elapsed = now_seconds() - start;
+        restore_stdout();
+        if (!value)
+        {
+            fprintf(stderr, "fibonacci(%d) did not evaluate\n", config.fib);
+            return 1;
+        }
+        fib_value = (long long)value->value.i_val;
+        free_comptime_value(value);
+        if (elapsed < best_fib)
+            best_fib = elapsed;
+    }
+
+    printf("Frontend benchmark (%s): %zu bytes, %d tokens, %ld nodes\n", BENCH_VERSION, corpus.length, token_count,
+           node_count);
+    printf("%-22s %12s %16s\n", "stage", "time (ms)", "throughput");
+    printf("%-22s %12.2f %12.2f M tok/s\n", "tokenize", best_lex * 1000, token_count / best_lex / 1e6);
+    printf("%-22s %12.2f %12.2f M nodes/s\n", "parse", best_parse * 1000, node_count / best_parse / 1e6);
+    printf("%-22s %12.2f %12.1f ns/node\n", "semantic_analysis", best_semantic * 1000, best_semantic * 1e9 / node_count);
+    printf("%-22s %12.2f %12.2fx on %d threads\n", "semantic (parallel)", best_semantic_parallel * 1000,
+           best_semantic / best_semantic_parallel, config.threads);
+    printf("%-22s %12.2f %12.2fx vs full, %d of %d decls\n", "semantic (1 fn edit)", best_incremental * 1000,
+           best_semantic_parallel / best_incremental, rechecked, decl_count);
+    printf("%-22s %12.2f %12.1f ns/node\n", "lower (flat AST)", best_lower * 1000, best_lower * 1e9 / node_count);
+    printf("%-22s %12.2f %12.2fx vs serial %.2f ms\n", "pipeline (all stages)", best_pipeline * 1000,
+           serial / best_pipeline, serial * 1000);
+    printf("%-22s %12.2f %12.1f ns/node\n", "comptime (deep exprs)", best_deep * 1000,
+           deep_nodes ? best_deep * 1e9 / deep_nodes : 0.0);
+    printf("%-22s %12.2f %12.1f ns/call\n", "comptime (fibonacci)", best_fib * 1000, best_fib * 1e9 / fib_calls);
+
+    FILE *json = strcmp(config.json, "-") == 0 ? stdout : fopen(config.json, "w");
+    if (!json)
+    {
+        perror(config.json);
+        return 1;
+    }
+    fprintf(json, "{\n");
+    fprintf(json, "  \"benchmark\": \"frontend\",\n");
+    fprintf(json, "  \"version\": \"%s\",\n", BENCH_VERSION);
+    fprintf(json, "  \"timestamp\": %lld,\n", (long long)time(NULL));
+    fprintf(json, "  \"config\": {\"functions\": %d, \"statements\": %d, \"deep\": %d, \"depth\": %d, "
+                  "\"fstrings\": %d, \"comptime\": %d, \"fib\": %d, \"runs\": %d, \"threads\": %d, "
+                  "\"seed\": %u},\n",
+            config.functions, config.statements, config.deep, config.depth, config.fstrings, config.comptime,
+            config.fib, config.runs, config.threads, config.seed);
+    fprintf(json, "  \"corpus\": {\"bytes\": %zu, \"parsed_bytes\": %zu, \"tokens\": %d, \"nodes\": %ld},\n",
+            corpus.length, declarations.length, token_count, node_count);
+    fprintf(json, "  \"tokenize\": {\"seconds\": %.6f, \"tokens_per_second\": %.0f},\n", best_lex,
+            token_count / best_lex);
+    fprintf(json, "  \"parse\": {\"seconds\": %.6f, \"nodes_per_second\": %.0f},\n", best_parse,
+            node_count / best_parse);
+    fprintf(json, "  \"semantic_analysis\": {\"seconds\": %.6f, \"ns_per_node\": %.2f},\n", best_semantic,
+            best_semantic * 1e9 / node_count);
+    fprintf(json, "  \"semantic_parallel\": {\"seconds\": %.6f, \"threads\": %d, \"speedup\": %.3f},\n",
+            best_semantic_parallel, config.threads, best_semantic / best_semantic_parallel);
+    fprintf(json, "  \"semantic_incremental\": {\"seconds\": %.6f, \"rechecked\": %d, \"declarations\": %d, "
+                  "\"speedup\": %.3f},\n",
+            best_incremental, rechecked, decl_count, best_semantic_parallel / best_incremental);
+    fprintf(json, "  \"lower\": {\"seconds\": %.6f, \"ns_per_node\": %.2f},\n", best_lower,
+            best_lower * 1e9 / node_count);
+    fprintf(json, "  \"pipeline\": {\"seconds\": %.6f, \"serial_seconds\": %.6f, \"speedup\": %.3f},\n", best_pipeline,
+            serial, serial / best_pipeline);
+    fprintf(json, "  \"comptime_deep\": {\"seconds\": %.6f, \"nodes\": %ld, \"ns_per_node\": %.2f},\n", best_deep,
+            deep_nodes, deep_nodes ? best_deep * 1e9 / deep_nodes : 0.0);
+    fprintf(json, "  \"comptime_fibonacci\": {\"n\": %d, \"value\": %lld, \"calls\": %ld, \"seconds\": %.6f, "
+                  "\"ns_per_call\": %.2f}\n",
+            config.fib, fib_value, fib_calls, best_fib, best_fib * 1e9 / fib_calls);
+    fprintf(json, "}\n");
+    if (json != stdout)
+    {
+        fclose(json);
+        printf("Results written to %s\n", config.json);
+    }
+
+    free_ast(call);
+    destroy_symbol_table(table);
+    free_ast(fibonacci);
+    free_ast(program);
+    free_token_array(&decl_tokens);
+    free(corpus.data);
+    free(declarations.data);
+    return 0;
+}
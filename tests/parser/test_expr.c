@@ -246,6 +246,70 @@ void test_assignment(void)
     printf("✓ Invalid assignment target test passed\n");
 }
 
+// Render an expression fully parenthesized, e.g. (+ a (* b c))
+static void render(ASTNode *node, char *out, size_t size)
+{
+    char left[256], right[256];
+    switch (node->type)
+    {
+    case AST_BINARY_EXPR:
+        render(node->data.binary_expr.left, left, sizeof(left));
+        render(node->data.binary_expr.right, right, sizeof(right));
+        snprintf(out, size, "(%s %s %s)", node->data.binary_expr.op, left, right);
+        break;
+    case AST_UNARY_EXPR:
+        render(node->data.unary_expr.operand, left, sizeof(left));
+        snprintf(out, size, "(%s %s)", node->data.unary_expr.op, left);
+        break;
+    case AST_ASSIGN_EXPR:
+        render(node->data.assign_expr.left, left, sizeof(left));
+        render(node->data.assign_expr.right, right, sizeof(right));
+        snprintf(out, size, "(= %s %s)", left, right);
+        break;
+    case AST_IDENTIFIER:
+        snprintf(out, size, "%s", node->data.identifier.name);
+        break;
+    default:
+        snprintf(out, size, "%s", node->data.literal.value);
+        break;
+    }
+}
+
+// Test the full precedence and associativity table
+void test_precedence_table(void)
+{
+    const char *cases[][2] = {
+        {"a - b - c", "(- (- a b) c)"},
+        {"a / b * c % d", "(% (* (/ a b) c) d)"},
+        {"a + b * c ** d", "(+ a (* b (** c d)))"},
+        {"-a ** 2", "(** (- a) 2)"},
+        {"a ** -b ** c", "(** a (** (- b) c))"},
+        {"not a == b", "(== (not a) b)"},
+        {"a < b == c >= d", "(== (< a b) (>= c d))"},
+        {"a == b != c", "(!= (== a b) c)"},
+        {"a or b or c and d", "(or (or a b) (and c d))"},
+        {"x = a or b", "(= x (or a b))"},
+        {"x = y = a + b", "(= x (= y (+ a b)))"},
+        {"(a + b) * c", "(* (+ a b) c)"},
+        {"a * (x = 2)", "(* a (= x 2))"},
+    };
+    char rendered[256];
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        ASTNode *node = parse_string(cases[i][0]);
+        assert(node != NULL);
+        render(node, rendered, sizeof(rendered));
+        assert(strcmp(rendered, cases[i][1]) == 0);
+        free_ast(node);
+    }
+    printf("✓ Precedence table test passed\n");
+
+    // Only identifiers can be assigned, at any depth
+    assert(parse_string("a + b = c") == NULL);
+    assert(parse_string("x = -y = 1") == NULL);
+    printf("✓ Nested invalid assignment target test passed\n");
+}
+
 // Test error cases
 void test_error_cases(void)
 {
@@ -275,6 +339,7 @@ int main()
     test_binary_operators();
     test_logical_operators();
     test_assignment();
+    test_precedence_table();
     test_error_cases();
 
     printf("All expression tests passed!\n");
@@ -0,0 +1,137 @@
+#include "../../include/parser.h"
+#include "../../include/lexer.h"
+#include "../../include/semantic.h"
+#include "../../include/token_stream.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+// Bodies are skipped at parse time and parsed on first use
+void test_deferred_body(void)
+{
+    const char *source = "fn first(a: i32): i32 { let x = { 1 }; let y = a; } fn second() { let z = 3; }";
+    TokenArray tokens = tokenize(source);
+    Parser *parser = create_parser(tokens);
+    parser->lazy_bodies = 1;
+
+    ASTNode *first = parse_function_declaration(parser);
+    assert(first && !parser->had_error);
+    assert(first->data.func_def.body == NULL);
+    assert(first->data.func_def.lazy_body != NULL);
+    assert(first->data.func_def.param_count == 1);
+    assert(strcmp(first->data.func_def.return_type, "i32") == 0);
+
+    // Parsing resumed after the matching brace
+    ASTNode *second = parse_function_declaration(parser);
+    assert(second && !parser->had_error);
+    assert(strcmp(second->data.func_def.name, "second") == 0);
+    assert(parser->tokens.tokens[parser->current].type == TOKEN_EOF);
+    destroy_parser(parser);
+
+    // The body is parsed once, after the parser is gone
+    ASTNode *body = func_def_body(second);
+    assert(body && body->type == AST_BLOCK);
+    assert(body->data.block.stmt_count == 1);
+    assert(second->data.func_def.lazy_body == NULL);
+    assert(func_def_body(second) == body);
+
+    free_ast(first); // Never parsed
+    free_ast(second);
+    free_token_array(&tokens);
+    printf("✓ Deferred body test passed\n");
+}
+
+// Syntax errors inside a skipped body surface when it is parsed
+void test_deferred_errors(void)
+{
+    TokenArray tokens = tokenize("fn broken(): i32 { let = ; }");
+    Parser *parser = create_parser(tokens);
+    parser->lazy_bodies = 1;
+    ASTNode *func = parse_function_declaration(parser);
+    assert(func && !parser->had_error);
+    assert(func_def_body(func) == NULL);
+    assert(func_def_body(func) == NULL);
+
+    // Semantic checking rejects the function, serially and in parallel
+    SemanticContext context;
+    semantic_context_init(&context, create_symbol_table(NULL));
+    assert(semantic_check(&context, func) == 1);
+    assert(strstr(context.diagnostics.items[0].message, "Syntax error in body of function 'broken'"));
+    destroy_symbol_table(context.globals);
+    semantic_context_destroy(&context);
+    semantic_context_init(&context, create_symbol_table(NULL));
+    assert(semantic_check_program(&context, &func, 1, 2) == 1);
+    assert(strstr(context.diagnostics.items[0].message, "Syntax error in body of function 'broken'"));
+    destroy_symbol_table(context.globals);
+    semantic_context_destroy(&context);
+    free_ast(func);
+    destroy_parser(parser);
+    free_token_array(&tokens);
+
+    // Unbalanced braces are still caught while skipping
+    tokens = tokenize("fn open() { let x = 1;");
+    parser = create_parser(tokens);
+    parser->lazy_bodies = 1;
+    assert(parse_function_declaration(parser) == NULL);
+    assert(parser->had_error);
+    destroy_parser(parser);
+    free_token_array(&tokens);
+    printf("✓ Deferred error test passed\n");
+}
+
+// Compact token streams and arenas work with lazy bodies too
+void test_stream_and_arena(void)
+{
+    const char *source = "fn f(n) { let a = n * 2; let b = a + 1; }";
+    TokenStream stream = tokenize_stream(source, strlen(source));
+    Parser *parser = create_token_stream_parser(&stream);
+    parser->lazy_bodies = 1;
+
+    ASTArena *arena = create_ast_arena();
+    ast_arena_set_current(arena);
+    ASTNode *func = parse_function_declaration(parser);
+    ast_arena_set_current(NULL);
+    destroy_parser(parser);
+    assert(func && func->data.func_def.lazy_body != NULL);
+
+    ASTNode *body = func_def_body(func);
+    assert(body && body->data.block.stmt_count == 2);
+    assert(body->flags & AST_NODE_IN_ARENA);
+    assert(ast_arena_current() == NULL);
+
+    destroy_ast_arena(arena);
+    free_token_stream(&stream);
+    printf("✓ Stream and arena lazy body test passed\n");
+}
+
+// Semantic analysis parses the bodies it visits
+void test_semantic_forces_body(void)
+{
+    TokenArray tokens = tokenize("fn g(x: i32) { let y: i32 = x; }");
+    Parser *parser = create_parser(tokens);
+    parser->lazy_bodies = 1;
+    ASTNode *func = parse_function_declaration(parser);
+    assert(func->data.func_def.body == NULL);
+
+    semantic_analysis(func);
+    assert(func->data.func_def.body != NULL);
+    assert(func->data.func_def.body->data.block.stmt_count == 1);
+
+    free_ast(func);
+    destroy_parser(parser);
+    free_token_array(&tokens);
+    printf("✓ Semantic analysis lazy body test passed\n");
+}
+
+int main()
+{
+    printf("Running lazy function body tests...\n");
+
+    test_deferred_body();
+    test_deferred_errors();
+    test_stream_and_arena();
+    test_semantic_forces_body();
+
+    printf("All lazy function body tests passed!\n");
+    return 0;
+}
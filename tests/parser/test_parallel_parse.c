@@ -0,0 +1,151 @@
+#include "../../include/parser.h"
+#include "../../include/lexer.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DECLS 120
+
+// Generate a module of let, fn, comptime fn and struct declarations, one per line
+static char *generate_module(int broken_every)
+{
+    char *source = malloc(DECLS * 128);
+    size_t used = 0;
+    for (int i = 0; i < DECLS; i++)
+    {
+        if (broken_every && i % broken_every == broken_every - 1)
+            used += sprintf(source + used, "let broken_%d = ;\n", i);
+        else if (i % 4 == 0)
+            used += sprintf(source + used, "let value_%d: i32 = (%d + 1) * 2;\n", i, i);
+        else if (i % 4 == 1)
+            used += sprintf(source + used, "fn func_%d(a: i32, b) { let x = a; let y = b * %d; }\n", i, i);
+        else if (i % 4 == 2)
+            used += sprintf(source + used, "comptime fn ct_%d(): i32 { let z = %d; }\n", i, i);
+        else
+            used += sprintf(source + used, "struct S_%d { x: i32, y: f64 }\n", i);
+    }
+    return source;
+}
+
+// Name atom of any top-level declaration
+static Atom decl_atom(const ASTNode *decl)
+{
+    switch (decl->type)
+    {
+    case AST_VAR_DECL:
+        return decl->data.var_decl.atom;
+    case AST_FUNC_DEF:
+        return decl->data.func_def.atom;
+    case AST_STRUCT_DEF:
+        return decl->data.struct_def.atom;
+    default:
+        return ATOM_NONE;
+    }
+}
+
+// Parallel parsing yields the same declarations as a serial parse
+void test_matches_serial(void)
+{
+    char *source = generate_module(0);
+    TokenArray tokens = tokenize(source);
+
+    Parser *parser = create_parser(tokens);
+    ASTNode *serial[DECLS];
+    for (int i = 0; i < DECLS; i++)
+    {
+        serial[i] = parse_declaration(parser);
+        assert(serial[i] != NULL);
+    }
+    assert(!parser->had_error && parser->error_count == 0);
+    destroy_parser(parser);
+
+    for (int threads = 1; threads <= 8; threads *= 2)
+    {
+        ParsedProgram program = parse_program_parallel(&tokens, threads);
+        assert(program.decl_count == DECLS);
+        assert(program.error_count == 0);
+        for (int i = 0; i < DECLS; i++)
+        {
+            ASTNode *decl = program.decls[i];
+            assert(decl->type == serial[i]->type);
+            assert(decl_atom(decl) == decl_atom(serial[i]));
+            assert(decl->flags & AST_NODE_IN_ARENA);
+            if (decl->type == AST_FUNC_DEF)
+            {
+                assert(decl->data.func_def.is_comptime == serial[i]->data.func_def.is_comptime);
+                assert(decl->data.func_def.body->data.block.stmt_count ==
+                       serial[i]->data.func_def.body->data.block.stmt_count);
+            }
+            if (decl->type == AST_STRUCT_DEF)
+            {
+                assert(decl->data.struct_def.field_count == 2);
+                assert(strcmp(decl->data.struct_def.field_types[1], "f64") == 0);
+            }
+        }
+        free_parsed_program(&program);
+    }
+
+    for (int i = 0; i < DECLS; i++)
+        free_ast(serial[i]);
+    free_token_array(&tokens);
+    free(source);
+    printf("✓ Parallel parse matches serial parse test passed\n");
+}
+
+// Errors are kept per worker and merged in source order
+void test_errors_in_order(void)
+{
+    char *source = generate_module(10);
+    TokenArray tokens = tokenize(source);
+    ParsedProgram program = parse_program_parallel(&tokens, 4);
+
+    // Every tenth declaration is broken; the rest still parse
+    assert(program.error_count == DECLS / 10);
+    assert(program.decl_count == DECLS - DECLS / 10);
+    for (int i = 0; i < program.error_count; i++)
+    {
+        assert(program.errors[i].line == 10 * (i + 1));
+        assert(strstr(program.errors[i].message, "Expected expression") != NULL);
+        if (i > 0)
+            assert(program.errors[i].token_index > program.errors[i - 1].token_index);
+    }
+
+    free_parsed_program(&program);
+    free_token_array(&tokens);
+    free(source);
+    printf("✓ Parallel parse error order test passed\n");
+}
+
+// Parsers record errors even when they print them
+void test_serial_error_records(void)
+{
+    TokenArray tokens = tokenize("let = 4;");
+    Parser *parser = create_parser(tokens);
+    parser->print_errors = 0;
+    assert(parse_declaration(parser) == NULL);
+    assert(parser->had_error && parser->error_count == 1);
+    assert(strcmp(parser->errors[0].message, "[line 1] Error at '=': Expected variable name") == 0);
+    destroy_parser(parser);
+    free_token_array(&tokens);
+
+    // Empty input has no declarations
+    tokens = tokenize("");
+    ParsedProgram program = parse_program_parallel(&tokens, 4);
+    assert(program.decl_count == 0 && program.error_count == 0);
+    free_parsed_program(&program);
+    free_token_array(&tokens);
+    printf("✓ Serial error record test passed\n");
+}
+
+int main()
+{
+    printf("Running parallel parser tests...\n");
+
+    test_matches_serial();
+    test_errors_in_order();
+    test_serial_error_records();
+
+    printf("All parallel parser tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "../../include/pipeline.h"
+#include "../../include/ast_hash.h"
+#include "../test_utils.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ITEMS 200000
+#define DECLS 2000
+
+static void *produce(void *arg)
+{
+    SpscQueue *queue = arg;
+    for (uintptr_t i = 1; i <= ITEMS; i++)
+        spsc_queue_push(queue, (void *)i);
+    return NULL;
+}
+
+// Items arrive once and in order through a small queue
+void test_spsc_queue(void)
+{
+    SpscQueue queue;
+    spsc_queue_init(&queue, 3);
+    assert(queue.mask == 3);
+    assert(spsc_queue_try_pop(&queue) == NULL);
+    for (uintptr_t i = 1; i <= 4; i++)
+        assert(spsc_queue_try_push(&queue, (void *)i));
+    assert(!spsc_queue_try_push(&queue, (void *)5));
+    for (uintptr_t i = 1; i <= 4; i++)
+        assert(spsc_queue_try_pop(&queue) == (void *)i);
+
+    pthread_t producer;
+    pthread_create(&producer, NULL, produce, &queue);
+    for (uintptr_t i = 1; i <= ITEMS; i++)
+        assert(spsc_queue_pop(&queue) == (void *)i);
+    pthread_join(producer, NULL);
+    assert(spsc_queue_try_pop(&queue) == NULL);
+    spsc_queue_destroy(&queue);
+    printf("✓ SPSC queue test passed\n");
+}
+
+// Semantically valid declarations; later ones use earlier globals
+static char *generate_module(int count)
+{
+    char *source = malloc(count * 96);
+    size_t used = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (i % 4 == 0)
+            used += sprintf(source + used, "let g_%d: i32 = (%d + 1) * 2;\n", i, i);
+        else if (i % 4 == 1)
+            used += sprintf(source + used, "fn f_%d(a: i32): i32 { let x: i32 = a * g_%d; }\n", i, i - 1);
+        else if (i % 4 == 2)
+            used += sprintf(source + used, "comptime fn c_%d(): i32 { let z: i32 = %d; }\n", i, i);
+        else
+            used += sprintf(source + used, "struct S_%d { x: i32, y: f64 }\n", i);
+    }
+    return source;
+}
+
+// The pipeline yields the declarations parse_program_parallel does, checks
+// them, and lowers them in order
+void test_matches_parallel_parse(void)
+{
+    char *source = generate_module(40);
+    FrontendResult result = run_frontend_pipeline(source, strlen(source), NULL);
+
+    TokenArray tokens = tokenize(source);
+    ParsedProgram program = parse_program_parallel(&tokens, 1);
+    assert(result.error_count == 0 && program.error_count == 0);
+    assert(result.token_count == tokens.count);
+    assert(result.decl_count == 40 && program.decl_count == 40);
+    for (int i = 0; i < result.decl_count; i++)
+    {
+        assert(result.decls[i]->type == program.decls[i]->type);
+        assert(ast_structurally_equal(result.decls[i], program.decls[i]));
+    }
+
+    FlatAST *expected = create_flat_ast();
+    FlatIndex items[40];
+    for (int i = 0; i < program.decl_count; i++)
+        items[i] = flat_ast_add_tree(expected, program.decls[i]);
+    FlatIndex root = flat_ast_add_block(expected, items, program.decl_count);
+    assert(result.flat->node_count == expected->node_count);
+    assert(result.root == root);
+    assert(memcmp(result.flat->nodes, expected->nodes, expected->node_count * sizeof(FlatNode)) == 0);
+
+    destroy_flat_ast(expected);
+    free_parsed_program(&program);
+    free_token_array(&tokens);
+    free_frontend_result(&result);
+    free(source);
+    printf("✓ Pipeline matches parallel parse test passed\n");
+}
+
+// Every error is reported; declarations after the first one are parsed but
+// not lowered
+void test_parse_errors(void)
+{
+    const char *source = "let a: i32 = 1;\n"
+                         "let broken = ;\n"
+                         "fn f(x: i32) { let y: i32 = x; }\n"
+                         "let also_broken: i32 = (2 + ;\n"
+                         "struct P { x: i32 }\n";
+    FrontendResult result = run_frontend_pipeline(source, strlen(source), NULL);
+
+    TokenArray tokens = tokenize(source);
+    ParsedProgram program = parse_program_parallel(&tokens, 1);
+    assert(result.error_count == 3 && program.error_count == 3);
+    for (int i = 0; i < 3; i++)
+    {
+        assert(result.errors[i].token_index == program.errors[i].token_index);
+        assert(result.errors[i].line == program.errors[i].line);
+        assert(strcmp(result.errors[i].message, program.errors[i].message) == 0);
+    }
+    assert(result.errors[0].line == 2 && result.errors[2].line == 4);
+    assert(result.decl_count == 3);
+    assert(result.decls[2]->type == AST_STRUCT_DEF);
+
+    // Only the first declaration made it past the parser
+    const FlatNode *block = flat_node(result.flat, result.root);
+    assert(block->tag == AST_BLOCK && block->b == 1);
+
+    free_parsed_program(&program);
+    free_token_array(&tokens);
+    free_frontend_result(&result);
+    printf("✓ Pipeline parse error test passed\n");
+}
+
+// A semantic error is recorded, checking goes on, and lowering stops there
+void test_semantic_errors(void)
+{
+    const char *source = "let a: i32 = 1;\n"
+                         "let b: bool = 2;\n"
+                         "let c: i32 = 3;\n"
+                         "let d: i32 = true;\n";
+    FrontendResult result = run_frontend_pipeline(source, strlen(source), NULL);
+    assert(result.error_count == 0);
+    assert(result.decl_count == 4);
+    assert(result.semantic_errors.count == 2);
+    assert(result.semantic_errors.items[0].decl == 1);
+    assert(strstr(result.semantic_errors.items[0].message, "Type mismatch"));
+    assert(result.semantic_errors.items[1].decl == 3);
+
+    const FlatNode *block = flat_node(result.flat, result.root);
+    assert(block->tag == AST_BLOCK && block->b == 1);
+
+    free_frontend_result(&result);
+    printf("✓ Pipeline semantic error test passed\n");
+}
+
+// Many declarations through the smallest queues, with stages switched off
+void test_backpressure(void)
+{
+    char *source = generate_module(DECLS);
+    FrontendOptions options[] = {{1, 0, 0}, {1, 0, 1}, {2, 0, 1}};
+    for (size_t k = 0; k < sizeof(options) / sizeof(options[0]); k++)
+    {
+        FrontendResult result = run_frontend_pipeline(source, strlen(source), &options[k]);
+        assert(result.error_count == 0);
+        assert(result.decl_count == DECLS);
+        assert(result.decls[DECLS - 1]->type == AST_STRUCT_DEF);
+        if (options[k].lower)
+            assert(flat_node(result.flat, result.root)->b == DECLS);
+        else
+            assert(result.flat == NULL);
+        free_frontend_result(&result);
+    }
+
+    FrontendResult empty = run_frontend_pipeline("", 0, NULL);
+    assert(empty.decl_count == 0 && empty.error_count == 0 && empty.token_count == 1);
+    assert(flat_node(empty.flat, empty.root)->b == 0);
+    free_frontend_result(&empty);
+    free(source);
+    printf("✓ Pipeline backpressure test passed\n");
+}
+
+int main()
+{
+    printf("Running frontend pipeline tests...\n");
+
+    test_spsc_queue();
+    test_matches_parallel_parse();
+    test_parse_errors();
+    test_semantic_errors();
+    test_backpressure();
+
+    printf("All frontend pipeline tests passed!\n");
+    return 0;
+}